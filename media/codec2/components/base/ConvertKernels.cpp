@@ -0,0 +1,853 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ConvertKernels"
+#include <log/log.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <SimpleC2Component.h>
+
+#include "ConvertKernels.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define CONVERT_X86 1
+#define CONVERT_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define CONVERT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CONVERT_X86 0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONVERT_NEON 1
+#else
+#define CONVERT_NEON 0
+#endif
+
+namespace android {
+
+namespace {
+
+// Luma and chroma values of Y410 are only masked to 10 bits for even pixels,
+// and the alpha bits are only set for groups of 4 pixels, as in the original
+// converter.
+constexpr uint32_t kY410Alpha = 3u << 30;
+constexpr uint16_t kY410EvenMask = 0x3FF;
+
+// Scalar kernels. They start at pixel "x", so that the vector kernels can
+// finish their rows with them.
+
+void shiftLeft6Scalar(uint16_t *dst, const uint16_t *src, size_t x, size_t width) {
+    for (; x < width; ++x) {
+        dst[x] = src[x] << 6;
+    }
+}
+
+void shiftRight6Scalar(uint16_t *dst, const uint16_t *src, size_t x, size_t width) {
+    for (; x < width; ++x) {
+        dst[x] = src[x] >> 6;
+    }
+}
+
+void narrow10To8Scalar(uint8_t *dst, const uint16_t *src, size_t x, size_t width) {
+    for (; x < width; ++x) {
+        dst[x] = (uint8_t)(src[x] >> 2);
+    }
+}
+
+void interleaveShiftLeft6Scalar(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                                size_t x, size_t width) {
+    for (; x < width; ++x) {
+        dstUV[2 * x] = srcU[x] << 6;
+        dstUV[2 * x + 1] = srcV[x] << 6;
+    }
+}
+
+void deinterleaveShiftRight6Scalar(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                                   size_t x, size_t width) {
+    for (; x < width; ++x) {
+        dstU[x] = srcUV[2 * x] >> 6;
+        dstV[x] = srcUV[2 * x + 1] >> 6;
+    }
+}
+
+// "x" is a multiple of 4.
+void y410RowsScalar(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                    const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                    size_t x, size_t width) {
+    for (; x + 3 < width; x += 4) {
+        const size_t c = x / 2;
+        const uint32_t uv0 = (srcU[c] & 0x3FF) | ((uint32_t)(srcV[c] & 0x3FF) << 20);
+        const uint32_t uv1 = srcU[c + 1] | ((uint32_t)srcV[c + 1] << 20);
+
+        dstTop[x] = kY410Alpha | ((srcYTop[x] & 0x3FF) << 10) | uv0;
+        dstTop[x + 1] = kY410Alpha | ((uint32_t)srcYTop[x + 1] << 10) | uv0;
+        dstTop[x + 2] = kY410Alpha | ((srcYTop[x + 2] & 0x3FF) << 10) | uv1;
+        dstTop[x + 3] = kY410Alpha | ((uint32_t)srcYTop[x + 3] << 10) | uv1;
+
+        dstBot[x] = kY410Alpha | ((srcYBot[x] & 0x3FF) << 10) | uv0;
+        dstBot[x + 1] = kY410Alpha | ((uint32_t)srcYBot[x + 1] << 10) | uv0;
+        dstBot[x + 2] = kY410Alpha | ((srcYBot[x + 2] & 0x3FF) << 10) | uv1;
+        dstBot[x + 3] = kY410Alpha | ((uint32_t)srcYBot[x + 3] << 10) | uv1;
+    }
+
+    // There should be at most 2 more pixels to process. Note that we don't
+    // need to consider odd case as the buffer is always aligned to even.
+    if (x < width) {
+        const size_t c = x / 2;
+        const uint32_t uv0 = (srcU[c] & 0x3FF) | ((uint32_t)(srcV[c] & 0x3FF) << 20);
+        dstTop[x] = ((srcYTop[x] & 0x3FF) << 10) | uv0;
+        dstTop[x + 1] = ((uint32_t)srcYTop[x + 1] << 10) | uv0;
+        dstBot[x] = ((srcYBot[x] & 0x3FF) << 10) | uv0;
+        dstBot[x + 1] = ((uint32_t)srcYBot[x + 1] << 10) | uv0;
+    }
+}
+
+inline uint32_t yuvToRgba1010102(int32_t y, int32_t uB, int32_t uvG, int32_t vR,
+                                 const int32_t *coeffs) {
+    const int32_t yMult = y * coeffs[kCoeffY] + 512;
+    const int32_t b = std::clamp((yMult + uB) / 1024, 0, 1023);
+    const int32_t g = std::clamp((yMult + uvG) / 1024, 0, 1023);
+    const int32_t r = std::clamp((yMult + vR) / 1024, 0, 1023);
+    return kY410Alpha | (b << 20) | (g << 10) | r;
+}
+
+// "x" is even.
+void rgba1010102RowsScalar(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                           const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                           size_t x, size_t width, const int32_t *coeffs) {
+    const int32_t c16 = coeffs[kCoeffC16];
+    for (; x < width; x += 2) {
+        const int32_t u = srcU[x / 2] - 512;
+        const int32_t v = srcV[x / 2] - 512;
+        const int32_t uB = u * coeffs[kCoeffBU];
+        const int32_t uvG = v * coeffs[kCoeffNegGV] + u * coeffs[kCoeffNegGU];
+        const int32_t vR = v * coeffs[kCoeffRV];
+        dstTop[x] = yuvToRgba1010102(srcYTop[x] - c16, uB, uvG, vR, coeffs);
+        dstTop[x + 1] = yuvToRgba1010102(srcYTop[x + 1] - c16, uB, uvG, vR, coeffs);
+        dstBot[x] = yuvToRgba1010102(srcYBot[x] - c16, uB, uvG, vR, coeffs);
+        dstBot[x + 1] = yuvToRgba1010102(srcYBot[x + 1] - c16, uB, uvG, vR, coeffs);
+    }
+}
+
+const ConvertKernels kScalarKernels = {
+    [](uint16_t *dst, const uint16_t *src, size_t width) {
+        shiftLeft6Scalar(dst, src, 0, width);
+    },
+    [](uint16_t *dst, const uint16_t *src, size_t width) {
+        shiftRight6Scalar(dst, src, 0, width);
+    },
+    [](uint8_t *dst, const uint16_t *src, size_t width) {
+        narrow10To8Scalar(dst, src, 0, width);
+    },
+    [](uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV, size_t width) {
+        interleaveShiftLeft6Scalar(dstUV, srcU, srcV, 0, width);
+    },
+    [](uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV, size_t width) {
+        deinterleaveShiftRight6Scalar(dstU, dstV, srcUV, 0, width);
+    },
+    [](uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop, const uint16_t *srcYBot,
+       const uint16_t *srcU, const uint16_t *srcV, size_t width) {
+        y410RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, 0, width);
+    },
+    [](uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop, const uint16_t *srcYBot,
+       const uint16_t *srcU, const uint16_t *srcV, size_t width, const int32_t *coeffs) {
+        rgba1010102RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, 0, width, coeffs);
+    },
+};
+
+#if CONVERT_X86
+
+// SSE4.1 kernels, 8 pixels at a time.
+
+CONVERT_TARGET_SSE4
+void shiftLeft6Sse4(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_slli_epi16(v, 6));
+    }
+    shiftLeft6Scalar(dst, src, x, width);
+}
+
+CONVERT_TARGET_SSE4
+void shiftRight6Sse4(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_srli_epi16(v, 6));
+    }
+    shiftRight6Scalar(dst, src, x, width);
+}
+
+CONVERT_TARGET_SSE4
+void narrow10To8Sse4(uint8_t *dst, const uint16_t *src, size_t width) {
+    // Masked to 8 bits first, so that packing truncates instead of saturating.
+    const __m128i mask = _mm_set1_epi16(0xFF);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + x + 8));
+        a = _mm_and_si128(_mm_srli_epi16(a, 2), mask);
+        b = _mm_and_si128(_mm_srli_epi16(b, 2), mask);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(a, b));
+    }
+    narrow10To8Scalar(dst, src, x, width);
+}
+
+CONVERT_TARGET_SSE4
+void interleaveShiftLeft6Sse4(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                              size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i u = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcU + x)), 6);
+        __m128i v = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcV + x)), 6);
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x), _mm_unpacklo_epi16(u, v));
+        _mm_storeu_si128((__m128i *)(dstUV + 2 * x + 8), _mm_unpackhi_epi16(u, v));
+    }
+    interleaveShiftLeft6Scalar(dstUV, srcU, srcV, x, width);
+}
+
+CONVERT_TARGET_SSE4
+void deinterleaveShiftRight6Sse4(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                                 size_t width) {
+    const __m128i mask = _mm_set1_epi32(0xFFFF);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(srcUV + 2 * x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(srcUV + 2 * x + 8));
+        __m128i u = _mm_packus_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+        __m128i v = _mm_packus_epi32(_mm_srli_epi32(a, 16), _mm_srli_epi32(b, 16));
+        _mm_storeu_si128((__m128i *)(dstU + x), _mm_srli_epi16(u, 6));
+        _mm_storeu_si128((__m128i *)(dstV + x), _mm_srli_epi16(v, 6));
+    }
+    deinterleaveShiftRight6Scalar(dstU, dstV, srcUV, x, width);
+}
+
+CONVERT_TARGET_SSE4
+void y410RowsSse4(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                  const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                  size_t width) {
+    const __m128i evenMask = _mm_set1_epi32(0xFFFF0000 | kY410EvenMask);
+    const __m128i alpha = _mm_set1_epi32(kY410Alpha);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        // Each chroma sample covers two pixels.
+        __m128i u = _mm_and_si128(_mm_loadl_epi64((const __m128i *)(srcU + x / 2)), evenMask);
+        __m128i v = _mm_and_si128(_mm_loadl_epi64((const __m128i *)(srcV + x / 2)), evenMask);
+        u = _mm_unpacklo_epi16(u, u);
+        v = _mm_unpacklo_epi16(v, v);
+        const __m128i uvLo = _mm_or_si128(
+                _mm_or_si128(_mm_cvtepu16_epi32(u), _mm_slli_epi32(_mm_cvtepu16_epi32(v), 20)),
+                alpha);
+        const __m128i uvHi = _mm_or_si128(
+                _mm_or_si128(_mm_unpackhi_epi16(u, _mm_setzero_si128()),
+                             _mm_slli_epi32(_mm_unpackhi_epi16(v, _mm_setzero_si128()), 20)),
+                alpha);
+
+        __m128i y = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcYTop + x)), evenMask);
+        _mm_storeu_si128((__m128i *)(dstTop + x),
+                         _mm_or_si128(_mm_slli_epi32(_mm_cvtepu16_epi32(y), 10), uvLo));
+        _mm_storeu_si128((__m128i *)(dstTop + x + 4),
+                         _mm_or_si128(_mm_slli_epi32(
+                                 _mm_unpackhi_epi16(y, _mm_setzero_si128()), 10), uvHi));
+        y = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcYBot + x)), evenMask);
+        _mm_storeu_si128((__m128i *)(dstBot + x),
+                         _mm_or_si128(_mm_slli_epi32(_mm_cvtepu16_epi32(y), 10), uvLo));
+        _mm_storeu_si128((__m128i *)(dstBot + x + 4),
+                         _mm_or_si128(_mm_slli_epi32(
+                                 _mm_unpackhi_epi16(y, _mm_setzero_si128()), 10), uvHi));
+    }
+    y410RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, x, width);
+}
+
+// Converts 4 pixels. The arithmetic shift rounds down where the scalar
+// division rounds towards zero, which only differs for negative values,
+// both of which clamp to 0.
+CONVERT_TARGET_SSE4
+inline __m128i yuvToRgba1010102Sse4(__m128i y, __m128i uB, __m128i uvG, __m128i vR,
+                                    __m128i yCoeff, __m128i rounding) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi32(1023);
+    const __m128i yMult = _mm_add_epi32(_mm_mullo_epi32(y, yCoeff), rounding);
+    __m128i b = _mm_srai_epi32(_mm_add_epi32(yMult, uB), 10);
+    __m128i g = _mm_srai_epi32(_mm_add_epi32(yMult, uvG), 10);
+    __m128i r = _mm_srai_epi32(_mm_add_epi32(yMult, vR), 10);
+    b = _mm_min_epi32(_mm_max_epi32(b, zero), max);
+    g = _mm_min_epi32(_mm_max_epi32(g, zero), max);
+    r = _mm_min_epi32(_mm_max_epi32(r, zero), max);
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(b, 20), _mm_slli_epi32(g, 10)),
+                        _mm_or_si128(r, _mm_set1_epi32(kY410Alpha)));
+}
+
+CONVERT_TARGET_SSE4
+void rgba1010102RowsSse4(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                         const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                         size_t width, const int32_t *coeffs) {
+    const __m128i yCoeff = _mm_set1_epi32(coeffs[kCoeffY]);
+    const __m128i rvCoeff = _mm_set1_epi32(coeffs[kCoeffRV]);
+    const __m128i neguCoeff = _mm_set1_epi32(coeffs[kCoeffNegGU]);
+    const __m128i negvCoeff = _mm_set1_epi32(coeffs[kCoeffNegGV]);
+    const __m128i buCoeff = _mm_set1_epi32(coeffs[kCoeffBU]);
+    const __m128i c16 = _mm_set1_epi32(coeffs[kCoeffC16]);
+    const __m128i neutral = _mm_set1_epi32(512);
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        int32_t u01, v01;
+        memcpy(&u01, srcU + x / 2, sizeof(u01));
+        memcpy(&v01, srcV + x / 2, sizeof(v01));
+        __m128i u = _mm_cvtsi32_si128(u01);
+        __m128i v = _mm_cvtsi32_si128(v01);
+        u = _mm_sub_epi32(_mm_cvtepu16_epi32(_mm_unpacklo_epi16(u, u)), neutral);
+        v = _mm_sub_epi32(_mm_cvtepu16_epi32(_mm_unpacklo_epi16(v, v)), neutral);
+        const __m128i uB = _mm_mullo_epi32(u, buCoeff);
+        const __m128i uvG = _mm_add_epi32(_mm_mullo_epi32(v, negvCoeff),
+                                          _mm_mullo_epi32(u, neguCoeff));
+        const __m128i vR = _mm_mullo_epi32(v, rvCoeff);
+
+        __m128i y = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(srcYTop + x))), c16);
+        _mm_storeu_si128((__m128i *)(dstTop + x),
+                         yuvToRgba1010102Sse4(y, uB, uvG, vR, yCoeff, neutral));
+        y = _mm_sub_epi32(
+                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(srcYBot + x))), c16);
+        _mm_storeu_si128((__m128i *)(dstBot + x),
+                         yuvToRgba1010102Sse4(y, uB, uvG, vR, yCoeff, neutral));
+    }
+    rgba1010102RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, x, width, coeffs);
+}
+
+const ConvertKernels kSse4Kernels = {
+    shiftLeft6Sse4,
+    shiftRight6Sse4,
+    narrow10To8Sse4,
+    interleaveShiftLeft6Sse4,
+    deinterleaveShiftRight6Sse4,
+    y410RowsSse4,
+    rgba1010102RowsSse4,
+};
+
+// AVX2 kernels, 16 pixels at a time. Packing and unpacking work within each
+// 128 bit lane, hence the permutes.
+
+CONVERT_TARGET_AVX2
+void shiftLeft6Avx2(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + x));
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_slli_epi16(v, 6));
+    }
+    shiftLeft6Scalar(dst, src, x, width);
+}
+
+CONVERT_TARGET_AVX2
+void shiftRight6Avx2(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + x));
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_srli_epi16(v, 6));
+    }
+    shiftRight6Scalar(dst, src, x, width);
+}
+
+CONVERT_TARGET_AVX2
+void narrow10To8Avx2(uint8_t *dst, const uint16_t *src, size_t width) {
+    const __m256i mask = _mm256_set1_epi16(0xFF);
+    size_t x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + x));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + x + 16));
+        a = _mm256_and_si256(_mm256_srli_epi16(a, 2), mask);
+        b = _mm256_and_si256(_mm256_srli_epi16(b, 2), mask);
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+    }
+    narrow10To8Scalar(dst, src, x, width);
+}
+
+CONVERT_TARGET_AVX2
+void interleaveShiftLeft6Avx2(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                              size_t width) {
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i u = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i *)(srcU + x)), 6);
+        __m256i v = _mm256_slli_epi16(_mm256_loadu_si256((const __m256i *)(srcV + x)), 6);
+        __m256i lo = _mm256_unpacklo_epi16(u, v);
+        __m256i hi = _mm256_unpackhi_epi16(u, v);
+        _mm256_storeu_si256((__m256i *)(dstUV + 2 * x), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dstUV + 2 * x + 16),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleaveShiftLeft6Scalar(dstUV, srcU, srcV, x, width);
+}
+
+CONVERT_TARGET_AVX2
+void deinterleaveShiftRight6Avx2(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                                 size_t width) {
+    const __m256i mask = _mm256_set1_epi32(0xFFFF);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(srcUV + 2 * x));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(srcUV + 2 * x + 16));
+        __m256i u = _mm256_packus_epi32(_mm256_and_si256(a, mask), _mm256_and_si256(b, mask));
+        __m256i v = _mm256_packus_epi32(_mm256_srli_epi32(a, 16), _mm256_srli_epi32(b, 16));
+        u = _mm256_permute4x64_epi64(u, 0xD8);
+        v = _mm256_permute4x64_epi64(v, 0xD8);
+        _mm256_storeu_si256((__m256i *)(dstU + x), _mm256_srli_epi16(u, 6));
+        _mm256_storeu_si256((__m256i *)(dstV + x), _mm256_srli_epi16(v, 6));
+    }
+    deinterleaveShiftRight6Scalar(dstU, dstV, srcUV, x, width);
+}
+
+CONVERT_TARGET_AVX2
+void y410RowsAvx2(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                  const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                  size_t width) {
+    const __m128i evenMask = _mm_set1_epi32(0xFFFF0000 | kY410EvenMask);
+    const __m256i alpha = _mm256_set1_epi32(kY410Alpha);
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i u = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcU + x / 2)), evenMask);
+        __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcV + x / 2)), evenMask);
+        const __m256i uvLo = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cvtepu16_epi32(_mm_unpacklo_epi16(u, u)),
+                                _mm256_slli_epi32(
+                                        _mm256_cvtepu16_epi32(_mm_unpacklo_epi16(v, v)), 20)),
+                alpha);
+        const __m256i uvHi = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cvtepu16_epi32(_mm_unpackhi_epi16(u, u)),
+                                _mm256_slli_epi32(
+                                        _mm256_cvtepu16_epi32(_mm_unpackhi_epi16(v, v)), 20)),
+                alpha);
+
+        for (int row = 0; row < 2; ++row) {
+            const uint16_t *srcY = row == 0 ? srcYTop : srcYBot;
+            uint32_t *dst = row == 0 ? dstTop : dstBot;
+            __m128i y0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcY + x)), evenMask);
+            __m128i y1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcY + x + 8)),
+                                       evenMask);
+            _mm256_storeu_si256((__m256i *)(dst + x),
+                                _mm256_or_si256(_mm256_slli_epi32(_mm256_cvtepu16_epi32(y0), 10),
+                                                uvLo));
+            _mm256_storeu_si256((__m256i *)(dst + x + 8),
+                                _mm256_or_si256(_mm256_slli_epi32(_mm256_cvtepu16_epi32(y1), 10),
+                                                uvHi));
+        }
+    }
+    y410RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, x, width);
+}
+
+CONVERT_TARGET_AVX2
+inline __m256i yuvToRgba1010102Avx2(__m256i y, __m256i uB, __m256i uvG, __m256i vR,
+                                    __m256i yCoeff, __m256i rounding) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi32(1023);
+    const __m256i yMult = _mm256_add_epi32(_mm256_mullo_epi32(y, yCoeff), rounding);
+    __m256i b = _mm256_srai_epi32(_mm256_add_epi32(yMult, uB), 10);
+    __m256i g = _mm256_srai_epi32(_mm256_add_epi32(yMult, uvG), 10);
+    __m256i r = _mm256_srai_epi32(_mm256_add_epi32(yMult, vR), 10);
+    b = _mm256_min_epi32(_mm256_max_epi32(b, zero), max);
+    g = _mm256_min_epi32(_mm256_max_epi32(g, zero), max);
+    r = _mm256_min_epi32(_mm256_max_epi32(r, zero), max);
+    return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(b, 20), _mm256_slli_epi32(g, 10)),
+                           _mm256_or_si256(r, _mm256_set1_epi32(kY410Alpha)));
+}
+
+CONVERT_TARGET_AVX2
+void rgba1010102RowsAvx2(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                         const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                         size_t width, const int32_t *coeffs) {
+    const __m256i yCoeff = _mm256_set1_epi32(coeffs[kCoeffY]);
+    const __m256i rvCoeff = _mm256_set1_epi32(coeffs[kCoeffRV]);
+    const __m256i neguCoeff = _mm256_set1_epi32(coeffs[kCoeffNegGU]);
+    const __m256i negvCoeff = _mm256_set1_epi32(coeffs[kCoeffNegGV]);
+    const __m256i buCoeff = _mm256_set1_epi32(coeffs[kCoeffBU]);
+    const __m256i c16 = _mm256_set1_epi32(coeffs[kCoeffC16]);
+    const __m256i neutral = _mm256_set1_epi32(512);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i u = _mm_loadl_epi64((const __m128i *)(srcU + x / 2));
+        __m128i v = _mm_loadl_epi64((const __m128i *)(srcV + x / 2));
+        const __m256i u32 = _mm256_sub_epi32(
+                _mm256_cvtepu16_epi32(_mm_unpacklo_epi16(u, u)), neutral);
+        const __m256i v32 = _mm256_sub_epi32(
+                _mm256_cvtepu16_epi32(_mm_unpacklo_epi16(v, v)), neutral);
+        const __m256i uB = _mm256_mullo_epi32(u32, buCoeff);
+        const __m256i uvG = _mm256_add_epi32(_mm256_mullo_epi32(v32, negvCoeff),
+                                             _mm256_mullo_epi32(u32, neguCoeff));
+        const __m256i vR = _mm256_mullo_epi32(v32, rvCoeff);
+
+        __m256i y = _mm256_sub_epi32(
+                _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(srcYTop + x))), c16);
+        _mm256_storeu_si256((__m256i *)(dstTop + x),
+                            yuvToRgba1010102Avx2(y, uB, uvG, vR, yCoeff, neutral));
+        y = _mm256_sub_epi32(
+                _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(srcYBot + x))), c16);
+        _mm256_storeu_si256((__m256i *)(dstBot + x),
+                            yuvToRgba1010102Avx2(y, uB, uvG, vR, yCoeff, neutral));
+    }
+    rgba1010102RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, x, width, coeffs);
+}
+
+const ConvertKernels kAvx2Kernels = {
+    shiftLeft6Avx2,
+    shiftRight6Avx2,
+    narrow10To8Avx2,
+    interleaveShiftLeft6Avx2,
+    deinterleaveShiftRight6Avx2,
+    y410RowsAvx2,
+    rgba1010102RowsAvx2,
+};
+
+#endif  // CONVERT_X86
+
+#if CONVERT_NEON
+
+// NEON kernels, 8 pixels at a time.
+
+void shiftLeft6Neon(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        vst1q_u16(dst + x, vshlq_n_u16(vld1q_u16(src + x), 6));
+    }
+    shiftLeft6Scalar(dst, src, x, width);
+}
+
+void shiftRight6Neon(uint16_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        vst1q_u16(dst + x, vshrq_n_u16(vld1q_u16(src + x), 6));
+    }
+    shiftRight6Scalar(dst, src, x, width);
+}
+
+void narrow10To8Neon(uint8_t *dst, const uint16_t *src, size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        // The narrowing shift truncates, as the scalar cast does.
+        vst1_u8(dst + x, vshrn_n_u16(vld1q_u16(src + x), 2));
+    }
+    narrow10To8Scalar(dst, src, x, width);
+}
+
+void interleaveShiftLeft6Neon(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                              size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint16x8x2_t uv;
+        uv.val[0] = vshlq_n_u16(vld1q_u16(srcU + x), 6);
+        uv.val[1] = vshlq_n_u16(vld1q_u16(srcV + x), 6);
+        vst2q_u16(dstUV + 2 * x, uv);
+    }
+    interleaveShiftLeft6Scalar(dstUV, srcU, srcV, x, width);
+}
+
+void deinterleaveShiftRight6Neon(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                                 size_t width) {
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint16x8x2_t uv = vld2q_u16(srcUV + 2 * x);
+        vst1q_u16(dstU + x, vshrq_n_u16(uv.val[0], 6));
+        vst1q_u16(dstV + x, vshrq_n_u16(uv.val[1], 6));
+    }
+    deinterleaveShiftRight6Scalar(dstU, dstV, srcUV, x, width);
+}
+
+void y410RowsNeon(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                  const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                  size_t width) {
+    const uint16x4_t evenMask4 = vreinterpret_u16_u32(vdup_n_u32(0xFFFF0000 | kY410EvenMask));
+    const uint16x8_t evenMask8 = vcombine_u16(evenMask4, evenMask4);
+    const uint32x4_t alpha = vdupq_n_u32(kY410Alpha);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        // Each chroma sample covers two pixels.
+        const uint16x4_t u4 = vand_u16(vld1_u16(srcU + x / 2), evenMask4);
+        const uint16x4_t v4 = vand_u16(vld1_u16(srcV + x / 2), evenMask4);
+        const uint16x4x2_t u = vzip_u16(u4, u4);
+        const uint16x4x2_t v = vzip_u16(v4, v4);
+        const uint32x4_t uvLo = vorrq_u32(
+                vorrq_u32(vmovl_u16(u.val[0]), vshlq_n_u32(vmovl_u16(v.val[0]), 20)), alpha);
+        const uint32x4_t uvHi = vorrq_u32(
+                vorrq_u32(vmovl_u16(u.val[1]), vshlq_n_u32(vmovl_u16(v.val[1]), 20)), alpha);
+
+        uint16x8_t y = vandq_u16(vld1q_u16(srcYTop + x), evenMask8);
+        vst1q_u32(dstTop + x, vorrq_u32(vshlq_n_u32(vmovl_u16(vget_low_u16(y)), 10), uvLo));
+        vst1q_u32(dstTop + x + 4,
+                  vorrq_u32(vshlq_n_u32(vmovl_u16(vget_high_u16(y)), 10), uvHi));
+        y = vandq_u16(vld1q_u16(srcYBot + x), evenMask8);
+        vst1q_u32(dstBot + x, vorrq_u32(vshlq_n_u32(vmovl_u16(vget_low_u16(y)), 10), uvLo));
+        vst1q_u32(dstBot + x + 4,
+                  vorrq_u32(vshlq_n_u32(vmovl_u16(vget_high_u16(y)), 10), uvHi));
+    }
+    y410RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, x, width);
+}
+
+// See yuvToRgba1010102Sse4() for the rounding.
+inline uint32x4_t yuvToRgba1010102Neon(int32x4_t y, int32x4_t uB, int32x4_t uvG, int32x4_t vR,
+                                       int32_t yCoeff) {
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max = vdupq_n_s32(1023);
+    const int32x4_t yMult = vmlaq_n_s32(vdupq_n_s32(512), y, yCoeff);
+    int32x4_t b = vshrq_n_s32(vaddq_s32(yMult, uB), 10);
+    int32x4_t g = vshrq_n_s32(vaddq_s32(yMult, uvG), 10);
+    int32x4_t r = vshrq_n_s32(vaddq_s32(yMult, vR), 10);
+    b = vminq_s32(vmaxq_s32(b, zero), max);
+    g = vminq_s32(vmaxq_s32(g, zero), max);
+    r = vminq_s32(vmaxq_s32(r, zero), max);
+    return vorrq_u32(vorrq_u32(vshlq_n_u32(vreinterpretq_u32_s32(b), 20),
+                               vshlq_n_u32(vreinterpretq_u32_s32(g), 10)),
+                     vorrq_u32(vreinterpretq_u32_s32(r), vdupq_n_u32(kY410Alpha)));
+}
+
+void rgba1010102RowsNeon(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                         const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                         size_t width, const int32_t *coeffs) {
+    const int32x4_t c16 = vdupq_n_s32(coeffs[kCoeffC16]);
+    const int32x4_t neutral = vdupq_n_s32(512);
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint16x4_t u4 = vld1_u16(srcU + x / 2);
+        const uint16x4_t v4 = vld1_u16(srcV + x / 2);
+        const uint16x4x2_t u16 = vzip_u16(u4, u4);
+        const uint16x4x2_t v16 = vzip_u16(v4, v4);
+        const uint16x8_t yTop = vld1q_u16(srcYTop + x);
+        const uint16x8_t yBot = vld1q_u16(srcYBot + x);
+        for (int half = 0; half < 2; ++half) {
+            const int32x4_t u = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(u16.val[half])),
+                                          neutral);
+            const int32x4_t v = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(v16.val[half])),
+                                          neutral);
+            const int32x4_t uB = vmulq_n_s32(u, coeffs[kCoeffBU]);
+            const int32x4_t uvG = vmlaq_n_s32(vmulq_n_s32(v, coeffs[kCoeffNegGV]), u,
+                                              coeffs[kCoeffNegGU]);
+            const int32x4_t vR = vmulq_n_s32(v, coeffs[kCoeffRV]);
+
+            const uint16x4_t top = half == 0 ? vget_low_u16(yTop) : vget_high_u16(yTop);
+            const uint16x4_t bot = half == 0 ? vget_low_u16(yBot) : vget_high_u16(yBot);
+            vst1q_u32(dstTop + x + 4 * half,
+                      yuvToRgba1010102Neon(
+                              vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(top)), c16),
+                              uB, uvG, vR, coeffs[kCoeffY]));
+            vst1q_u32(dstBot + x + 4 * half,
+                      yuvToRgba1010102Neon(
+                              vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(bot)), c16),
+                              uB, uvG, vR, coeffs[kCoeffY]));
+        }
+    }
+    rgba1010102RowsScalar(dstTop, dstBot, srcYTop, srcYBot, srcU, srcV, x, width, coeffs);
+}
+
+const ConvertKernels kNeonKernels = {
+    shiftLeft6Neon,
+    shiftRight6Neon,
+    narrow10To8Neon,
+    interleaveShiftLeft6Neon,
+    deinterleaveShiftRight6Neon,
+    y410RowsNeon,
+    rgba1010102RowsNeon,
+};
+
+#endif  // CONVERT_NEON
+
+CONV_SIMD_T detectSimdLevel() {
+#if CONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return CONV_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return CONV_SIMD_SSE4;
+    }
+#elif CONVERT_NEON
+    return CONV_SIMD_NEON;
+#endif
+    return CONV_SIMD_NONE;
+}
+
+CONV_SIMD_T maxSimdLevel() {
+    static const CONV_SIMD_T level = detectSimdLevel();
+    return level;
+}
+
+std::atomic<const ConvertKernels *> sKernels{nullptr};
+
+const ConvertKernels &kernelsForLevel(CONV_SIMD_T level) {
+    switch (level) {
+#if CONVERT_X86
+        case CONV_SIMD_SSE4:
+            return kSse4Kernels;
+        case CONV_SIMD_AVX2:
+            return kAvx2Kernels;
+#endif
+#if CONVERT_NEON
+        case CONV_SIMD_NEON:
+            return kNeonKernels;
+#endif
+        default:
+            return kScalarKernels;
+    }
+}
+
+// Frames smaller than this are converted on the calling thread.
+constexpr size_t kMinParallelPixels = 1280 * 720;
+// Fewest rows worth handing to another thread.
+constexpr size_t kMinBandRows = 64;
+// Most threads converting a frame, including the calling one.
+constexpr size_t kMaxConvertThreads = 4;
+
+size_t defaultThreadCount() {
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, kMaxConvertThreads);
+}
+
+std::atomic<size_t> sThreadCount{0};
+
+// Worker threads shared by all the components of the process. One frame is
+// split across them at a time. A frame converted while they are busy is
+// converted on its calling thread alone.
+class RowBandWorkers {
+public:
+    explicit RowBandWorkers(size_t numThreads) {
+        for (size_t i = 0; i < numThreads; ++i) {
+            std::thread(&RowBandWorkers::threadLoop, this).detach();
+        }
+    }
+
+    // Returns false if the workers are busy with another frame.
+    bool run(size_t numBands, const std::function<void(size_t)> &band) {
+        std::unique_lock<std::mutex> runLock(mRunLock, std::try_to_lock);
+        if (!runLock.owns_lock()) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(mLock);
+        mBand = &band;
+        mNumBands = numBands;
+        mNextBand = 0;
+        mDoneBands = 0;
+        ++mGeneration;
+        mWorkCond.notify_all();
+        runBands_l(lock);
+        mDoneCond.wait(lock, [this] { return mDoneBands == mNumBands; });
+        mBand = nullptr;
+        return true;
+    }
+
+private:
+    void threadLoop() {
+        std::unique_lock<std::mutex> lock(mLock);
+        uint64_t generation = 0;
+        for (;;) {
+            mWorkCond.wait(lock, [this, generation] { return mGeneration != generation; });
+            generation = mGeneration;
+            runBands_l(lock);
+        }
+    }
+
+    void runBands_l(std::unique_lock<std::mutex> &lock) {
+        while (mNextBand < mNumBands) {
+            const size_t index = mNextBand++;
+            const std::function<void(size_t)> &band = *mBand;
+            lock.unlock();
+            band(index);
+            lock.lock();
+            if (++mDoneBands == mNumBands) {
+                mDoneCond.notify_all();
+            }
+        }
+    }
+
+    std::mutex mRunLock;
+    std::mutex mLock;
+    std::condition_variable mWorkCond;
+    std::condition_variable mDoneCond;
+    uint64_t mGeneration = 0;
+    const std::function<void(size_t)> *mBand = nullptr;
+    size_t mNumBands = 0;
+    size_t mNextBand = 0;
+    size_t mDoneBands = 0;
+};
+
+RowBandWorkers &getRowBandWorkers() {
+    // Never destroyed, as its threads run until the process exits.
+    static RowBandWorkers *workers = new RowBandWorkers(kMaxConvertThreads - 1);
+    return *workers;
+}
+
+}  // namespace
+
+CONV_SIMD_T getMaxConvertSimdLevel() {
+    return maxSimdLevel();
+}
+
+bool setConvertSimdLevel(CONV_SIMD_T level) {
+    const bool supported = level == CONV_SIMD_NONE || level == maxSimdLevel()
+            || (level == CONV_SIMD_SSE4 && maxSimdLevel() == CONV_SIMD_AVX2);
+    if (!supported) {
+        return false;
+    }
+    sKernels = &kernelsForLevel(level);
+    return true;
+}
+
+void setConvertThreadCount(size_t count) {
+    sThreadCount = std::min(count, kMaxConvertThreads);
+}
+
+const ConvertKernels &getConvertKernels() {
+    const ConvertKernels *kernels = sKernels;
+    if (kernels == nullptr) {
+        kernels = &kernelsForLevel(maxSimdLevel());
+        ALOGV("converting with simd level %d", maxSimdLevel());
+        sKernels = kernels;
+    }
+    return *kernels;
+}
+
+void forEachRowBand(size_t width, size_t height,
+                    const std::function<void(size_t, size_t)> &band) {
+    size_t threads = sThreadCount;
+    if (threads == 0) {
+        threads = defaultThreadCount();
+    }
+    const size_t numBands = std::min(threads, height / kMinBandRows);
+    if (numBands <= 1 || width * height < kMinParallelPixels) {
+        band(0, height);
+        return;
+    }
+
+    // An even number of rows per band.
+    const size_t bandRows = ((height + numBands - 1) / numBands + 1) & ~(size_t)1;
+    const std::function<void(size_t)> runBand = [&band, bandRows, height](size_t index) {
+        const size_t y0 = index * bandRows;
+        if (y0 < height) {
+            band(y0, std::min(y0 + bandRows, height));
+        }
+    };
+    if (!getRowBandWorkers().run(numBands, runBand)) {
+        band(0, height);
+    }
+}
+
+}  // namespace android
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONVERT_KERNELS_H_
+#define CONVERT_KERNELS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+
+namespace android {
+
+// Row kernels of the pixel format converters of SimpleC2Component.cpp. Each
+// one converts a whole row, and gives the same result as the original
+// scalar loop for any input, including values out of the 10 bit range.
+struct ConvertKernels {
+    // dst[x] = src[x] << 6
+    void (*shiftLeft6)(uint16_t *dst, const uint16_t *src, size_t width);
+    // dst[x] = src[x] >> 6
+    void (*shiftRight6)(uint16_t *dst, const uint16_t *src, size_t width);
+    // dst[x] = (uint8_t)(src[x] >> 2)
+    void (*narrow10To8)(uint8_t *dst, const uint16_t *src, size_t width);
+    // dstUV[2 * x] = srcU[x] << 6, dstUV[2 * x + 1] = srcV[x] << 6
+    void (*interleaveShiftLeft6)(uint16_t *dstUV, const uint16_t *srcU, const uint16_t *srcV,
+                                 size_t width);
+    // dstU[x] = srcUV[2 * x] >> 6, dstV[x] = srcUV[2 * x + 1] >> 6
+    void (*deinterleaveShiftRight6)(uint16_t *dstU, uint16_t *dstV, const uint16_t *srcUV,
+                                    size_t width);
+    // Two rows of Y410 sharing a row of 4:2:0 chroma.
+    void (*y410Rows)(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                     const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                     size_t width);
+    // Two rows of RGBA1010102 sharing a row of 4:2:0 chroma.
+    void (*rgba1010102Rows)(uint32_t *dstTop, uint32_t *dstBot, const uint16_t *srcYTop,
+                            const uint16_t *srcYBot, const uint16_t *srcU, const uint16_t *srcV,
+                            size_t width, const int32_t *coeffs);
+};
+
+// Indices of the coefficients passed to rgba1010102Rows.
+enum {
+    kCoeffY,
+    kCoeffRV,
+    kCoeffNegGU,
+    kCoeffNegGV,
+    kCoeffBU,
+    kCoeffC16,
+    kNumCoeffs,
+};
+
+// The kernels of the instruction set selected by setConvertSimdLevel(), or
+// of the best one the CPU supports.
+const ConvertKernels &getConvertKernels();
+
+// Calls band(y0, y1) over bands of rows covering [0, height). Bands start on
+// even rows, so that they hold whole rows of 4:2:0 chroma. Large frames are
+// split across worker threads, the calling thread converting one band.
+void forEachRowBand(size_t width, size_t height, const std::function<void(size_t, size_t)> &band);
+
+}  // namespace android
+
+#endif  // CONVERT_KERNELS_H_
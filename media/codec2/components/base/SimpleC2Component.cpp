@@ -19,6 +19,7 @@
 #include <log/log.h>
 
 #include <android/hardware_buffer.h>
+#include <android-base/file.h>
 #include <cutils/properties.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AUtils.h>
@@ -26,6 +27,9 @@
 #include <inttypes.h>
 #include <libyuv.h>
 
+#include <algorithm>
+#include <sstream>
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
@@ -33,6 +37,9 @@
 #include <Codec2CommonUtils.h>
 #include <SimpleC2Component.h>
 
+#include "ConvertKernels.h"
+#include "SimpleC2Executor.h"
+
 namespace android {
 
 // libyuv version required for I410ToAB30Matrix and I210ToAB30Matrix.
@@ -51,98 +58,36 @@ void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, con
                                 size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                 size_t dstUStride, size_t dstVStride, uint32_t width,
                                 uint32_t height, bool isMonochrome) {
-    for (size_t i = 0; i < height; ++i) {
-        memcpy(dstY, srcY, width);
-        srcY += srcYStride;
-        dstY += dstYStride;
-    }
-
-    if (isMonochrome) {
-        // Fill with neutral U/V values.
-        for (size_t i = 0; i < (height + 1) / 2; ++i) {
-            memset(dstV, kNeutralUVBitDepth8, (width + 1) / 2);
-            memset(dstU, kNeutralUVBitDepth8, (width + 1) / 2);
-            dstV += dstVStride;
-            dstU += dstUStride;
+    forEachRowBand(width, height, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            memcpy(dstY + y * dstYStride, srcY + y * srcYStride, width);
         }
-        return;
-    }
 
-    for (size_t i = 0; i < (height + 1) / 2; ++i) {
-        memcpy(dstV, srcV, (width + 1) / 2);
-        srcV += srcVStride;
-        dstV += dstVStride;
-    }
-
-    for (size_t i = 0; i < (height + 1) / 2; ++i) {
-        memcpy(dstU, srcU, (width + 1) / 2);
-        srcU += srcUStride;
-        dstU += dstUStride;
-    }
+        for (size_t y = y0 / 2; y < (y1 + 1) / 2; ++y) {
+            if (isMonochrome) {
+                // Fill with neutral U/V values.
+                memset(dstV + y * dstVStride, kNeutralUVBitDepth8, (width + 1) / 2);
+                memset(dstU + y * dstUStride, kNeutralUVBitDepth8, (width + 1) / 2);
+            } else {
+                memcpy(dstV + y * dstVStride, srcV + y * srcVStride, (width + 1) / 2);
+                memcpy(dstU + y * dstUStride, srcU + y * srcUStride, (width + 1) / 2);
+            }
+        }
+    });
 }
 
 void convertYUV420Planar16ToY410(uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
                                  const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
                                  size_t srcVStride, size_t dstStride, size_t width, size_t height) {
+    const ConvertKernels &kernels = getConvertKernels();
     // Converting two lines at a time, slightly faster
-    for (size_t y = 0; y < height; y += 2) {
-        uint32_t *dstTop = (uint32_t *)dst;
-        uint32_t *dstBot = (uint32_t *)(dst + dstStride);
-        uint16_t *ySrcTop = (uint16_t *)srcY;
-        uint16_t *ySrcBot = (uint16_t *)(srcY + srcYStride);
-        uint16_t *uSrc = (uint16_t *)srcU;
-        uint16_t *vSrc = (uint16_t *)srcV;
-
-        uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
-        size_t x = 0;
-        for (; x < width - 3; x += 4) {
-            u01 = *((uint32_t *)uSrc);
-            uSrc += 2;
-            v01 = *((uint32_t *)vSrc);
-            vSrc += 2;
-
-            y01 = *((uint32_t *)ySrcTop);
-            ySrcTop += 2;
-            y23 = *((uint32_t *)ySrcTop);
-            ySrcTop += 2;
-            y45 = *((uint32_t *)ySrcBot);
-            ySrcBot += 2;
-            y67 = *((uint32_t *)ySrcBot);
-            ySrcBot += 2;
-
-            uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
-            uv1 = (u01 >> 16) | ((v01 >> 16) << 20);
-
-            *dstTop++ = 3 << 30 | ((y01 & 0x3FF) << 10) | uv0;
-            *dstTop++ = 3 << 30 | ((y01 >> 16) << 10) | uv0;
-            *dstTop++ = 3 << 30 | ((y23 & 0x3FF) << 10) | uv1;
-            *dstTop++ = 3 << 30 | ((y23 >> 16) << 10) | uv1;
-
-            *dstBot++ = 3 << 30 | ((y45 & 0x3FF) << 10) | uv0;
-            *dstBot++ = 3 << 30 | ((y45 >> 16) << 10) | uv0;
-            *dstBot++ = 3 << 30 | ((y67 & 0x3FF) << 10) | uv1;
-            *dstBot++ = 3 << 30 | ((y67 >> 16) << 10) | uv1;
+    forEachRowBand(width, height, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; y += 2) {
+            kernels.y410Rows(dst + y * dstStride, dst + (y + 1) * dstStride,
+                             srcY + y * srcYStride, srcY + (y + 1) * srcYStride,
+                             srcU + y / 2 * srcUStride, srcV + y / 2 * srcVStride, width);
         }
-
-        // There should be at most 2 more pixels to process. Note that we don't
-        // need to consider odd case as the buffer is always aligned to even.
-        if (x < width) {
-            u01 = *uSrc;
-            v01 = *vSrc;
-            y01 = *((uint32_t *)ySrcTop);
-            y45 = *((uint32_t *)ySrcBot);
-            uv0 = (u01 & 0x3FF) | ((v01 & 0x3FF) << 20);
-            *dstTop++ = ((y01 & 0x3FF) << 10) | uv0;
-            *dstTop++ = ((y01 >> 16) << 10) | uv0;
-            *dstBot++ = ((y45 & 0x3FF) << 10) | uv0;
-            *dstBot++ = ((y45 >> 16) << 10) | uv0;
-        }
-
-        srcY += srcYStride * 2;
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dst += dstStride * 2;
-    }
+    });
 }
 
 namespace {
@@ -257,86 +202,21 @@ void convertYUV420Planar16ToRGBA1010102(
 
     struct Coeffs coeffs = GetCoeffsForAspects(_aspects);
 
-    int32_t _y = coeffs._y;
-    int32_t _b_u = coeffs._b_u;
-    int32_t _neg_g_u = -coeffs._g_u;
-    int32_t _neg_g_v = -coeffs._g_v;
-    int32_t _r_v = coeffs._r_v;
-    int32_t _c16 = coeffs._c16;
+    // In the kCoeff* order of ConvertKernels.h
+    const int32_t kernelCoeffs[kNumCoeffs] = {
+            coeffs._y, coeffs._r_v, -coeffs._g_u, -coeffs._g_v, coeffs._b_u, coeffs._c16,
+    };
 
+    const ConvertKernels &kernels = getConvertKernels();
     // Converting two lines at a time, slightly faster
-    for (size_t y = 0; y < height; y += 2) {
-        uint32_t *dstTop = (uint32_t *)dst;
-        uint32_t *dstBot = (uint32_t *)(dst + dstStride);
-        uint16_t *ySrcTop = (uint16_t *)srcY;
-        uint16_t *ySrcBot = (uint16_t *)(srcY + srcYStride);
-        uint16_t *uSrc = (uint16_t *)srcU;
-        uint16_t *vSrc = (uint16_t *)srcV;
-
-        for (size_t x = 0; x < width; x += 2) {
-            int32_t u, v, y00, y01, y10, y11;
-            u = *uSrc - 512;
-            uSrc += 1;
-            v = *vSrc - 512;
-            vSrc += 1;
-
-            y00 = *ySrcTop - _c16;
-            ySrcTop += 1;
-            y01 = *ySrcTop - _c16;
-            ySrcTop += 1;
-            y10 = *ySrcBot - _c16;
-            ySrcBot += 1;
-            y11 = *ySrcBot - _c16;
-            ySrcBot += 1;
-
-            int32_t u_b = u * _b_u;
-            int32_t u_g = u * _neg_g_u;
-            int32_t v_g = v * _neg_g_v;
-            int32_t v_r = v * _r_v;
-
-            int32_t yMult, b, g, r;
-            yMult = y00 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y01 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y10 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y11 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
+    forEachRowBand(width, height, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; y += 2) {
+            kernels.rgba1010102Rows(dst + y * dstStride, dst + (y + 1) * dstStride,
+                                    srcY + y * srcYStride, srcY + (y + 1) * srcYStride,
+                                    srcU + y / 2 * srcUStride, srcV + y / 2 * srcVStride, width,
+                                    kernelCoeffs);
         }
-
-        srcY += srcYStride * 2;
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dst += dstStride * 2;
-    }
+    });
 }
 
 void convertYUV420Planar16ToY410OrRGBA1010102(
@@ -359,35 +239,25 @@ void convertYUV420Planar16ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, co
                                  size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = (uint8_t)(srcY[x] >> 2);
-        }
-        srcY += srcYStride;
-        dstY += dstYStride;
-    }
-
-    if (isMonochrome) {
-        // Fill with neutral U/V values.
-        for (size_t y = 0; y < (height + 1) / 2; ++y) {
-            memset(dstV, kNeutralUVBitDepth8, (width + 1) / 2);
-            memset(dstU, kNeutralUVBitDepth8, (width + 1) / 2);
-            dstV += dstUVStride;
-            dstU += dstUVStride;
+    const ConvertKernels &kernels = getConvertKernels();
+    forEachRowBand(width, height, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            kernels.narrow10To8(dstY + y * dstYStride, srcY + y * srcYStride, width);
         }
-        return;
-    }
 
-    for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstU[x] = (uint8_t)(srcU[x] >> 2);
-            dstV[x] = (uint8_t)(srcV[x] >> 2);
+        for (size_t y = y0 / 2; y < (y1 + 1) / 2; ++y) {
+            if (isMonochrome) {
+                // Fill with neutral U/V values.
+                memset(dstV + y * dstUVStride, kNeutralUVBitDepth8, (width + 1) / 2);
+                memset(dstU + y * dstUVStride, kNeutralUVBitDepth8, (width + 1) / 2);
+            } else {
+                kernels.narrow10To8(dstU + y * dstUVStride, srcU + y * srcUStride,
+                                    (width + 1) / 2);
+                kernels.narrow10To8(dstV + y * dstUVStride, srcV + y * srcVStride,
+                                    (width + 1) / 2);
+            }
         }
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dstU += dstUVStride;
-        dstV += dstUVStride;
-    }
+    });
 }
 
 void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t *srcY,
@@ -395,35 +265,23 @@ void convertYUV420Planar16ToP010(uint16_t *dstY, uint16_t *dstUV, const uint16_t
                                  size_t srcUStride, size_t srcVStride, size_t dstYStride,
                                  size_t dstUVStride, size_t width, size_t height,
                                  bool isMonochrome) {
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = srcY[x] << 6;
+    const ConvertKernels &kernels = getConvertKernels();
+    forEachRowBand(width, height, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            kernels.shiftLeft6(dstY + y * dstYStride, srcY + y * srcYStride, width);
         }
-        srcY += srcYStride;
-        dstY += dstYStride;
-    }
 
-    if (isMonochrome) {
-        // Fill with neutral U/V values.
-        for (size_t y = 0; y < (height + 1) / 2; ++y) {
-            for (size_t x = 0; x < (width + 1) / 2; ++x) {
-                dstUV[2 * x] = kNeutralUVBitDepth10 << 6;
-                dstUV[2 * x + 1] = kNeutralUVBitDepth10 << 6;
+        for (size_t y = y0 / 2; y < (y1 + 1) / 2; ++y) {
+            uint16_t *dstUVRow = dstUV + y * dstUVStride;
+            if (isMonochrome) {
+                // Fill with neutral U/V values.
+                std::fill_n(dstUVRow, 2 * ((width + 1) / 2), kNeutralUVBitDepth10 << 6);
+            } else {
+                kernels.interleaveShiftLeft6(dstUVRow, srcU + y * srcUStride,
+                                             srcV + y * srcVStride, (width + 1) / 2);
             }
-            dstUV += dstUVStride;
-        }
-        return;
-    }
-
-    for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstUV[2 * x] = srcU[x] << 6;
-            dstUV[2 * x + 1] = srcV[x] << 6;
         }
-        srcU += srcUStride;
-        srcV += srcVStride;
-        dstUV += dstUVStride;
-    }
+    });
 }
 
 void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
@@ -431,36 +289,23 @@ void convertP010ToYUV420Planar16(uint16_t *dstY, uint16_t *dstU, uint16_t *dstV,
                                  size_t srcYStride, size_t srcUVStride, size_t dstYStride,
                                  size_t dstUStride, size_t dstVStride, size_t width,
                                  size_t height, bool isMonochrome) {
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            dstY[x] = srcY[x] >> 6;
+    const ConvertKernels &kernels = getConvertKernels();
+    forEachRowBand(width, height, [&](size_t y0, size_t y1) {
+        for (size_t y = y0; y < y1; ++y) {
+            kernels.shiftRight6(dstY + y * dstYStride, srcY + y * srcYStride, width);
         }
-        srcY += srcYStride;
-        dstY += dstYStride;
-    }
 
-    if (isMonochrome) {
-        // Fill with neutral U/V values.
-        for (size_t y = 0; y < (height + 1) / 2; ++y) {
-            for (size_t x = 0; x < (width + 1) / 2; ++x) {
-                dstU[x] = kNeutralUVBitDepth10;
-                dstV[x] = kNeutralUVBitDepth10;
+        for (size_t y = y0 / 2; y < (y1 + 1) / 2; ++y) {
+            if (isMonochrome) {
+                // Fill with neutral U/V values.
+                std::fill_n(dstU + y * dstUStride, (width + 1) / 2, kNeutralUVBitDepth10);
+                std::fill_n(dstV + y * dstVStride, (width + 1) / 2, kNeutralUVBitDepth10);
+            } else {
+                kernels.deinterleaveShiftRight6(dstU + y * dstUStride, dstV + y * dstVStride,
+                                                srcUV + y * srcUVStride, (width + 1) / 2);
             }
-            dstU += dstUStride;
-            dstV += dstVStride;
-        }
-        return;
-    }
-
-    for (size_t y = 0; y < (height + 1) / 2; ++y) {
-        for (size_t x = 0; x < (width + 1) / 2; ++x) {
-            dstU[x] = srcUV[2 * x] >> 6;
-            dstV[x] = srcUV[2 * x + 1] >> 6;
         }
-        dstU += dstUStride;
-        dstV += dstVStride;
-        srcUV += srcUVStride;
-    }
+    });
 }
 
 static const int16_t bt709Matrix_10bit[2][3][3] = {
@@ -638,7 +483,7 @@ std::unique_ptr<C2Work> SimpleC2Component::WorkQueue::pop_front() {
 }
 
 void SimpleC2Component::WorkQueue::push_back(std::unique_ptr<C2Work> work) {
-    mQueue.push_back({ std::move(work), NO_DRAIN });
+    mQueue.push_back({ std::move(work), NO_DRAIN, std::chrono::steady_clock::now() });
 }
 
 bool SimpleC2Component::WorkQueue::empty() const {
@@ -653,88 +498,15 @@ uint32_t SimpleC2Component::WorkQueue::drainMode() const {
     return mQueue.front().drainMode;
 }
 
-void SimpleC2Component::WorkQueue::markDrain(uint32_t drainMode) {
-    mQueue.push_back({ nullptr, drainMode });
+std::chrono::steady_clock::time_point SimpleC2Component::WorkQueue::queuedAt() const {
+    return mQueue.front().queuedAt;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-
-SimpleC2Component::WorkHandler::WorkHandler() : mRunning(false) {}
-
-void SimpleC2Component::WorkHandler::setComponent(
-        const std::shared_ptr<SimpleC2Component> &thiz) {
-    mThiz = thiz;
-}
-
-static void Reply(const sp<AMessage> &msg, int32_t *err = nullptr) {
-    sp<AReplyToken> replyId;
-    CHECK(msg->senderAwaitsResponse(&replyId));
-    sp<AMessage> reply = new AMessage;
-    if (err) {
-        reply->setInt32("err", *err);
-    }
-    reply->postReply(replyId);
+void SimpleC2Component::WorkQueue::markDrain(uint32_t drainMode) {
+    mQueue.push_back({ nullptr, drainMode, std::chrono::steady_clock::now() });
 }
 
-void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg) {
-    std::shared_ptr<SimpleC2Component> thiz = mThiz.lock();
-    if (!thiz) {
-        ALOGD("component not yet set; msg = %s", msg->debugString().c_str());
-        sp<AReplyToken> replyId;
-        if (msg->senderAwaitsResponse(&replyId)) {
-            sp<AMessage> reply = new AMessage;
-            reply->setInt32("err", C2_CORRUPTED);
-            reply->postReply(replyId);
-        }
-        return;
-    }
-
-    switch (msg->what()) {
-        case kWhatProcess: {
-            if (mRunning) {
-                if (thiz->processQueue()) {
-                    (new AMessage(kWhatProcess, this))->post();
-                }
-            } else {
-                ALOGV("Ignore process message as we're not running");
-            }
-            break;
-        }
-        case kWhatInit: {
-            int32_t err = thiz->onInit();
-            Reply(msg, &err);
-            [[fallthrough]];
-        }
-        case kWhatStart: {
-            mRunning = true;
-            break;
-        }
-        case kWhatStop: {
-            int32_t err = thiz->onStop();
-            thiz->mOutputBlockPool.reset();
-            Reply(msg, &err);
-            break;
-        }
-        case kWhatReset: {
-            thiz->onReset();
-            thiz->mOutputBlockPool.reset();
-            mRunning = false;
-            Reply(msg);
-            break;
-        }
-        case kWhatRelease: {
-            thiz->onRelease();
-            thiz->mOutputBlockPool.reset();
-            mRunning = false;
-            Reply(msg);
-            break;
-        }
-        default: {
-            ALOGD("Unrecognized msg: %d", msg->what());
-            break;
-        }
-    }
-}
+////////////////////////////////////////////////////////////////////////////////
 
 class SimpleC2Component::BlockingBlockPool : public C2BlockPool {
 public:
@@ -752,10 +524,13 @@ public:
             uint32_t capacity,
             C2MemoryUsage usage,
             std::shared_ptr<C2LinearBlock>* block) {
-        c2_status_t status;
-        do {
-            status = mBase->fetchLinearBlock(capacity, usage, block);
-        } while (status == C2_BLOCKING);
+        c2_status_t status = mBase->fetchLinearBlock(capacity, usage, block);
+        if (status == C2_BLOCKING) {
+            SimpleC2Executor::ScopedBlocking blocking;
+            do {
+                status = mBase->fetchLinearBlock(capacity, usage, block);
+            } while (status == C2_BLOCKING);
+        }
         return status;
     }
 
@@ -763,10 +538,13 @@ public:
             uint32_t capacity,
             C2MemoryUsage usage,
             std::shared_ptr<C2CircularBlock>* block) {
-        c2_status_t status;
-        do {
-            status = mBase->fetchCircularBlock(capacity, usage, block);
-        } while (status == C2_BLOCKING);
+        c2_status_t status = mBase->fetchCircularBlock(capacity, usage, block);
+        if (status == C2_BLOCKING) {
+            SimpleC2Executor::ScopedBlocking blocking;
+            do {
+                status = mBase->fetchCircularBlock(capacity, usage, block);
+            } while (status == C2_BLOCKING);
+        }
         return status;
     }
 
@@ -774,11 +552,16 @@ public:
             uint32_t width, uint32_t height, uint32_t format,
             C2MemoryUsage usage,
             std::shared_ptr<C2GraphicBlock>* block) {
-        c2_status_t status;
-        do {
-            status = mBase->fetchGraphicBlock(width, height, format, usage,
-                                              block);
-        } while (status == C2_BLOCKING);
+        c2_status_t status = mBase->fetchGraphicBlock(width, height, format, usage, block);
+        if (status == C2_BLOCKING) {
+            // Waiting for the client to return output buffers can take long,
+            // so let another worker run the other components meanwhile.
+            SimpleC2Executor::ScopedBlocking blocking;
+            do {
+                status = mBase->fetchGraphicBlock(width, height, format, usage,
+                                                  block);
+            } while (status == C2_BLOCKING);
+        }
         return status;
     }
 
@@ -800,22 +583,37 @@ SimpleC2Component::SimpleC2Component(
         const std::shared_ptr<C2ComponentInterface> &intf)
     : mDummyReadView(DummyReadView()),
       mIntf(intf),
-      mLooper(new ALooper),
-      mHandler(new WorkHandler) {
-    mLooper->setName(intf->getName().c_str());
-    (void)mLooper->registerHandler(mHandler);
-    mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
+      mSerialQueue(SimpleC2SerialQueue::Create(intf->getName())),
+      mRunning(false) {
 }
 
-SimpleC2Component::~SimpleC2Component() {
-    mLooper->unregisterHandler(mHandler->id());
-    (void)mLooper->stop();
+SimpleC2Component::~SimpleC2Component() {}
+
+void SimpleC2Component::requestProcess() {
+    mSerialQueue->requestProcess([weakThiz = weak_from_this()] {
+        std::shared_ptr<SimpleC2Component> thiz = weakThiz.lock();
+        if (!thiz) {
+            return false;
+        }
+        if (!thiz->mRunning) {
+            ALOGV("Ignore process request as we're not running");
+            return false;
+        }
+        return thiz->processQueue();
+    });
+}
+
+void SimpleC2Component::updatePriority() {
+    C2RealTimePriorityTuning priority(0);
+    std::vector<std::unique_ptr<C2Param>> heapParams;
+    c2_status_t err = intf()->query_vb({ &priority }, {}, C2_DONT_BLOCK, &heapParams);
+    mSerialQueue->setPriority((err == C2_OK && priority.value < 0)
+                                      ? SimpleC2SerialQueue::PRIORITY_BATCH
+                                      : SimpleC2SerialQueue::PRIORITY_REALTIME);
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
         const std::shared_ptr<C2Component::Listener> &listener, c2_blocking_t mayBlock) {
-    mHandler->setComponent(shared_from_this());
-
     Mutexed<ExecState>::Locked state(mExecState);
     if (state->mState == RUNNING) {
         if (listener) {
@@ -847,7 +645,7 @@ c2_status_t SimpleC2Component::queue_nb(std::list<std::unique_ptr<C2Work>> * con
         }
     }
     if (queueWasEmpty) {
-        (new AMessage(WorkHandler::kWhatProcess, mHandler))->post();
+        requestProcess();
     }
     return C2_OK;
 }
@@ -902,7 +700,7 @@ c2_status_t SimpleC2Component::drain_nb(drain_mode_t drainMode) {
         queue->markDrain(drainMode);
     }
     if (queueWasEmpty) {
-        (new AMessage(WorkHandler::kWhatProcess, mHandler))->post();
+        requestProcess();
     }
 
     return C2_OK;
@@ -915,16 +713,23 @@ c2_status_t SimpleC2Component::start() {
     }
     bool needsInit = (state->mState == UNINITIALIZED);
     state.unlock();
+    updatePriority();
     if (needsInit) {
-        sp<AMessage> reply;
-        (new AMessage(WorkHandler::kWhatInit, mHandler))->postAndAwaitResponse(&reply);
-        int32_t err;
-        CHECK(reply->findInt32("err", &err));
+        c2_status_t err = C2_OK;
+        mSerialQueue->postAndWait([this, &err] {
+            err = onInit();
+            mRunning = true;
+        });
         if (err != C2_OK) {
-            return (c2_status_t)err;
+            return err;
         }
     } else {
-        (new AMessage(WorkHandler::kWhatStart, mHandler))->post();
+        mSerialQueue->post([weakThiz = weak_from_this()] {
+            std::shared_ptr<SimpleC2Component> thiz = weakThiz.lock();
+            if (thiz) {
+                thiz->mRunning = true;
+            }
+        });
     }
     state.lock();
     state->mState = RUNNING;
@@ -945,14 +750,12 @@ c2_status_t SimpleC2Component::stop() {
         queue->clear();
         queue->pending().clear();
     }
-    sp<AMessage> reply;
-    (new AMessage(WorkHandler::kWhatStop, mHandler))->postAndAwaitResponse(&reply);
-    int32_t err;
-    CHECK(reply->findInt32("err", &err));
-    if (err != C2_OK) {
-        return (c2_status_t)err;
-    }
-    return C2_OK;
+    c2_status_t err = C2_OK;
+    mSerialQueue->postAndWait([this, &err] {
+        err = onStop();
+        mOutputBlockPool.reset();
+    });
+    return err;
 }
 
 c2_status_t SimpleC2Component::reset() {
@@ -966,15 +769,21 @@ c2_status_t SimpleC2Component::reset() {
         queue->clear();
         queue->pending().clear();
     }
-    sp<AMessage> reply;
-    (new AMessage(WorkHandler::kWhatReset, mHandler))->postAndAwaitResponse(&reply);
+    mSerialQueue->postAndWait([this] {
+        onReset();
+        mOutputBlockPool.reset();
+        mRunning = false;
+    });
     return C2_OK;
 }
 
 c2_status_t SimpleC2Component::release() {
     ALOGV("release");
-    sp<AMessage> reply;
-    (new AMessage(WorkHandler::kWhatRelease, mHandler))->postAndAwaitResponse(&reply);
+    mSerialQueue->postAndWait([this] {
+        onRelease();
+        mOutputBlockPool.reset();
+        mRunning = false;
+    });
     return C2_OK;
 }
 
@@ -1053,6 +862,7 @@ bool SimpleC2Component::processQueue() {
         generation = queue->generation();
         drainMode = queue->drainMode();
         isFlushPending = queue->popPendingFlush();
+        mSerialQueue->recordWorkLatency(std::chrono::steady_clock::now() - queue->queuedAt());
         work = queue->pop_front();
         hasQueuedWork = !queue->empty();
     }
@@ -1134,6 +944,7 @@ bool SimpleC2Component::processQueue() {
             std::vector<std::unique_ptr<C2SettingResult>> failures;
             c2_status_t err = intf()->config_vb(updates, C2_MAY_BLOCK, &failures);
             ALOGD("applied %zu configUpdates => %s (%d)", updates.size(), asString(err), err);
+            updatePriority();
         }
     }
 
@@ -1233,4 +1044,12 @@ std::shared_ptr<C2Buffer> SimpleC2Component::createGraphicBuffer(
     return C2Buffer::CreateGraphicBuffer(block->share(crop, ::C2Fence()));
 }
 
+void DumpSimpleC2Components(int fd) {
+    std::ostringstream out;
+    SimpleC2Executor::Get().dump(out);
+    if (!base::WriteStringToFd(out.str(), fd)) {
+        ALOGW("failed to write dump");
+    }
+}
+
 } // namespace android
@@ -0,0 +1,443 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2Executor"
+#include <log/log.h>
+
+#include <utils/AndroidThreads.h>
+#include <utils/ThreadDefs.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <thread>
+
+#include "SimpleC2Executor.h"
+
+namespace android {
+
+namespace {
+
+// Most workers ever running, including those started to stand in for blocked
+// workers.
+constexpr size_t kMaxWorkers = 64;
+
+// Workers beyond the core ones exit after being idle for this long.
+constexpr std::chrono::seconds kSpareWorkerIdleTimeout(3);
+
+// Workers running a task for this long count as blocked, as they are most
+// likely waiting on a fence, an allocation or another process.
+constexpr std::chrono::milliseconds kStallTimeout(50);
+
+// Worker thread priority of each SimpleC2SerialQueue::priority_t.
+constexpr int kThreadPriorities[SimpleC2SerialQueue::NUM_PRIORITIES] = {
+    ANDROID_PRIORITY_VIDEO,
+    ANDROID_PRIORITY_NORMAL,
+};
+
+thread_local SimpleC2SerialQueue *tCurrentQueue = nullptr;
+thread_local void *tWorker = nullptr;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t coreWorkerCount() {
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+}
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SimpleC2SerialQueue::Latency::add(std::chrono::nanoseconds latency) {
+    ++mCount;
+    mTotal += latency;
+    mMax = std::max(mMax, latency);
+}
+
+void SimpleC2SerialQueue::Latency::dump(std::ostream &out, const char *what) const {
+    using ms = std::chrono::duration<double, std::milli>;
+    out << what << " latency: ";
+    if (mCount == 0) {
+        out << "n/a";
+        return;
+    }
+    out << std::fixed << std::setprecision(2) << "avg " << ms(mTotal / mCount).count()
+        << " ms, max " << ms(mMax).count() << " ms over " << mCount;
+}
+
+// static
+std::shared_ptr<SimpleC2SerialQueue> SimpleC2SerialQueue::Create(const std::string &name) {
+    std::shared_ptr<SimpleC2SerialQueue> queue(new SimpleC2SerialQueue(name));
+    SimpleC2Executor::Get().registerQueue(queue);
+    return queue;
+}
+
+SimpleC2SerialQueue::SimpleC2SerialQueue(const std::string &name)
+    : mName(name),
+      mPriority(PRIORITY_REALTIME),
+      mScheduled(false),
+      mProcessQueued(false) {}
+
+void SimpleC2SerialQueue::push(Task task) {
+    const bool isProcess = (task.process != nullptr);
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (isProcess && mProcessQueued) {
+            return;
+        }
+        mProcessQueued = isProcess;
+        mTasks.push_back(std::move(task));
+        if (mScheduled) {
+            return;
+        }
+        mScheduled = true;
+    }
+    SimpleC2Executor::Get().schedule(shared_from_this());
+}
+
+void SimpleC2SerialQueue::post(std::function<void()> task) {
+    push({ std::move(task), nullptr, std::chrono::steady_clock::now() });
+}
+
+void SimpleC2SerialQueue::postAndWait(std::function<void()> task) {
+    if (tCurrentQueue == this) {
+        task();
+        return;
+    }
+    std::mutex lock;
+    std::condition_variable cond;
+    bool done = false;
+    post([&task, &lock, &cond, &done] {
+        task();
+        std::lock_guard<std::mutex> l(lock);
+        done = true;
+        cond.notify_one();
+    });
+    SimpleC2Executor::ScopedBlocking blocking;
+    std::unique_lock<std::mutex> l(lock);
+    cond.wait(l, [&done] { return done; });
+}
+
+void SimpleC2SerialQueue::requestProcess(std::function<bool()> process) {
+    push({ nullptr, std::move(process), std::chrono::steady_clock::now() });
+}
+
+void SimpleC2SerialQueue::recordWorkLatency(std::chrono::nanoseconds latency) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mWorkLatency.add(latency);
+}
+
+bool SimpleC2SerialQueue::runOne() {
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mTasks.empty()) {
+            mScheduled = false;
+            return false;
+        }
+        task = std::move(mTasks.front());
+        mTasks.pop_front();
+        if (mTasks.empty()) {
+            mProcessQueued = false;
+        }
+        mDispatchLatency.add(std::chrono::steady_clock::now() - task.queuedAt);
+    }
+
+    SimpleC2SerialQueue *previous = tCurrentQueue;
+    tCurrentQueue = this;
+    if (task.fn) {
+        task.fn();
+    } else if (task.process()) {
+        requestProcess(std::move(task.process));
+    }
+    tCurrentQueue = previous;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mTasks.empty()) {
+        mScheduled = false;
+        return false;
+    }
+    return true;
+}
+
+void SimpleC2SerialQueue::dump(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(mLock);
+    out << mName << " ("
+        << (mPriority == PRIORITY_REALTIME ? "realtime" : "batch") << "): "
+        << mTasks.size() << " tasks queued" << std::endl;
+    out << "      ";
+    mWorkLatency.dump(out, "work");
+    out << std::endl << "      ";
+    mDispatchLatency.dump(out, "dispatch");
+    out << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SimpleC2Executor::ScopedBlocking::ScopedBlocking() : mIsWorker(tWorker != nullptr) {
+    if (!mIsWorker) {
+        return;
+    }
+    SimpleC2Executor &executor = Get();
+    std::lock_guard<std::mutex> lock(executor.mLock);
+    ++static_cast<Worker *>(tWorker)->mNumBlocked;
+    ++executor.mNumBlocked;
+    if (executor.mQueued > 0) {
+        executor.wake_l();
+    }
+}
+
+SimpleC2Executor::ScopedBlocking::~ScopedBlocking() {
+    if (!mIsWorker) {
+        return;
+    }
+    SimpleC2Executor &executor = Get();
+    std::lock_guard<std::mutex> lock(executor.mLock);
+    --static_cast<Worker *>(tWorker)->mNumBlocked;
+    --executor.mNumBlocked;
+}
+
+// static
+SimpleC2Executor &SimpleC2Executor::Get() {
+    // Never destroyed, as detached workers may still be running at exit.
+    static SimpleC2Executor *sExecutor = new SimpleC2Executor;
+    return *sExecutor;
+}
+
+SimpleC2Executor::SimpleC2Executor()
+    : mCoreWorkers(coreWorkerCount()),
+      mQueued(0),
+      mWorkers(new Worker[kMaxWorkers]),
+      mNumSlots(0),
+      mNumRunning(0),
+      mNumIdle(0),
+      mNumBlocked(0),
+      mMonitorRunning(false) {}
+
+void SimpleC2Executor::registerQueue(const std::shared_ptr<SimpleC2SerialQueue> &queue) {
+    std::lock_guard<std::mutex> lock(mQueuesLock);
+    mQueues.remove_if([](const std::weak_ptr<SimpleC2SerialQueue> &q) { return q.expired(); });
+    mQueues.push_back(queue);
+}
+
+void SimpleC2Executor::schedule(const std::shared_ptr<SimpleC2SerialQueue> &queue) {
+    const SimpleC2SerialQueue::priority_t priority = queue->priority();
+    // Counted before being pushed, so that it never goes below the number of
+    // queues that can be found.
+    ++mQueued;
+    Worker *worker = static_cast<Worker *>(tWorker);
+    if (worker) {
+        std::lock_guard<std::mutex> lock(worker->mLock);
+        worker->mReady[priority].push_back(queue);
+    } else {
+        std::lock_guard<std::mutex> lock(mInjectLock);
+        mInjected[priority].push_back(queue);
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    wake_l();
+}
+
+void SimpleC2Executor::wake_l() {
+    if (mNumIdle > 0) {
+        mCond.notify_one();
+    } else if (mNumRunning - mNumBlocked < mCoreWorkers) {
+        startWorker_l();
+    } else if (!mMonitorRunning) {
+        mMonitorRunning = true;
+        std::thread(&SimpleC2Executor::monitorLoop, this).detach();
+    } else {
+        mMonitorCond.notify_one();
+    }
+}
+
+size_t SimpleC2Executor::numStalled_l() const {
+    const int64_t stalledBefore = nowNs() -
+            std::chrono::duration_cast<std::chrono::nanoseconds>(kStallTimeout).count();
+    size_t numStalled = 0;
+    for (size_t i = 0; i < mNumSlots; ++i) {
+        const Worker &worker = mWorkers[i];
+        // Blocked workers are already counted in mNumBlocked.
+        if (!worker.mRunning || worker.mNumBlocked > 0) {
+            continue;
+        }
+        const int64_t busySince = worker.mBusySinceNs;
+        if (busySince != 0 && busySince < stalledBefore) {
+            ++numStalled;
+        }
+    }
+    return numStalled;
+}
+
+void SimpleC2Executor::monitorLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        if (mQueued == 0 || mNumIdle > 0) {
+            mMonitorCond.wait(lock);
+            continue;
+        }
+        mMonitorCond.wait_for(lock, kStallTimeout);
+        if (mQueued > 0 && mNumIdle == 0
+                && mNumRunning < mCoreWorkers + mNumBlocked + numStalled_l()) {
+            ALOGV("workers stalled with %zu queues ready", (size_t)mQueued);
+            startWorker_l();
+        }
+    }
+}
+
+std::shared_ptr<SimpleC2SerialQueue> SimpleC2Executor::findWork(Worker *self) {
+    const size_t numSlots = mNumSlots;
+    const size_t selfIndex = self - mWorkers.get();
+    for (size_t priority = 0; priority < SimpleC2SerialQueue::NUM_PRIORITIES; ++priority) {
+        std::shared_ptr<SimpleC2SerialQueue> queue;
+        {
+            std::lock_guard<std::mutex> lock(self->mLock);
+            std::deque<std::shared_ptr<SimpleC2SerialQueue>> &ready = self->mReady[priority];
+            if (!ready.empty()) {
+                queue = std::move(ready.front());
+                ready.pop_front();
+            }
+        }
+        if (!queue) {
+            std::lock_guard<std::mutex> lock(mInjectLock);
+            std::deque<std::shared_ptr<SimpleC2SerialQueue>> &ready = mInjected[priority];
+            if (!ready.empty()) {
+                queue = std::move(ready.front());
+                ready.pop_front();
+            }
+        }
+        // Steal from the back of the other workers' deques, starting next to
+        // this one so that thieves spread out.
+        for (size_t i = 1; !queue && i < numSlots; ++i) {
+            Worker *victim = &mWorkers[(selfIndex + i) % numSlots];
+            std::lock_guard<std::mutex> lock(victim->mLock);
+            std::deque<std::shared_ptr<SimpleC2SerialQueue>> &ready = victim->mReady[priority];
+            if (!ready.empty()) {
+                queue = std::move(ready.back());
+                ready.pop_back();
+            }
+        }
+        if (queue) {
+            --mQueued;
+            return queue;
+        }
+    }
+    return nullptr;
+}
+
+void SimpleC2Executor::startWorker_l() {
+    if (mNumRunning >= kMaxWorkers) {
+        return;
+    }
+    size_t index = 0;
+    while (mWorkers[index].mRunning) {
+        ++index;
+    }
+    Worker *worker = &mWorkers[index];
+    worker->mRunning = true;
+    ++mNumRunning;
+    if (index >= mNumSlots) {
+        mNumSlots = index + 1;
+    }
+    ALOGV("starting worker %zu, %zu running", index, mNumRunning);
+    std::thread(&SimpleC2Executor::workerLoop, this, worker).detach();
+}
+
+void SimpleC2Executor::workerLoop(Worker *self) {
+    tWorker = self;
+    int threadPriority = kThreadPriorities[SimpleC2SerialQueue::PRIORITY_REALTIME];
+    androidSetThreadPriority(0, threadPriority);
+
+    while (true) {
+        std::shared_ptr<SimpleC2SerialQueue> queue = findWork(self);
+        if (!queue) {
+            std::unique_lock<std::mutex> lock(mLock);
+            if (mQueued > 0) {
+                continue;
+            }
+            const bool isSpare = mNumRunning - mNumBlocked > mCoreWorkers;
+            ++mNumIdle;
+            bool timedOut = false;
+            if (isSpare) {
+                timedOut = mCond.wait_for(lock, kSpareWorkerIdleTimeout) ==
+                        std::cv_status::timeout;
+            } else {
+                mCond.wait(lock);
+            }
+            --mNumIdle;
+            if (timedOut && mQueued == 0 && mNumRunning - mNumBlocked > mCoreWorkers) {
+                ALOGV("spare worker %zu exiting", (size_t)(self - mWorkers.get()));
+                self->mRunning = false;
+                --mNumRunning;
+                return;
+            }
+            continue;
+        }
+
+        const int wanted = kThreadPriorities[queue->priority()];
+        if (wanted != threadPriority) {
+            threadPriority = wanted;
+            androidSetThreadPriority(0, threadPriority);
+        }
+        self->mBusySinceNs = nowNs();
+        const bool more = queue->runOne();
+        self->mBusySinceNs = 0;
+        if (more) {
+            // Keep it on this worker, where its data is likely still cached,
+            // but let idle workers steal it if others are waiting here too.
+            const SimpleC2SerialQueue::priority_t priority = queue->priority();
+            size_t numReady = 0;
+            ++mQueued;
+            {
+                std::lock_guard<std::mutex> lock(self->mLock);
+                self->mReady[priority].push_back(std::move(queue));
+                for (const auto &ready : self->mReady) {
+                    numReady += ready.size();
+                }
+            }
+            if (numReady > 1) {
+                std::lock_guard<std::mutex> lock(mLock);
+                if (mNumIdle > 0) {
+                    mCond.notify_one();
+                }
+            }
+        }
+    }
+}
+
+void SimpleC2Executor::dump(std::ostream &out) {
+    constexpr const char indent[] = "  ";
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        out << "SimpleC2Executor: " << mNumRunning << " workers (" << mNumIdle << " idle, "
+            << mNumBlocked << " blocked, " << numStalled_l() << " stalled, "
+            << mCoreWorkers << " core), " << mQueued
+            << " queues ready" << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(mQueuesLock);
+    for (const std::weak_ptr<SimpleC2SerialQueue> &weak : mQueues) {
+        std::shared_ptr<SimpleC2SerialQueue> queue = weak.lock();
+        if (queue) {
+            out << indent << indent;
+            queue->dump(out);
+        }
+    }
+}
+
+}  // namespace android
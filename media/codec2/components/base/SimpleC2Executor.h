@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIMPLE_C2_EXECUTOR_H_
+#define SIMPLE_C2_EXECUTOR_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace android {
+
+/**
+ * Task queue of one component. Tasks run one at a time, in the order they
+ * were posted, on the worker threads of the shared SimpleC2Executor.
+ */
+class SimpleC2SerialQueue : public std::enable_shared_from_this<SimpleC2SerialQueue> {
+public:
+    enum priority_t {
+        PRIORITY_REALTIME,
+        PRIORITY_BATCH,
+        NUM_PRIORITIES,
+    };
+
+    static std::shared_ptr<SimpleC2SerialQueue> Create(const std::string &name);
+
+    const std::string &name() const { return mName; }
+
+    /**
+     * Queues of realtime priority are always run before those of batch
+     * priority. Takes effect the next time the queue is scheduled.
+     */
+    void setPriority(priority_t priority) { mPriority = priority; }
+    priority_t priority() const { return mPriority; }
+
+    void post(std::function<void()> task);
+
+    /**
+     * Posts |task| and waits for it to have run. Runs it right away if called
+     * from a task of this queue.
+     */
+    void postAndWait(std::function<void()> task);
+
+    /**
+     * Posts a call to |process|, which is posted again for as long as it
+     * returns true. Requests made while such a call is the last task of the
+     * queue are merged into it.
+     */
+    void requestProcess(std::function<bool()> process);
+
+    // Records how long an input waited from being queued to being processed.
+    void recordWorkLatency(std::chrono::nanoseconds latency);
+
+    void dump(std::ostream &out) const;
+
+private:
+    friend class SimpleC2Executor;
+
+    struct Task {
+        std::function<void()> fn;
+        std::function<bool()> process;  // set instead of fn by requestProcess()
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct Latency {
+        uint64_t mCount = 0;
+        std::chrono::nanoseconds mTotal{0};
+        std::chrono::nanoseconds mMax{0};
+
+        void add(std::chrono::nanoseconds latency);
+        void dump(std::ostream &out, const char *what) const;
+    };
+
+    explicit SimpleC2SerialQueue(const std::string &name);
+
+    void push(Task task);
+
+    // Runs the first task. Returns true if more tasks are queued, in which
+    // case the queue stays scheduled.
+    bool runOne();
+
+    const std::string mName;
+    std::atomic<priority_t> mPriority;
+
+    mutable std::mutex mLock;
+    std::deque<Task> mTasks;
+    bool mScheduled;
+    bool mProcessQueued;
+    Latency mDispatchLatency;
+    Latency mWorkLatency;
+};
+
+/**
+ * Process wide pool of worker threads running the SimpleC2SerialQueue of
+ * every SimpleC2Component, instead of a looper thread per component.
+ *
+ * Each worker keeps its own deques of ready queues, to which it puts back the
+ * queue it just ran a task of. Queues made ready by other threads go to
+ * shared deques, and idle workers steal from the deques of busy ones.
+ *
+ * Workers running a task for longer than a frame or two are assumed to be
+ * blocked, e.g. on a fence or in an allocator, and another worker is started
+ * if queues are left waiting for them.
+ */
+class SimpleC2Executor {
+public:
+    static SimpleC2Executor &Get();
+
+    /**
+     * Marks the calling worker as blocked for the lifetime of this object,
+     * starting another worker if ready queues would otherwise wait for it.
+     * Does nothing on other threads.
+     */
+    class ScopedBlocking {
+    public:
+        ScopedBlocking();
+        ~ScopedBlocking();
+
+    private:
+        const bool mIsWorker;
+    };
+
+    void dump(std::ostream &out);
+
+private:
+    friend class SimpleC2SerialQueue;
+
+    struct Worker {
+        std::mutex mLock;
+        std::deque<std::shared_ptr<SimpleC2SerialQueue>>
+                mReady[SimpleC2SerialQueue::NUM_PRIORITIES];
+        bool mRunning = false;
+        size_t mNumBlocked = 0;  // ScopedBlocking objects alive on this worker
+        // steady_clock time at which the current task started, or 0 if idle
+        std::atomic<int64_t> mBusySinceNs{0};
+    };
+
+    SimpleC2Executor();
+
+    void registerQueue(const std::shared_ptr<SimpleC2SerialQueue> &queue);
+    void schedule(const std::shared_ptr<SimpleC2SerialQueue> &queue);
+    std::shared_ptr<SimpleC2SerialQueue> findWork(Worker *self);
+    // Wakes an idle worker, or starts one if too few are running.
+    void wake_l();
+    void startWorker_l();
+    void workerLoop(Worker *self);
+    size_t numStalled_l() const;
+    // Starts workers for those stalled while queues are ready.
+    void monitorLoop();
+
+    const size_t mCoreWorkers;
+    std::atomic<size_t> mQueued;
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::unique_ptr<Worker[]> mWorkers;
+    std::atomic<size_t> mNumSlots;  // slots of mWorkers ever used
+    size_t mNumRunning;
+    size_t mNumIdle;
+    size_t mNumBlocked;
+    bool mMonitorRunning;
+    std::condition_variable mMonitorCond;
+
+    std::mutex mInjectLock;
+    std::deque<std::shared_ptr<SimpleC2SerialQueue>>
+            mInjected[SimpleC2SerialQueue::NUM_PRIORITIES];
+
+    std::mutex mQueuesLock;
+    std::list<std::weak_ptr<SimpleC2SerialQueue>> mQueues;
+};
+
+}  // namespace android
+
+#endif  // SIMPLE_C2_EXECUTOR_H_
@@ -17,6 +17,7 @@
 #ifndef SIMPLE_C2_COMPONENT_H_
 #define SIMPLE_C2_COMPONENT_H_
 
+#include <chrono>
 #include <list>
 #include <unordered_map>
 
@@ -31,12 +32,37 @@ struct C2ColorAspectsStruct;
 
 namespace android {
 
+class SimpleC2SerialQueue;
+
+/**
+ * Writes the worker threads shared by SimpleC2Component instances, and the
+ * queue latencies of each component, to |fd|. Component store dumps look
+ * it up with dlsym(), as they do not link against this library.
+ */
+extern "C" void DumpSimpleC2Components(int fd);
+
 typedef enum {
     CONV_FORMAT_I420,
     CONV_FORMAT_I422,
     CONV_FORMAT_I444,
 } CONV_FORMAT_T;
 
+// Instruction sets the converters below can use. They use the best one the
+// CPU supports, and split large frames across a few threads.
+typedef enum {
+    CONV_SIMD_NONE,
+    CONV_SIMD_SSE4,
+    CONV_SIMD_AVX2,
+    CONV_SIMD_NEON,
+} CONV_SIMD_T;
+
+CONV_SIMD_T getMaxConvertSimdLevel();
+// For tests and benchmarks. Restricts the converters to "level", returning
+// false if the CPU does not support it, and to "count" threads, 0 restoring
+// the default.
+bool setConvertSimdLevel(CONV_SIMD_T level);
+void setConvertThreadCount(size_t count);
+
 void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, const uint8_t *srcY,
                                 const uint8_t *srcU, const uint8_t *srcV, size_t srcYStride,
                                 size_t srcUStride, size_t srcVStride, size_t dstYStride,
@@ -119,7 +145,7 @@ public:
     virtual c2_status_t release() override;
     virtual std::shared_ptr<C2ComponentInterface> intf() override;
 
-    // for handler
+    // for the serial queue
     bool processQueue();
 
 protected:
@@ -223,30 +249,6 @@ protected:
 private:
     const std::shared_ptr<C2ComponentInterface> mIntf;
 
-    class WorkHandler : public AHandler {
-    public:
-        enum {
-            kWhatProcess,
-            kWhatInit,
-            kWhatStart,
-            kWhatStop,
-            kWhatReset,
-            kWhatRelease,
-        };
-
-        WorkHandler();
-        ~WorkHandler() override = default;
-
-        void setComponent(const std::shared_ptr<SimpleC2Component> &thiz);
-
-    protected:
-        void onMessageReceived(const sp<AMessage> &msg) override;
-
-    private:
-        std::weak_ptr<SimpleC2Component> mThiz;
-        bool mRunning;
-    };
-
     enum {
         UNINITIALIZED,
         STOPPED,
@@ -261,8 +263,16 @@ private:
     };
     Mutexed<ExecState> mExecState;
 
-    sp<ALooper> mLooper;
-    sp<WorkHandler> mHandler;
+    // Runs start/stop/reset/release and processQueue() of this component, one
+    // at a time, on the threads shared by all SimpleC2Component instances.
+    std::shared_ptr<SimpleC2SerialQueue> mSerialQueue;
+    // Only accessed from tasks of mSerialQueue.
+    bool mRunning;
+
+    void requestProcess();
+    // Runs at batch priority if the client asked for a negative realtime
+    // priority (C2RealTimePriorityTuning).
+    void updatePriority();
 
     class WorkQueue {
     public:
@@ -277,6 +287,7 @@ private:
         void push_back(std::unique_ptr<C2Work> work);
         bool empty() const;
         uint32_t drainMode() const;
+        std::chrono::steady_clock::time_point queuedAt() const;
         void markDrain(uint32_t drainMode);
         inline bool popPendingFlush() {
             bool flush = mFlush;
@@ -290,6 +301,7 @@ private:
         struct Entry {
             std::unique_ptr<C2Work> work;
             uint32_t drainMode;
+            std::chrono::steady_clock::time_point queuedAt;
         };
 
         bool mFlush;
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ConvertersTest"
+#include <utils/Log.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <SimpleC2Component.h>
+
+namespace android {
+
+namespace {
+
+// Output of every converter for one frame.
+struct Outputs {
+    std::vector<uint32_t> rgba;
+    std::vector<uint8_t> yv12Y, yv12U, yv12V;
+    std::vector<uint16_t> p010Y, p010UV;
+    std::vector<uint16_t> planarY, planarU, planarV;
+    std::vector<uint8_t> yv12From8Y, yv12From8U, yv12From8V;
+
+    bool operator==(const Outputs &o) const {
+        return std::tie(rgba, yv12Y, yv12U, yv12V, p010Y, p010UV, planarY, planarU, planarV,
+                        yv12From8Y, yv12From8U, yv12From8V) ==
+               std::tie(o.rgba, o.yv12Y, o.yv12U, o.yv12V, o.p010Y, o.p010UV, o.planarY,
+                        o.planarU, o.planarV, o.yv12From8Y, o.yv12From8U, o.yv12From8V);
+    }
+};
+
+// A 4:2:0 frame with padded strides. Values use all 16 bits, as the converters
+// must match the scalar code for out of range input too.
+class Frame {
+  public:
+    Frame(size_t width, size_t height) : mWidth(width), mHeight(height) {
+        std::mt19937 rng(width * 7919 + height);
+        mYStride = width + 5;
+        mUVStride = (width + 1) / 2 + 3;
+        mY = random<uint16_t>(rng, mYStride * (height + 1));
+        mU = random<uint16_t>(rng, mUVStride * (height / 2 + 1));
+        mV = random<uint16_t>(rng, mUVStride * (height / 2 + 1));
+        mUV = random<uint16_t>(rng, 2 * mUVStride * (height / 2 + 1));
+        mY8 = random<uint8_t>(rng, mYStride * (height + 1));
+        mU8 = random<uint8_t>(rng, mUVStride * (height / 2 + 1));
+        mV8 = random<uint8_t>(rng, mUVStride * (height / 2 + 1));
+    }
+
+    Outputs convert(bool isMonochrome) const {
+        // Destination strides differ from the source ones, and the extra row
+        // takes the bottom row that the 32 bit converters write for odd heights.
+        const size_t dstStride = mWidth + 3;
+        const size_t dstUVStride = (mWidth + 1) / 2 + 1;
+        const size_t rows = mHeight + 1;
+        Outputs out;
+        if (mWidth % 2 == 0) {
+            out.rgba.resize(dstStride * rows);
+            convertYUV420Planar16ToY410OrRGBA1010102(out.rgba.data(), mY.data(), mU.data(),
+                                                     mV.data(), mYStride, mUVStride, mUVStride,
+                                                     dstStride, mWidth, mHeight);
+        }
+
+        out.yv12Y.resize(dstStride * rows);
+        out.yv12U.resize(dstUVStride * rows);
+        out.yv12V.resize(dstUVStride * rows);
+        convertYUV420Planar16ToYV12(out.yv12Y.data(), out.yv12U.data(), out.yv12V.data(),
+                                    mY.data(), mU.data(), mV.data(), mYStride, mUVStride,
+                                    mUVStride, dstStride, dstUVStride, mWidth, mHeight,
+                                    isMonochrome);
+
+        out.p010Y.resize(dstStride * rows);
+        out.p010UV.resize(dstStride * rows);
+        convertYUV420Planar16ToP010(out.p010Y.data(), out.p010UV.data(), mY.data(), mU.data(),
+                                    mV.data(), mYStride, mUVStride, mUVStride, dstStride,
+                                    dstStride, mWidth, mHeight, isMonochrome);
+
+        out.planarY.resize(dstStride * rows);
+        out.planarU.resize(dstUVStride * rows);
+        out.planarV.resize(dstUVStride * rows);
+        convertP010ToYUV420Planar16(out.planarY.data(), out.planarU.data(), out.planarV.data(),
+                                    mY.data(), mUV.data(), mYStride, 2 * mUVStride, dstStride,
+                                    dstUVStride, dstUVStride, mWidth, mHeight, isMonochrome);
+
+        out.yv12From8Y.resize(dstStride * rows);
+        out.yv12From8U.resize(dstUVStride * rows);
+        out.yv12From8V.resize(dstUVStride * rows);
+        convertPlanar8ToYV12(out.yv12From8Y.data(), out.yv12From8U.data(),
+                             out.yv12From8V.data(), mY8.data(), mU8.data(), mV8.data(), mYStride,
+                             mUVStride, mUVStride, dstStride, dstUVStride, dstUVStride, mWidth,
+                             mHeight, isMonochrome, CONV_FORMAT_I420);
+        return out;
+    }
+
+  private:
+    template <typename T>
+    static std::vector<T> random(std::mt19937 &rng, size_t size) {
+        std::vector<T> v(size);
+        for (T &value : v) {
+            value = rng();
+        }
+        return v;
+    }
+
+    size_t mWidth;
+    size_t mHeight;
+    size_t mYStride;
+    size_t mUVStride;
+    std::vector<uint16_t> mY, mU, mV, mUV;
+    std::vector<uint8_t> mY8, mU8, mV8;
+};
+
+// Frame sizes around the vector widths, and ones large enough to be split
+// across threads.
+const std::pair<size_t, size_t> kFrameSizes[] = {
+        {4, 2},    {6, 3},    {14, 1},    {16, 16},    {30, 5},      {34, 8},
+        {63, 7},   {66, 9},   {130, 4},   {176, 144},  {1280, 720},  {1922, 1081},
+};
+
+}  // namespace
+
+class ConvertersTest : public ::testing::TestWithParam<std::tuple<CONV_SIMD_T, size_t>> {
+  protected:
+    void TearDown() override {
+        setConvertSimdLevel(getMaxConvertSimdLevel());
+        setConvertThreadCount(0);
+    }
+};
+
+TEST_P(ConvertersTest, MatchesScalar) {
+    const auto [level, threads] = GetParam();
+    for (const auto &[width, height] : kFrameSizes) {
+        SCOPED_TRACE(::testing::Message() << width << "x" << height);
+        Frame frame(width, height);
+        for (bool isMonochrome : {false, true}) {
+            ASSERT_TRUE(setConvertSimdLevel(CONV_SIMD_NONE));
+            setConvertThreadCount(1);
+            Outputs expected = frame.convert(isMonochrome);
+
+            if (!setConvertSimdLevel(level)) {
+                GTEST_SKIP() << "Instruction set " << level << " is not supported";
+            }
+            setConvertThreadCount(threads);
+            EXPECT_TRUE(frame.convert(isMonochrome) == expected)
+                    << "monochrome " << isMonochrome;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(ConvertersTestAll, ConvertersTest,
+                         ::testing::Combine(::testing::Values(CONV_SIMD_NONE, CONV_SIMD_SSE4,
+                                                              CONV_SIMD_AVX2, CONV_SIMD_NEON),
+                                            ::testing::Values(1, 4)));
+
+TEST(ConvertersP010Test, RoundTrip) {
+    const size_t width = 37, height = 5;
+    std::vector<uint16_t> y(width * height), u((width + 1) / 2 * 3), v((width + 1) / 2 * 3);
+    for (size_t i = 0; i < y.size(); ++i) y[i] = (i * 37) & 0x3FF;
+    for (size_t i = 0; i < u.size(); ++i) {
+        u[i] = (i * 11) & 0x3FF;
+        v[i] = (i * 13) & 0x3FF;
+    }
+    std::vector<uint16_t> p010Y(y.size()), p010UV(u.size() * 2);
+    convertYUV420Planar16ToP010(p010Y.data(), p010UV.data(), y.data(), u.data(), v.data(), width,
+                                (width + 1) / 2, (width + 1) / 2, width, width + 1, width,
+                                height);
+    EXPECT_EQ(y[3] << 6, p010Y[3]);
+    EXPECT_EQ(u[2] << 6, p010UV[4]);
+    EXPECT_EQ(v[2] << 6, p010UV[5]);
+
+    std::vector<uint16_t> outY(y.size()), outU(u.size()), outV(v.size());
+    convertP010ToYUV420Planar16(outY.data(), outU.data(), outV.data(), p010Y.data(),
+                                p010UV.data(), width, width + 1, width, (width + 1) / 2,
+                                (width + 1) / 2, width, height);
+    EXPECT_EQ(y, outY);
+    EXPECT_EQ(u, outU);
+    EXPECT_EQ(v, outV);
+}
+
+}  // namespace android
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the 10 bit output converters of SimpleC2Component on a 4K frame
+// for each instruction set, state.range(0) being a CONV_SIMD_T, and
+// state.range(1) threads.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <SimpleC2Component.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kWidth = 3840;
+constexpr size_t kHeight = 2160;
+
+struct Frame {
+    std::vector<uint16_t> y = std::vector<uint16_t>(kWidth * kHeight);
+    std::vector<uint16_t> u = std::vector<uint16_t>(kWidth * kHeight / 4);
+    std::vector<uint16_t> v = std::vector<uint16_t>(kWidth * kHeight / 4);
+
+    Frame() {
+        for (size_t i = 0; i < y.size(); ++i) {
+            y[i] = (i * 7) & 0x3FF;
+        }
+        for (size_t i = 0; i < u.size(); ++i) {
+            u[i] = (i * 3) & 0x3FF;
+            v[i] = (i * 5) & 0x3FF;
+        }
+    }
+};
+
+bool setUp(benchmark::State &state) {
+    if (!setConvertSimdLevel((CONV_SIMD_T)state.range(0))) {
+        state.SkipWithError("instruction set not supported");
+        return false;
+    }
+    setConvertThreadCount(state.range(1));
+    return true;
+}
+
+void tearDown(benchmark::State &state) {
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+    setConvertSimdLevel(getMaxConvertSimdLevel());
+    setConvertThreadCount(0);
+}
+
+static void BM_Planar16ToRGBA1010102(benchmark::State &state) {
+    if (!setUp(state)) return;
+    Frame frame;
+    std::vector<uint32_t> dst(kWidth * kHeight);
+    for (auto _ : state) {
+        convertYUV420Planar16ToY410OrRGBA1010102(dst.data(), frame.y.data(), frame.u.data(),
+                                                 frame.v.data(), kWidth, kWidth / 2, kWidth / 2,
+                                                 kWidth, kWidth, kHeight);
+        benchmark::ClobberMemory();
+    }
+    tearDown(state);
+}
+
+static void BM_Planar16ToP010(benchmark::State &state) {
+    if (!setUp(state)) return;
+    Frame frame;
+    std::vector<uint16_t> dstY(kWidth * kHeight), dstUV(kWidth * kHeight / 2);
+    for (auto _ : state) {
+        convertYUV420Planar16ToP010(dstY.data(), dstUV.data(), frame.y.data(), frame.u.data(),
+                                    frame.v.data(), kWidth, kWidth / 2, kWidth / 2, kWidth,
+                                    kWidth, kWidth, kHeight);
+        benchmark::ClobberMemory();
+    }
+    tearDown(state);
+}
+
+static void BM_P010ToPlanar16(benchmark::State &state) {
+    if (!setUp(state)) return;
+    Frame frame;
+    std::vector<uint16_t> srcUV(kWidth * kHeight / 2, 512 << 6);
+    std::vector<uint16_t> dstY(kWidth * kHeight), dstU(kWidth * kHeight / 4),
+            dstV(kWidth * kHeight / 4);
+    for (auto _ : state) {
+        convertP010ToYUV420Planar16(dstY.data(), dstU.data(), dstV.data(), frame.y.data(),
+                                    srcUV.data(), kWidth, kWidth, kWidth, kWidth / 2, kWidth / 2,
+                                    kWidth, kHeight);
+        benchmark::ClobberMemory();
+    }
+    tearDown(state);
+}
+
+static void BM_Planar16ToYV12(benchmark::State &state) {
+    if (!setUp(state)) return;
+    Frame frame;
+    std::vector<uint8_t> dstY(kWidth * kHeight), dstU(kWidth * kHeight / 4),
+            dstV(kWidth * kHeight / 4);
+    for (auto _ : state) {
+        convertYUV420Planar16ToYV12(dstY.data(), dstU.data(), dstV.data(), frame.y.data(),
+                                    frame.u.data(), frame.v.data(), kWidth, kWidth / 2,
+                                    kWidth / 2, kWidth, kWidth / 2, kWidth, kHeight);
+        benchmark::ClobberMemory();
+    }
+    tearDown(state);
+}
+
+void ConvertArgs(benchmark::internal::Benchmark *b) {
+    for (CONV_SIMD_T level : {CONV_SIMD_NONE, CONV_SIMD_SSE4, CONV_SIMD_AVX2, CONV_SIMD_NEON}) {
+        for (int threads : {1, 2, 4}) {
+            b->Args({level, threads});
+        }
+    }
+    b->ArgNames({"simd", "threads"})->UseRealTime();
+}
+
+BENCHMARK(BM_Planar16ToRGBA1010102)->Apply(ConvertArgs);
+BENCHMARK(BM_Planar16ToP010)->Apply(ConvertArgs);
+BENCHMARK(BM_P010ToPlanar16)->Apply(ConvertArgs);
+BENCHMARK(BM_Planar16ToYV12)->Apply(ConvertArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2ExecutorTest"
+#include <utils/Log.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SimpleC2Executor.h"
+
+namespace android {
+
+TEST(SimpleC2ExecutorTest, RunsTasksOfAQueueInOrderAndOneAtATime) {
+    constexpr size_t kNumQueues = 16;
+    constexpr size_t kNumTasks = 500;
+
+    struct State {
+        std::shared_ptr<SimpleC2SerialQueue> queue;
+        std::vector<size_t> order;
+        std::atomic<int> running{0};
+        std::atomic<bool> overlapped{false};
+    };
+    std::vector<State> states(kNumQueues);
+    for (size_t i = 0; i < kNumQueues; ++i) {
+        states[i].queue = SimpleC2SerialQueue::Create("ordering" + std::to_string(i));
+        if (i % 2) {
+            states[i].queue->setPriority(SimpleC2SerialQueue::PRIORITY_BATCH);
+        }
+    }
+
+    // Post from several threads at once, each to its own set of queues.
+    std::vector<std::thread> posters;
+    for (size_t t = 0; t < 4; ++t) {
+        posters.emplace_back([&states, t] {
+            for (size_t n = 0; n < kNumTasks; ++n) {
+                for (size_t i = t; i < kNumQueues; i += 4) {
+                    State *state = &states[i];
+                    state->queue->post([state, n] {
+                        if (state->running++ != 0) {
+                            state->overlapped = true;
+                        }
+                        state->order.push_back(n);
+                        --state->running;
+                    });
+                }
+            }
+        });
+    }
+    for (std::thread &poster : posters) {
+        poster.join();
+    }
+
+    for (State &state : states) {
+        state.queue->postAndWait([] {});
+        EXPECT_FALSE(state.overlapped) << state.queue->name();
+        ASSERT_EQ(kNumTasks, state.order.size()) << state.queue->name();
+        for (size_t n = 0; n < kNumTasks; ++n) {
+            ASSERT_EQ(n, state.order[n]) << state.queue->name();
+        }
+    }
+}
+
+TEST(SimpleC2ExecutorTest, PostAndWaitFromOwnTaskRunsInline) {
+    std::shared_ptr<SimpleC2SerialQueue> queue = SimpleC2SerialQueue::Create("inline");
+    bool ranInner = false;
+    queue->postAndWait([&queue, &ranInner] {
+        queue->postAndWait([&ranInner] { ranInner = true; });
+    });
+    EXPECT_TRUE(ranInner);
+}
+
+TEST(SimpleC2ExecutorTest, RepeatsAndMergesProcessRequests) {
+    std::shared_ptr<SimpleC2SerialQueue> queue = SimpleC2SerialQueue::Create("process");
+    std::atomic<int> calls{0};
+    std::atomic<int> remaining{0};
+    auto process = [&calls, &remaining] {
+        ++calls;
+        return --remaining > 0;
+    };
+
+    // Keeps being called while it returns true. Repeated calls are posted
+    // after the tasks already queued, so wait until they are done.
+    remaining = 5;
+    queue->requestProcess(process);
+    while (remaining > 0) {
+        queue->postAndWait([] {});
+    }
+    queue->postAndWait([] {});
+    EXPECT_EQ(5, calls);
+
+    // Requests made while one is the last task are merged.
+    calls = 0;
+    remaining = 1;
+    queue->postAndWait([&queue, &process] {
+        for (int i = 0; i < 10; ++i) {
+            queue->requestProcess(process);
+        }
+    });
+    queue->postAndWait([] {});
+    EXPECT_EQ(1, calls);
+
+    // But not into a call queued before another task.
+    calls = 0;
+    remaining = 1;
+    queue->postAndWait([&queue, &process, &remaining] {
+        queue->requestProcess(process);
+        queue->post([&remaining] { remaining = 1; });
+        queue->requestProcess(process);
+    });
+    queue->postAndWait([] {});
+    EXPECT_EQ(2, calls);
+}
+
+TEST(SimpleC2ExecutorTest, BlockedWorkersDoNotStallOtherQueues) {
+    // More queues block than there are core workers (8 at most); they can
+    // only finish if others stand in for them to run the queue releasing them.
+    constexpr size_t numBlocked = 12;
+    std::mutex lock;
+    std::condition_variable cond;
+    bool released = false;
+    std::atomic<size_t> done{0};
+
+    std::vector<std::shared_ptr<SimpleC2SerialQueue>> queues;
+    for (size_t i = 0; i < numBlocked; ++i) {
+        queues.push_back(SimpleC2SerialQueue::Create("blocked" + std::to_string(i)));
+        queues.back()->post([&lock, &cond, &released, &done] {
+            SimpleC2Executor::ScopedBlocking blocking;
+            std::unique_lock<std::mutex> l(lock);
+            cond.wait(l, [&released] { return released; });
+            ++done;
+        });
+    }
+    std::shared_ptr<SimpleC2SerialQueue> releaser = SimpleC2SerialQueue::Create("releaser");
+    releaser->post([&lock, &cond, &released] {
+        std::lock_guard<std::mutex> l(lock);
+        released = true;
+        cond.notify_all();
+    });
+
+    for (const std::shared_ptr<SimpleC2SerialQueue> &queue : queues) {
+        queue->postAndWait([] {});
+    }
+    EXPECT_EQ(numBlocked, done);
+}
+
+TEST(SimpleC2ExecutorTest, SlowTasksDoNotStallOtherQueues) {
+    // Same as above, but the tasks wait without saying so, as they would on a
+    // fence. They time out if no worker is started to run the releaser.
+    constexpr size_t numSlow = 12;
+    std::mutex lock;
+    std::condition_variable cond;
+    bool released = false;
+    std::atomic<size_t> done{0};
+
+    std::vector<std::shared_ptr<SimpleC2SerialQueue>> queues;
+    for (size_t i = 0; i < numSlow; ++i) {
+        queues.push_back(SimpleC2SerialQueue::Create("slow" + std::to_string(i)));
+        queues.back()->post([&lock, &cond, &released, &done] {
+            std::unique_lock<std::mutex> l(lock);
+            if (cond.wait_for(l, std::chrono::seconds(5), [&released] { return released; })) {
+                ++done;
+            }
+        });
+    }
+    std::shared_ptr<SimpleC2SerialQueue> releaser = SimpleC2SerialQueue::Create("releaser");
+    releaser->post([&lock, &cond, &released] {
+        std::lock_guard<std::mutex> l(lock);
+        released = true;
+        cond.notify_all();
+    });
+
+    for (const std::shared_ptr<SimpleC2SerialQueue> &queue : queues) {
+        queue->postAndWait([] {});
+    }
+    EXPECT_EQ(numSlow, done);
+}
+
+TEST(SimpleC2ExecutorTest, DumpsLatencies) {
+    std::shared_ptr<SimpleC2SerialQueue> queue = SimpleC2SerialQueue::Create("dumped");
+    queue->recordWorkLatency(std::chrono::milliseconds(3));
+    queue->postAndWait([] {});
+
+    std::ostringstream out;
+    SimpleC2Executor::Get().dump(out);
+    const std::string dump = out.str();
+    EXPECT_NE(std::string::npos, dump.find("dumped (realtime)")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("work latency: avg 3.00 ms")) << dump;
+}
+
+}  // namespace android
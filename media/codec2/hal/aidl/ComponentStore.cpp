@@ -23,6 +23,7 @@
 #include <codec2/aidl/ComponentInterface.h>
 #include <codec2/aidl/ComponentStore.h>
 #include <codec2/aidl/ParamTypes.h>
+#include <codec2/common/SoftwareComponentDump.h>
 
 #include <android-base/file.h>
 #include <utils/Errors.h>
@@ -520,6 +521,7 @@ binder_status_t ComponentStore::dump(
     } else {
         LOG(INFO) << "debug -- dumping succeeded";
     }
+    ::android::DumpSoftwareComponents(fd);
     return STATUS_OK;
 }
 
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Codec2-SoftwareComponentDump"
+#include <android-base/logging.h>
+
+#include <dlfcn.h>
+
+#include <codec2/common/SoftwareComponentDump.h>
+
+namespace android {
+
+void DumpSoftwareComponents(int fd) {
+    // The software components are loaded by the store as plugins, so the HAL
+    // cannot link against their common library. Only look it up if it is
+    // already loaded.
+    void *lib = dlopen("libcodec2_soft_common.so", RTLD_NOW | RTLD_NOLOAD);
+    if (lib == nullptr) {
+        return;
+    }
+    typedef void (*DumpFunc)(int);
+    DumpFunc dump = (DumpFunc)dlsym(lib, "DumpSimpleC2Components");
+    if (dump != nullptr) {
+        dump(fd);
+    } else {
+        LOG(DEBUG) << "DumpSimpleC2Components not found";
+    }
+    dlclose(lib);
+}
+
+}  // namespace android
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CODEC2_SOFTWARE_COMPONENT_DUMP_H
+#define CODEC2_SOFTWARE_COMPONENT_DUMP_H
+
+namespace android {
+
+// Writes the worker and queue latency state of the SimpleC2Component based
+// software components of this process to |fd|. Does nothing if none have been
+// loaded.
+void DumpSoftwareComponents(int fd);
+
+}  // namespace android
+
+#endif  // CODEC2_SOFTWARE_COMPONENT_DUMP_H
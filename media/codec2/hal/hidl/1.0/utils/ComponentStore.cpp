@@ -18,6 +18,7 @@
 #define LOG_TAG "Codec2-ComponentStore"
 #include <android-base/logging.h>
 
+#include <codec2/common/SoftwareComponentDump.h>
 #include <codec2/hidl/1.0/ComponentStore.h>
 #include <codec2/hidl/1.0/InputSurface.h>
 #include <codec2/hidl/1.0/types.h>
@@ -512,6 +513,7 @@ Return<void> ComponentStore::debug(
     } else {
         LOG(INFO) << "debug -- dumping succeeded";
     }
+    ::android::DumpSoftwareComponents(h->data[0]);
     return Void();
 }
 
@@ -18,6 +18,7 @@
 #define LOG_TAG "Codec2-ComponentStore@1.1"
 #include <android-base/logging.h>
 
+#include <codec2/common/SoftwareComponentDump.h>
 #include <codec2/hidl/1.1/ComponentStore.h>
 #include <codec2/hidl/1.1/InputSurface.h>
 #include <codec2/hidl/1.1/types.h>
@@ -549,6 +550,7 @@ Return<void> ComponentStore::debug(
     } else {
         LOG(INFO) << "debug -- dumping succeeded";
     }
+    ::android::DumpSoftwareComponents(h->data[0]);
     return Void();
 }
 
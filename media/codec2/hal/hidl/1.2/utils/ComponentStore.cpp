@@ -18,6 +18,7 @@
 #define LOG_TAG "Codec2-ComponentStore@1.2"
 #include <android-base/logging.h>
 
+#include <codec2/common/SoftwareComponentDump.h>
 #include <codec2/hidl/1.2/ComponentStore.h>
 #include <codec2/hidl/1.2/InputSurface.h>
 #include <codec2/hidl/1.2/types.h>
@@ -583,6 +584,7 @@ Return<void> ComponentStore::debug(
     } else {
         LOG(INFO) << "debug -- dumping succeeded";
     }
+    ::android::DumpSoftwareComponents(h->data[0]);
     return Void();
 }
 
@@ -62,6 +62,7 @@ enum RingbufferFlags : uint32_t {
     COHERENCY_DMA = 0x0004,
     COHERENCY_ACQUIRE_RELEASE = 0x0008,
     COHERENCY_AUTO = 0x0010,
+    SHARED_READ_ONLY = 0x0020, // data and write counter can only be mapped read-only
 };
 
 // This is not passed through Binder.
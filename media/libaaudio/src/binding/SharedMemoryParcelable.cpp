@@ -91,6 +91,11 @@ aaudio_result_t SharedMemoryParcelable::closeAndReleaseFd() {
 aaudio_result_t SharedMemoryParcelable::resolveSharedMemory(const unique_fd& fd) {
     mResolvedAddress = (uint8_t *) mmap(nullptr, mSizeInBytes, PROT_READ | PROT_WRITE,
                                         MAP_SHARED, fd.get(), 0);
+    if (mResolvedAddress == MMAP_UNRESOLVED_ADDRESS && (errno == EPERM || errno == EACCES)) {
+        // The service may only allow read access, eg. to a ring shared by several clients.
+        mResolvedAddress = (uint8_t *) mmap(nullptr, mSizeInBytes, PROT_READ,
+                                            MAP_SHARED, fd.get(), 0);
+    }
     if (mResolvedAddress == MMAP_UNRESOLVED_ADDRESS) {
         ALOGE("mmap() failed for fd = %d, nBytes = %" PRId64 ", errno = %s",
               fd.get(), mSizeInBytes, strerror(errno));
@@ -65,14 +65,19 @@ static aaudio_result_t AudioEndpoint_validateQueueDescriptor(const char *type,
           descriptor->readCounterAddress,
           descriptor->writeCounterAddress);
 
+    // The data and the write counter of a ring shared with other clients are read-only.
+    const bool sharedReadOnly = (descriptor->flags & RingbufferFlags::SHARED_READ_ONLY) != 0;
+
     // Try to READ from the data area.
     // This code will crash if the mmap failed.
     uint8_t value = descriptor->dataAddress[0];
     ALOGV("AudioEndpoint_validateQueueDescriptor() dataAddress[0] = %d, then try to write",
         (int) value);
-    // Try to WRITE to the data area.
-    descriptor->dataAddress[0] = value * 3;
-    ALOGV("AudioEndpoint_validateQueueDescriptor() wrote successfully");
+    if (!sharedReadOnly) {
+        // Try to WRITE to the data area.
+        descriptor->dataAddress[0] = value * 3;
+        ALOGV("AudioEndpoint_validateQueueDescriptor() wrote successfully");
+    }
 
     if (descriptor->readCounterAddress) {
         fifo_counter_t counter = *descriptor->readCounterAddress;
@@ -86,8 +91,10 @@ static aaudio_result_t AudioEndpoint_validateQueueDescriptor(const char *type,
         fifo_counter_t counter = *descriptor->writeCounterAddress;
         ALOGV("AudioEndpoint_validateQueueDescriptor() *writeCounterAddress = %d, now write",
               (int) counter);
-        *descriptor->writeCounterAddress = counter;
-        ALOGV("AudioEndpoint_validateQueueDescriptor() wrote writeCounterAddress successfully");
+        if (!sharedReadOnly) {
+            *descriptor->writeCounterAddress = counter;
+            ALOGV("AudioEndpoint_validateQueueDescriptor() wrote writeCounterAddress successfully");
+        }
     }
 
     return AAUDIO_OK;
@@ -170,16 +177,21 @@ aaudio_result_t AudioEndpoint::configureDataQueue(const RingBufferDescriptor& de
                                   ? &mDataWriteCounter
                                   : descriptor.writeCounterAddress;
 
-    // Clear buffer to avoid an initial glitch on some devices.
-    size_t bufferSizeBytes = descriptor.capacityInFrames * descriptor.bytesPerFrame;
-    memset(descriptor.dataAddress, 0, bufferSizeBytes);
+    // A ring shared with other clients is already running and is only written by the service.
+    const bool sharedReadOnly = (descriptor.flags & RingbufferFlags::SHARED_READ_ONLY) != 0;
+    if (!sharedReadOnly) {
+        // Clear buffer to avoid an initial glitch on some devices.
+        size_t bufferSizeBytes = descriptor.capacityInFrames * descriptor.bytesPerFrame;
+        memset(descriptor.dataAddress, 0, bufferSizeBytes);
+    }
 
     mDataQueue = std::make_unique<FifoBufferIndirect>(
             descriptor.bytesPerFrame,
             descriptor.capacityInFrames,
             readCounterAddress,
             writeCounterAddress,
-            descriptor.dataAddress
+            descriptor.dataAddress,
+            !sharedReadOnly /* resetCounters */
     );
     uint32_t threshold = descriptor.capacityInFrames / 2;
     mDataQueue->setThreshold(threshold);
@@ -151,7 +151,8 @@ public:
                        fifo_frames_t capacityInFrames,
                        fifo_counter_t* readCounterAddress,
                        fifo_counter_t* writeCounterAddress,
-                       void* dataStorageAddress);
+                       void* dataStorageAddress,
+                       bool resetCounters = true);
 
 private:
 
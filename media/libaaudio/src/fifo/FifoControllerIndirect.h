@@ -33,16 +33,23 @@ namespace android {
 class FifoControllerIndirect : public FifoControllerBase {
 
 public:
+    /**
+     * @param resetCounters false if the counters are owned by the other side,
+     *                      eg. because they are mapped read-only
+     */
     FifoControllerIndirect(fifo_frames_t capacity,
                            fifo_frames_t threshold,
                            fifo_counter_t * readCounterAddress,
-                           fifo_counter_t * writeCounterAddress)
+                           fifo_counter_t * writeCounterAddress,
+                           bool resetCounters = true)
         : FifoControllerBase(capacity, threshold)
         , mReadCounterAddress((std::atomic<fifo_counter_t> *) readCounterAddress)
         , mWriteCounterAddress((std::atomic<fifo_counter_t> *) writeCounterAddress)
     {
-        setReadCounter(0);
-        setWriteCounter(0);
+        if (resetCounters) {
+            setReadCounter(0);
+            setWriteCounter(0);
+        }
     }
     virtual ~FifoControllerIndirect() = default;
 
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <map>
 #include <math.h>
+#include <mutex>
+#include <tuple>
 
 #include "IntegerRatio.h"
 #include "LinearResampler.h"
@@ -27,11 +30,21 @@
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
+namespace {
+
+// Coefficient tables are identified by numTaps, numRows, phaseIncrement and cutoffScaler.
+using CoefficientKey = std::tuple<int32_t, int32_t, double, float>;
+
+// Tables that are in use by at least one resampler.
+std::mutex sCoefficientCacheLock;
+std::map<CoefficientKey, std::weak_ptr<const std::vector<float>>> sCoefficientCache;
+
+} // namespace
+
 MultiChannelResampler::MultiChannelResampler(const MultiChannelResampler::Builder &builder)
         : mNumTaps(builder.getNumTaps())
         , mX(static_cast<size_t>(builder.getChannelCount())
                 * static_cast<size_t>(builder.getNumTaps()) * 2)
-        , mSingleFrame(builder.getChannelCount())
         , mChannelCount(builder.getChannelCount())
         {
     // Reduce sample rates to the smallest ratio.
@@ -124,20 +137,56 @@ float MultiChannelResampler::sinc(float radians) {
     return sinf(radians) / radians;   // Sinc function
 }
 
-// Generate coefficients in the order they will be used by readFrame().
-// This is more complicated but readFrame() is called repeatedly and should be optimized.
 void MultiChannelResampler::generateCoefficients(int32_t inputRate,
                                               int32_t outputRate,
                                               int32_t numRows,
                                               double phaseIncrement,
                                               float normalizedCutoff) {
-    mCoefficients.resize(static_cast<size_t>(getNumTaps()) * static_cast<size_t>(numRows));
-    int coefficientIndex = 0;
-    double phase = 0.0; // ranges from 0.0 to 1.0, fraction between samples
     // Stretch the sinc function for low pass filtering.
     const float cutoffScaler = (outputRate < inputRate)
              ? (normalizedCutoff * (float)outputRate / inputRate)
              : 1.0f; // Do not filter when upsampling.
+    const CoefficientKey key(getNumTaps(), numRows, phaseIncrement, cutoffScaler);
+
+    {
+        std::lock_guard<std::mutex> lock(sCoefficientCacheLock);
+        auto it = sCoefficientCache.find(key);
+        if (it != sCoefficientCache.end()) {
+            mCoefficientTable = it->second.lock();
+        }
+    }
+
+    if (mCoefficientTable == nullptr) {
+        // Calculate outside the lock because large tables take a while.
+        auto coefficients = std::make_shared<std::vector<float>>();
+        fillCoefficients(*coefficients, numRows, phaseIncrement, cutoffScaler);
+
+        std::lock_guard<std::mutex> lock(sCoefficientCacheLock);
+        std::weak_ptr<const std::vector<float>> &entry = sCoefficientCache[key];
+        mCoefficientTable = entry.lock();
+        if (mCoefficientTable == nullptr) {
+            mCoefficientTable = coefficients;
+            entry = mCoefficientTable;
+        }
+        // Forget tables that are no longer used.
+        for (auto it = sCoefficientCache.begin(); it != sCoefficientCache.end();) {
+            it = it->second.expired() ? sCoefficientCache.erase(it) : std::next(it);
+        }
+    }
+
+    mCoefficients = mCoefficientTable->data();
+    mNumCoefficients = static_cast<int32_t>(mCoefficientTable->size());
+}
+
+// Generate coefficients in the order they will be used by readFrame().
+// This is more complicated but readFrame() is called repeatedly and should be optimized.
+void MultiChannelResampler::fillCoefficients(std::vector<float> &coefficients,
+                                             int32_t numRows,
+                                             double phaseIncrement,
+                                             float cutoffScaler) {
+    coefficients.resize(static_cast<size_t>(getNumTaps()) * static_cast<size_t>(numRows));
+    int coefficientIndex = 0;
+    double phase = 0.0; // ranges from 0.0 to 1.0, fraction between samples
     const int numTapsHalf = getNumTaps() / 2; // numTaps must be even.
     const float numTapsHalfInverse = 1.0f / numTapsHalf;
     for (int i = 0; i < numRows; i++) {
@@ -153,7 +202,7 @@ void MultiChannelResampler::generateCoefficients(int32_t inputRate,
             float window = mCoshWindow(static_cast<double>(tapPhase) * numTapsHalfInverse);
 #endif
             float coefficient = sinc(radians * cutoffScaler) * window;
-            mCoefficients.at(coefficientIndex++) = coefficient;
+            coefficients.at(coefficientIndex++) = coefficient;
             gain += coefficient;
             tapPhase += 1.0;
         }
@@ -165,7 +214,7 @@ void MultiChannelResampler::generateCoefficients(int32_t inputRate,
         // Correct for gain variations.
         float gainCorrection = 1.0 / gain; // normalize the gain
         for (int tap = 0; tap < getNumTaps(); tap++) {
-            mCoefficients.at(gainCursor + tap) *= gainCorrection;
+            coefficients.at(gainCursor + tap) *= gainCorrection;
         }
     }
 }
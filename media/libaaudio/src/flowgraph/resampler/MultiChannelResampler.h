@@ -231,6 +231,9 @@ protected:
     /**
      * Generate the filter coefficients in optimal order.
      *
+     * The table only depends on the ratio and the number of taps so it is shared
+     * with any other resampler that uses the same values.
+     *
      * Note that normalizedCutoff is ignored when upsampling, which is when
      * the outputRate is higher than the inputRate.
      *
@@ -252,12 +255,12 @@ protected:
     }
 
     static constexpr int kMaxCoefficients = 8 * 1024;
-    std::vector<float>   mCoefficients;
+    const float         *mCoefficients = nullptr; // points into mCoefficientTable
+    int32_t              mNumCoefficients = 0;
 
     const int            mNumTaps;
     int                  mCursor = 0;
     std::vector<float>   mX;           // delayed input values for the FIR
-    std::vector<float>   mSingleFrame; // one frame for temporary use
     int32_t              mIntegerPhase = 0;
     int32_t              mNumerator = 0;
     int32_t              mDenominator = 0;
@@ -265,6 +268,13 @@ protected:
 
 private:
 
+    void fillCoefficients(std::vector<float> &coefficients,
+                          int32_t numRows,
+                          double phaseIncrement,
+                          float cutoffScaler);
+
+    std::shared_ptr<const std::vector<float>> mCoefficientTable;
+
 #if MCR_USE_KAISER
     KaiserWindow           mKaiserWindow;
 #else
@@ -18,6 +18,7 @@
 #include <math.h>
 #include "IntegerRatio.h"
 #include "PolyphaseResampler.h"
+#include "ResamplerKernels.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
@@ -37,24 +38,11 @@ PolyphaseResampler::PolyphaseResampler(const MultiChannelResampler::Builder &bui
 }
 
 void PolyphaseResampler::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
-
     // Multiply input times windowed sinc function.
-    float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int i = 0; i < mNumTaps; i++) {
-        float coefficient = *coefficients++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            mSingleFrame[channel] += *xFrame++ * coefficient;
-        }
-    }
-
-    // Advance and wrap through coefficients.
-    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
+    const float *coefficients = &mCoefficients[mCoefficientCursor];
+    const float *xFrame = &mX[static_cast<size_t>(mCursor)
+                              * static_cast<size_t>(getChannelCount())];
+    convolveChannels(xFrame, coefficients, mNumTaps, getChannelCount(), frame);
 
-    // Copy accumulator to output.
-    for (int channel = 0; channel < getChannelCount(); channel++) {
-        frame[channel] = mSingleFrame[channel];
-    }
+    advanceCoefficientCursor();
 }
@@ -44,6 +44,14 @@ public:
 
 protected:
 
+    // Advance and wrap through coefficients.
+    void advanceCoefficientCursor() {
+        mCoefficientCursor += mNumTaps;
+        if (mCoefficientCursor >= mNumCoefficients) {
+            mCoefficientCursor = 0;
+        }
+    }
+
     int32_t                mCoefficientCursor = 0;
 
 };
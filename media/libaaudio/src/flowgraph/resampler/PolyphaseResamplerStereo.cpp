@@ -16,6 +16,7 @@
 
 #include <cassert>
 #include "PolyphaseResamplerStereo.h"
+#include "ResamplerKernels.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
@@ -44,36 +45,10 @@ void PolyphaseResamplerStereo::writeFrame(const float *frame) {
 }
 
 void PolyphaseResamplerStereo::readFrame(float *frame) {
-    // Clear accumulators.
-    float left = 0.0;
-    float right = 0.0;
-
     // Multiply input times precomputed windowed sinc function.
     const float *coefficients = &mCoefficients[mCoefficientCursor];
-    float *xFrame = &mX[mCursor * STEREO];
-    const int numLoops = mNumTaps >> 2; // n/4
-    for (int i = 0; i < numLoops; i++) {
-        // Manual loop unrolling, might get converted to SIMD.
-        float coefficient = *coefficients++;
-        left += *xFrame++ * coefficient;
-        right += *xFrame++ * coefficient;
-
-        coefficient = *coefficients++; // next tap
-        left += *xFrame++ * coefficient;
-        right += *xFrame++ * coefficient;
-
-        coefficient = *coefficients++;  // next tap
-        left += *xFrame++ * coefficient;
-        right += *xFrame++ * coefficient;
-
-        coefficient = *coefficients++;  // next tap
-        left += *xFrame++ * coefficient;
-        right += *xFrame++ * coefficient;
-    }
-
-    mCoefficientCursor = (mCoefficientCursor + mNumTaps) % mCoefficients.size();
+    const float *xFrame = &mX[mCursor * STEREO];
+    convolveStereo(xFrame, coefficients, mNumTaps, frame);
 
-    // Copy accumulators to output.
-    frame[0] = left;
-    frame[1] = right;
+    advanceCoefficientCursor();
 }
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_RESAMPLER_KERNELS_H
+#define RESAMPLER_RESAMPLER_KERNELS_H
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RESAMPLER_USE_NEON 1
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define RESAMPLER_USE_SSE 1
+#endif
+
+#include "ResamplerDefinitions.h"
+
+/**
+ * FIR inner loops shared by the resamplers.
+ *
+ * The input holds numTaps frames of interleaved samples and the coefficients
+ * hold one row of numTaps values. numTaps must be a multiple of four.
+ * These use NEON or SSE when available and plain loops otherwise.
+ */
+namespace RESAMPLER_OUTER_NAMESPACE::resampler {
+
+// @return sum of input[i] * coefficients[i]
+static inline float convolveMono(const float *input, const float *coefficients,
+                                 int32_t numTaps) {
+#if RESAMPLER_USE_NEON
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        sum = vmlaq_f32(sum, vld1q_f32(input + i), vld1q_f32(coefficients + i));
+    }
+    float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    return vget_lane_f32(vpadd_f32(half, half), 0);
+#elif RESAMPLER_USE_SSE
+    __m128 sum = _mm_setzero_ps();
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(input + i),
+                                         _mm_loadu_ps(coefficients + i)));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#else
+    float sum = 0.0f;
+    for (int32_t i = 0; i < numTaps; i++) {
+        sum += input[i] * coefficients[i];
+    }
+    return sum;
+#endif
+}
+
+// Process two stereo frames per vector, with each coefficient duplicated for L and R.
+static inline void convolveStereo(const float *input, const float *coefficients,
+                                  int32_t numTaps, float *output) {
+#if RESAMPLER_USE_NEON
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        float32x4x2_t pairs = vzipq_f32(vld1q_f32(coefficients + i),
+                                        vld1q_f32(coefficients + i));
+        sum = vmlaq_f32(sum, vld1q_f32(input + 2 * i), pairs.val[0]);
+        sum = vmlaq_f32(sum, vld1q_f32(input + 2 * i + 4), pairs.val[1]);
+    }
+    vst1_f32(output, vadd_f32(vget_low_f32(sum), vget_high_f32(sum)));
+#elif RESAMPLER_USE_SSE
+    __m128 sum = _mm_setzero_ps();
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        __m128 coefficient = _mm_loadu_ps(coefficients + i);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(input + 2 * i),
+                                         _mm_unpacklo_ps(coefficient, coefficient)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(input + 2 * i + 4),
+                                         _mm_unpackhi_ps(coefficient, coefficient)));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    _mm_storel_pi(reinterpret_cast<__m64 *>(output), sum);
+#else
+    float left = 0.0f;
+    float right = 0.0f;
+    for (int32_t i = 0; i < numTaps; i++) {
+        left += input[2 * i] * coefficients[i];
+        right += input[2 * i + 1] * coefficients[i];
+    }
+    output[0] = left;
+    output[1] = right;
+#endif
+}
+
+// Vectorize across channels, four at a time, then finish any remaining channels.
+static inline void convolveChannels(const float *input, const float *coefficients,
+                                    int32_t numTaps, int32_t channelCount, float *output) {
+    int32_t channel = 0;
+#if RESAMPLER_USE_NEON
+    for (; channel + 4 <= channelCount; channel += 4) {
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        const float *x = input + channel;
+        for (int32_t i = 0; i < numTaps; i++, x += channelCount) {
+            sum = vmlaq_n_f32(sum, vld1q_f32(x), coefficients[i]);
+        }
+        vst1q_f32(output + channel, sum);
+    }
+#elif RESAMPLER_USE_SSE
+    for (; channel + 4 <= channelCount; channel += 4) {
+        __m128 sum = _mm_setzero_ps();
+        const float *x = input + channel;
+        for (int32_t i = 0; i < numTaps; i++, x += channelCount) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x), _mm_set1_ps(coefficients[i])));
+        }
+        _mm_storeu_ps(output + channel, sum);
+    }
+#endif
+    for (; channel < channelCount; channel++) {
+        float sum = 0.0f;
+        const float *x = input + channel;
+        for (int32_t i = 0; i < numTaps; i++, x += channelCount) {
+            sum += *x * coefficients[i];
+        }
+        output[channel] = sum;
+    }
+}
+
+// output[i] = low[i] + fraction * (high[i] - low[i])
+static inline void interpolateCoefficients(const float *low, const float *high,
+                                           float fraction, int32_t numTaps, float *output) {
+#if RESAMPLER_USE_NEON
+    const float32x4_t scale = vdupq_n_f32(fraction);
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        float32x4_t lowValues = vld1q_f32(low + i);
+        vst1q_f32(output + i, vmlaq_f32(lowValues, scale,
+                                        vsubq_f32(vld1q_f32(high + i), lowValues)));
+    }
+#elif RESAMPLER_USE_SSE
+    const __m128 scale = _mm_set1_ps(fraction);
+    for (int32_t i = 0; i < numTaps; i += 4) {
+        __m128 lowValues = _mm_loadu_ps(low + i);
+        _mm_storeu_ps(output + i, _mm_add_ps(lowValues, _mm_mul_ps(scale,
+                _mm_sub_ps(_mm_loadu_ps(high + i), lowValues))));
+    }
+#else
+    for (int32_t i = 0; i < numTaps; i++) {
+        output[i] = low[i] + (fraction * (high[i] - low[i]));
+    }
+#endif
+}
+
+} /* namespace RESAMPLER_OUTER_NAMESPACE::resampler */
+
+#endif //RESAMPLER_RESAMPLER_KERNELS_H
@@ -16,13 +16,14 @@
 
 #include <cassert>
 #include <math.h>
+#include "ResamplerKernels.h"
 #include "SincResampler.h"
 
 using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
 
 SincResampler::SincResampler(const MultiChannelResampler::Builder &builder)
         : MultiChannelResampler(builder)
-        , mSingleFrame2(builder.getChannelCount()) {
+        , mInterpolatedCoefficients(builder.getNumTaps()) {
     assert((getNumTaps() % 4) == 0); // Required for loop unrolling.
     mNumRows = kMaxCoefficients / getNumTaps(); // includes guard row
     const int32_t numRowsNoGuard = mNumRows - 1;
@@ -35,37 +36,27 @@ SincResampler::SincResampler(const MultiChannelResampler::Builder &builder)
                          builder.getNormalizedCutoff());
 }
 
-void SincResampler::readFrame(float *frame) {
-    // Clear accumulator for mixing.
-    std::fill(mSingleFrame.begin(), mSingleFrame.end(), 0.0);
-    std::fill(mSingleFrame2.begin(), mSingleFrame2.end(), 0.0);
-
+// The FIR is linear so interpolating the coefficients before filtering gives
+// the same result as filtering with both rows and interpolating the outputs.
+const float *SincResampler::getInterpolatedCoefficients() {
     // Determine indices into coefficients table.
     const double tablePhase = getIntegerPhase() * mPhaseScaler;
     const int indexLow = static_cast<int>(floor(tablePhase));
     const int indexHigh = indexLow + 1; // OK because using a guard row.
     assert (indexHigh < mNumRows);
-    float *coefficientsLow = &mCoefficients[static_cast<size_t>(indexLow)
-                                            * static_cast<size_t>(getNumTaps())];
-    float *coefficientsHigh = &mCoefficients[static_cast<size_t>(indexHigh)
-                                             * static_cast<size_t>(getNumTaps())];
-
-    float *xFrame = &mX[static_cast<size_t>(mCursor) * static_cast<size_t>(getChannelCount())];
-    for (int tap = 0; tap < mNumTaps; tap++) {
-        const float coefficientLow = *coefficientsLow++;
-        const float coefficientHigh = *coefficientsHigh++;
-        for (int channel = 0; channel < getChannelCount(); channel++) {
-            const float sample = *xFrame++;
-            mSingleFrame[channel] += sample * coefficientLow;
-            mSingleFrame2[channel] += sample * coefficientHigh;
-        }
-    }
-
-    // Interpolate and copy to output.
+    const float *coefficientsLow = &mCoefficients[static_cast<size_t>(indexLow)
+                                                  * static_cast<size_t>(getNumTaps())];
+    const float *coefficientsHigh = &mCoefficients[static_cast<size_t>(indexHigh)
+                                                   * static_cast<size_t>(getNumTaps())];
     const float fraction = tablePhase - indexLow;
-    for (int channel = 0; channel < getChannelCount(); channel++) {
-        const float low = mSingleFrame[channel];
-        const float high = mSingleFrame2[channel];
-        frame[channel] = low + (fraction * (high - low));
-    }
+    interpolateCoefficients(coefficientsLow, coefficientsHigh, fraction,
+                            mNumTaps, mInterpolatedCoefficients.data());
+    return mInterpolatedCoefficients.data();
+}
+
+void SincResampler::readFrame(float *frame) {
+    const float *coefficients = getInterpolatedCoefficients();
+    const float *xFrame = &mX[static_cast<size_t>(mCursor)
+                              * static_cast<size_t>(getChannelCount())];
+    convolveChannels(xFrame, coefficients, mNumTaps, getChannelCount(), frame);
 }
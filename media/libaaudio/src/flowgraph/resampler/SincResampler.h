@@ -40,7 +40,10 @@ public:
 
 protected:
 
-    std::vector<float> mSingleFrame2; // for interpolation
+    // @return coefficients interpolated between the two table rows nearest the phase
+    const float *getInterpolatedCoefficients();
+
+    std::vector<float> mInterpolatedCoefficients; // one row between two table rows
     int32_t            mNumRows = 0;
     double             mPhaseScaler = 1.0;
 };
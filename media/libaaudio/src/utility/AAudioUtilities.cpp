@@ -630,6 +630,10 @@ int32_t AAudioProperty_getOutputMMapOffsetMicros() {
     return AAudioProperty_getMMapOffsetMicros(__func__, AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC);
 }
 
+bool AAudioProperty_isCaptureBroadcastEnabled() {
+    return property_get_bool(AAUDIO_PROP_CAPTURE_BROADCAST, false);
+}
+
 int32_t AAudioProperty_getLogMask() {
     return property_get_int32(AAUDIO_PROP_LOG_MASK, 0);
 }
@@ -166,6 +166,16 @@ int32_t AAudioProperty_getInputMMapOffsetMicros();
 int32_t AAudioProperty_getOutputMMapOffsetMicros();
 #define AAUDIO_PROP_OUTPUT_MMAP_OFFSET_USEC   "aaudio.out_mmap_offset_usec"
 
+/**
+ * Read a system property that specifies whether shared capture streams read directly
+ * from a ring buffer that is shared by all the clients of the endpoint, instead of
+ * each getting its own copy of the data.
+ *
+ * @return true if shared capture endpoints should broadcast their data
+ */
+bool AAudioProperty_isCaptureBroadcastEnabled();
+#define AAUDIO_PROP_CAPTURE_BROADCAST   "aaudio.capture_broadcast"
+
 // These are powers of two that can be combined as a bit mask.
 // AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM must be enabled before the stream is opened.
 #define AAUDIO_LOG_CLOCK_MODEL_HISTOGRAM   1
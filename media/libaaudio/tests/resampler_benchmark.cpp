@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "flowgraph/resampler/MultiChannelResampler.h"
+
+using namespace RESAMPLER_OUTER_NAMESPACE::resampler;
+
+/*
+ * Benchmark the resamplers picked by MultiChannelResampler::make().
+ *
+ * Arguments are the quality, the channel count and the sink rate. The source
+ * rate is 44100. A 48000 sink uses the polyphase resamplers and a 47999 sink,
+ * whose reduced ratio is too large for a full table, uses the sinc resamplers.
+ * Fastest is always the linear resampler.
+ */
+
+static constexpr int32_t kSourceRate = 44100;
+static constexpr int32_t kNumInputFrames = 960;
+
+static void BM_Resample(benchmark::State& state) {
+    const auto quality = static_cast<MultiChannelResampler::Quality>(state.range(0));
+    const int32_t channelCount = state.range(1);
+    const int32_t sinkRate = state.range(2);
+
+    std::vector<float> input(kNumInputFrames * channelCount);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = sinf(i * 0.01f);
+    }
+    std::vector<float> output(channelCount);
+
+    std::unique_ptr<MultiChannelResampler> resampler(MultiChannelResampler::make(
+            channelCount, kSourceRate, sinkRate, quality));
+
+    int64_t framesRead = 0;
+    for (auto _ : state) {
+        for (int32_t i = 0; i < kNumInputFrames;) {
+            if (resampler->isWriteNeeded()) {
+                resampler->writeNextFrame(&input[i++ * channelCount]);
+            } else {
+                resampler->readNextFrame(output.data());
+                framesRead++;
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(framesRead);
+}
+
+static void ResampleArgs(benchmark::internal::Benchmark* b) {
+    for (int sinkRate : {48000, 47999}) {
+        for (int quality = static_cast<int>(MultiChannelResampler::Quality::Fastest);
+                quality <= static_cast<int>(MultiChannelResampler::Quality::Best); quality++) {
+            for (int channelCount : {1, 2, 4, 6, 8}) {
+                b->Args({quality, channelCount, sinkRate});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_Resample)->Apply(ResampleArgs);
+
+// Opening a stream builds the coefficient table, which is shared while in use.
+static void BM_ResamplerMake(benchmark::State& state) {
+    const auto quality = static_cast<MultiChannelResampler::Quality>(state.range(0));
+    const int32_t sinkRate = state.range(1);
+    const bool shared = state.range(2);
+
+    std::unique_ptr<MultiChannelResampler> keep;
+    if (shared) {
+        keep.reset(MultiChannelResampler::make(2, kSourceRate, sinkRate, quality));
+    }
+    for (auto _ : state) {
+        std::unique_ptr<MultiChannelResampler> resampler(MultiChannelResampler::make(
+                2, kSourceRate, sinkRate, quality));
+        benchmark::DoNotOptimize(resampler.get());
+    }
+}
+
+BENCHMARK(BM_ResamplerMake)
+    ->ArgsProduct({{static_cast<int>(MultiChannelResampler::Quality::Medium),
+                    static_cast<int>(MultiChannelResampler::Quality::Best)},
+                   {48000, 47999},
+                   {0, 1}});
+
+BENCHMARK_MAIN();
@@ -22,6 +22,7 @@
  */
 
 #include <iostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -223,3 +224,64 @@ TEST(test_resampler, resampler_48000_44100_best) {
 TEST(test_resampler, resampler_44100_11025_best) {
     checkResampler(44100, 11025, MultiChannelResampler::Quality::Best);
 }
+
+/**
+ * Resample several channels at once and compare each one with a mono resampler.
+ * The multi-channel inner loops are vectorized differently than the mono one.
+ */
+static void checkChannelsMatchMono(int32_t sourceRate, int32_t sinkRate,
+        MultiChannelResampler::Quality quality) {
+    const int kNumInputFrames = 2000;
+    const int kMaxChannels = 8;
+
+    for (int channelCount = 2; channelCount <= kMaxChannels; channelCount++) {
+        std::vector<float> input(kNumInputFrames * channelCount);
+        for (int i = 0; i < kNumInputFrames; i++) {
+            for (int channel = 0; channel < channelCount; channel++) {
+                input[i * channelCount + channel] = sinf(i * 0.01f * (channel + 1));
+            }
+        }
+
+        std::unique_ptr<MultiChannelResampler> mcResampler(MultiChannelResampler::make(
+                channelCount, sourceRate, sinkRate, quality));
+        std::vector<float> output;
+        std::vector<float> frame(channelCount);
+        for (int i = 0; i < kNumInputFrames;) {
+            if (mcResampler->isWriteNeeded()) {
+                mcResampler->writeNextFrame(&input[i++ * channelCount]);
+            } else {
+                mcResampler->readNextFrame(frame.data());
+                output.insert(output.end(), frame.begin(), frame.end());
+            }
+        }
+        const int numOutputFrames = output.size() / channelCount;
+
+        for (int channel = 0; channel < channelCount; channel++) {
+            std::unique_ptr<MultiChannelResampler> monoResampler(MultiChannelResampler::make(
+                    1, sourceRate, sinkRate, quality));
+            int outputIndex = 0;
+            for (int i = 0; i < kNumInputFrames;) {
+                if (monoResampler->isWriteNeeded()) {
+                    monoResampler->writeNextFrame(&input[i++ * channelCount + channel]);
+                } else {
+                    float sample;
+                    monoResampler->readNextFrame(&sample);
+                    ASSERT_LT(outputIndex, numOutputFrames);
+                    ASSERT_NEAR(sample, output[outputIndex * channelCount + channel], 1.0e-5)
+                            << "channelCount = " << channelCount << ", channel = " << channel
+                            << ", frame = " << outputIndex;
+                    outputIndex++;
+                }
+            }
+            EXPECT_EQ(numOutputFrames, outputIndex);
+        }
+    }
+}
+
+TEST(test_resampler, resampler_channels_match_mono_polyphase) {
+    checkChannelsMatchMono(44100, 48000, MultiChannelResampler::Quality::Medium);
+}
+
+TEST(test_resampler, resampler_channels_match_mono_sinc) {
+    checkChannelsMatchMono(11025, 48000, MultiChannelResampler::Quality::Best);
+}
@@ -18,6 +18,7 @@
 #define LOG_TAG "AudioMixer"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <sstream>
 #include <stdint.h>
 #include <string.h>
@@ -184,6 +185,7 @@ status_t AudioMixer::Track::prepareForDownmix()
             if (static_cast<DownmixerBufferProvider *>(mDownmixerBufferProvider.get())
                     ->isValid()) {
                 mDownmixRequiresFormat = format;
+                mDownmixerFusable = false;
                 reconfigureBufferProviders();
                 return NO_ERROR;
             }
@@ -201,6 +203,7 @@ status_t AudioMixer::Track::prepareForDownmix()
         if (static_cast<ChannelMixBufferProvider *>(mDownmixerBufferProvider.get())
                 ->isValid()) {
             mDownmixRequiresFormat = mMixerInFormat;
+            mDownmixerFusable = true;
             reconfigureBufferProviders();
             ALOGD("%s: Fallback using ChannelMix", __func__);
             return NO_ERROR;
@@ -212,6 +215,7 @@ status_t AudioMixer::Track::prepareForDownmix()
     // Effect downmixer does not accept the channel conversion.  Let's use our remixer.
     mDownmixerBufferProvider.reset(new RemixBufferProvider(channelMask,
             mMixerChannelMask, mMixerInFormat, kCopyBufferFrameCount));
+    mDownmixerFusable = true;
     // Remix always finds a conversion whereas Downmixer effect above may fail.
     reconfigureBufferProviders();
     return NO_ERROR;
@@ -336,32 +340,89 @@ void AudioMixer::Track::clearTeeFrameCopied() {
 
 void AudioMixer::Track::reconfigureBufferProviders()
 {
+    // Fused providers whose stages did not change are reused below, so changing
+    // only the input provider (e.g. when a track is removed) does not allocate.
+    // Like the other providers, a fused provider keeps its buffer unless its
+    // upstream provider changes.
+    size_t fusedCount = 0;  // providers before this index are in the new chain
+
     // configure from upstream to downstream buffer providers.
+    // Runs of consecutive fusable providers are collected in stages and replaced by
+    // a single FusedBufferProvider; a run of one provider is chained as is.
+    std::vector<CopyBufferProvider *> stages;
+    const auto chainStages = [this, &stages, &fusedCount]() {
+        if (stages.size() == 1) {
+            stages[0]->setBufferProvider(bufferProvider);
+            bufferProvider = stages[0];
+        } else if (stages.size() > 1) {
+            for (CopyBufferProvider *stage : stages) {
+                stage->setBufferProvider(nullptr);
+            }
+            const auto unused = mFusedBufferProviders.begin() + fusedCount;
+            const auto it = std::find_if(unused, mFusedBufferProviders.end(),
+                    [&stages](const auto &fused) { return fused->hasStages(stages); });
+            if (it != mFusedBufferProviders.end()) {
+                std::iter_swap(unused, it);
+            } else {
+                mFusedBufferProviders.emplace(unused,
+                        new FusedBufferProvider(std::move(stages), kCopyBufferFrameCount));
+            }
+            FusedBufferProvider *fused = mFusedBufferProviders[fusedCount++].get();
+            fused->setBufferProvider(bufferProvider);
+            bufferProvider = fused;
+        }
+        stages.clear();
+    };
+    const auto chain = [this, &stages, &chainStages](
+            PassthruBufferProvider *provider, bool fusable) {
+        if (provider == nullptr) {
+            return;
+        }
+        if (fusable) {
+            // all fusable providers are CopyBufferProviders.
+            stages.push_back(static_cast<CopyBufferProvider *>(provider));
+            return;
+        }
+        chainStages();
+        provider->setBufferProvider(bufferProvider);
+        bufferProvider = provider;
+    };
+
     bufferProvider = mInputBufferProvider;
-    if (mTeeBufferProvider != nullptr) {
-        mTeeBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mTeeBufferProvider.get();
-    }
-    if (mAdjustChannelsBufferProvider.get() != nullptr) {
-        mAdjustChannelsBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mAdjustChannelsBufferProvider.get();
-    }
-    if (mReformatBufferProvider.get() != nullptr) {
-        mReformatBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mReformatBufferProvider.get();
-    }
-    if (mDownmixerBufferProvider.get() != nullptr) {
-        mDownmixerBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mDownmixerBufferProvider.get();
-    }
-    if (mPostDownmixReformatBufferProvider.get() != nullptr) {
-        mPostDownmixReformatBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mPostDownmixReformatBufferProvider.get();
-    }
-    if (mTimestretchBufferProvider.get() != nullptr) {
-        mTimestretchBufferProvider->setBufferProvider(bufferProvider);
-        bufferProvider = mTimestretchBufferProvider.get();
+    chain(mTeeBufferProvider.get(), true /* fusable */);
+    // AdjustChannelsBufferProvider limits the frames obtained and writes past the
+    // output frames, so it keeps its own buffer.
+    chain(mAdjustChannelsBufferProvider.get(), false /* fusable */);
+    chain(mReformatBufferProvider.get(), true /* fusable */);
+    chain(mDownmixerBufferProvider.get(), mDownmixerFusable);
+    chain(mPostDownmixReformatBufferProvider.get(), true /* fusable */);
+    chainStages();
+    chain(mTimestretchBufferProvider.get(), false /* fusable */);
+
+    // the remaining fused providers have stages that are no longer used.
+    // They release any buffer held on destruction, unless the upstream provider
+    // is already gone, in which case the buffer is dropped.
+    const auto isLive = [this, fusedCount](const AudioBufferProvider *provider) {
+        if (provider == mInputBufferProvider
+                || provider == mTeeBufferProvider.get()
+                || provider == mAdjustChannelsBufferProvider.get()
+                || provider == mReformatBufferProvider.get()
+                || provider == mDownmixerBufferProvider.get()
+                || provider == mPostDownmixReformatBufferProvider.get()
+                || provider == mTimestretchBufferProvider.get()) {
+            return true;
+        }
+        return std::any_of(mFusedBufferProviders.begin(),
+                mFusedBufferProviders.begin() + fusedCount,
+                [provider](const auto &fused) { return provider == fused.get(); });
+    };
+    for (size_t i = fusedCount; i < mFusedBufferProviders.size(); ++i) {
+        if (!isLive(mFusedBufferProviders[i]->getBufferProvider())) {
+            mFusedBufferProviders[i]->setBufferProvider(nullptr);
+        }
     }
+    mFusedBufferProviders.erase(mFusedBufferProviders.begin() + fusedCount,
+            mFusedBufferProviders.end());
 }
 
 void AudioMixer::setParameter(int name, int target, int param, void *value)
@@ -539,6 +600,9 @@ void AudioMixer::setBufferProvider(int name, AudioBufferProvider* bufferProvider
     // reset order from downstream to upstream buffer providers.
     if (track->mTimestretchBufferProvider.get() != nullptr) {
         track->mTimestretchBufferProvider->reset();
+    } else if (!track->mFusedBufferProviders.empty()
+            && track->bufferProvider == track->mFusedBufferProviders.back().get()) {
+        track->mFusedBufferProviders.back()->reset();
     } else if (track->mPostDownmixReformatBufferProvider.get() != nullptr) {
         track->mPostDownmixReformatBufferProvider->reset();
     } else if (track->mDownmixerBufferProvider != nullptr) {
@@ -555,6 +619,19 @@ void AudioMixer::setBufferProvider(int name, AudioBufferProvider* bufferProvider
     track->reconfigureBufferProviders();
 }
 
+size_t AudioMixer::getCopiesAvoidedPerCycle() const
+{
+    size_t copies = 0;
+    for (const auto &pair : mTracks) {
+        const Track *t = static_cast<const Track *>(pair.second.get());
+        if (!t->enabled) continue;
+        for (const auto &fused : t->mFusedBufferProviders) {
+            copies += fused->getCopiesAvoided();
+        }
+    }
+    return copies;
+}
+
 /*static*/ pthread_once_t AudioMixer::sOnceControl = PTHREAD_ONCE_INIT;
 
 /*static*/ void AudioMixer::sInitRoutine()
@@ -582,6 +659,7 @@ status_t AudioMixer::postCreateTrack(TrackBase *track)
     t->channelMask = channelMask;
     t->mInputBufferProvider = NULL;
     t->mDownmixRequiresFormat = AUDIO_FORMAT_INVALID; // no format required
+    t->mDownmixerFusable = false;
     t->mPlaybackRate = AUDIO_PLAYBACK_RATE_DEFAULT;
     // haptic
     t->mHapticPlaybackEnabled = false;
@@ -19,13 +19,17 @@
 //#define LOG_NDEBUG 0
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <sstream>
 #include <string.h>
+#include <thread>
 
 #include <audio_utils/primitives.h>
 #include <cutils/compiler.h>
 #include <media/AudioMixerBase.h>
-#include <media/AudioNeonCal.h>
 #include <utils/Log.h>
 
 #include "AudioMixerOps.h"
@@ -57,6 +61,114 @@ namespace android {
 
 // ----------------------------------------------------------------------------
 
+// Worker threads for process__parallel().
+//
+// run() hands out job indices to the workers and to the calling thread through an atomic
+// counter, so the assignment of jobs to threads varies, but every job writes only its own
+// output and the results do not depend on it.
+class AudioMixerBase::ParallelMixer {
+public:
+    using job_t = std::function<void(size_t index, int32_t *temp)>;
+
+    ParallelMixer(size_t threadCount, size_t frameCount)
+    {
+        // one temp buffer per worker, plus one for the calling thread.
+        for (size_t i = 0; i <= threadCount; ++i) {
+            mTemp.emplace_back(new int32_t[MAX_NUM_CHANNELS * frameCount]);
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            mThreads.emplace_back(&ParallelMixer::threadLoop, this, i);
+        }
+    }
+
+    ~ParallelMixer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mExit = true;
+        }
+        mWorkCv.notify_all();
+        for (auto &thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    size_t threadCount() const { return mThreads.size(); }
+
+    // Calls job(index, temp) for each index in [0, count), and returns when all calls are done.
+    // temp is a scratch buffer of MAX_NUM_CHANNELS * frameCount samples owned by the thread
+    // making the call.
+    void run(size_t count, const job_t &job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mJob = &job;
+            mCount = count;
+            mNext = 0;
+            mBusy = mThreads.size();
+            ++mGeneration;
+        }
+        mWorkCv.notify_all();
+        runJobs(mThreads.size());
+
+        std::unique_lock<std::mutex> lock(mLock);
+        mDoneCv.wait(lock, [this] { return mBusy == 0; });
+        mJob = nullptr;
+    }
+
+private:
+    void threadLoop(size_t thread)
+    {
+        uint64_t generation = 0;
+        std::unique_lock<std::mutex> lock(mLock);
+        for (;;) {
+            mWorkCv.wait(lock, [&] { return mExit || mGeneration != generation; });
+            if (mExit) {
+                return;
+            }
+            generation = mGeneration;
+            lock.unlock();
+            runJobs(thread);
+            lock.lock();
+            if (--mBusy == 0) {
+                mDoneCv.notify_one();
+            }
+        }
+    }
+
+    void runJobs(size_t thread)
+    {
+        for (size_t index; (index = mNext.fetch_add(1)) < mCount; ) {
+            (*mJob)(index, mTemp[thread].get());
+        }
+    }
+
+    std::vector<std::thread> mThreads;
+    std::vector<std::unique_ptr<int32_t[]>> mTemp;
+
+    std::mutex mLock;
+    std::condition_variable mWorkCv;    // a new job was posted, or the threads should exit
+    std::condition_variable mDoneCv;    // all workers are done with the job
+    uint64_t mGeneration = 0;           // incremented for each job, guarded by mLock
+    size_t mBusy = 0;                   // workers still running the job, guarded by mLock
+    bool mExit = false;                 // guarded by mLock
+
+    // the current job, set under mLock before the workers are woken.
+    const job_t *mJob = nullptr;
+    size_t mCount = 0;
+    std::atomic<size_t> mNext{0};
+};
+
+AudioMixerBase::AudioMixerBase(size_t frameCount, uint32_t sampleRate)
+    : mSampleRate(sampleRate)
+    , mFrameCount(frameCount)
+{
+}
+
+AudioMixerBase::~AudioMixerBase()
+{
+}
+
 bool AudioMixerBase::isValidFormat(audio_format_t format) const
 {
     switch (format) {
@@ -609,6 +721,24 @@ size_t AudioMixerBase::getUnreleasedFrames(int name) const
     return 0;
 }
 
+void AudioMixerBase::setParallelThreadCount(size_t threadCount)
+{
+    if (threadCount == getParallelThreadCount()) {
+        return;
+    }
+    mParallelMixer.reset();
+    if (threadCount > 0) {
+        mParallelMixer = std::make_unique<ParallelMixer>(threadCount, mFrameCount);
+    }
+    ALOGV("setParallelThreadCount(%zu)", threadCount);
+    invalidate();
+}
+
+size_t AudioMixerBase::getParallelThreadCount() const
+{
+    return mParallelMixer != nullptr ? mParallelMixer->threadCount() : 0;
+}
+
 std::string AudioMixerBase::trackNames() const
 {
     std::stringstream ss;
@@ -736,9 +866,31 @@ void AudioMixerBase::process__validate()
         }
     }
 
+    if (mParallelMixer != nullptr && mEnabled.size() > 1
+            && (mHook == &AudioMixerBase::process__genericResampling
+                    || mHook == &AudioMixerBase::process__genericNoResampling)) {
+        mParallelTracks.clear();
+        for (const auto &pair : mGroups) {
+            for (const int name : pair.second) {
+                TrackBase * const t = mTracks[name].get();
+                t->mParallelOut.resize(t->mMixerChannelCount * mFrameCount);
+                if (t->needs & NEEDS_AUX) {
+                    t->mParallelAux.resize(mFrameCount);
+                }
+                mParallelTracks.emplace_back(t);
+            }
+        }
+        if (mOutputTemp.get() == nullptr) {
+            mOutputTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+        mHook = resampling ? &AudioMixerBase::process__parallel<true>
+                : &AudioMixerBase::process__parallel<false>;
+    }
+
     ALOGV("mixer configuration change: %zu "
-        "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d",
-        mEnabled.size(), all16BitsStereoNoResample, resampling, volumeRamp);
+        "all16BitsStereoNoResample=%d, resampling=%d, volumeRamp=%d, parallel=%zu",
+        mEnabled.size(), all16BitsStereoNoResample, resampling, volumeRamp,
+        getParallelThreadCount());
 
     process();
 
@@ -1118,39 +1270,9 @@ void AudioMixerBase::process__genericNoResampling()
             memset(outTemp, 0, sizeof(outTemp));
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
-                int32_t *aux = NULL;
-                if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                    aux = t->auxBuffer + numFrames;
-                }
-                for (int outFrames = frameCount; outFrames > 0; ) {
-                    // t->in == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) {
-                        break;
-                    }
-                    size_t inFrames = (t->frameCount > outFrames)?outFrames:t->frameCount;
-                    if (inFrames > 0) {
-                        (t.get()->*t->hook)(
-                                outTemp + (frameCount - outFrames) * t->mMixerChannelCount,
-                                inFrames, mResampleTemp.get() /* naked ptr */, aux);
-                        t->frameCount -= inFrames;
-                        outFrames -= inFrames;
-                        if (CC_UNLIKELY(aux != NULL)) {
-                            aux += inFrames;
-                        }
-                    }
-                    if (t->frameCount == 0 && outFrames) {
-                        t->bufferProvider->releaseBuffer(&t->buffer);
-                        t->buffer.frameCount = (mFrameCount - numFrames) -
-                                (frameCount - outFrames);
-                        t->bufferProvider->getNextBuffer(&t->buffer);
-                        t->mIn = t->buffer.raw;
-                        if (t->mIn == nullptr) {
-                            break;
-                        }
-                        t->frameCount = t->buffer.frameCount;
-                    }
-                }
+                mixTrackNoResampling(t.get(), outTemp, numFrames, frameCount,
+                        (t->needs & NEEDS_AUX) ? t->auxBuffer : nullptr,
+                        mResampleTemp.get() /* naked ptr */);
             }
 
             const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
@@ -1171,12 +1293,50 @@ void AudioMixerBase::process__genericNoResampling()
     }
 }
 
+// Mixes frames [numFrames, numFrames + frameCount) of track t into out,
+// for process__genericNoResampling(). aux is the start of the track's aux buffer, or nullptr.
+void AudioMixerBase::mixTrackNoResampling(TrackBase *t, int32_t *out,
+        size_t numFrames, size_t frameCount, int32_t *aux, int32_t *temp)
+{
+    if (CC_UNLIKELY(aux != NULL)) {
+        aux += numFrames;
+    }
+    for (int outFrames = frameCount; outFrames > 0; ) {
+        // t->in == nullptr can happen if the track was flushed just after having
+        // been enabled for mixing.
+        if (t->mIn == nullptr) {
+            break;
+        }
+        size_t inFrames = (t->frameCount > outFrames)?outFrames:t->frameCount;
+        if (inFrames > 0) {
+            (t->*t->hook)(
+                    out + (frameCount - outFrames) * t->mMixerChannelCount,
+                    inFrames, temp, aux);
+            t->frameCount -= inFrames;
+            outFrames -= inFrames;
+            if (CC_UNLIKELY(aux != NULL)) {
+                aux += inFrames;
+            }
+        }
+        if (t->frameCount == 0 && outFrames) {
+            t->bufferProvider->releaseBuffer(&t->buffer);
+            t->buffer.frameCount = (mFrameCount - numFrames) -
+                    (frameCount - outFrames);
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            if (t->mIn == nullptr) {
+                break;
+            }
+            t->frameCount = t->buffer.frameCount;
+        }
+    }
+}
+
 // generic code with resampling
 void AudioMixerBase::process__genericResampling()
 {
     ALOGVV("process__genericResampling\n");
     int32_t * const outTemp = mOutputTemp.get(); // naked ptr
-    size_t numFrames = mFrameCount;
 
     for (const auto &pair : mGroups) {
         const auto &group = pair.second;
@@ -1186,40 +1346,130 @@ void AudioMixerBase::process__genericResampling()
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
             const std::shared_ptr<TrackBase> &t = mTracks[name];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                aux = t->auxBuffer;
-            }
+            mixTrackResampling(t.get(), outTemp,
+                    (t->needs & NEEDS_AUX) ? t->auxBuffer : nullptr,
+                    mResampleTemp.get() /* naked ptr */);
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, mFrameCount * t1->mMixerChannelCount);
+    }
+}
 
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
-            } else {
+// Mixes all frames of track t into out, for process__genericResampling().
+// aux is the track's aux buffer, or nullptr.
+void AudioMixerBase::mixTrackResampling(TrackBase *t, int32_t *out, int32_t *aux, int32_t *temp)
+{
+    const size_t numFrames = mFrameCount;
 
-                size_t outFrames = 0;
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(out, numFrames, temp, aux);
+    } else {
 
-                while (outFrames < numFrames) {
-                    t->buffer.frameCount = numFrames - outFrames;
-                    t->bufferProvider->getNextBuffer(&t->buffer);
-                    t->mIn = t->buffer.raw;
-                    // t->mIn == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) break;
+        size_t outFrames = 0;
 
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
-                    outFrames += t->buffer.frameCount;
+        while (outFrames < numFrames) {
+            t->buffer.frameCount = numFrames - outFrames;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->mIn == nullptr) break;
 
-                    t->bufferProvider->releaseBuffer(&t->buffer);
-                }
+            (t->*t->hook)(
+                    out + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                    temp, aux != nullptr ? aux + outFrames : nullptr);
+            outFrames += t->buffer.frameCount;
+
+            t->bufferProvider->releaseBuffer(&t->buffer);
+        }
+    }
+}
+
+// Adds count samples of src to dst.
+template <typename T>
+static void accumulateMix(T *dst, const T *src, size_t count)
+{
+    for (; count >= kMixVecLanes; count -= kMixVecLanes) {
+        mixVecStore(dst, mixVecLoad(dst) + mixVecLoad(src));
+        dst += kMixVecLanes;
+        src += kMixVecLanes;
+    }
+    for (; count > 0; --count) {
+        *dst++ += *src++;
+    }
+}
+
+/* Parallel form of process__genericResampling() and process__genericNoResampling().
+ *
+ * Each track is mixed exactly as by the serial hook, but into its own zeroed partial
+ * buffers, on whichever thread picks it up. The partial buffers are then summed on
+ * the calling thread in the order the serial hook mixes the tracks, so every output
+ * sample is the same sum, in the same order, as in serial mixing.
+ */
+template <bool RESAMPLING>
+void AudioMixerBase::process__parallel()
+{
+    ALOGVV("process__parallel\n");
+
+    mParallelMixer->run(mParallelTracks.size(), [this](size_t index, int32_t *temp) {
+        TrackBase * const t = mParallelTracks[index];
+        int32_t * const out = t->mParallelOut.data();
+        memset(out, 0, t->mParallelOut.size() * sizeof(int32_t));
+        int32_t *aux = nullptr;
+        if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+            aux = t->mParallelAux.data();
+            memset(aux, 0, t->mParallelAux.size() * sizeof(int32_t));
+        }
+
+        if constexpr (RESAMPLING) {
+            mixTrackResampling(t, out, aux, temp);
+        } else {
+            // Use the same blocks as process__genericNoResampling(), as volume ramps
+            // are adjusted at the end of each call to the track hook.
+            t->buffer.frameCount = mFrameCount;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->frameCount = t->buffer.frameCount;
+            t->mIn = t->buffer.raw;
+            size_t numFrames = 0;
+            do {
+                const size_t frameCount = std::min((size_t)BLOCKSIZE, mFrameCount - numFrames);
+                mixTrackNoResampling(t, out + numFrames * t->mMixerChannelCount,
+                        numFrames, frameCount, aux, temp);
+                numFrames += frameCount;
+            } while (numFrames < mFrameCount);
+            t->bufferProvider->releaseBuffer(&t->buffer);
+        }
+    });
+
+    int32_t * const outTemp = mOutputTemp.get(); // naked ptr
+    size_t index = 0;
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        const TrackBase * const t1 = mParallelTracks[index];
+        const size_t sampleCount = mFrameCount * t1->mMixerChannelCount;
+
+        memset(outTemp, 0, sizeof(*outTemp) * sampleCount);
+        for (size_t i = 0; i < group.size(); ++i) {
+            const int32_t * const out = mParallelTracks[index++]->mParallelOut.data();
+            if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                accumulateMix((float *)outTemp, (const float *)out, sampleCount);
+            } else {
+                accumulateMix(outTemp, out, sampleCount);
             }
         }
         convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
-                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+                outTemp, t1->mMixerInFormat, sampleCount);
+    }
+
+    // aux buffers may be shared across groups, so these are summed in the same order.
+    for (const TrackBase *t : mParallelTracks) {
+        if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+            accumulateMix((TYPE_AUX *)t->auxBuffer, (const TYPE_AUX *)t->mParallelAux.data(),
+                    mFrameCount);
+        }
     }
 }
 
@@ -1619,20 +1869,9 @@ AudioMixerBase::hook_t AudioMixerBase::TrackBase::getTrackHook(int trackType, ui
     case TRACKTYPE_RESAMPLE:
         switch (mixerInFormat) {
         case AUDIO_FORMAT_PCM_FLOAT:
-            /* 
-             * If mtypeIds is not equal to FLOAT_FLOAT_FLOAT_MTYPE_IDS,
-             * recalculate the ids corresponding to the type
-             * The same applies to the following case
-             */
-            if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                checkTypeIds<float, float, float>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__Resample<
                     MIXTYPE_MULTI, float /*TO*/, float /*TI*/, TYPE_AUX>;
         case AUDIO_FORMAT_PCM_16_BIT:
-            if(mtypeIds != AudioMixerBase::INT_INT16_INT16_MTYPE_IDS){
-                checkTypeIds<int32_t, int16_t, int16_t>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__Resample<
                     MIXTYPE_MULTI, int32_t /*TO*/, int16_t /*TI*/, TYPE_AUX>;
         default:
@@ -1643,16 +1882,10 @@ AudioMixerBase::hook_t AudioMixerBase::TrackBase::getTrackHook(int trackType, ui
     case TRACKTYPE_RESAMPLESTEREO:
         switch (mixerInFormat) {
         case AUDIO_FORMAT_PCM_FLOAT:
-            if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                checkTypeIds<float, float, float>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__Resample<
                     MIXTYPE_MULTI_STEREOVOL, float /*TO*/, float /*TI*/,
                     TYPE_AUX>;
         case AUDIO_FORMAT_PCM_16_BIT:
-            if(mtypeIds != AudioMixerBase::INT_INT16_INT16_MTYPE_IDS){
-                checkTypeIds<int32_t, int16_t, int16_t>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__Resample<
                     MIXTYPE_MULTI_STEREOVOL, int32_t /*TO*/, int16_t /*TI*/,
                     TYPE_AUX>;
@@ -1666,16 +1899,10 @@ AudioMixerBase::hook_t AudioMixerBase::TrackBase::getTrackHook(int trackType, ui
     case TRACKTYPE_RESAMPLEMONO:
         switch (mixerInFormat) {
         case AUDIO_FORMAT_PCM_FLOAT:
-            if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                checkTypeIds<float, float, float>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__Resample<
                     MIXTYPE_STEREOEXPAND, float /*TO*/, float /*TI*/,
                     TYPE_AUX>;
         case AUDIO_FORMAT_PCM_16_BIT:
-            if(mtypeIds != AudioMixerBase::INT_INT16_INT16_MTYPE_IDS){
-                checkTypeIds<int32_t, int16_t, int16_t>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__Resample<
                     MIXTYPE_STEREOEXPAND, int32_t /*TO*/, int16_t /*TI*/,
                     TYPE_AUX>;
@@ -1687,15 +1914,9 @@ AudioMixerBase::hook_t AudioMixerBase::TrackBase::getTrackHook(int trackType, ui
     case TRACKTYPE_NORESAMPLEMONO:
         switch (mixerInFormat) {
         case AUDIO_FORMAT_PCM_FLOAT:
-            if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                checkTypeIds<float, float, float>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__NoResample<
                             MIXTYPE_MONOEXPAND, float /*TO*/, float /*TI*/, TYPE_AUX>;
         case AUDIO_FORMAT_PCM_16_BIT:
-            if(mtypeIds != AudioMixerBase::INT_INT16_INT16_MTYPE_IDS){
-                checkTypeIds<int32_t, int16_t, int16_t>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__NoResample<
                             MIXTYPE_MONOEXPAND, int32_t /*TO*/, int16_t /*TI*/, TYPE_AUX>;
         default:
@@ -1706,15 +1927,9 @@ AudioMixerBase::hook_t AudioMixerBase::TrackBase::getTrackHook(int trackType, ui
     case TRACKTYPE_NORESAMPLE:
         switch (mixerInFormat) {
         case AUDIO_FORMAT_PCM_FLOAT:
-            if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                checkTypeIds<float, float, float>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__NoResample<
                     MIXTYPE_MULTI, float /*TO*/, float /*TI*/, TYPE_AUX>;
         case AUDIO_FORMAT_PCM_16_BIT:
-            if(mtypeIds != AudioMixerBase::INT_INT16_INT16_MTYPE_IDS){
-                checkTypeIds<int32_t, int16_t, int16_t>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__NoResample<
                     MIXTYPE_MULTI, int32_t /*TO*/, int16_t /*TI*/, TYPE_AUX>;
         default:
@@ -1725,16 +1940,10 @@ AudioMixerBase::hook_t AudioMixerBase::TrackBase::getTrackHook(int trackType, ui
     case TRACKTYPE_NORESAMPLESTEREO:
         switch (mixerInFormat) {
         case AUDIO_FORMAT_PCM_FLOAT:
-            if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                checkTypeIds<float, float, float>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__NoResample<
                     MIXTYPE_MULTI_STEREOVOL, float /*TO*/, float /*TI*/,
                     TYPE_AUX>;
         case AUDIO_FORMAT_PCM_16_BIT:
-            if(mtypeIds != AudioMixerBase::INT_INT16_INT16_MTYPE_IDS){
-                checkTypeIds<int32_t, int16_t, int16_t>();
-            }
             return (AudioMixerBase::hook_t) &TrackBase::track__NoResample<
                     MIXTYPE_MULTI_STEREOVOL, int32_t /*TO*/, int16_t /*TI*/,
                     TYPE_AUX>;
@@ -1777,16 +1986,10 @@ AudioMixerBase::process_hook_t AudioMixerBase::getProcessHook(
         case AUDIO_FORMAT_PCM_FLOAT:
             switch (mixerOutFormat) {
             case AUDIO_FORMAT_PCM_FLOAT:
-                if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                    checkTypeIds<float, float, float>();
-                }
                 return &AudioMixerBase::process__noResampleOneTrack<
                         MIXTYPE_MULTI_SAVEONLY_STEREOVOL, float /*TO*/,
                         float /*TI*/, TYPE_AUX>;
             case AUDIO_FORMAT_PCM_16_BIT:
-                if(mtypeIds != AudioMixerBase::INT16_FLOAT_FLOAT_MTYPE_IDS){
-                    checkTypeIds<int16_t, float, float>();
-                }
                 return &AudioMixerBase::process__noResampleOneTrack<
                         MIXTYPE_MULTI_SAVEONLY_STEREOVOL, int16_t /*TO*/,
                         float /*TI*/, TYPE_AUX>;
@@ -1798,16 +2001,10 @@ AudioMixerBase::process_hook_t AudioMixerBase::getProcessHook(
         case AUDIO_FORMAT_PCM_16_BIT:
             switch (mixerOutFormat) {
             case AUDIO_FORMAT_PCM_FLOAT:
-                if(mtypeIds != AudioMixerBase::FLOAT_INT16_INT16_MTYPE_IDS){
-                    checkTypeIds<float, int16_t, int16_t>();
-                }
                 return &AudioMixerBase::process__noResampleOneTrack<
                         MIXTYPE_MULTI_SAVEONLY_STEREOVOL, float /*TO*/,
                         int16_t /*TI*/, TYPE_AUX>;
             case AUDIO_FORMAT_PCM_16_BIT:
-                if(mtypeIds != AudioMixerBase::INT16_INT16_INT16_MTYPE_IDS){
-                    checkTypeIds<int16_t, int16_t, int16_t>();
-                }
                 return &AudioMixerBase::process__noResampleOneTrack<
                         MIXTYPE_MULTI_SAVEONLY_STEREOVOL, int16_t /*TO*/,
                         int16_t /*TI*/, TYPE_AUX>;
@@ -1825,16 +2022,10 @@ AudioMixerBase::process_hook_t AudioMixerBase::getProcessHook(
           case AUDIO_FORMAT_PCM_FLOAT:
               switch (mixerOutFormat) {
               case AUDIO_FORMAT_PCM_FLOAT:
-                  if(mtypeIds != AudioMixerBase::FLOAT_FLOAT_FLOAT_MTYPE_IDS){
-                      checkTypeIds<float, float, float>();
-                  }
                   return &AudioMixerBase::process__noResampleOneTrack<
                           MIXTYPE_MULTI_SAVEONLY, float /*TO*/,
                           float /*TI*/, TYPE_AUX>;
               case AUDIO_FORMAT_PCM_16_BIT:
-                  if(mtypeIds != AudioMixerBase::INT16_FLOAT_FLOAT_MTYPE_IDS){
-                      checkTypeIds<int16_t, float, float>();
-                  }
                   return &AudioMixerBase::process__noResampleOneTrack<
                           MIXTYPE_MULTI_SAVEONLY, int16_t /*TO*/,
                           float /*TI*/, TYPE_AUX>;
@@ -1846,16 +2037,10 @@ AudioMixerBase::process_hook_t AudioMixerBase::getProcessHook(
           case AUDIO_FORMAT_PCM_16_BIT:
               switch (mixerOutFormat) {
               case AUDIO_FORMAT_PCM_FLOAT:
-                  if(mtypeIds != AudioMixerBase::FLOAT_INT16_INT16_MTYPE_IDS){
-                      checkTypeIds<float, int16_t, int16_t>();
-                  }
                   return &AudioMixerBase::process__noResampleOneTrack<
                           MIXTYPE_MULTI_SAVEONLY, float /*TO*/,
                           int16_t /*TI*/, TYPE_AUX>;
               case AUDIO_FORMAT_PCM_16_BIT:
-                  if(mtypeIds != AudioMixerBase::INT16_INT16_INT16_MTYPE_IDS){
-                      checkTypeIds<int16_t, int16_t, int16_t>();
-                  }
                   return &AudioMixerBase::process__noResampleOneTrack<
                           MIXTYPE_MULTI_SAVEONLY, int16_t /*TO*/,
                           int16_t /*TI*/, TYPE_AUX>;
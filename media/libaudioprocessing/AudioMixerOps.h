@@ -17,9 +17,12 @@
 #ifndef ANDROID_AUDIO_MIXER_OPS_H
 #define ANDROID_AUDIO_MIXER_OPS_H
 
+#include <array>
+#include <numeric>
+#include <type_traits>
+
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
-#include <media/AudioNeonCal.h>
 #include <system/audio.h>
 
 #if defined(__aarch64__) || defined(__ARM_NEON__)
@@ -385,95 +388,402 @@ void stereoVolumeHelper(TO*& out, const TI*& in, const TV *vol, F f) {
 }
 
 /*
- * Applies stereo volume to the audio data based on proper left right channel affinity
- * (templated channel MASK parameter).
- * but use neon cal
+ * Vector kernels for volumeMulti() and volumeRampMulti().
+ *
+ * These use the GCC/clang vector extensions with 4 lanes of 32 bits, which map onto
+ * SSE on x86 and NEON on ARM, so the same code serves every channel count and
+ * architecture. Every lane performs the same operations in the same order as the
+ * scalar MixMul() and MixAccum() above, so the results are identical to the scalar
+ * kernels; the aux send is still summed per frame in channel order for that reason.
+ *
+ * volumeMulti() processes the interleaved samples as one stream, with a
+ * precomputed volume vector for each position in a block of lcm(4, NCHAN) samples;
+ * it is used for 3 or more channels.
+ * volumeRampMulti() changes the volume every frame, so it vectorizes within a frame
+ * and is only used for 4 or more channels.
+ *
+ * Set USE_MIXER_VECTOR_OPS to false to use the scalar kernels only.
  */
-template <int MIXTYPE, audio_channel_mask_t MASK,
-        typename TO, typename TI, typename TV>
-void stereoVolumeHelperWithChannelMaskNeon(TO*& out, const TI*& in, const TV *vol) {
-    //Align the original MIXTTYPE==MIXTYPE.MULI_STEREOVOL condition and perform addition operation
-    bool isAdd = (MIXTYPE == MIXTYPE_MULTI_STEREOVOL);
+#ifndef USE_MIXER_VECTOR_OPS
+#define USE_MIXER_VECTOR_OPS (true)
+#endif
 
-    std::decay_t<TV> center;
-    constexpr bool USES_CENTER_CHANNEL = usesCenterChannel(MASK);
-    if constexpr (USES_CENTER_CHANNEL) {
-        if constexpr (std::is_floating_point_v<TV>) {
-            center = (vol[0] + vol[1]) * 0.5;       // do not use divide
+typedef float mix_f32x4_t __attribute__((vector_size(16)));
+typedef int32_t mix_i32x4_t __attribute__((vector_size(16)));
+typedef int16_t mix_i16x4_t __attribute__((vector_size(8)));
+
+// Unaligned forms for loads and stores; interleaved frames are only sample aligned.
+typedef float mix_f32x4_u_t __attribute__((vector_size(16), aligned(4), may_alias));
+typedef int32_t mix_i32x4_u_t __attribute__((vector_size(16), aligned(4), may_alias));
+typedef int16_t mix_i16x4_u_t __attribute__((vector_size(8), aligned(2), may_alias));
+
+constexpr size_t kMixVecLanes = 4;
+
+// int16_t and int32_t samples and volumes are processed in int32_t lanes.
+template <typename T>
+using MixVec = std::conditional_t<std::is_floating_point_v<T>, mix_f32x4_t, mix_i32x4_t>;
+
+template <typename T>
+inline MixVec<T> mixVecLoad(const T *p) {
+    if constexpr (std::is_same_v<T, int16_t>) {
+        return __builtin_convertvector(*(const mix_i16x4_u_t *)p, mix_i32x4_t);
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        return *(const mix_i32x4_u_t *)p;
+    } else {
+        return *(const mix_f32x4_u_t *)p;
+    }
+}
+
+// int16_t lanes are truncated, as when assigning an int to an int16_t.
+template <typename T>
+inline void mixVecStore(T *p, MixVec<T> v) {
+    if constexpr (std::is_same_v<T, int16_t>) {
+        *(mix_i16x4_u_t *)p = __builtin_convertvector(v, mix_i16x4_t);
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        *(mix_i32x4_u_t *)p = v;
+    } else {
+        *(mix_f32x4_u_t *)p = v;
+    }
+}
+
+template <typename T>
+inline MixVec<T> mixVecSplat(T x) {
+    return MixVec<T>{x, x, x, x};
+}
+
+template <typename T>
+inline mix_f32x4_t mixVecToFloat(T v) {
+    if constexpr (std::is_same_v<T, mix_f32x4_t>) {
+        return v;
+    } else {
+        return __builtin_convertvector(v, mix_f32x4_t);
+    }
+}
+
+// Vector form of clamp16().
+inline mix_i32x4_t mixVecClamp16(mix_i32x4_t v) {
+    const mix_i32x4_t sign = v >> 31;
+    const mix_i32x4_t overflow = ((v >> 15) ^ sign) != 0; // all ones where v does not fit.
+    return (overflow & (0x7FFF ^ sign)) | (~overflow & v);
+}
+
+// Returns true if MixMulVec() is available, i.e. the scalar MixMul() is usable at runtime.
+template <typename TO, typename TI, typename TV>
+constexpr bool mixMulVecSupported() {
+    if constexpr (std::is_floating_point_v<TO>) {
+        return !std::is_same_v<TI, int32_t>;
+    } else if constexpr (std::is_same_v<TO, int32_t>) {
+        return std::is_integral_v<TI> && std::is_integral_v<TV>;
+    } else {
+        return !(std::is_floating_point_v<TV> && std::is_integral_v<TI>);
+    }
+}
+
+/* MixMulVec is the 4 lane form of MixMul. */
+
+template <typename TO, typename TI, typename TV>
+inline MixVec<TO> MixMulVec(MixVec<TI> value, MixVec<TV> volume) {
+    static_assert(mixMulVecSupported<TO, TI, TV>());
+    if constexpr (std::is_same_v<TO, int16_t>) {
+        if constexpr (std::is_floating_point_v<TI> || std::is_floating_point_v<TV>) {
+            const mix_f32x4_t f = MixMulVec<float, TI, TV>(value, volume);
+            mix_i32x4_t result{};
+            for (size_t i = 0; i < kMixVecLanes; ++i) {
+                result[i] = clamp16_from_float(f[i]);
+            }
+            return result;
         } else {
-            center = (vol[0] >> 1) + (vol[1] >> 1); // rounds to 0.
+            return mixVecClamp16(MixMulVec<int32_t, TI, TV>(value, volume) >> 12);
+        }
+    } else if constexpr (std::is_same_v<TO, int32_t>) {
+        if constexpr (std::is_same_v<TI, int32_t>) value >>= 12;
+        if constexpr (std::is_same_v<TV, int32_t>) volume >>= 16;
+        return value * volume;
+    } else /* constexpr */ {
+        if constexpr (std::is_floating_point_v<TI> && std::is_floating_point_v<TV>) {
+            return value * volume;
+        } else if constexpr (std::is_floating_point_v<TI>) {
+            constexpr float norm = std::is_same_v<TV, int16_t>
+                    ? 1. / (1 << 12) : 1. / (1 << 28);
+            return value * mixVecToFloat(volume) * norm;
+        } else if constexpr (std::is_floating_point_v<TV>) {
+            constexpr float float_from_q_15 = 1. / (1 << 15);
+            return mixVecToFloat(value) * volume * float_from_q_15;
+        } else {
+            constexpr float norm = std::is_same_v<TV, int16_t>
+                    ? 1. / (1 << (15 + 12)) : 1. / (1ULL << (15 + 28));
+            return mixVecToFloat(value) * mixVecToFloat(volume) * norm;
         }
     }
+}
+
+/* MixAccumVec returns the 4 lane values that MixAccum would add to an accumulator. */
 
+template <typename TA, typename TI>
+inline MixVec<TA> MixAccumVec(MixVec<TI> value) {
+    if constexpr (std::is_same_v<TA, float> && std::is_same_v<TI, int16_t>) {
+        constexpr float norm = 1. / (1 << 15);
+        return norm * mixVecToFloat(value);
+    } else if constexpr (std::is_same_v<TA, float> && std::is_same_v<TI, int32_t>) {
+        constexpr float norm = 1. / (1 << 27);
+        return norm * mixVecToFloat(value);
+    } else if constexpr (std::is_same_v<TA, int32_t> && std::is_same_v<TI, int16_t>) {
+        return value << 12;
+    } else if constexpr (std::is_same_v<MixVec<TA>, MixVec<TI>>) {
+        return value;
+    } else /* constexpr */ {
+        MixVec<TA> result{};
+        for (size_t i = 0; i < kMixVecLanes; ++i) {
+            TA accum = 0;
+            MixAccum<TA, TI>(&accum, value[i]);
+            result[i] = accum;
+        }
+        return result;
+    }
+}
+
+// compile-time function.
+// Returns which stereo volume the channel at |position| of |mask| uses:
+// 0 for left, 1 for right and 2 for center, matching stereoVolumeHelperWithChannelMask().
+constexpr inline int stereoVolumeIndex(audio_channel_mask_t mask, int position) {
     using namespace audio_utils::channels;
+    constexpr unsigned LFE_LFE2 =
+            AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2;
+    const bool has_LFE_LFE2 = (mask & LFE_LFE2) == LFE_LFE2;
+    for (size_t i = 0; i < std::size(kSideFromChannelIdx); ++i) {
+        if ((mask & (1 << i)) == 0 || position-- > 0) continue;
+        const auto side = kSideFromChannelIdx[i];
+        if (side == AUDIO_GEOMETRY_SIDE_LEFT
+                || (has_LFE_LFE2 && (1u << i) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY)) {
+            return 0;
+        }
+        if (side == AUDIO_GEOMETRY_SIDE_RIGHT
+                || (has_LFE_LFE2 && (1u << i) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2)) {
+            return 1;
+        }
+        return 2;
+    }
+    return 2;
+}
 
-    // if LFE and LFE2 are both present, they take left and right volume respectively.
-    constexpr unsigned LFE_LFE2 = \
-             AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2;
-    constexpr bool has_LFE_LFE2 = (MASK & LFE_LFE2) == LFE_LFE2;
+constexpr inline bool isStereoVolumeMixType(int mixtype) {
+    return mixtype == MIXTYPE_MULTI_STEREOVOL
+            || mixtype == MIXTYPE_MULTI_SAVEONLY_STEREOVOL
+            || mixtype == MIXTYPE_STEREOEXPAND
+            || mixtype == MIXTYPE_MONOEXPAND;
+}
 
-#pragma push_macro("DO_CHANNEL_POSITION")
-#undef DO_CHANNEL_POSITION
-#define DO_CHANNEL_POSITION(BIT_INDEX) \
-    if constexpr ((MASK & (1 << BIT_INDEX)) != 0) { \
-        constexpr auto side = kSideFromChannelIdx[BIT_INDEX]; \
-        if constexpr (side == AUDIO_GEOMETRY_SIDE_LEFT || \
-               has_LFE_LFE2 && (1 << BIT_INDEX) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY) { \
-            mixCalNeon(out, in, vol[0], isAdd);/* use neon */ \
-        } else if constexpr (side == AUDIO_GEOMETRY_SIDE_RIGHT || \
-               has_LFE_LFE2 && (1 << BIT_INDEX) == AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2) { \
-            mixCalNeon(out, in, vol[1], isAdd);/* use neon */\
-        } else /* constexpr */ { \
-            mixCalNeon(out, in, center, isAdd);/* use neon */\
-        } \
+constexpr inline bool isSaveOnlyMixType(int mixtype) {
+    return mixtype == MIXTYPE_MULTI_SAVEONLY
+            || mixtype == MIXTYPE_MULTI_SAVEONLY_MONOVOL
+            || mixtype == MIXTYPE_MULTI_SAVEONLY_STEREOVOL;
+}
+
+// Number of input samples consumed per frame.
+template <int MIXTYPE, int NCHAN>
+constexpr int mixInputStride() {
+    if constexpr (MIXTYPE == MIXTYPE_MONOEXPAND) return 1;
+    if constexpr (MIXTYPE == MIXTYPE_STEREOEXPAND) return 2;
+    return NCHAN;
+}
+
+// Index into the volumes returned by mixVolumes() used for output channel |channel|.
+template <int MIXTYPE, int NCHAN>
+constexpr int mixVolumeIndex(int channel) {
+    if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        return channel;
+    } else if constexpr (isStereoVolumeMixType(MIXTYPE)) {
+        return stereoVolumeIndex(canonicalChannelMaskFromCount(NCHAN), channel);
+    } else {
+        return 0;
     }
+}
 
-    DO_CHANNEL_POSITION(0);
-    DO_CHANNEL_POSITION(1);
-    DO_CHANNEL_POSITION(2);
-    DO_CHANNEL_POSITION(3);
-    DO_CHANNEL_POSITION(4);
-    DO_CHANNEL_POSITION(5);
-    DO_CHANNEL_POSITION(6);
-    DO_CHANNEL_POSITION(7);
+template <int MIXTYPE, int NCHAN>
+constexpr std::array<int, NCHAN> mixVolumeIndices() {
+    std::array<int, NCHAN> indices{};
+    for (int i = 0; i < NCHAN; ++i) {
+        indices[i] = mixVolumeIndex<MIXTYPE, NCHAN>(i);
+    }
+    return indices;
+}
 
-    DO_CHANNEL_POSITION(8);
-    DO_CHANNEL_POSITION(9);
-    DO_CHANNEL_POSITION(10);
-    DO_CHANNEL_POSITION(11);
-    DO_CHANNEL_POSITION(12);
-    DO_CHANNEL_POSITION(13);
-    DO_CHANNEL_POSITION(14);
-    DO_CHANNEL_POSITION(15);
+// The distinct volumes of a frame: the volume array, plus the center volume
+// for the stereo volume mix types.
+template <int MIXTYPE, typename TV>
+inline std::array<std::decay_t<TV>, 3> mixVolumes(const TV *vol) {
+    std::array<std::decay_t<TV>, 3> volumes{vol[0], vol[0], vol[0]};
+    if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY
+            || isStereoVolumeMixType(MIXTYPE)) {
+        volumes[1] = vol[1];
+    }
+    if constexpr (isStereoVolumeMixType(MIXTYPE)) {
+        if constexpr (std::is_floating_point_v<TV>) {
+            volumes[2] = (vol[0] + vol[1]) * 0.5;       // do not use divide
+        } else {
+            volumes[2] = (vol[0] >> 1) + (vol[1] >> 1); // rounds to 0.
+        }
+    }
+    return volumes;
+}
 
-    DO_CHANNEL_POSITION(16);
-    DO_CHANNEL_POSITION(17);
-    DO_CHANNEL_POSITION(18);
-    DO_CHANNEL_POSITION(19);
-    DO_CHANNEL_POSITION(20);
-    DO_CHANNEL_POSITION(21);
-    DO_CHANNEL_POSITION(22);
-    DO_CHANNEL_POSITION(23);
-    DO_CHANNEL_POSITION(24);
-    DO_CHANNEL_POSITION(25);
-    static_assert(FCC_LIMIT <= FCC_26); // Note: this may need to change.
-#pragma pop_macro("DO_CHANNEL_POSITION")
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV, typename TA>
+constexpr bool volumeMultiVecSupported() {
+    if constexpr (!USE_MIXER_VECTOR_OPS || !mixMulVecSupported<TO, TI, TV>()) {
+        return false;
+    } else if constexpr (NCHAN <= 2) {
+        // The scalar mono and stereo loops already vectorize well.
+        return false;
+    } else if constexpr (isStereoVolumeMixType(MIXTYPE)) {
+        // stereoVolumeHelper() ignores channel counts without a canonical mask.
+        return canonicalChannelMaskFromCount(NCHAN) != AUDIO_CHANNEL_NONE;
+    } else {
+        return true;
+    }
 }
 
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV, typename TA>
+constexpr bool volumeRampMultiVecSupported() {
+    return NCHAN >= (int)kMixVecLanes
+            && MIXTYPE != MIXTYPE_MULTI && MIXTYPE != MIXTYPE_MULTI_SAVEONLY
+            && volumeMultiVecSupported<MIXTYPE, NCHAN, TO, TI, TV, TA>();
+}
+
+template <int MIXTYPE, typename TO, typename TI, typename TV>
+inline void mixVecOut(TO *out, MixVec<TI> value, MixVec<TV> volume) {
+    MixVec<TO> result = MixMulVec<TO, TI, TV>(value, volume);
+    if constexpr (!isSaveOnlyMixType(MIXTYPE)) {
+        result += mixVecLoad(out);
+    }
+    mixVecStore(out, result);
+}
+
+/*
+ * Vector part of volumeMulti(): processes whole blocks of lcm(4, NCHAN) samples,
+ * advancing out, in and aux, and returns the number of frames left over for the
+ * scalar kernel.
+ */
 template <int MIXTYPE, int NCHAN,
-        typename TO, typename TI, typename TV>
-void stereoVolumeHelperNeon(TO*& out, const TI*& in, const TV *vol) {
-    static_assert(NCHAN > 0 && NCHAN <= FCC_LIMIT);
-    static_assert(MIXTYPE == MIXTYPE_MULTI_STEREOVOL
-            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL
-            || MIXTYPE == MIXTYPE_STEREOEXPAND
-            || MIXTYPE == MIXTYPE_MONOEXPAND);
-    constexpr audio_channel_mask_t MASK{canonicalChannelMaskFromCount(NCHAN)};
-    if constexpr (MASK == AUDIO_CHANNEL_NONE) {
-        ALOGE("%s: Invalid position count %d", __func__, NCHAN);
-        return; // not a valid system mask, ignore.
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+inline size_t volumeMultiVec(TO*& out, size_t frameCount,
+        const TI*& in, TA*& aux, const TV *vol, TAV vola)
+{
+    constexpr size_t BLOCK_SAMPLES = std::lcm(kMixVecLanes, (size_t)NCHAN);
+    constexpr size_t BLOCK_FRAMES = BLOCK_SAMPLES / NCHAN;
+    constexpr size_t BLOCK_VECTORS = BLOCK_SAMPLES / kMixVecLanes;
+    constexpr int IN_STRIDE = mixInputStride<MIXTYPE, NCHAN>();
+    constexpr bool EXPAND = MIXTYPE == MIXTYPE_MONOEXPAND || MIXTYPE == MIXTYPE_STEREOEXPAND;
+
+    constexpr auto VOLUME_INDEX = mixVolumeIndices<MIXTYPE, NCHAN>();
+
+    const auto volumes = mixVolumes<MIXTYPE>(vol);
+    MixVec<TV> volumeVec[BLOCK_VECTORS]{};
+    for (size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+        volumeVec[i / kMixVecLanes][i % kMixVecLanes] = volumes[VOLUME_INDEX[i % NCHAN]];
+    }
+
+    for (; frameCount >= BLOCK_FRAMES; frameCount -= BLOCK_FRAMES) {
+        TA auxSamples[BLOCK_SAMPLES];
+        for (size_t v = 0; v < BLOCK_VECTORS; ++v) {
+            const size_t sample = v * kMixVecLanes;
+            MixVec<TI> value{};
+            if constexpr (EXPAND) {
+                // EXPAND replicates the first input channel, see stereoVolumeHelper().
+                for (size_t i = 0; i < kMixVecLanes; ++i) {
+                    value[i] = in[(sample + i) / NCHAN * IN_STRIDE];
+                }
+            } else {
+                value = mixVecLoad(in + sample);
+            }
+            mixVecOut<MIXTYPE, TO, TI, TV>(out + sample, value, volumeVec[v]);
+            if (aux != NULL) {
+                mixVecStore(auxSamples + sample, MixAccumVec<TA, TI>(value));
+            }
+        }
+        if (aux != NULL) {
+            for (size_t frame = 0; frame < BLOCK_FRAMES; ++frame) {
+                TA auxaccum = 0;
+                for (int i = 0; i < NCHAN; ++i) {
+                    auxaccum += auxSamples[frame * NCHAN + i];
+                }
+                auxaccum /= NCHAN;
+                *aux++ += MixMul<TA, TA, TAV>(auxaccum, vola);
+            }
+        }
+        out += BLOCK_SAMPLES;
+        in += BLOCK_FRAMES * IN_STRIDE;
     }
-    stereoVolumeHelperWithChannelMaskNeon<MIXTYPE, MASK, TO, TI, TV>(out, in, vol);
+    return frameCount;
+}
+
+/*
+ * Vector form of volumeRampMulti() for 4 or more channels: each frame is processed
+ * as NCHAN / 4 vectors followed by the remaining channels.
+ */
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+inline void volumeRampMultiVec(TO* out, size_t frameCount,
+        const TI* in, TA* aux, TV *vol, const TV *volinc, TAV *vola, TAV volainc)
+{
+    constexpr size_t VECTORS = NCHAN / kMixVecLanes;
+    constexpr int IN_STRIDE = mixInputStride<MIXTYPE, NCHAN>();
+    constexpr bool EXPAND = MIXTYPE == MIXTYPE_MONOEXPAND || MIXTYPE == MIXTYPE_STEREOEXPAND;
+    constexpr auto VOLUME_INDEX = mixVolumeIndices<MIXTYPE, NCHAN>();
+
+    // Lane masks selecting each of the volumes returned by mixVolumes(), so the
+    // volume vectors are blended from splats rather than built lane by lane.
+    mix_i32x4_t volumeMask[VECTORS][3]{};
+    for (size_t i = 0; i < VECTORS * kMixVecLanes; ++i) {
+        volumeMask[i / kMixVecLanes][VOLUME_INDEX[i]][i % kMixVecLanes] = -1;
+    }
+
+    do {
+        const auto volumes = mixVolumes<MIXTYPE>(vol);
+        mix_i32x4_t volumeBits[3];
+        for (size_t j = 0; j < 3; ++j) {
+            volumeBits[j] = (mix_i32x4_t)mixVecSplat(volumes[j]);
+        }
+        TA auxaccum = 0;
+        for (size_t v = 0; v < VECTORS; ++v) {
+            const size_t sample = v * kMixVecLanes;
+            const MixVec<TV> volume = (MixVec<TV>)((volumeMask[v][0] & volumeBits[0])
+                    | (volumeMask[v][1] & volumeBits[1])
+                    | (volumeMask[v][2] & volumeBits[2]));
+            const MixVec<TI> value = EXPAND ? mixVecSplat<TI>(*in) : mixVecLoad(in + sample);
+            mixVecOut<MIXTYPE, TO, TI, TV>(out + sample, value, volume);
+            if (aux != NULL) {
+                // Summed from the lanes in channel order, as the scalar kernel does.
+                const MixVec<TA> accum = MixAccumVec<TA, TI>(value);
+                for (size_t i = 0; i < kMixVecLanes; ++i) {
+                    auxaccum += accum[i];
+                }
+            }
+        }
+        for (int i = VECTORS * kMixVecLanes; i < NCHAN; ++i) {
+            const TI value = EXPAND ? *in : in[i];
+            const TO result = MixMul<TO, TI, TV>(value, volumes[VOLUME_INDEX[i]]);
+            if constexpr (isSaveOnlyMixType(MIXTYPE)) {
+                out[i] = result;
+            } else {
+                out[i] += result;
+            }
+            if (aux != NULL) {
+                MixAccum<TA, TI>(&auxaccum, value);
+            }
+        }
+        out += NCHAN;
+        in += IN_STRIDE;
+
+        vol[0] += volinc[0];
+        if constexpr (isStereoVolumeMixType(MIXTYPE)) {
+            vol[1] += volinc[1];
+        }
+        if (aux != NULL) {
+            auxaccum /= NCHAN;
+            *aux++ += MixMul<TA, TA, TAV>(auxaccum, *vola);
+            vola[0] += volainc;
+        }
+    } while (--frameCount);
 }
 
 /*
@@ -534,12 +844,9 @@ void stereoVolumeHelperNeon(TO*& out, const TI*& in, const TV *vol) {
 
 template <int MIXTYPE, int NCHAN,
         typename TO, typename TI, typename TV, typename TA, typename TAV>
-inline void volumeRampMulti(TO* out, size_t frameCount,
+inline void volumeRampMultiScalar(TO* out, size_t frameCount,
         const TI* in, TA* aux, TV *vol, const TV *volinc, TAV *vola, TAV volainc)
 {
-#ifdef ALOGVV
-    ALOGVV("volumeRampMulti, MIXTYPE:%d\n", MIXTYPE);
-#endif
     if (aux != NULL) {
         do {
             TA auxaccum = 0;
@@ -628,12 +935,9 @@ inline void volumeRampMulti(TO* out, size_t frameCount,
 
 template <int MIXTYPE, int NCHAN,
         typename TO, typename TI, typename TV, typename TA, typename TAV>
-inline void volumeMulti(TO* out, size_t frameCount,
+inline void volumeMultiScalar(TO* out, size_t frameCount,
         const TI* in, TA* aux, const TV *vol, TAV vola)
 {
-#ifdef ALOGVV
-    ALOGVV("volumeMulti MIXTYPE:%d\n", MIXTYPE);
-#endif
     if (aux != NULL) {
         do {
             TA auxaccum = 0;
@@ -696,43 +1000,52 @@ inline void volumeMulti(TO* out, size_t frameCount,
                     || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL
                     || MIXTYPE == MIXTYPE_MONOEXPAND
                     || MIXTYPE == MIXTYPE_STEREOEXPAND) {
-                /* 
-                 * Neon processes 4 frames at a time, so it is only called when frameCount>=4.
-                 *
-                 * The original loop always processes -1, and originally processed one frame once, 
-                 * now it processes 4 frames at a time, so a total of frameCount-4 is required.
-                 */                 
-                #ifdef USE_NEON
-                    if(frameCount >= 4 && (MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL||MIXTYPE == MIXTYPE_MULTI_STEREOVOL)){
-                        stereoVolumeHelperNeon<MIXTYPE, NCHAN>(out, in, vol);
-                        frameCount -= 4;
-                        continue;
-                    }
-                    else{
-                        //MIXTYPE = MIXTYPE_MONOEXPAND | MIXTYPE = MIXTYPE_STEREOEXPAND | frameCount<4
-                        //Use the original plan
-                        //END AudioFlinger
-                        stereoVolumeHelper<MIXTYPE, NCHAN>(out, in, vol, [] (auto &a, const auto &b) {
-                            return MixMul<TO, TI, TV>(a, b);
-                        });
-                        if constexpr (MIXTYPE == MIXTYPE_MONOEXPAND) in += 1;
-                        if constexpr (MIXTYPE == MIXTYPE_STEREOEXPAND) in += 2;
-                    }
-                #else
-                    //If devices are not supported __aarch64__ or __ARM_NEON
-                    //Use the original plan
-                    stereoVolumeHelper<MIXTYPE, NCHAN>(out, in, vol, [] (auto &a, const auto &b) {
-                            return MixMul<TO, TI, TV>(a, b);
-                        });
-                        if constexpr (MIXTYPE == MIXTYPE_MONOEXPAND) in += 1;
-                        if constexpr (MIXTYPE == MIXTYPE_STEREOEXPAND) in += 2;
-                #endif
+                stereoVolumeHelper<MIXTYPE, NCHAN>(out, in, vol, [] (auto &a, const auto &b) {
+                    return MixMul<TO, TI, TV>(a, b);
+                });
+                if constexpr (MIXTYPE == MIXTYPE_MONOEXPAND) in += 1;
+                if constexpr (MIXTYPE == MIXTYPE_STEREOEXPAND) in += 2;
             } else /* constexpr */ {
                 static_assert(dependent_false<MIXTYPE>, "invalid mixtype");
             }
-            frameCount--;
-        } while (frameCount>0);
+        } while (--frameCount);
+    }
+}
+
+/*
+ * volumeRampMulti and volumeMulti use the vector kernels above where they are
+ * supported and the scalar kernels otherwise, or for the frames left over.
+ */
+
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+inline void volumeRampMulti(TO* out, size_t frameCount,
+        const TI* in, TA* aux, TV *vol, const TV *volinc, TAV *vola, TAV volainc)
+{
+#ifdef ALOGVV
+    ALOGVV("volumeRampMulti, MIXTYPE:%d\n", MIXTYPE);
+#endif
+    if constexpr (volumeRampMultiVecSupported<MIXTYPE, NCHAN, TO, TI, TV, TA>()) {
+        volumeRampMultiVec<MIXTYPE, NCHAN>(out, frameCount, in, aux, vol, volinc, vola, volainc);
+    } else {
+        volumeRampMultiScalar<MIXTYPE, NCHAN>(
+                out, frameCount, in, aux, vol, volinc, vola, volainc);
+    }
+}
+
+template <int MIXTYPE, int NCHAN,
+        typename TO, typename TI, typename TV, typename TA, typename TAV>
+inline void volumeMulti(TO* out, size_t frameCount,
+        const TI* in, TA* aux, const TV *vol, TAV vola)
+{
+#ifdef ALOGVV
+    ALOGVV("volumeMulti MIXTYPE:%d\n", MIXTYPE);
+#endif
+    if constexpr (volumeMultiVecSupported<MIXTYPE, NCHAN, TO, TI, TV, TA>()) {
+        frameCount = volumeMultiVec<MIXTYPE, NCHAN>(out, frameCount, in, aux, vol, vola);
+        if (frameCount == 0) return;
     }
+    volumeMultiScalar<MIXTYPE, NCHAN>(out, frameCount, in, aux, vol, vola);
 }
 
 };
@@ -22,6 +22,9 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <memory>
+
 #include <cutils/properties.h>
 #include <log/log.h>
 
@@ -261,6 +264,36 @@ AudioResampler* AudioResampler::create(audio_format_t format, int inChannelCount
     return resampler;
 }
 
+void AudioResampler::preloadFilters(int32_t sampleRate) {
+    int ok = pthread_once(&once_control, init_routine);
+    if (ok != 0) {
+        ALOGE("%s pthread_once failed: %d", __func__, ok);
+    }
+    src_quality quality = defaultQuality == DEFAULT_QUALITY ? DYN_MED_QUALITY : defaultQuality;
+    if (quality < DYN_LOW_QUALITY) {
+        return; // only the dynamic resamplers share filters.
+    }
+
+    // keep in sync with isCommonConversion() in AudioResamplerDyn.cpp.
+    static constexpr int32_t kCommonSampleRates[] = {44100, 48000, 96000};
+    static constexpr audio_format_t kFormats[] = {AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_16_BIT};
+    if (std::find(std::begin(kCommonSampleRates), std::end(kCommonSampleRates), sampleRate)
+            == std::end(kCommonSampleRates)) {
+        return; // filters for other conversions are not kept, nothing to preload.
+    }
+    for (int32_t inSampleRate : kCommonSampleRates) {
+        if (inSampleRate == sampleRate) {
+            continue;
+        }
+        for (audio_format_t format : kFormats) {
+            // The filter outlives the resampler as it is a common conversion.
+            std::unique_ptr<AudioResampler> resampler(
+                    create(format, FCC_2, sampleRate, quality));
+            resampler->setSampleRate(inSampleRate);
+        }
+    }
+}
+
 AudioResampler::AudioResampler(int inChannelCount,
         int32_t sampleRate, src_quality quality) :
         mChannelCount(inChannelCount),
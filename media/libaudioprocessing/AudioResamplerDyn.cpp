@@ -23,6 +23,11 @@
 #include <dlfcn.h>
 #include <math.h>
 
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -31,6 +36,7 @@
 #include "AudioResamplerFirOps.h" // USE_NEON, USE_SSE and USE_INLINE_ASSEMBLY defined here
 #include "AudioResamplerFirProcess.h"
 #include "AudioResamplerFirProcessNeon.h"
+#include "AudioResamplerFirProcessAVX.h"
 #include "AudioResamplerFirProcessSSE.h"
 #include "AudioResamplerFirGen.h" // requires math.h
 #include "AudioResamplerDyn.h"
@@ -42,6 +48,22 @@ constexpr size_t CACHE_LINE_SIZE = 64;
 
 namespace android {
 
+#if USE_SSE
+FirSimdLevel getFirSimdLevelSupported()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return FIR_SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return FIR_SIMD_AVX2;
+    }
+    return FIR_SIMD_SSE;
+}
+
+FirSimdLevel gFirSimdLevel = getFirSimdLevelSupported();
+#endif
+
 /*
  * InBuffer is a type agnostic input buffer.
  *
@@ -181,8 +203,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +228,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -232,6 +252,118 @@ void AudioResamplerDyn<TC, TI, TO>::setVolume(float left, float right)
     }
 }
 
+/*
+ * KaiserFirCache is a process-wide cache of polyphase filter banks, one per coefficient type TC.
+ *
+ * A filter bank is fully determined by its design parameters (phases, half length,
+ * stopband attenuation and cutoff), which in turn are derived from the quality and the
+ * conversion ratio. Resamplers with the same design share one read-only table, which is
+ * released when the last resampler using it lets go of it. Tables for common conversions
+ * are pinned so they survive track churn (and can be computed up front, see
+ * AudioResampler::preloadFilters()).
+ */
+template<typename TC>
+class KaiserFirCache {
+public:
+    struct Design {
+        int phases;
+        int halfLength;
+        double stopBandAtten;
+        double fcr;
+
+        bool operator<(const Design& other) const {
+            return std::tie(phases, halfLength, stopBandAtten, fcr)
+                    < std::tie(other.phases, other.halfLength, other.stopBandAtten, other.fcr);
+        }
+    };
+
+    // Returns the filter bank for the design, generating it if it is not cached.
+    // The filter is designed without holding the lock, so a real-time thread looking up
+    // another filter is not blocked for the duration of firKaiserGen().
+    static std::shared_ptr<const TC> acquire(const Design& design, double attenuation, bool pin) {
+        KaiserFirCache& cache = getInstance();
+        std::shared_ptr<const TC> coefs = cache.find(design, pin);
+        if (coefs != nullptr) {
+            return coefs;
+        }
+
+        std::shared_ptr<const TC> generated = generate(design, attenuation);
+
+        std::lock_guard<std::mutex> lock(cache.mLock);
+        // Another thread may have designed the same filter meanwhile, use the first one.
+        coefs = cache.find_l(design);
+        if (coefs == nullptr) {
+            cache.pruneExpired_l();
+            coefs = std::move(generated);
+            cache.mFilters[design] = coefs;
+        }
+        cache.pin_l(design, coefs, pin);
+        return coefs;
+    }
+
+private:
+    static KaiserFirCache& getInstance() {
+        static KaiserFirCache cache;
+        return cache;
+    }
+
+    static std::shared_ptr<const TC> generate(const Design& design, double attenuation) {
+        TC *coefs = nullptr;
+        int ret = posix_memalign(
+                reinterpret_cast<void **>(&coefs),
+                CACHE_LINE_SIZE /* alignment */,
+                (design.phases + 1) * design.halfLength * sizeof(TC));
+        LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+        firKaiserGen(coefs, design.phases, design.halfLength, design.stopBandAtten, design.fcr,
+                attenuation);
+        return std::shared_ptr<const TC>(coefs, [](const TC *p) { free((void *)p); });
+    }
+
+    std::shared_ptr<const TC> find(const Design& design, bool pin) {
+        std::lock_guard<std::mutex> lock(mLock);
+        std::shared_ptr<const TC> coefs = find_l(design);
+        if (coefs != nullptr) {
+            pin_l(design, coefs, pin);
+        }
+        return coefs;
+    }
+
+    std::shared_ptr<const TC> find_l(const Design& design) const {
+        auto it = mFilters.find(design);
+        return it == mFilters.end() ? nullptr : it->second.lock();
+    }
+
+    void pin_l(const Design& design, const std::shared_ptr<const TC>& coefs, bool pin) {
+        if (pin && mPinned.emplace(design, coefs).second) {
+            ALOGV("%s: pinned phases:%d halfLength:%d", __func__, design.phases, design.halfLength);
+        }
+    }
+
+    void pruneExpired_l() {
+        for (auto it = mFilters.begin(); it != mFilters.end(); ) {
+            if (it->second.expired()) {
+                it = mFilters.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    std::mutex mLock;
+    std::map<Design, std::weak_ptr<const TC>> mFilters;        // guarded by mLock
+    std::map<Design, std::shared_ptr<const TC>> mPinned;       // guarded by mLock
+};
+
+// Conversions between the ubiquitous rates, whose filters are kept for the process lifetime.
+static bool isCommonConversion(int32_t inSampleRate, int32_t outSampleRate)
+{
+    auto isCommonRate = [](int32_t rate) {
+        return rate == 44100 || rate == 48000 || rate == 96000;
+    };
+    return inSampleRate != outSampleRate
+            && isCommonRate(inSampleRate) && isCommonRate(outSampleRate);
+}
+
 // TODO: update to C++11
 
 template<typename T> T max(T a, T b) {return a > b ? a : b;}
@@ -263,24 +395,16 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or share an identical one already designed.
+    const typename KaiserFirCache<TC>::Design design{phases, halfLength, stopBandAtten, fcr};
+    mCoefs = KaiserFirCache<TC>::acquire(design, attenuation,
+            isCommonConversion(mInSampleRate, mSampleRate));
+    c.mFirCoefs = mCoefs.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +430,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
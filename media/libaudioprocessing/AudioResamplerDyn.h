@@ -21,6 +21,8 @@
 #include <sys/types.h>
 #include <android/log.h>
 
+#include <memory>
+
 #include <media/AudioResampler.h>
 
 namespace android {
@@ -166,7 +168,9 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const TC> mCoefs;  // if a filter is created, this is not null.
+                                       // shared read-only with other resamplers using
+                                       // the same filter design, see KaiserFirCache.
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
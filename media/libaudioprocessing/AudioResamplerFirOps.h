@@ -17,6 +17,8 @@
 #ifndef ANDROID_AUDIO_RESAMPLER_FIR_OPS_H
 #define ANDROID_AUDIO_RESAMPLER_FIR_OPS_H
 
+#include <type_traits>
+
 namespace android {
 
 #if defined(__arm__) && !defined(__thumb__)
@@ -43,12 +45,25 @@ namespace android {
 #elif defined(__SSSE3__)  // Should be supported in x86 ABI for both 32 & 64-bit.
 #define USE_SSE (true)  // Inference SSE Intrinsics
 #define USE_AVX2 (false)
-#include <tmmintrin.h>
+#include <immintrin.h>  // AVX2 and AVX-512 kernels are selected at runtime
 #else
 #define USE_SSE (false)
-#define USE_AVX2(false)
+#define USE_AVX2 (false)
 #endif
 
+#if USE_SSE
+// Widest x86 SIMD extension used by the FIR kernels in AudioResamplerFirProcessAVX.h.
+// Detected from the CPU at startup; may be lowered for testing and benchmarking,
+// but never raised above what the CPU supports.
+enum FirSimdLevel {
+    FIR_SIMD_SSE,
+    FIR_SIMD_AVX2,
+    FIR_SIMD_AVX512,
+};
+
+extern FirSimdLevel gFirSimdLevel;         // defined in AudioResamplerDyn.cpp
+FirSimdLevel getFirSimdLevelSupported();
+#endif
 
 template<typename T, typename U>
 struct is_same
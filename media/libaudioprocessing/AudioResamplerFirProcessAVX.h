@@ -0,0 +1,539 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+
+namespace android {
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+
+#if USE_SSE
+
+//
+// 256-bit (AVX2/FMA) and 512-bit (AVX-512F) polyphase dot products.
+//
+// These are compiled with function level target attributes so that they are available
+// regardless of the -m flags of the build, and are selected at runtime by gFirSimdLevel.
+// Float kernels are called from the SSE specializations in AudioResamplerFirProcessSSE.h,
+// integer kernels from the int16_t/int32_t specializations at the end of this file.
+//
+// The integer kernels widen everything to 32 bit lanes and perform the same truncating
+// multiplies as mulAdd() and interpolate() in the scalar path, so their output is bit exact
+// with ProcessBase(). The float kernels sum in a different order (as do the SSE and NEON
+// kernels), so they match the scalar path only to within rounding.
+//
+
+#define FIR_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define FIR_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+
+struct FirAvx2 {
+    static constexpr int kLanes = 8;
+    typedef __m256i vi;
+    typedef __m256 vf;
+
+    FIR_TARGET_AVX2 static inline vi zeroi() { return _mm256_setzero_si256(); }
+    FIR_TARGET_AVX2 static inline vf zerof() { return _mm256_setzero_ps(); }
+    FIR_TARGET_AVX2 static inline vi set1i(int32_t v) { return _mm256_set1_epi32(v); }
+    FIR_TARGET_AVX2 static inline vf set1f(float v) { return _mm256_set1_ps(v); }
+
+    FIR_TARGET_AVX2 static inline vi load(const int16_t* p) {
+        return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    FIR_TARGET_AVX2 static inline vi load(const int32_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    FIR_TARGET_AVX2 static inline vf load(const float* p) {
+        return _mm256_loadu_ps(p);
+    }
+
+    // Loads kLanes interleaved stereo frames and splits them into left and right lanes.
+    FIR_TARGET_AVX2 static inline void loadStereo(const int16_t* p, vi* l, vi* r) {
+        const vi x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        *l = _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16);
+        *r = _mm256_srai_epi32(x, 16);
+    }
+    FIR_TARGET_AVX2 static inline void loadStereo(const float* p, vf* l, vf* r) {
+        const vi idx = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        const vf a = _mm256_permutevar8x32_ps(_mm256_loadu_ps(p), idx);      // L0-3 R0-3
+        const vf b = _mm256_permutevar8x32_ps(_mm256_loadu_ps(p + 8), idx);  // L4-7 R4-7
+        *l = _mm256_permute2f128_ps(a, b, 0x20);
+        *r = _mm256_permute2f128_ps(a, b, 0x31);
+    }
+
+    FIR_TARGET_AVX2 static inline vi reverse(vi x) {
+        return _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+    FIR_TARGET_AVX2 static inline vf reverse(vf x) {
+        return _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    }
+
+    FIR_TARGET_AVX2 static inline vi add(vi a, vi b) { return _mm256_add_epi32(a, b); }
+    FIR_TARGET_AVX2 static inline vi sub(vi a, vi b) { return _mm256_sub_epi32(a, b); }
+    FIR_TARGET_AVX2 static inline vi mullo(vi a, vi b) { return _mm256_mullo_epi32(a, b); }
+    FIR_TARGET_AVX2 static inline vi srai(vi a, int n) { return _mm256_srai_epi32(a, n); }
+    FIR_TARGET_AVX2 static inline vi slli(vi a, int n) { return _mm256_slli_epi32(a, n); }
+
+    // Low 32 bits of (int64(a) * int64(b)) >> SHIFT per lane, for 0 < SHIFT < 32.
+    template <int SHIFT>
+    FIR_TARGET_AVX2 static inline vi mulShift(vi a, vi b) {
+        const vi even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), SHIFT);
+        const vi odd = _mm256_slli_epi64(_mm256_mul_epi32(
+                _mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), 32 - SHIFT);
+        return _mm256_blend_epi32(even, odd, 0xAA);
+    }
+
+    FIR_TARGET_AVX2 static inline vf fmadd(vf a, vf b, vf c) { return _mm256_fmadd_ps(a, b, c); }
+    FIR_TARGET_AVX2 static inline vf subf(vf a, vf b) { return _mm256_sub_ps(a, b); }
+
+    FIR_TARGET_AVX2 static inline int32_t sum(vi x) {
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        return _mm_cvtsi128_si32(s);
+    }
+    FIR_TARGET_AVX2 static inline float sum(vf x) {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+        return _mm_cvtss_f32(s);
+    }
+
+    // Per lane mulAdd() product and interpolate() for the integer coefficient types.
+    template <typename TC>
+    FIR_TARGET_AVX2 static inline vi mulCoef(vi coef, vi s) {
+        if constexpr (std::is_same_v<TC, int16_t>) {
+            return mullo(coef, s);                  // coef * s
+        } else {
+            return mulShift<16>(coef, s);           // (int64_t(coef) * s) >> 16
+        }
+    }
+    template <typename TC>
+    FIR_TARGET_AVX2 static inline vi interpolateCoef(vi c0, vi c1, vi lerp) {
+        if constexpr (std::is_same_v<TC, int16_t>) {
+            // ((int16_t)lerp * (int16_t)(c1 - c0) >> 15) + c0, truncated to int16_t.
+            const vi d = srai(slli(sub(c1, c0), 16), 16);
+            const vi c = add(srai(mullo(lerp, d), 15), c0);
+            return srai(slli(c, 16), 16);
+        } else {
+            // (lerp * int64_t(c1 - c0) >> 31) + c0, lerp < 2^31 for int32_t coefs, see fir().
+            return add(mulShift<31>(lerp, sub(c1, c0)), c0);
+        }
+    }
+    template <typename TC>
+    static inline int32_t lerpLane(uint32_t lerp) {
+        return std::is_same_v<TC, int16_t>
+                ? static_cast<int16_t>(lerp) : static_cast<int32_t>(lerp);
+    }
+
+    // Accumulates kLanes taps of the positive and negative half, starting at tap i,
+    // into the per channel accumulators.
+    template <int CHANNELS, bool FIXED, typename TC>
+    FIR_TARGET_AVX2 static inline void stepInt(vi* acc, int i, int count,
+            const TC* coefsP, const TC* coefsN, const int16_t* sP, const int16_t* sN, vi lerp) {
+        vi cP = load(coefsP + i);
+        vi cN = load(coefsN + i);
+        if (!FIXED) {
+            cP = interpolateCoef<TC>(cP, load(coefsP + i + count), lerp);
+            cN = interpolateCoef<TC>(load(coefsN + i + count), cN, lerp);
+        }
+        // positive samples are read backwards: load the block from its far end and reverse.
+        const int16_t* pP = sP - (i + kLanes - 1) * CHANNELS;
+        const int16_t* pN = sN + i * CHANNELS;
+        if (CHANNELS == 1) {
+            acc[0] = add(acc[0], mulCoef<TC>(cP, reverse(load(pP))));
+            acc[0] = add(acc[0], mulCoef<TC>(cN, load(pN)));
+        } else {
+            vi l, r;
+            loadStereo(pP, &l, &r);
+            acc[0] = add(acc[0], mulCoef<TC>(cP, reverse(l)));
+            acc[1] = add(acc[1], mulCoef<TC>(cP, reverse(r)));
+            loadStereo(pN, &l, &r);
+            acc[0] = add(acc[0], mulCoef<TC>(cN, l));
+            acc[1] = add(acc[1], mulCoef<TC>(cN, r));
+        }
+    }
+
+    template <int CHANNELS, bool FIXED>
+    FIR_TARGET_AVX2 static inline void stepFloat(vf* acc, int i, int count,
+            const float* coefsP, const float* coefsN, const float* sP, const float* sN, vf lerp) {
+        vf cP = load(coefsP + i);
+        vf cN = load(coefsN + i);
+        if (!FIXED) {
+            // same formulation as interpolate(): lerp * (coef_1 - coef_0) + coef_0
+            cP = fmadd(lerp, subf(load(coefsP + i + count), cP), cP);
+            const vf cN1 = load(coefsN + i + count);
+            cN = fmadd(lerp, subf(cN, cN1), cN1);
+        }
+        const float* pP = sP - (i + kLanes - 1) * CHANNELS;
+        const float* pN = sN + i * CHANNELS;
+        if (CHANNELS == 1) {
+            acc[0] = fmadd(cP, reverse(load(pP)), acc[0]);
+            acc[0] = fmadd(cN, load(pN), acc[0]);
+        } else {
+            vf l, r;
+            loadStereo(pP, &l, &r);
+            acc[0] = fmadd(cP, reverse(l), acc[0]);
+            acc[1] = fmadd(cP, reverse(r), acc[1]);
+            loadStereo(pN, &l, &r);
+            acc[0] = fmadd(cN, l, acc[0]);
+            acc[1] = fmadd(cN, r, acc[1]);
+        }
+    }
+};
+
+struct FirAvx512 {
+    static constexpr int kLanes = 16;
+    typedef __m512i vi;
+    typedef __m512 vf;
+
+    FIR_TARGET_AVX512 static inline vi zeroi() { return _mm512_setzero_si512(); }
+    FIR_TARGET_AVX512 static inline vf zerof() { return _mm512_setzero_ps(); }
+    FIR_TARGET_AVX512 static inline vi set1i(int32_t v) { return _mm512_set1_epi32(v); }
+    FIR_TARGET_AVX512 static inline vf set1f(float v) { return _mm512_set1_ps(v); }
+
+    FIR_TARGET_AVX512 static inline vi load(const int16_t* p) {
+        return _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    }
+    FIR_TARGET_AVX512 static inline vi load(const int32_t* p) {
+        return _mm512_loadu_si512(p);
+    }
+    FIR_TARGET_AVX512 static inline vf load(const float* p) {
+        return _mm512_loadu_ps(p);
+    }
+
+    FIR_TARGET_AVX512 static inline void loadStereo(const int16_t* p, vi* l, vi* r) {
+        const vi x = _mm512_loadu_si512(p);
+        *l = _mm512_srai_epi32(_mm512_slli_epi32(x, 16), 16);
+        *r = _mm512_srai_epi32(x, 16);
+    }
+    FIR_TARGET_AVX512 static inline void loadStereo(const float* p, vf* l, vf* r) {
+        const vi idxL = _mm512_setr_epi32(
+                0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        const vi idxR = _mm512_setr_epi32(
+                1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+        const vf a = _mm512_loadu_ps(p);
+        const vf b = _mm512_loadu_ps(p + 16);
+        *l = _mm512_permutex2var_ps(a, idxL, b);
+        *r = _mm512_permutex2var_ps(a, idxR, b);
+    }
+
+    FIR_TARGET_AVX512 static inline vi reverse(vi x) {
+        return _mm512_permutexvar_epi32(_mm512_setr_epi32(
+                15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), x);
+    }
+    FIR_TARGET_AVX512 static inline vf reverse(vf x) {
+        return _mm512_permutexvar_ps(_mm512_setr_epi32(
+                15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), x);
+    }
+
+    FIR_TARGET_AVX512 static inline vi add(vi a, vi b) { return _mm512_add_epi32(a, b); }
+    FIR_TARGET_AVX512 static inline vi sub(vi a, vi b) { return _mm512_sub_epi32(a, b); }
+    FIR_TARGET_AVX512 static inline vi mullo(vi a, vi b) { return _mm512_mullo_epi32(a, b); }
+    FIR_TARGET_AVX512 static inline vi srai(vi a, int n) { return _mm512_srai_epi32(a, n); }
+    FIR_TARGET_AVX512 static inline vi slli(vi a, int n) { return _mm512_slli_epi32(a, n); }
+
+    template <int SHIFT>
+    FIR_TARGET_AVX512 static inline vi mulShift(vi a, vi b) {
+        const vi even = _mm512_srli_epi64(_mm512_mul_epi32(a, b), SHIFT);
+        const vi odd = _mm512_slli_epi64(_mm512_mul_epi32(
+                _mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32)), 32 - SHIFT);
+        return _mm512_mask_blend_epi32(0xAAAA, even, odd);
+    }
+
+    FIR_TARGET_AVX512 static inline vf fmadd(vf a, vf b, vf c) {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+    FIR_TARGET_AVX512 static inline vf subf(vf a, vf b) { return _mm512_sub_ps(a, b); }
+
+    FIR_TARGET_AVX512 static inline int32_t sum(vi x) { return _mm512_reduce_add_epi32(x); }
+    FIR_TARGET_AVX512 static inline float sum(vf x) { return _mm512_reduce_add_ps(x); }
+
+    // Per lane mulAdd() product and interpolate() for the integer coefficient types.
+    template <typename TC>
+    FIR_TARGET_AVX512 static inline vi mulCoef(vi coef, vi s) {
+        if constexpr (std::is_same_v<TC, int16_t>) {
+            return mullo(coef, s);                  // coef * s
+        } else {
+            return mulShift<16>(coef, s);           // (int64_t(coef) * s) >> 16
+        }
+    }
+    template <typename TC>
+    FIR_TARGET_AVX512 static inline vi interpolateCoef(vi c0, vi c1, vi lerp) {
+        if constexpr (std::is_same_v<TC, int16_t>) {
+            // ((int16_t)lerp * (int16_t)(c1 - c0) >> 15) + c0, truncated to int16_t.
+            const vi d = srai(slli(sub(c1, c0), 16), 16);
+            const vi c = add(srai(mullo(lerp, d), 15), c0);
+            return srai(slli(c, 16), 16);
+        } else {
+            // (lerp * int64_t(c1 - c0) >> 31) + c0, lerp < 2^31 for int32_t coefs, see fir().
+            return add(mulShift<31>(lerp, sub(c1, c0)), c0);
+        }
+    }
+    template <typename TC>
+    static inline int32_t lerpLane(uint32_t lerp) {
+        return std::is_same_v<TC, int16_t>
+                ? static_cast<int16_t>(lerp) : static_cast<int32_t>(lerp);
+    }
+
+    // Accumulates kLanes taps of the positive and negative half, starting at tap i,
+    // into the per channel accumulators.
+    template <int CHANNELS, bool FIXED, typename TC>
+    FIR_TARGET_AVX512 static inline void stepInt(vi* acc, int i, int count,
+            const TC* coefsP, const TC* coefsN, const int16_t* sP, const int16_t* sN, vi lerp) {
+        vi cP = load(coefsP + i);
+        vi cN = load(coefsN + i);
+        if (!FIXED) {
+            cP = interpolateCoef<TC>(cP, load(coefsP + i + count), lerp);
+            cN = interpolateCoef<TC>(load(coefsN + i + count), cN, lerp);
+        }
+        // positive samples are read backwards: load the block from its far end and reverse.
+        const int16_t* pP = sP - (i + kLanes - 1) * CHANNELS;
+        const int16_t* pN = sN + i * CHANNELS;
+        if (CHANNELS == 1) {
+            acc[0] = add(acc[0], mulCoef<TC>(cP, reverse(load(pP))));
+            acc[0] = add(acc[0], mulCoef<TC>(cN, load(pN)));
+        } else {
+            vi l, r;
+            loadStereo(pP, &l, &r);
+            acc[0] = add(acc[0], mulCoef<TC>(cP, reverse(l)));
+            acc[1] = add(acc[1], mulCoef<TC>(cP, reverse(r)));
+            loadStereo(pN, &l, &r);
+            acc[0] = add(acc[0], mulCoef<TC>(cN, l));
+            acc[1] = add(acc[1], mulCoef<TC>(cN, r));
+        }
+    }
+
+    template <int CHANNELS, bool FIXED>
+    FIR_TARGET_AVX512 static inline void stepFloat(vf* acc, int i, int count,
+            const float* coefsP, const float* coefsN, const float* sP, const float* sN, vf lerp) {
+        vf cP = load(coefsP + i);
+        vf cN = load(coefsN + i);
+        if (!FIXED) {
+            // same formulation as interpolate(): lerp * (coef_1 - coef_0) + coef_0
+            cP = fmadd(lerp, subf(load(coefsP + i + count), cP), cP);
+            const vf cN1 = load(coefsN + i + count);
+            cN = fmadd(lerp, subf(cN, cN1), cN1);
+        }
+        const float* pP = sP - (i + kLanes - 1) * CHANNELS;
+        const float* pN = sN + i * CHANNELS;
+        if (CHANNELS == 1) {
+            acc[0] = fmadd(cP, reverse(load(pP)), acc[0]);
+            acc[0] = fmadd(cN, load(pN), acc[0]);
+        } else {
+            vf l, r;
+            loadStereo(pP, &l, &r);
+            acc[0] = fmadd(cP, reverse(l), acc[0]);
+            acc[1] = fmadd(cP, reverse(r), acc[1]);
+            loadStereo(pN, &l, &r);
+            acc[0] = fmadd(cN, l, acc[0]);
+            acc[1] = fmadd(cN, r, acc[1]);
+        }
+    }
+};
+
+// count is a multiple of 8: the 512-bit kernels finish an odd block of 8 with 256-bit ops.
+
+template <int CHANNELS, bool FIXED, typename TC>
+FIR_TARGET_AVX2 static inline void ProcessAvx2Int(int32_t* const out, int count,
+        const TC* coefsP, const TC* coefsN, const int16_t* sP, const int16_t* sN,
+        uint32_t lerpP, const int32_t* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+    typedef FirAvx2 V;
+    const V::vi lerp = V::set1i(V::lerpLane<TC>(lerpP));
+    V::vi acc[2] = { V::zeroi(), V::zeroi() };
+    for (int i = 0; i < count; i += V::kLanes) {
+        V::stepInt<CHANNELS, FIXED>(acc, i, count, coefsP, coefsN, sP, sN, lerp);
+    }
+    const int32_t l = V::sum(acc[0]);
+    const int32_t r = CHANNELS == 2 ? V::sum(acc[1]) : l;
+    out[0] += volumeAdjust(l, volumeLR[0]);
+    out[1] += volumeAdjust(r, volumeLR[1]);
+}
+
+template <int CHANNELS, bool FIXED, typename TC>
+FIR_TARGET_AVX512 static inline void ProcessAvx512Int(int32_t* const out, int count,
+        const TC* coefsP, const TC* coefsN, const int16_t* sP, const int16_t* sN,
+        uint32_t lerpP, const int32_t* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+    typedef FirAvx512 V;
+    const V::vi lerp = V::set1i(V::lerpLane<TC>(lerpP));
+    V::vi acc[2] = { V::zeroi(), V::zeroi() };
+    int i = 0;
+    for (; i + V::kLanes <= count; i += V::kLanes) {
+        V::stepInt<CHANNELS, FIXED>(acc, i, count, coefsP, coefsN, sP, sN, lerp);
+    }
+    // integer sums are exact, so the tail may be reduced separately.
+    int32_t tail[2] = { 0, 0 };
+    if (i < count) {
+        FirAvx2::vi acc2[2] = { FirAvx2::zeroi(), FirAvx2::zeroi() };
+        FirAvx2::stepInt<CHANNELS, FIXED>(acc2, i, count, coefsP, coefsN, sP, sN,
+                FirAvx2::set1i(FirAvx2::lerpLane<TC>(lerpP)));
+        tail[0] = FirAvx2::sum(acc2[0]);
+        tail[1] = FirAvx2::sum(acc2[1]);
+    }
+    // unsigned to keep the wraparound of the scalar accumulation well defined.
+    const int32_t l = static_cast<int32_t>(
+            static_cast<uint32_t>(V::sum(acc[0])) + static_cast<uint32_t>(tail[0]));
+    const int32_t r = CHANNELS == 2 ? static_cast<int32_t>(
+            static_cast<uint32_t>(V::sum(acc[1])) + static_cast<uint32_t>(tail[1])) : l;
+    out[0] += volumeAdjust(l, volumeLR[0]);
+    out[1] += volumeAdjust(r, volumeLR[1]);
+}
+
+template <int CHANNELS, bool FIXED>
+FIR_TARGET_AVX2 static inline void ProcessAvx2Float(float* const out, int count,
+        const float* coefsP, const float* coefsN, const float* sP, const float* sN,
+        float lerpP, const float* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+    typedef FirAvx2 V;
+    const V::vf lerp = V::set1f(lerpP);
+    V::vf acc[2] = { V::zerof(), V::zerof() };
+    for (int i = 0; i < count; i += V::kLanes) {
+        V::stepFloat<CHANNELS, FIXED>(acc, i, count, coefsP, coefsN, sP, sN, lerp);
+    }
+    const float l = V::sum(acc[0]);
+    const float r = CHANNELS == 2 ? V::sum(acc[1]) : l;
+    out[0] += l * volumeLR[0];
+    out[1] += r * volumeLR[1];
+}
+
+template <int CHANNELS, bool FIXED>
+FIR_TARGET_AVX512 static inline void ProcessAvx512Float(float* const out, int count,
+        const float* coefsP, const float* coefsN, const float* sP, const float* sN,
+        float lerpP, const float* const volumeLR)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+    typedef FirAvx512 V;
+    const V::vf lerp = V::set1f(lerpP);
+    V::vf acc[2] = { V::zerof(), V::zerof() };
+    int i = 0;
+    for (; i + V::kLanes <= count; i += V::kLanes) {
+        V::stepFloat<CHANNELS, FIXED>(acc, i, count, coefsP, coefsN, sP, sN, lerp);
+    }
+    float tail[2] = { 0.f, 0.f };
+    if (i < count) {
+        FirAvx2::vf acc2[2] = { FirAvx2::zerof(), FirAvx2::zerof() };
+        FirAvx2::stepFloat<CHANNELS, FIXED>(acc2, i, count, coefsP, coefsN, sP, sN,
+                FirAvx2::set1f(lerpP));
+        tail[0] = FirAvx2::sum(acc2[0]);
+        tail[1] = FirAvx2::sum(acc2[1]);
+    }
+    const float l = V::sum(acc[0]) + tail[0];
+    const float r = CHANNELS == 2 ? V::sum(acc[1]) + tail[1] : l;
+    out[0] += l * volumeLR[0];
+    out[1] += r * volumeLR[1];
+}
+
+// Runtime selection between the 512-bit and 256-bit kernels.
+// Returns false if neither is available, so the caller falls back to its own path.
+
+template <int CHANNELS, bool FIXED, typename TC>
+static inline bool ProcessAvxInt(int32_t* const out, int count,
+        const TC* coefsP, const TC* coefsN, const int16_t* sP, const int16_t* sN,
+        uint32_t lerpP, const int32_t* const volumeLR)
+{
+    if (gFirSimdLevel >= FIR_SIMD_AVX512) {
+        ProcessAvx512Int<CHANNELS, FIXED>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+        return true;
+    }
+    if (gFirSimdLevel >= FIR_SIMD_AVX2) {
+        ProcessAvx2Int<CHANNELS, FIXED>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+        return true;
+    }
+    return false;
+}
+
+template <int CHANNELS, bool FIXED>
+static inline bool ProcessAvxFloat(float* const out, int count,
+        const float* coefsP, const float* coefsN, const float* sP, const float* sN,
+        float lerpP, const float* const volumeLR)
+{
+    if (gFirSimdLevel >= FIR_SIMD_AVX512) {
+        ProcessAvx512Float<CHANNELS, FIXED>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+        return true;
+    }
+    if (gFirSimdLevel >= FIR_SIMD_AVX2) {
+        ProcessAvx2Float<CHANNELS, FIXED>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR);
+        return true;
+    }
+    return false;
+}
+
+//
+// Integer specializations for Process() and ProcessL() in AudioResamplerFirProcess.h.
+// Without AVX2 these continue to use the scalar ProcessBase().
+//
+
+#define FIR_AVX_INT_SPECIALIZATIONS(TC) \
+template <> \
+inline void ProcessL<1, 16>(int32_t* const out, int count, \
+        const TC* coefsP, const TC* coefsN, const int16_t* sP, const int16_t* sN, \
+        const int32_t* const volumeLR) \
+{ \
+    if (!ProcessAvxInt<1, true>(out, count, coefsP, coefsN, sP, sN, 0 /* lerpP */, volumeLR)) { \
+        ProcessBase<1, 16, InterpNull>(out, count, coefsP, coefsN, sP, sN, 0, volumeLR); \
+    } \
+} \
+template <> \
+inline void ProcessL<2, 16>(int32_t* const out, int count, \
+        const TC* coefsP, const TC* coefsN, const int16_t* sP, const int16_t* sN, \
+        const int32_t* const volumeLR) \
+{ \
+    if (!ProcessAvxInt<2, true>(out, count, coefsP, coefsN, sP, sN, 0 /* lerpP */, volumeLR)) { \
+        ProcessBase<2, 16, InterpNull>(out, count, coefsP, coefsN, sP, sN, 0, volumeLR); \
+    } \
+} \
+template <> \
+inline void Process<1, 16>(int32_t* const out, int count, \
+        const TC* coefsP, const TC* coefsN, const TC* coefsP1 __unused, \
+        const TC* coefsN1 __unused, const int16_t* sP, const int16_t* sN, uint32_t lerpP, \
+        const int32_t* const volumeLR) \
+{ \
+    if (!ProcessAvxInt<1, false>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR)) { \
+        ProcessBase<1, 16, InterpCompute>(out, count, coefsP, coefsN, sP, sN, lerpP, \
+                volumeLR); \
+    } \
+} \
+template <> \
+inline void Process<2, 16>(int32_t* const out, int count, \
+        const TC* coefsP, const TC* coefsN, const TC* coefsP1 __unused, \
+        const TC* coefsN1 __unused, const int16_t* sP, const int16_t* sN, uint32_t lerpP, \
+        const int32_t* const volumeLR) \
+{ \
+    if (!ProcessAvxInt<2, false>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR)) { \
+        ProcessBase<2, 16, InterpCompute>(out, count, coefsP, coefsN, sP, sN, lerpP, \
+                volumeLR); \
+    } \
+}
+
+FIR_AVX_INT_SPECIALIZATIONS(int16_t)
+FIR_AVX_INT_SPECIALIZATIONS(int32_t)
+
+#undef FIR_AVX_INT_SPECIALIZATIONS
+
+#endif //USE_SSE
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H*/
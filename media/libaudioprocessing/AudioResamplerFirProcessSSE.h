@@ -19,7 +19,7 @@
 
 namespace android {
 
-// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h, AudioResamplerFirProcessAVX.h
 
 #if USE_SSE
 
@@ -32,6 +32,7 @@ namespace android {
 
 //
 // SSEx specializations are enabled for Process() and ProcessL() in AudioResamplerFirProcess.h
+// These use the wider AVX2/AVX-512 kernels instead when the CPU supports them.
 //
 
 template <int CHANNELS, int STRIDE, bool FIXED>
@@ -163,12 +164,10 @@ static inline void ProcessSSEIntrinsic(float* out,
         outAccum = _mm_hadd_ps(accL, accR);
         outAccum = _mm_hadd_ps(outAccum, outAccum);
     }
-    #if USE_AVX2
-    outSamp = _mm_fmadd_ps(outAccum, vLR,outSamp);
-    #else
+    // Not fused, so that out receives the same increment whatever it holds;
+    // AudioMixerBase parallel mixing relies on this.
     outAccum = _mm_mul_ps(outAccum, vLR);
     outSamp = _mm_add_ps(outSamp, outAccum);
-    #endif
 
     _mm_storel_pi(reinterpret_cast<__m64*>(out), outSamp);
 }
@@ -182,6 +181,9 @@ inline void ProcessL<1, 16>(float* const out,
         const float* sN,
         const float* const volumeLR)
 {
+    if (ProcessAvxFloat<1, true>(out, count, coefsP, coefsN, sP, sN, 0 /*lerpP*/, volumeLR)) {
+        return;
+    }
     ProcessSSEIntrinsic<1, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
 }
@@ -195,6 +197,9 @@ inline void ProcessL<2, 16>(float* const out,
         const float* sN,
         const float* const volumeLR)
 {
+    if (ProcessAvxFloat<2, true>(out, count, coefsP, coefsN, sP, sN, 0 /*lerpP*/, volumeLR)) {
+        return;
+    }
     ProcessSSEIntrinsic<2, 16, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
 }
@@ -211,6 +216,9 @@ inline void Process<1, 16>(float* const out,
         float lerpP,
         const float* const volumeLR)
 {
+    if (ProcessAvxFloat<1, false>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR)) {
+        return;
+    }
     ProcessSSEIntrinsic<1, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             lerpP, coefsP1, coefsN1);
 }
@@ -227,6 +235,9 @@ inline void Process<2, 16>(float* const out,
         float lerpP,
         const float* const volumeLR)
 {
+    if (ProcessAvxFloat<2, false>(out, count, coefsP, coefsN, sP, sN, lerpP, volumeLR)) {
+        return;
+    }
     ProcessSSEIntrinsic<2, 16, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
             lerpP, coefsP1, coefsN1);
 }
@@ -762,5 +762,59 @@ void TeeBufferProvider::clearFramesCopied() {
     mFrameCopied = 0;
 }
 
+FusedBufferProvider::FusedBufferProvider(
+        std::vector<CopyBufferProvider *> stages, size_t bufferFrameCount) :
+        CopyBufferProvider(
+                stages.front()->getInputFrameSize(),
+                stages.back()->getOutputFrameSize(),
+                bufferFrameCount),
+        mStages(std::move(stages)),
+        mStageFrameSizes(getFrameSizes(mStages))
+{
+    ALOGV("FusedBufferProvider(%p)(%zu stages, %zu)", this, mStages.size(), bufferFrameCount);
+    LOG_ALWAYS_FATAL_IF(mStages.size() < 2, "%s: requires at least 2 stages", __func__);
+    // intermediate results alternate between the two scratch buffers.
+    size_t maxFrameSize = 0;
+    for (size_t i = 0; i < mStages.size() - 1; ++i) {
+        maxFrameSize = std::max(maxFrameSize, mStages[i]->getOutputFrameSize());
+    }
+    const size_t scratchSize = (kBlockFrameCount * maxFrameSize + sizeof(float) - 1)
+            / sizeof(float);
+    mScratch[0].resize(scratchSize);
+    mScratch[1].resize(scratchSize);
+}
+
+/*static*/ std::vector<std::pair<size_t, size_t>> FusedBufferProvider::getFrameSizes(
+        const std::vector<CopyBufferProvider *> &stages)
+{
+    std::vector<std::pair<size_t, size_t>> frameSizes;
+    frameSizes.reserve(stages.size());
+    for (const CopyBufferProvider *stage : stages) {
+        frameSizes.emplace_back(stage->getInputFrameSize(), stage->getOutputFrameSize());
+    }
+    return frameSizes;
+}
+
+bool FusedBufferProvider::hasStages(const std::vector<CopyBufferProvider *> &stages) const
+{
+    // a stage may have been replaced by a new provider at the same address.
+    return stages == mStages && getFrameSizes(stages) == mStageFrameSizes;
+}
+
+void FusedBufferProvider::copyFrames(void *dst, const void *src, size_t frames)
+{
+    const size_t last = mStages.size() - 1;
+    for (size_t offset = 0; offset < frames; offset += kBlockFrameCount) {
+        const size_t count = std::min(kBlockFrameCount, frames - offset);
+        const void *in = (const uint8_t *)src + offset * mInputFrameSize;
+        for (size_t i = 0; i < last; ++i) {
+            void *out = mScratch[i & 1].data();
+            mStages[i]->copyFrames(out, in, count);
+            in = out;
+        }
+        mStages[last]->copyFrames((uint8_t *)dst + offset * mOutputFrameSize, in, count);
+    }
+}
+
 // ----------------------------------------------------------------------------
 } // namespace android
@@ -66,6 +66,10 @@ public:
     void setParameter(int name, int target, int param, void *value) override;
     void setBufferProvider(int name, AudioBufferProvider* bufferProvider);
 
+    // Returns the number of whole buffer copies saved each mix cycle by fusing the
+    // copying buffer providers of the enabled tracks, see reconfigureBufferProviders().
+    size_t getCopiesAvoidedPerCycle() const;
+
 private:
 
     struct Track : public TrackBase {
@@ -77,6 +81,7 @@ private:
             // Ensure the order of destruction of buffer providers as they
             // release the upstream provider in the destructor.
             mTimestretchBufferProvider.reset(nullptr);
+            mFusedBufferProviders.clear();
             mPostDownmixReformatBufferProvider.reset(nullptr);
             mDownmixerBufferProvider.reset(nullptr);
             mReformatBufferProvider.reset(nullptr);
@@ -124,6 +129,11 @@ private:
          * 6) mPostDownmixReformatBufferProvider: If not NULL, performs reformatting from
          *    the downmixer requirements to the mixer engine input requirements.
          * 7) mTimestretchBufferProvider: Adds timestretching for playback rate
+         *
+         * Consecutive providers among 2) to 6) that only convert frames one to one are
+         * not chained but run as the stages of a FusedBufferProvider in mFusedBufferProviders,
+         * so the data is copied once instead of once per provider. The effect downmixer
+         * and mAdjustChannelsBufferProvider are always chained.
          */
         AudioBufferProvider* mInputBufferProvider;    // externally provided buffer provider.
         std::unique_ptr<PassthruBufferProvider> mTeeBufferProvider;
@@ -132,6 +142,8 @@ private:
         std::unique_ptr<PassthruBufferProvider> mDownmixerBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mPostDownmixReformatBufferProvider;
         std::unique_ptr<PassthruBufferProvider> mTimestretchBufferProvider;
+        std::vector<std::unique_ptr<FusedBufferProvider>> mFusedBufferProviders;
+        bool mDownmixerFusable;  // mDownmixerBufferProvider is not the effect downmixer
 
         audio_format_t mDownmixRequiresFormat;  // required downmixer format
                                                 // AUDIO_FORMAT_PCM_16_BIT if 16 bit necessary
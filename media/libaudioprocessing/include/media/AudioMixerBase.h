@@ -27,7 +27,6 @@
 #include <media/AudioBufferProvider.h>
 #include <media/AudioResampler.h>
 #include <media/AudioResamplerPublic.h>
-#include <media/AudioNeonCal.h>
 #include <system/audio.h>
 #include <utils/Compat.h>
 
@@ -52,13 +51,6 @@ public:
     static const uint16_t UNITY_GAIN_INT = 0x1000;
     static const CONSTEXPR float UNITY_GAIN_FLOAT = 1.0f;
 
-    //ID of the neon type used
-    static const int FLOAT_FLOAT_FLOAT_MTYPE_IDS = 333;
-    static const int INT_INT16_INT16_MTYPE_IDS = 122;
-    static const int INT16_FLOAT_FLOAT_MTYPE_IDS = 233;
-    static const int FLOAT_INT16_INT16_MTYPE_IDS = 322;
-    static const int INT16_INT16_INT16_MTYPE_IDS = 222;
-
     enum { // names
         // setParameter targets
         TRACK           = 0x3000,
@@ -99,12 +91,9 @@ public:
         AUXLEVEL        = 0x4210,
     };
 
-    AudioMixerBase(size_t frameCount, uint32_t sampleRate)
-        : mSampleRate(sampleRate)
-        , mFrameCount(frameCount) {
-    }
+    AudioMixerBase(size_t frameCount, uint32_t sampleRate);
 
-    virtual ~AudioMixerBase() {}
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -145,6 +134,16 @@ public:
 
     size_t      getUnreleasedFrames(int name) const;
 
+    // Mix tracks on threadCount worker threads in addition to the thread calling process(),
+    // or only on the calling thread if threadCount is 0 (the default).
+    //
+    // Each enabled track is mixed into its own partial buffer, and the partial buffers are
+    // summed in the serial mixing order, so the output is identical to serial mixing.
+    // Only used when more than one track is enabled. The worker threads are created by,
+    // and inherit the scheduling policy of, the calling thread.
+    void        setParallelThreadCount(size_t threadCount);
+    size_t      getParallelThreadCount() const;
+
     std::string trackNames() const;
 
   protected:
@@ -305,6 +304,10 @@ public:
 
         int32_t        mTeeBufferFrameCount;
 
+        // partial main and aux buffers for parallel mixing, see setParallelThreadCount().
+        std::vector<int32_t> mParallelOut;
+        std::vector<int32_t> mParallelAux;
+
         uint32_t       mInputFrameSize; // The track input frame size, used for tee buffer
 
         // consider volume muted only if all channel volume (floating point) is 0.f
@@ -360,6 +363,14 @@ public:
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
 
+    template <bool RESAMPLING>
+    void process__parallel();
+
+    // Per track parts of the generic process hooks, shared with process__parallel().
+    void mixTrackNoResampling(TrackBase *t, int32_t *out, size_t numFrames, size_t frameCount,
+            int32_t *aux, int32_t *temp);
+    void mixTrackResampling(TrackBase *t, int32_t *out, int32_t *aux, int32_t *temp);
+
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
 
@@ -390,6 +401,14 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // worker threads for parallel mixing, or nullptr to mix serially.
+    class ParallelMixer;
+    std::unique_ptr<ParallelMixer> mParallelMixer;
+
+    // enabled tracks in serial mixing order: by group, then by name.
+    // Only valid while a process__parallel() hook is selected.
+    std::vector<TrackBase *> mParallelTracks;
 };
 
 }  // namespace android
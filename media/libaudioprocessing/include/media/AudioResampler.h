@@ -54,6 +54,14 @@ public:
     static AudioResampler* create(audio_format_t format, int inChannelCount,
             int32_t sampleRate, src_quality quality=DEFAULT_QUALITY);
 
+    // Computes the dynamic resampler filters for conversions between the common
+    // 44.1, 48 and 96 kHz rates to sampleRate at the default quality. These filters are
+    // shared by all resamplers in the process and kept for its lifetime, so tracks created
+    // later with those conversions do not design a filter of their own.
+    // This can take milliseconds, so call it from a non real-time thread before
+    // creating mixers at sampleRate, e.g. when an output thread is created.
+    static void preloadFilters(int32_t sampleRate);
+
     virtual ~AudioResampler();
 
     virtual void init() = 0;
@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 #include <sys/types.h>
+#include <utility>
+#include <vector>
 
 #include <audio_utils/ChannelMix.h>
 #include <media/AudioBufferProvider.h>
@@ -54,6 +56,9 @@ public:
         mTrackBufferProvider = p;
     }
 
+    // returns the upstream buffer provider.
+    AudioBufferProvider *getBufferProvider() const { return mTrackBufferProvider; }
+
 protected:
     AudioBufferProvider *mTrackBufferProvider;
 };
@@ -87,6 +92,9 @@ public:
     // of the internal buffers.
     virtual void copyFrames(void *dst, const void *src, size_t frames) = 0;
 
+    size_t getInputFrameSize() const { return mInputFrameSize; }
+    size_t getOutputFrameSize() const { return mOutputFrameSize; }
+
 protected:
     const size_t         mInputFrameSize;
     const size_t         mOutputFrameSize;
@@ -305,6 +313,39 @@ protected:
     int mFrameCopied;
 };
 
+// FusedBufferProvider derives from CopyBufferProvider to run the copyFrames() of a
+// sequence of CopyBufferProviders in a single pass over the input.
+// Each block of input frames goes through all the stages in a small scratch buffer that
+// stays in cache, and only the last stage writes to the local buffer, instead of every
+// stage copying the whole buffer into its own local buffer.
+// The stages are not owned, and their getNextBuffer() and releaseBuffer() are not used.
+// Stages must convert frames one to one and be able to work on arbitrary buffers.
+class FusedBufferProvider : public CopyBufferProvider {
+public:
+    FusedBufferProvider(std::vector<CopyBufferProvider *> stages, size_t bufferFrameCount);
+    //Overrides
+    void copyFrames(void *dst, const void *src, size_t frames) override;
+
+    // Number of whole buffer copies saved for each buffer obtained, compared to
+    // chaining the stages.
+    size_t getCopiesAvoided() const { return mStages.size() - 1; }
+
+    // True if this provider can run stages as is, i.e. they are the same providers
+    // with the same frame sizes as the ones it was created with.
+    bool hasStages(const std::vector<CopyBufferProvider *> &stages) const;
+
+protected:
+    // frames per block passed through the stages.
+    static constexpr size_t kBlockFrameCount = 64;
+
+    static std::vector<std::pair<size_t, size_t>> getFrameSizes(
+            const std::vector<CopyBufferProvider *> &stages);
+
+    const std::vector<CopyBufferProvider *> mStages;
+    const std::vector<std::pair<size_t, size_t>> mStageFrameSizes;  // input, output
+    std::vector<float>   mScratch[2];  // float for alignment, sized in bytes / sizeof(float)
+};
+
 // ----------------------------------------------------------------------------
 } // namespace android
 
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "buffer_providers_tests"
+#include <log/log.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioMixer.h>
+#include <media/BufferProviders.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kCopyBufferFrameCount = 256;
+
+// Returns consecutive frames of a random 16 bit signal, at most maxFrames per call.
+class SignalProvider : public AudioBufferProvider {
+public:
+    SignalProvider(uint32_t channelCount, size_t frameCount, size_t maxFrames)
+        : mChannelCount(channelCount)
+        , mMaxFrames(maxFrames)
+        , mData(frameCount * channelCount)
+    {
+        std::minstd_rand gen(42);
+        std::uniform_int_distribution<int16_t> dis(INT16_MIN, INT16_MAX);
+        for (int16_t &sample : mData) sample = dis(gen);
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        const size_t frameCount = mData.size() / mChannelCount;
+        buffer->frameCount = std::min({buffer->frameCount, mMaxFrames, frameCount - mPosition});
+        buffer->raw = buffer->frameCount > 0 ? &mData[mPosition * mChannelCount] : nullptr;
+        return buffer->frameCount > 0 ? NO_ERROR : NOT_ENOUGH_DATA;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        mPosition += buffer->frameCount;
+        buffer->frameCount = 0;
+    }
+
+private:
+    const uint32_t mChannelCount;
+    const size_t mMaxFrames;
+    std::vector<int16_t> mData;
+    size_t mPosition = 0;
+};
+
+// Returns 16 bit stereo frames, at most maxFrames per call, and counts the buffers
+// obtained while the previous one is still held. The position only advances on
+// release, so a held buffer that is dropped instead is returned again.
+class HeldBufferProvider : public AudioBufferProvider {
+public:
+    explicit HeldBufferProvider(size_t maxFrames)
+        : mMaxFrames(maxFrames)
+        , mData(maxFrames * 2 /* channelCount */)
+    {
+        std::minstd_rand gen(42);
+        std::uniform_int_distribution<int16_t> dis(INT16_MIN, INT16_MAX);
+        for (int16_t &sample : mData) sample = dis(gen);
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        if (mHeldFrames != 0) {
+            ++mRepeatedBuffers;
+        }
+        buffer->frameCount = std::min(buffer->frameCount, mMaxFrames);
+        buffer->raw = mData.data();
+        mHeldFrames = buffer->frameCount;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        EXPECT_LE(buffer->frameCount, mHeldFrames);
+        mPosition += buffer->frameCount;
+        mHeldFrames = 0;
+        buffer->frameCount = 0;
+    }
+
+    bool isHeld() const { return mHeldFrames != 0; }
+    size_t getPosition() const { return mPosition; }
+    size_t getRepeatedBuffers() const { return mRepeatedBuffers; }
+
+private:
+    const size_t mMaxFrames;
+    std::vector<int16_t> mData;
+    size_t mPosition = 0;
+    size_t mHeldFrames = 0;
+    size_t mRepeatedBuffers = 0;
+};
+
+// Reads the provider in requests of requestFrames until it runs dry.
+std::vector<float> drain(AudioBufferProvider *provider, uint32_t channelCount,
+        size_t requestFrames) {
+    std::vector<float> result;
+    for (;;) {
+        AudioBufferProvider::Buffer buffer;
+        buffer.frameCount = requestFrames;
+        if (provider->getNextBuffer(&buffer) != NO_ERROR || buffer.frameCount == 0) {
+            return result;
+        }
+        const float *data = static_cast<const float *>(buffer.raw);
+        result.insert(result.end(), data, data + buffer.frameCount * channelCount);
+        provider->releaseBuffer(&buffer);
+    }
+}
+
+struct Stages {
+    ReformatBufferProvider reformat{6 /* channelCount */,
+            AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount};
+    RemixBufferProvider remix{AUDIO_CHANNEL_OUT_5POINT1, AUDIO_CHANNEL_OUT_STEREO,
+            AUDIO_FORMAT_PCM_FLOAT, kCopyBufferFrameCount};
+    ClampFloatBufferProvider clamp{2 /* channelCount */, kCopyBufferFrameCount};
+};
+
+} // namespace
+
+class FusedBufferProviderTest : public ::testing::TestWithParam<
+        std::tuple<size_t /* maxFrames */, size_t /* requestFrames */>> {
+};
+
+// The fused provider must return the same frames as the chained providers,
+// whatever the sizes of the upstream buffers and of the requests.
+TEST_P(FusedBufferProviderTest, same_as_chain) {
+    const auto [maxFrames, requestFrames] = GetParam();
+    constexpr size_t kFrameCount = 4000;
+
+    SignalProvider chainInput(6 /* channelCount */, kFrameCount, maxFrames);
+    Stages chain;
+    chain.reformat.setBufferProvider(&chainInput);
+    chain.remix.setBufferProvider(&chain.reformat);
+    chain.clamp.setBufferProvider(&chain.remix);
+    const std::vector<float> expected = drain(&chain.clamp, 2 /* channelCount */, requestFrames);
+    ASSERT_EQ(kFrameCount * 2, expected.size());
+
+    SignalProvider fusedInput(6 /* channelCount */, kFrameCount, maxFrames);
+    Stages stages;
+    FusedBufferProvider fused({&stages.reformat, &stages.remix, &stages.clamp},
+            kCopyBufferFrameCount);
+    EXPECT_EQ(2u, fused.getCopiesAvoided());
+    fused.setBufferProvider(&fusedInput);
+    const std::vector<float> actual = drain(&fused, 2 /* channelCount */, requestFrames);
+    EXPECT_EQ(expected, actual);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        FusedBufferProviderTestAll, FusedBufferProviderTest,
+        ::testing::Combine(
+                ::testing::Values(1, 63, 64, 1000),
+                ::testing::Values(1, 100, 240, 1024)));
+
+// AudioMixer reuses a fused provider for new input as long as its stages are unchanged.
+TEST(FusedBufferProviderTest, reuse_for_new_input) {
+    constexpr size_t kFrameCount = 1000;
+    Stages stages;
+    FusedBufferProvider fused({&stages.reformat, &stages.remix, &stages.clamp},
+            kCopyBufferFrameCount);
+    EXPECT_TRUE(fused.hasStages({&stages.reformat, &stages.remix, &stages.clamp}));
+    EXPECT_FALSE(fused.hasStages({&stages.reformat, &stages.remix}));
+    EXPECT_FALSE(fused.hasStages({&stages.remix, &stages.reformat, &stages.clamp}));
+
+    SignalProvider firstInput(6 /* channelCount */, kFrameCount, 100 /* maxFrames */);
+    fused.setBufferProvider(&firstInput);
+    const std::vector<float> first = drain(&fused, 2 /* channelCount */, 240);
+
+    // the new input replays the same signal.
+    SignalProvider secondInput(6 /* channelCount */, kFrameCount, 100 /* maxFrames */);
+    fused.setBufferProvider(nullptr);
+    fused.setBufferProvider(&secondInput);
+    const std::vector<float> second = drain(&fused, 2 /* channelCount */, 240);
+    ASSERT_EQ(kFrameCount * 2, first.size());
+    EXPECT_EQ(first, second);
+}
+
+// Changing the playback rate or the tee buffer of an AudioMixer track while its fused
+// provider holds part of an input buffer must not return any input frame twice.
+TEST(FusedBufferProviderTest, mixer_reconfigure_mid_buffer) {
+    constexpr size_t kFrameCount = 1000;
+    constexpr size_t kMaxCycles = 20;
+    constexpr int kName = 0;
+    AudioMixer mixer(kFrameCount, 48000 /* sampleRate */);
+    HeldBufferProvider input(kFrameCount * 2 /* maxFrames */);
+    std::vector<float> mainBuffer(kFrameCount * 2 /* channelCount */);
+    std::vector<int16_t> teeBuffer(kFrameCount * 2 /* channelCount */);
+    std::vector<int16_t> otherTeeBuffer(kFrameCount * 2 /* channelCount */);
+
+    // 16 bit input is teed and converted to float by a single fused provider.
+    ASSERT_EQ(NO_ERROR, mixer.create(kName, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_SESSION_OUTPUT_MIX));
+    mixer.setBufferProvider(kName, &input);
+    mixer.setParameter(kName, AudioMixer::TRACK, AudioMixer::MIXER_FORMAT,
+            (void *)(uintptr_t)AUDIO_FORMAT_PCM_FLOAT);
+    mixer.setParameter(kName, AudioMixer::TRACK, AudioMixer::MAIN_BUFFER, mainBuffer.data());
+    mixer.setParameter(kName, AudioMixer::TRACK, AudioMixer::TEE_BUFFER_FRAME_COUNT,
+            (void *)(uintptr_t)kFrameCount);
+    mixer.setParameter(kName, AudioMixer::TRACK, AudioMixer::TEE_BUFFER, teeBuffer.data());
+    mixer.enable(kName);
+
+    // the timestretch provider consumes part of the buffers of the fused provider.
+    const auto processUntilHeld = [&]() {
+        for (size_t cycle = 0; cycle < kMaxCycles; ++cycle) {
+            mixer.process();
+            if (input.isHeld()) return true;
+        }
+        return false;
+    };
+    mixer.process();
+    AudioPlaybackRate playbackRate = AUDIO_PLAYBACK_RATE_DEFAULT;
+    playbackRate.mSpeed = 1.5f;
+    mixer.setParameter(kName, AudioMixer::TIMESTRETCH, AudioMixer::PLAYBACK_RATE, &playbackRate);
+    ASSERT_TRUE(processUntilHeld());
+
+    playbackRate.mSpeed = 1.25f;
+    mixer.setParameter(kName, AudioMixer::TIMESTRETCH, AudioMixer::PLAYBACK_RATE, &playbackRate);
+    ASSERT_TRUE(processUntilHeld());
+
+    // replacing the tee provider replaces the fused provider holding the input buffer.
+    mixer.setParameter(kName, AudioMixer::TRACK, AudioMixer::TEE_BUFFER, otherTeeBuffer.data());
+    const size_t position = input.getPosition();
+    for (size_t cycle = 0; cycle < 4; ++cycle) {
+        mixer.process();
+    }
+    EXPECT_LT(position, input.getPosition());
+    EXPECT_EQ(0u, input.getRepeatedBuffers());
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioMixerBase.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kFrameCount = 960; // 20 ms
+
+// Returns the same block of stereo float samples forever.
+class ConstantProvider : public AudioBufferProvider {
+public:
+    explicit ConstantProvider(uint32_t seed) : mData(kFrameCount * FCC_2) {
+        std::minstd_rand gen(seed);
+        std::uniform_real_distribution<float> dis(-1.f, 1.f);
+        for (float &sample : mData) sample = dis(gen);
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        buffer->raw = mData.data();
+        buffer->frameCount = std::min(buffer->frameCount, kFrameCount);
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        buffer->frameCount = 0;
+    }
+
+private:
+    std::vector<float> mData;
+};
+
+class BenchmarkMixer : public AudioMixerBase {
+public:
+    BenchmarkMixer() : AudioMixerBase(kFrameCount, kSampleRate) {}
+
+    void setBufferProvider(int name, AudioBufferProvider *provider) {
+        mTracks[name]->bufferProvider = provider;
+    }
+};
+
+} // namespace
+
+// Args: number of stereo float tracks, worker threads (0 is serial mixing),
+// and whether every other track is resampled from 44.1 kHz.
+static void BM_MixerParallel(benchmark::State& state) {
+    const size_t trackCount = state.range(0);
+    const size_t threadCount = state.range(1);
+    const bool resampling = state.range(2) != 0;
+
+    BenchmarkMixer mixer;
+    mixer.setParallelThreadCount(threadCount);
+    std::vector<float> mainBuffer(kFrameCount * FCC_2);
+    std::vector<std::unique_ptr<ConstantProvider>> providers;
+    for (size_t name = 0; name < trackCount; ++name) {
+        mixer.create(name, AUDIO_CHANNEL_OUT_STEREO, AUDIO_FORMAT_PCM_FLOAT,
+                AUDIO_SESSION_OUTPUT_MIX);
+        providers.emplace_back(new ConstantProvider(name));
+        mixer.setBufferProvider(name, providers.back().get());
+        mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::MAIN_BUFFER,
+                mainBuffer.data());
+        if (resampling && name % 2 == 1) {
+            mixer.setParameter(name, AudioMixerBase::RESAMPLE, AudioMixerBase::SAMPLE_RATE,
+                    (void *)(uintptr_t)44100);
+        }
+        float volume = 0.5f;
+        mixer.setParameter(name, AudioMixerBase::VOLUME, AudioMixerBase::VOLUME0, &volume);
+        mixer.setParameter(name, AudioMixerBase::VOLUME, AudioMixerBase::VOLUME1, &volume);
+        mixer.enable(name);
+    }
+
+    for (auto _ : state) {
+        mixer.process();
+        benchmark::DoNotOptimize(mainBuffer.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * trackCount * kFrameCount);
+}
+
+BENCHMARK(BM_MixerParallel)
+        ->ArgsProduct({{8, 32, 64}, {0, 1, 2, 3}, {0, 1}})
+        ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixer_parallel_tests"
+#include <log/log.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioMixerBase.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kFrameCount = 240;
+constexpr size_t kCycles = 40;
+
+// Loops over a fixed block of random float samples, returning at most maxFrames per call
+// so that tracks cross buffer boundaries in the middle of a mix cycle.
+// AudioMixerBase mixes float input; format conversion is done by AudioMixer.
+class LoopProvider : public AudioBufferProvider {
+public:
+    LoopProvider(uint32_t channelCount, size_t maxFrames, uint32_t seed)
+        : mChannelCount(channelCount)
+        , mMaxFrames(maxFrames)
+        , mData(kLoopFrames * channelCount)
+    {
+        std::minstd_rand gen(seed);
+        std::uniform_real_distribution<float> dis(-1.f, 1.f);
+        for (float &sample : mData) sample = dis(gen);
+    }
+
+    status_t getNextBuffer(Buffer *buffer) override {
+        const size_t frames = std::min({buffer->frameCount, mMaxFrames, kLoopFrames - mPosition});
+        buffer->raw = mData.data() + mPosition * mChannelCount;
+        buffer->frameCount = frames;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer *buffer) override {
+        mPosition = (mPosition + buffer->frameCount) % kLoopFrames;
+        buffer->frameCount = 0;
+    }
+
+private:
+    static constexpr size_t kLoopFrames = 1009;
+    const size_t mChannelCount;
+    const size_t mMaxFrames;
+    std::vector<float> mData;
+    size_t mPosition = 0;
+};
+
+class TestMixer : public AudioMixerBase {
+public:
+    TestMixer() : AudioMixerBase(kFrameCount, kSampleRate) {}
+
+    void setBufferProvider(int name, AudioBufferProvider *provider) {
+        mTracks[name]->bufferProvider = provider;
+    }
+};
+
+struct TrackConfig {
+    audio_channel_mask_t channelMask;
+    uint32_t sampleRate;
+    size_t maxFrames;   // largest buffer returned by the provider
+    int group;          // index of the main buffer
+    int aux;            // index of the aux buffer, or -1
+};
+
+// Mixes the tracks for kCycles, changing volumes as it goes, and returns the concatenated
+// main and aux buffers of every cycle.
+std::vector<uint8_t> mix(const std::vector<TrackConfig> &configs,
+        audio_format_t mixerFormat, size_t threadCount) {
+    constexpr size_t kGroups = 2;
+    constexpr size_t kAuxBuffers = 2;
+    constexpr uint32_t kMixerChannelCount = 2;
+    const size_t mainSize = kFrameCount * kMixerChannelCount * audio_bytes_per_sample(mixerFormat);
+
+    TestMixer mixer;
+    mixer.setParallelThreadCount(threadCount);
+    std::vector<std::vector<uint8_t>> mainBuffers(kGroups, std::vector<uint8_t>(mainSize));
+    std::vector<std::vector<int32_t>> auxBuffers(kAuxBuffers, std::vector<int32_t>(kFrameCount));
+    std::vector<std::unique_ptr<LoopProvider>> providers;
+
+    for (size_t name = 0; name < configs.size(); ++name) {
+        const TrackConfig &config = configs[name];
+        EXPECT_EQ(NO_ERROR, mixer.create(name, config.channelMask, AUDIO_FORMAT_PCM_FLOAT,
+                AUDIO_SESSION_OUTPUT_MIX));
+        providers.emplace_back(new LoopProvider(
+                audio_channel_count_from_out_mask(config.channelMask), config.maxFrames, name));
+        mixer.setBufferProvider(name, providers.back().get());
+        mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::MIXER_FORMAT,
+                (void *)(uintptr_t)mixerFormat);
+        mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::MAIN_BUFFER,
+                mainBuffers[config.group].data());
+        if (config.aux >= 0) {
+            mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::AUX_BUFFER,
+                    auxBuffers[config.aux].data());
+        }
+        if (config.sampleRate != kSampleRate) {
+            mixer.setParameter(name, AudioMixerBase::RESAMPLE, AudioMixerBase::SAMPLE_RATE,
+                    (void *)(uintptr_t)config.sampleRate);
+        }
+        mixer.enable(name);
+    }
+
+    std::minstd_rand gen(42);
+    std::uniform_real_distribution<float> dis(0.f, 1.f);
+    std::vector<uint8_t> result;
+    for (size_t cycle = 0; cycle < kCycles; ++cycle) {
+        // ramp to new volumes every few cycles, so that some cycles mix with ramps.
+        if (cycle % 4 == 0) {
+            for (size_t name = 0; name < configs.size(); ++name) {
+                const int target = cycle % 8 == 0
+                        ? AudioMixerBase::RAMP_VOLUME : AudioMixerBase::VOLUME;
+                float volume = dis(gen);
+                mixer.setParameter(name, target, AudioMixerBase::VOLUME0, &volume);
+                volume = dis(gen);
+                mixer.setParameter(name, target, AudioMixerBase::VOLUME1, &volume);
+                if (configs[name].aux >= 0) {
+                    volume = dis(gen);
+                    mixer.setParameter(name, target, AudioMixerBase::AUXLEVEL, &volume);
+                }
+            }
+        }
+        for (auto &aux : auxBuffers) {
+            std::fill(aux.begin(), aux.end(), 0);
+        }
+        mixer.process();
+        for (const auto &main : mainBuffers) {
+            result.insert(result.end(), main.begin(), main.end());
+        }
+        for (const auto &aux : auxBuffers) {
+            const uint8_t *data = reinterpret_cast<const uint8_t *>(aux.data());
+            result.insert(result.end(), data, data + aux.size() * sizeof(int32_t));
+        }
+    }
+    return result;
+}
+
+std::vector<TrackConfig> makeConfigs(bool resampling) {
+    return {
+        { AUDIO_CHANNEL_OUT_STEREO, 48000, 1000, 0, 0 },
+        { AUDIO_CHANNEL_OUT_STEREO, 48000, 100, 0, -1 },
+        { AUDIO_CHANNEL_OUT_MONO, resampling ? 44100 : 48000, 77, 0, 1 },
+        { AUDIO_CHANNEL_OUT_MONO, 48000, 1000, 1, 0 },
+        { AUDIO_CHANNEL_OUT_STEREO, resampling ? 22050 : 48000, 50, 1, 1 },
+        { AUDIO_CHANNEL_OUT_STEREO, resampling ? 32000 : 48000, 1000, 1, -1 },
+        { AUDIO_CHANNEL_OUT_STEREO, 48000, 13, 0, 0 },
+    };
+}
+
+} // namespace
+
+class MixerParallelTest
+        : public ::testing::TestWithParam<std::tuple<bool /* resampling */, audio_format_t>> {
+};
+
+TEST_P(MixerParallelTest, identical_to_serial) {
+    const auto [resampling, mixerFormat] = GetParam();
+    const std::vector<TrackConfig> configs = makeConfigs(resampling);
+
+    const std::vector<uint8_t> serial = mix(configs, mixerFormat, 0 /* threadCount */);
+    for (size_t threadCount : { 1, 2, 3 }) {
+        const std::vector<uint8_t> parallel = mix(configs, mixerFormat, threadCount);
+        ASSERT_EQ(serial.size(), parallel.size());
+        EXPECT_EQ(0, memcmp(serial.data(), parallel.data(), serial.size()))
+                << "threadCount " << threadCount;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        MixerParallelTestAll, MixerParallelTest,
+        ::testing::Combine(
+                ::testing::Bool(),
+                ::testing::Values(AUDIO_FORMAT_PCM_FLOAT, AUDIO_FORMAT_PCM_16_BIT)));
+
+TEST(MixerParallelThreadCountTest, set_and_get) {
+    TestMixer mixer;
+    EXPECT_EQ(0u, mixer.getParallelThreadCount());
+    mixer.setParallelThreadCount(2);
+    EXPECT_EQ(2u, mixer.getParallelThreadCount());
+    mixer.setParallelThreadCount(0);
+    EXPECT_EQ(0u, mixer.getParallelThreadCount());
+}
@@ -23,53 +23,72 @@
 
 using namespace android;
 
-template <int MIXTYPE, int NCHAN>
+// VECTOR selects volumeRampMulti() and volumeMulti(), which use the vector kernels where
+// available, or the scalar kernels volumeRampMultiScalar() and volumeMultiScalar().
+// Compare the two for the speedup per channel count and format.
+template <int MIXTYPE, int NCHAN, bool VECTOR = true,
+        typename TO = float, typename TI = float, typename TV = float, typename TA = float>
 static void BM_VolumeRampMulti(benchmark::State& state) {
     constexpr size_t FRAME_COUNT = 1000;
     constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
 
     // data inialized to 0.
-    float out[SAMPLE_COUNT]{};
-    float in[SAMPLE_COUNT]{};
-    float aux[FRAME_COUNT]{};
+    TO out[SAMPLE_COUNT]{};
+    TI in[SAMPLE_COUNT]{};
+    TA aux[FRAME_COUNT]{};
 
     // volume initialized to 0
-    float vola = 0.f;
-    float vol[2] = {0.f, 0.f};
+    TA vola = 0;
+    TV vol[2] = {0, 0};
 
     // some volume increment
-    float volainc = 0.01f;
-    float volinc[2] = {0.01f, 0.01f};
+    TA volainc = std::is_floating_point_v<TA> ? (TA)0.01f : (TA)1;
+    TV volinc[2] = {std::is_floating_point_v<TV> ? (TV)0.01f : (TV)1,
+            std::is_floating_point_v<TV> ? (TV)0.01f : (TV)1};
 
     while (state.KeepRunning()) {
         benchmark::DoNotOptimize(out);
         benchmark::DoNotOptimize(in);
-        volumeRampMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, aux, vol, volinc, &vola, volainc);
+        if constexpr (VECTOR) {
+            volumeRampMulti<MIXTYPE, NCHAN>(
+                    out, FRAME_COUNT, in, aux, vol, volinc, &vola, volainc);
+        } else {
+            volumeRampMultiScalar<MIXTYPE, NCHAN>(
+                    out, FRAME_COUNT, in, aux, vol, volinc, &vola, volainc);
+        }
         benchmark::ClobberMemory();
     }
+    state.SetItemsProcessed(state.iterations() * SAMPLE_COUNT);
 }
 
-template <int MIXTYPE, int NCHAN>
+template <int MIXTYPE, int NCHAN, bool VECTOR = true,
+        typename TO = float, typename TI = float, typename TV = float, typename TA = float>
 static void BM_VolumeMulti(benchmark::State& state) {
     constexpr size_t FRAME_COUNT = 1000;
     constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
 
     // data inialized to 0.
-    float out[SAMPLE_COUNT]{};
-    float in[SAMPLE_COUNT]{};
-    float aux[FRAME_COUNT]{};
+    TO out[SAMPLE_COUNT]{};
+    TI in[SAMPLE_COUNT]{};
+    TA aux[FRAME_COUNT]{};
+    // state.range(0) selects whether the aux send is mixed.
+    TA * const auxp = state.range(0) ? aux : nullptr;
 
     // volume initialized to 0
-    float vola = 0.f;
-    float vol[2] = {0.f, 0.f};
-
+    TA vola = 0;
+    TV vol[2] = {0, 0};
 
     while (state.KeepRunning()) {
         benchmark::DoNotOptimize(out);
         benchmark::DoNotOptimize(in);
-        volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, aux, vol, vola);
+        if constexpr (VECTOR) {
+            volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, auxp, vol, vola);
+        } else {
+            volumeMultiScalar<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, auxp, vol, vola);
+        }
         benchmark::ClobberMemory();
     }
+    state.SetItemsProcessed(state.iterations() * SAMPLE_COUNT);
 }
 
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
@@ -96,9 +115,49 @@ BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_MONOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
+BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_MONOVOL, 8)->Arg(1);
+BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8)->Arg(1);
+BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8)->Arg(1);
+BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8)->Arg(1);
+
+// Vector versus scalar kernels for the channel counts used by AudioMixer and the
+// spatializer (stereo, 5.1, 7.1, 7.1.4 and 22.2), with and without the aux send.
+#define BENCHMARK_VECTOR_SCALAR(BM, MIXTYPE, NCHAN, ...) \
+    BENCHMARK_TEMPLATE(BM, MIXTYPE, NCHAN, true, __VA_ARGS__)->Arg(0)->Arg(1); \
+    BENCHMARK_TEMPLATE(BM, MIXTYPE, NCHAN, false, __VA_ARGS__)->Arg(0)->Arg(1)
+
+#define BENCHMARK_VECTOR_SCALAR_CHANNELS(BM, MIXTYPE, ...) \
+    BENCHMARK_VECTOR_SCALAR(BM, MIXTYPE, 2, __VA_ARGS__); \
+    BENCHMARK_VECTOR_SCALAR(BM, MIXTYPE, 6, __VA_ARGS__); \
+    BENCHMARK_VECTOR_SCALAR(BM, MIXTYPE, 8, __VA_ARGS__); \
+    BENCHMARK_VECTOR_SCALAR(BM, MIXTYPE, 12, __VA_ARGS__); \
+    BENCHMARK_VECTOR_SCALAR(BM, MIXTYPE, 24, __VA_ARGS__)
+
+// float mixer.
+BENCHMARK_VECTOR_SCALAR_CHANNELS(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL,
+        float, float, float, float);
+BENCHMARK_VECTOR_SCALAR_CHANNELS(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL,
+        float, float, float, float);
+BENCHMARK_VECTOR_SCALAR_CHANNELS(BM_VolumeMulti, MIXTYPE_MONOEXPAND,
+        float, float, float, float);
+// 16 bit tracks into the integer mixer and into the float mixer.
+BENCHMARK_VECTOR_SCALAR_CHANNELS(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL,
+        int32_t, int16_t, int16_t, int32_t);
+BENCHMARK_VECTOR_SCALAR_CHANNELS(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL,
+        float, int16_t, float, float);
+// 16 bit output.
+BENCHMARK_VECTOR_SCALAR_CHANNELS(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL,
+        int16_t, int16_t, int16_t, int32_t);
+
+// volume ramps are vectorized for 4 or more channels.
+#define BENCHMARK_RAMP_VECTOR_SCALAR(MIXTYPE, NCHAN, ...) \
+    BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE, NCHAN, true, __VA_ARGS__); \
+    BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE, NCHAN, false, __VA_ARGS__)
+
+BENCHMARK_RAMP_VECTOR_SCALAR(MIXTYPE_MULTI_STEREOVOL, 6, float, float, float, float);
+BENCHMARK_RAMP_VECTOR_SCALAR(MIXTYPE_MULTI_STEREOVOL, 8, float, float, float, float);
+BENCHMARK_RAMP_VECTOR_SCALAR(MIXTYPE_MULTI_STEREOVOL, 12, float, float, float, float);
+BENCHMARK_RAMP_VECTOR_SCALAR(MIXTYPE_MULTI_STEREOVOL, 24, float, float, float, float);
+BENCHMARK_RAMP_VECTOR_SCALAR(MIXTYPE_MULTI_STEREOVOL, 12, int32_t, int16_t, int16_t, int32_t);
 
 BENCHMARK_MAIN();
@@ -19,7 +19,9 @@
 #include <log/log.h>
 
 #include <inttypes.h>
+#include <random>
 #include <type_traits>
+#include <vector>
 
 #include <../AudioMixerOps.h>
 #include <gtest/gtest.h>
@@ -173,3 +175,140 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+// Checks that the vector kernels used by volumeMulti() and volumeRampMulti() produce
+// exactly the same output, aux and volume ramp state as the scalar kernels.
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV, typename TA>
+class MixerOpsVectorTest {
+public:
+    static void testEquivalence() {
+        // odd frame count to exercise the scalar tail of volumeMulti().
+        constexpr size_t FRAME_COUNT = 251;
+        constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+        std::minstd_rand gen(MIXTYPE * 100 + NCHAN);
+        std::vector<TI> in(SAMPLE_COUNT);
+        for (auto &sample : in) sample = randomSample<TI>(gen);
+        std::vector<TO> out(SAMPLE_COUNT);
+        for (auto &sample : out) sample = randomSample<TO>(gen);
+        std::vector<TA> aux(FRAME_COUNT);
+        for (auto &sample : aux) sample = randomSample<TA>(gen);
+        TV vol[2] = {randomVolume<TV>(gen), randomVolume<TV>(gen)};
+        const TA vola = randomVolume<TA>(gen);
+
+        for (const bool useAux : {false, true}) {
+            SCOPED_TRACE(useAux ? "aux" : "no aux");
+            auto outVector = out, outScalar = out;
+            auto auxVector = aux, auxScalar = aux;
+            TA * const auxVectorP = useAux ? auxVector.data() : nullptr;
+            TA * const auxScalarP = useAux ? auxScalar.data() : nullptr;
+
+            volumeMulti<MIXTYPE, NCHAN>(
+                    outVector.data(), FRAME_COUNT, in.data(), auxVectorP, vol, vola);
+            volumeMultiScalar<MIXTYPE, NCHAN>(
+                    outScalar.data(), FRAME_COUNT, in.data(), auxScalarP, vol, vola);
+            EXPECT_EQ(outScalar, outVector);
+            EXPECT_EQ(auxScalar, auxVector);
+
+            // volume ramps use a small per frame increment from the same start volume.
+            const TV volinc[2] = {rampIncrement<TV>(vol[0]), rampIncrement<TV>(vol[1])};
+            const TA volainc = rampIncrement<TA>(vola);
+            TV volVector[2] = {vol[0], vol[1]}, volScalar[2] = {vol[0], vol[1]};
+            TA volaVector = vola, volaScalar = vola;
+            outVector = outScalar = out;
+            auxVector = auxScalar = aux;
+            volumeRampMulti<MIXTYPE, NCHAN>(outVector.data(), FRAME_COUNT, in.data(),
+                    auxVectorP, volVector, volinc, &volaVector, volainc);
+            volumeRampMultiScalar<MIXTYPE, NCHAN>(outScalar.data(), FRAME_COUNT, in.data(),
+                    auxScalarP, volScalar, volinc, &volaScalar, volainc);
+            EXPECT_EQ(outScalar, outVector);
+            EXPECT_EQ(auxScalar, auxVector);
+            EXPECT_EQ(volScalar[0], volVector[0]);
+            EXPECT_EQ(volScalar[1], volVector[1]);
+            EXPECT_EQ(volaScalar, volaVector);
+        }
+    }
+
+private:
+    // Samples are within float [-1, 1], Q0.15 or Q4.27. Integer samples are scaled
+    // down by the channel count so that the int32_t aux sum of a frame cannot overflow.
+    template <typename T>
+    static T randomSample(std::minstd_rand &gen) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return std::uniform_real_distribution<T>(-1.f, 1.f)(gen);
+        } else if constexpr (std::is_same_v<T, int16_t>) {
+            return std::uniform_int_distribution<int32_t>(
+                    INT16_MIN / NCHAN, INT16_MAX / NCHAN)(gen);
+        } else {
+            return std::uniform_int_distribution<int32_t>(
+                    -(1 << 27) / NCHAN, (1 << 27) / NCHAN)(gen);
+        }
+    }
+
+    // Volumes are at most unity gain: float 1, U4.12 or U4.28.
+    template <typename T>
+    static T randomVolume(std::minstd_rand &gen) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return std::uniform_real_distribution<T>(0.f, 1.f)(gen);
+        } else if constexpr (std::is_same_v<T, int16_t>) {
+            return std::uniform_int_distribution<int32_t>(0, 1 << 12)(gen);
+        } else {
+            return std::uniform_int_distribution<int32_t>(0, 1 << 28)(gen);
+        }
+    }
+
+    template <typename T>
+    static T rampIncrement(T volume) {
+        return std::is_floating_point_v<T> ? volume / 1000 : -(volume / 1000);
+    }
+};
+
+// Runs the type combinations used by AudioMixer for the given MIXTYPE and channel count.
+template <int MIXTYPE, int NCHAN>
+static void testVectorEquivalence() {
+    if constexpr (MIXTYPE == MIXTYPE_MULTI_SAVEONLY
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL) {
+        MixerOpsVectorTest<MIXTYPE, NCHAN, float, float, float, float>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, int16_t, int16_t, int16_t, int32_t>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, int16_t, float, float, float>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, int16_t, int32_t, int32_t, int32_t>::testEquivalence();
+    } else {
+        MixerOpsVectorTest<MIXTYPE, NCHAN, float, float, float, float>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, int32_t, int16_t, int16_t, int32_t>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, float, int16_t, float, float>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, float, float, int16_t, float>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, int32_t, int32_t, int32_t, int32_t>::testEquivalence();
+        MixerOpsVectorTest<MIXTYPE, NCHAN, float, int16_t, int16_t, int32_t>::testEquivalence();
+    }
+}
+
+template <int NCHAN>
+static void testVectorEquivalenceAllMixTypes() {
+    if constexpr (NCHAN <= FCC_LIMIT) {
+        SCOPED_TRACE(testing::Message() << "channels " << NCHAN);
+        if constexpr (NCHAN <= 2) { // MULTI and MULTI_SAVEONLY are limited to stereo.
+            testVectorEquivalence<MIXTYPE_MULTI, NCHAN>();
+            testVectorEquivalence<MIXTYPE_MULTI_SAVEONLY, NCHAN>();
+        }
+        testVectorEquivalence<MIXTYPE_MULTI_MONOVOL, NCHAN>();
+        testVectorEquivalence<MIXTYPE_MULTI_SAVEONLY_MONOVOL, NCHAN>();
+        testVectorEquivalence<MIXTYPE_MULTI_STEREOVOL, NCHAN>();
+        testVectorEquivalence<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN>();
+        testVectorEquivalence<MIXTYPE_MONOEXPAND, NCHAN>();
+        testVectorEquivalence<MIXTYPE_STEREOEXPAND, NCHAN>();
+    }
+}
+
+TEST(mixerops, vector_equivalence) {
+    testVectorEquivalenceAllMixTypes<1>();
+    testVectorEquivalenceAllMixTypes<2>();
+    testVectorEquivalenceAllMixTypes<3>();
+    testVectorEquivalenceAllMixTypes<4>();
+    testVectorEquivalenceAllMixTypes<5>();
+    testVectorEquivalenceAllMixTypes<6>();
+    testVectorEquivalenceAllMixTypes<7>();
+    testVectorEquivalenceAllMixTypes<8>();
+    testVectorEquivalenceAllMixTypes<12>();
+    testVectorEquivalenceAllMixTypes<24>();
+}
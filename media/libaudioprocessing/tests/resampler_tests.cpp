@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <memory>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -40,6 +41,9 @@
 #include <media/AudioResampler.h>
 #include "../AudioResamplerDyn.h"
 #include "../AudioResamplerFirGen.h"
+#include "../AudioResamplerFirOps.h"
+#include "../AudioResamplerFirProcess.h"
+#include "../AudioResamplerFirProcessAVX.h"
 #include "test_utils.h"
 
 template <typename T>
@@ -601,3 +605,159 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers with the same conversion share one filter bank, other conversions do not.
+TEST(audioflinger_resampler, sharedfiltercoefficients) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto createResampler = [](size_t channels, int32_t inSampleRate, int32_t outSampleRate) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT,
+                                channels,
+                                outSampleRate,
+                                android::AudioResampler::DYN_HIGH_QUALITY)));
+        rdyn->setSampleRate(inSampleRate);
+        return rdyn;
+    };
+
+    auto r1 = createResampler(2 /* channels */, 44100, 48000);
+    auto r2 = createResampler(6 /* channels */, 44100, 48000);
+    auto r3 = createResampler(2 /* channels */, 32000, 48000);
+    EXPECT_EQ(r1->getFilterCoefs(), r2->getFilterCoefs());
+    EXPECT_NE(r1->getFilterCoefs(), r3->getFilterCoefs());
+
+    // the shared table must be identical to a freshly designed one.
+    const int phases = r1->getPhases();
+    const int halfLength = r1->getHalfLength();
+    std::vector<float> expected((phases + 1) * halfLength);
+    android::firKaiserGen(expected.data(), phases, halfLength,
+            r1->getStopbandAttenuationDb(), r1->getNormalizedCutoffFrequency(),
+            r1->getFilterAttenuation());
+    EXPECT_EQ(0, memcmp(expected.data(), r2->getFilterCoefs(), expected.size() * sizeof(float)));
+
+    // a shared table stays valid after the resampler that designed it goes away.
+    const float *coefs = r2->getFilterCoefs();
+    r1.reset();
+    EXPECT_EQ(coefs, createResampler(1 /* channels */, 44100, 48000)->getFilterCoefs());
+}
+
+#if USE_SSE
+
+// Runs one polyphase dot product with random coefficients and samples through the scalar
+// ProcessBase() and through |kernel|, and returns both outputs.
+template <int CHANNELS, bool FIXED, typename TC, typename TI, typename TO, typename TINTERP,
+        typename KERNEL>
+static void runFirKernel(int count, TINTERP lerpP, KERNEL kernel, std::mt19937 &rng,
+        TO reference[2], TO test[2])
+{
+    std::uniform_int_distribution<int32_t> dist(INT32_MIN, INT32_MAX);
+    auto random = [&](auto *value) {
+        using T = std::remove_pointer_t<decltype(value)>;
+        if constexpr (std::is_floating_point_v<T>) {
+            *value = static_cast<T>(dist(rng)) / 2147483648.f;
+        } else {
+            *value = static_cast<T>(dist(rng));
+        }
+    };
+
+    // coefficients hold the next phase for interpolation right after the current phase.
+    std::vector<TC> coefsP(2 * count), coefsN(2 * count);
+    for (TC &c : coefsP) random(&c);
+    for (TC &c : coefsN) random(&c);
+    // samples centered in the buffer, see fir().
+    std::vector<TI> samples((2 * count + 2) * CHANNELS);
+    for (TI &sample : samples) random(&sample);
+    const TI *sP = samples.data() + count * CHANNELS;
+    const TI *sN = sP + CHANNELS;
+    TO volumeLR[2];
+    random(&volumeLR[0]);
+    random(&volumeLR[1]);
+
+    reference[0] = reference[1] = test[0] = test[1] = 0;
+    if (FIXED) {
+        android::ProcessBase<CHANNELS, 16, android::InterpNull>(reference, count,
+                coefsP.data(), coefsN.data(), sP, sN, lerpP, volumeLR);
+    } else {
+        android::ProcessBase<CHANNELS, 16, android::InterpCompute>(reference, count,
+                coefsP.data(), coefsN.data(), sP, sN, lerpP, volumeLR);
+    }
+    kernel(test, count, coefsP.data(), coefsN.data(), sP, sN, lerpP, volumeLR);
+}
+
+template <int CHANNELS, bool FIXED, typename TC>
+static void testFirKernelInt(android::FirSimdLevel level)
+{
+    std::mt19937 rng(CHANNELS * 2 + FIXED);
+    // lerpP is Q15 for int16_t coefficients and Q31 for int32_t, see fir().
+    std::uniform_int_distribution<uint32_t> lerpDist(
+            0, std::is_same_v<TC, int16_t> ? INT16_MAX : INT32_MAX);
+    for (int count = 8; count <= 64; count += 8) {
+        for (int trial = 0; trial < 16; ++trial) {
+            int32_t reference[2], test[2];
+            const uint32_t lerpP = FIXED ? 0 : lerpDist(rng);
+            if (level == android::FIR_SIMD_AVX512) {
+                runFirKernel<CHANNELS, FIXED, TC, int16_t, int32_t>(count, lerpP,
+                        android::ProcessAvx512Int<CHANNELS, FIXED, TC>, rng, reference, test);
+            } else {
+                runFirKernel<CHANNELS, FIXED, TC, int16_t, int32_t>(count, lerpP,
+                        android::ProcessAvx2Int<CHANNELS, FIXED, TC>, rng, reference, test);
+            }
+            // integer kernels are bit exact.
+            ASSERT_EQ(reference[0], test[0]) << "count " << count;
+            ASSERT_EQ(reference[1], test[1]) << "count " << count;
+        }
+    }
+}
+
+template <int CHANNELS, bool FIXED>
+static void testFirKernelFloat(android::FirSimdLevel level)
+{
+    std::mt19937 rng(CHANNELS * 2 + FIXED);
+    std::uniform_real_distribution<float> lerpDist(0.f, 1.f);
+    for (int count = 8; count <= 64; count += 8) {
+        for (int trial = 0; trial < 16; ++trial) {
+            float reference[2], test[2];
+            const float lerpP = FIXED ? 0.f : lerpDist(rng);
+            if (level == android::FIR_SIMD_AVX512) {
+                runFirKernel<CHANNELS, FIXED, float, float, float>(count, lerpP,
+                        android::ProcessAvx512Float<CHANNELS, FIXED>, rng, reference, test);
+            } else {
+                runFirKernel<CHANNELS, FIXED, float, float, float>(count, lerpP,
+                        android::ProcessAvx2Float<CHANNELS, FIXED>, rng, reference, test);
+            }
+            // float kernels sum in a different order, allow for rounding.
+            ASSERT_NEAR(reference[0], test[0], 1e-5 * count) << "count " << count;
+            ASSERT_NEAR(reference[1], test[1], 1e-5 * count) << "count " << count;
+        }
+    }
+}
+
+static void testFirKernels(android::FirSimdLevel level)
+{
+    if (android::getFirSimdLevelSupported() < level) {
+        GTEST_SKIP() << "CPU does not support SIMD level " << level;
+    }
+    testFirKernelInt<1, true, int16_t>(level);
+    testFirKernelInt<2, true, int16_t>(level);
+    testFirKernelInt<1, false, int16_t>(level);
+    testFirKernelInt<2, false, int16_t>(level);
+    testFirKernelInt<1, true, int32_t>(level);
+    testFirKernelInt<2, true, int32_t>(level);
+    testFirKernelInt<1, false, int32_t>(level);
+    testFirKernelInt<2, false, int32_t>(level);
+    testFirKernelFloat<1, true>(level);
+    testFirKernelFloat<2, true>(level);
+    testFirKernelFloat<1, false>(level);
+    testFirKernelFloat<2, false>(level);
+}
+
+TEST(audioflinger_resampler, firkernels_avx2) {
+    testFirKernels(android::FIR_SIMD_AVX2);
+}
+
+TEST(audioflinger_resampler, firkernels_avx512) {
+    testFirKernels(android::FIR_SIMD_AVX512);
+}
+
+#endif // USE_SSE
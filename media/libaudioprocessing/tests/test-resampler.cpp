@@ -32,6 +32,7 @@
 #include <utils/Vector.h>
 #include <media/AudioBufferProvider.h>
 #include <media/AudioResampler.h>
+#include "../AudioResamplerFirOps.h"
 
 using namespace android;
 
@@ -41,7 +42,7 @@ static int usage(const char* name) {
     fprintf(stderr,"Usage: %s [-p] [-f] [-F] [-v] [-c channels]"
                    " [-q {dq|lq|mq|hq|vhq|dlq|dmq|dhq}]"
                    " [-i input-sample-rate] [-o output-sample-rate]"
-                   " [-O csv] [-P csv] [<input-file>]"
+                   " [-O csv] [-P csv] [-s {sse|avx2|avx512}] [<input-file>]"
                    " <output-file>\n", name);
     fprintf(stderr,"    -p    enable profiling\n");
     fprintf(stderr,"    -f    enable filter profiling\n");
@@ -61,6 +62,8 @@ static int usage(const char* name) {
     fprintf(stderr,"    -o    output file sample rate\n");
     fprintf(stderr,"    -O    # frames output per call to resample() in CSV format\n");
     fprintf(stderr,"    -P    # frames provided per call to resample() in CSV format\n");
+    fprintf(stderr,"    -s    widest x86 SIMD extension used by dlq|dmq|dhq, for profiling\n");
+    fprintf(stderr,"              (defaults to the widest one supported by the CPU)\n");
     return -1;
 }
 
@@ -116,7 +119,7 @@ int main(int argc, char* argv[]) {
     Vector<int> Pvalues;
 
     int ch;
-    while ((ch = getopt(argc, argv, "pfFvc:q:i:o:O:P:")) != -1) {
+    while ((ch = getopt(argc, argv, "pfFvc:q:i:o:O:P:s:")) != -1) {
         switch (ch) {
         case 'p':
             profileResample = true;
@@ -173,6 +176,29 @@ int main(int argc, char* argv[]) {
                 return -1;
             }
             break;
+        case 's': {
+#if USE_SSE
+            FirSimdLevel level;
+            if (!strcmp(optarg, "sse"))
+                level = FIR_SIMD_SSE;
+            else if (!strcmp(optarg, "avx2"))
+                level = FIR_SIMD_AVX2;
+            else if (!strcmp(optarg, "avx512"))
+                level = FIR_SIMD_AVX512;
+            else {
+                usage(progname);
+                return -1;
+            }
+            if (level > getFirSimdLevelSupported()) {
+                fprintf(stderr, "%s is not supported by this CPU\n", optarg);
+                return -1;
+            }
+            gFirSimdLevel = level;
+#else
+            fprintf(stderr, "-s option is only available on x86\n");
+            return -1;
+#endif
+        } break;
         case '?':
         default:
             usage(progname);
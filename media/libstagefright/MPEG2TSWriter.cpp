@@ -23,6 +23,7 @@
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/ByteUtils.h>
+#include <media/stagefright/foundation/CRC32.h>
 #include <media/stagefright/MPEG2TSWriter.h>
 #include <media/stagefright/MediaBuffer.h>
 #include <media/stagefright/MediaDefs.h>
@@ -474,8 +475,6 @@ MPEG2TSWriter::MPEG2TSWriter(
 void MPEG2TSWriter::init() {
     CHECK(mFile != NULL || mWriteFunc != NULL);
 
-    initCrcTable();
-
     mLooper = new ALooper;
     mLooper->setName("MPEG2TSWriter");
 
@@ -707,7 +706,7 @@ void MPEG2TSWriter::writeProgramAssociationTable() {
     }
     buffer->data()[3] |= mPATContinuityCounter;
 
-    uint32_t crc = htonl(crc32(&buffer->data()[5], 12));
+    uint32_t crc = htonl(CRC32MPEG2(&buffer->data()[5], 12));
     memcpy(&buffer->data()[17], &crc, sizeof(crc));
 
     CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
@@ -783,7 +782,7 @@ void MPEG2TSWriter::writeProgramMap() {
         *ptr++ = 0x00;
     }
 
-    uint32_t crc = htonl(crc32(&buffer->data()[5], 12+mSources.size()*5));
+    uint32_t crc = htonl(CRC32MPEG2(&buffer->data()[5], 12+mSources.size()*5));
     memcpy(&buffer->data()[17+mSources.size()*5], &crc, sizeof(crc));
 
     CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
@@ -952,33 +951,6 @@ void MPEG2TSWriter::writeTS() {
     }
 }
 
-void MPEG2TSWriter::initCrcTable() {
-    uint32_t poly = 0x04C11DB7;
-
-    for (int i = 0; i < 256; i++) {
-        uint32_t crc = i << 24;
-        for (int j = 0; j < 8; j++) {
-            crc = (crc << 1) ^ ((crc & 0x80000000) ? (poly) : 0);
-        }
-        mCrcTable[i] = crc;
-    }
-}
-
-/**
- * Compute CRC32 checksum for buffer starting at offset start and for length
- * bytes.
- */
-uint32_t MPEG2TSWriter::crc32(const uint8_t *p_start, size_t length) {
-    uint32_t crc = 0xFFFFFFFF;
-    const uint8_t *p;
-
-    for (p = p_start; p < p_start + length; p++) {
-        crc = (crc << 8) ^ mCrcTable[((crc >> 24) ^ *p) & 0xFF];
-    }
-
-    return crc;
-}
-
 ssize_t MPEG2TSWriter::internalWrite(const void *data, size_t size) {
     if (mFile != NULL) {
         return fwrite(data, 1, size, mFile);
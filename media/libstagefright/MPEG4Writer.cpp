@@ -26,11 +26,15 @@
 #include <sys/prctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <utils/Log.h>
 
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <thread>
 
 #include <media/stagefright/MediaSource.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -153,6 +157,7 @@ public:
     int64_t getEstimatedTrackSizeBytes() const;
     int32_t getMetaSizeIncrease(int32_t angle, int32_t trackCount) const;
     void writeTrackHeader();
+    void writeTrexBox();
     int64_t getMinCttsOffsetTimeUs();
     void bufferChunk(int64_t timestampUs);
     bool isAvc() const { return mIsAvc; }
@@ -177,6 +182,13 @@ public:
     int64_t trackMetaDataSize();
     bool isTimestampValid(int64_t timeUs);
 
+    // Fragmented output. Whether the track has received its first sample or
+    // its end, and whether it has samples. Both are set with the owner locked.
+    bool isFragmentReady() const { return mFragmentReady; }
+    bool hasFragmentSamples() const { return mHasFragmentSamples; }
+    // Writes the samples held back until the init segment was written.
+    void writePendingFragment();
+
 private:
     // A helper class to handle faster write box with table entries
     template<class TYPE, unsigned ENTRY_SIZE>
@@ -347,6 +359,22 @@ private:
 
     List<MediaBuffer *> mChunkSamples;
 
+    // A sample of the fragment being built. The times are relative to the
+    // start of the track.
+    struct FragmentSample {
+        MediaBuffer *mBuffer;
+        int64_t mDecodingTimeUs;
+        int64_t mCompositionOffsetUs;
+        uint32_t mSize;
+        bool mIsSync;
+        bool mUsePrefix;
+    };
+    std::vector<FragmentSample> mFragmentSamples;
+    // Decoding time following the last sample, once the track has ended.
+    int64_t mFragmentEndTimeUs;
+    bool mFragmentReady;
+    bool mHasFragmentSamples;
+
     bool mSamplesHaveSameSize;
     ListTableEntries<uint32_t, 1> *mStszTableEntries;
     ListTableEntries<off64_t, 1> *mCo64TableEntries;
@@ -465,6 +493,12 @@ private:
     bool isTrackMalFormed();
     void sendTrackSummary(bool hasMultipleTracks);
 
+    status_t addFragmentSample(const FragmentSample &sample);
+    void setFragmentReady(bool hasSamples);
+    // Writes the held samples as one fragment, if the init segment has been
+    // written. "endTimeUs" is the decoding time following the last sample.
+    void writeFragment(int64_t endTimeUs);
+
     // Write the boxes
     void writeCo64Box();
     void writeStscBox();
@@ -495,6 +529,7 @@ private:
     void writeAudioFourCCBox();
     void writeVideoFourCCBox();
     void writeMetadataFourCCBox();
+    void writeStsdBox();
     void writeStblBox();
     void writeEdtsBox();
 
@@ -502,6 +537,253 @@ private:
     Track &operator=(const Track &);
 };
 
+// Writes the samples of the chunks on a separate I/O thread, so that the
+// writer thread can prepare the next chunk while the previous one is written.
+// Samples that are contiguous in the file are gathered into batches, each
+// written with a single pwritev(). A batch is handed to the I/O thread at a
+// sample boundary when the thread is idle, or when the batch is full, so
+// batches only grow while the storage is falling behind.
+class MPEG4Writer::AsyncChunkWriter {
+public:
+    explicit AsyncChunkWriter(int fd);
+    ~AsyncChunkWriter();
+
+    // Queues "size" bytes at "data" to be written at file offset "offset".
+    // The data must stay valid until the sample holding it is released.
+    void write(off64_t offset, const void *data, size_t size);
+    // Like write(), but copies the data. For sample headers of a few bytes.
+    void writeCopy(off64_t offset, const void *data, size_t size);
+    // Ends a sample, and releases "buffer" once its data is written.
+    void releaseSample(MediaBuffer *buffer);
+    // Waits until all the queued data is written. Returns false if a write
+    // failed.
+    bool flush();
+    bool hasError();
+    // The longest pwritev() calls so far.
+    std::vector<std::chrono::microseconds> longestWrites();
+
+private:
+    // Batches are handed over once they reach kMaxBatchSize bytes, even if
+    // the I/O thread is busy. The writer thread blocks while more than
+    // kMaxQueuedSize bytes are waiting to be written.
+    static constexpr size_t kMaxBatchSize = 2 * 1024 * 1024;
+    static constexpr size_t kMaxQueuedSize = 16 * 1024 * 1024;
+    static constexpr size_t kMaxBatchIovecs = 512;
+    static constexpr size_t kMaxBatchCopySize = 1024;
+    static constexpr size_t kLongestWritesCount = 5;
+
+    struct Batch {
+        off64_t mOffset = 0;
+        size_t mSize = 0;
+        std::vector<struct iovec> mIovecs;
+        std::vector<MediaBuffer *> mBuffers;
+        std::unique_ptr<uint8_t[]> mCopies;
+        size_t mCopiesSize = 0;
+    };
+
+    const int mFd;
+    std::thread mThread;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::deque<Batch> mQueue;
+    size_t mQueuedSize = 0;
+    bool mWriting = false;
+    bool mError = false;
+    bool mStopping = false;
+    std::vector<std::chrono::microseconds> mLongestWrites;
+
+    // Only used by the writer thread.
+    Batch mBatch;
+
+    // Hands over the current batch unless "size" more bytes at "offset" can
+    // be appended to it.
+    void prepareAppend(off64_t offset, size_t size, bool copy);
+    void append(off64_t offset, const void *data, size_t size);
+    void submit_l(std::unique_lock<std::mutex> &lock);
+    bool writeBatch(Batch *batch, std::chrono::microseconds *duration);
+    void threadLoop();
+
+    AsyncChunkWriter(const AsyncChunkWriter &) = delete;
+    AsyncChunkWriter &operator=(const AsyncChunkWriter &) = delete;
+};
+
+MPEG4Writer::AsyncChunkWriter::AsyncChunkWriter(int fd)
+    : mFd(fd) {
+    mThread = std::thread(&AsyncChunkWriter::threadLoop, this);
+}
+
+MPEG4Writer::AsyncChunkWriter::~AsyncChunkWriter() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+void MPEG4Writer::AsyncChunkWriter::write(off64_t offset, const void *data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    prepareAppend(offset, size, false /* copy */);
+    append(offset, data, size);
+}
+
+void MPEG4Writer::AsyncChunkWriter::writeCopy(
+        off64_t offset, const void *data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    CHECK_LE(size, kMaxBatchCopySize);
+    prepareAppend(offset, size, true /* copy */);
+    if (mBatch.mCopies == nullptr) {
+        mBatch.mCopies.reset(new uint8_t[kMaxBatchCopySize]);
+    }
+    uint8_t *copy = mBatch.mCopies.get() + mBatch.mCopiesSize;
+    memcpy(copy, data, size);
+    mBatch.mCopiesSize += size;
+    append(offset, copy, size);
+}
+
+void MPEG4Writer::AsyncChunkWriter::prepareAppend(off64_t offset, size_t size, bool copy) {
+    if (mBatch.mIovecs.empty()) {
+        return;
+    }
+    if (offset != mBatch.mOffset + (off64_t)mBatch.mSize
+            || mBatch.mSize + size > kMaxBatchSize
+            || mBatch.mIovecs.size() == kMaxBatchIovecs
+            || (copy && mBatch.mCopiesSize + size > kMaxBatchCopySize)) {
+        std::unique_lock<std::mutex> lock(mLock);
+        submit_l(lock);
+    }
+}
+
+void MPEG4Writer::AsyncChunkWriter::append(off64_t offset, const void *data, size_t size) {
+    if (mBatch.mIovecs.empty()) {
+        mBatch.mOffset = offset;
+    }
+    struct iovec iov;
+    iov.iov_base = const_cast<void *>(data);
+    iov.iov_len = size;
+    mBatch.mIovecs.push_back(iov);
+    mBatch.mSize += size;
+}
+
+void MPEG4Writer::AsyncChunkWriter::releaseSample(MediaBuffer *buffer) {
+    mBatch.mBuffers.push_back(buffer);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    if (mQueue.empty() && !mWriting) {
+        submit_l(lock);
+    }
+}
+
+bool MPEG4Writer::AsyncChunkWriter::flush() {
+    std::unique_lock<std::mutex> lock(mLock);
+    submit_l(lock);
+    mCondition.wait(lock, [this] { return mQueue.empty() && !mWriting; });
+    return !mError;
+}
+
+bool MPEG4Writer::AsyncChunkWriter::hasError() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mError;
+}
+
+std::vector<std::chrono::microseconds> MPEG4Writer::AsyncChunkWriter::longestWrites() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mLongestWrites;
+}
+
+void MPEG4Writer::AsyncChunkWriter::submit_l(std::unique_lock<std::mutex> &lock) {
+    if (mBatch.mIovecs.empty() && mBatch.mBuffers.empty()) {
+        return;
+    }
+    mQueuedSize += mBatch.mSize;
+    mQueue.push_back(std::move(mBatch));
+    mBatch = Batch();
+    mCondition.notify_all();
+
+    // Samples are released once written, so the encoders cannot run
+    // arbitrarily far ahead of the storage.
+    mCondition.wait(lock, [this] { return mQueuedSize <= kMaxQueuedSize || mError; });
+}
+
+bool MPEG4Writer::AsyncChunkWriter::writeBatch(
+        Batch *batch, std::chrono::microseconds *duration) {
+    auto beforeTP = std::chrono::high_resolution_clock::now();
+    struct iovec *iov = batch->mIovecs.data();
+    int iovcnt = batch->mIovecs.size();
+    off64_t offset = batch->mOffset;
+    while (iovcnt > 0) {
+        ssize_t bytesWritten = pwritev64(mFd, iov, iovcnt, offset);
+        if (bytesWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesWritten <= 0) {
+            ALOGE("pwritev at %lld failed: %s(%d)",
+                    (long long)offset, std::strerror(errno), errno);
+            return false;
+        }
+        offset += bytesWritten;
+        // Skip what was written, in case of a short write.
+        while (iovcnt > 0 && (size_t)bytesWritten >= iov->iov_len) {
+            bytesWritten -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (bytesWritten > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + bytesWritten;
+            iov->iov_len -= bytesWritten;
+        }
+    }
+    auto afterTP = std::chrono::high_resolution_clock::now();
+    *duration = std::chrono::duration_cast<std::chrono::microseconds>(afterTP - beforeTP);
+    return true;
+}
+
+void MPEG4Writer::AsyncChunkWriter::threadLoop() {
+    prctl(PR_SET_NAME, (unsigned long)"MPEG4WriterIO", 0, 0, 0);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mCondition.wait(lock, [this] { return !mQueue.empty() || mStopping; });
+        if (mQueue.empty()) {
+            break;
+        }
+        Batch batch = std::move(mQueue.front());
+        mQueue.pop_front();
+        mWriting = true;
+        bool skip = mError;
+        lock.unlock();
+
+        // After an error, the remaining batches are dropped.
+        std::chrono::microseconds duration(0);
+        bool ok = skip || batch.mIovecs.empty() || writeBatch(&batch, &duration);
+        for (MediaBuffer *buffer : batch.mBuffers) {
+            buffer->release();
+        }
+
+        lock.lock();
+        mWriting = false;
+        mQueuedSize -= batch.mSize;
+        if (!ok) {
+            mError = true;
+        }
+        if (duration.count() > 0) {
+            mLongestWrites.push_back(duration);
+            std::sort(mLongestWrites.begin(), mLongestWrites.end(),
+                    std::greater<std::chrono::microseconds>());
+            if (mLongestWrites.size() > kLongestWritesCount) {
+                mLongestWrites.pop_back();
+            }
+        }
+        mCondition.notify_all();
+    }
+}
+
 MPEG4Writer::MPEG4Writer(int fd) {
     initInternal(dup(fd), true /*isFirstSession*/);
 }
@@ -585,13 +867,19 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
         mAreGeoTagsAvailable = false;
         mSwitchPending = false;
         mIsFileSizeLimitExplicitlyRequested = false;
+        mFragmentDurationUs = 0;
+        mFragmentSink = NULL;
     }
+    mInitSegmentWritten = false;
+    mFragmentSequenceNumber = 0;
+    mWriteBoxToFragment = false;
 
-    // Verify mFd is seekable
+    // Verify mFd is seekable. Only the fragmented output can do without,
+    // which start() checks.
     off64_t off = lseek64(mFd, 0, SEEK_SET);
-    if (off < 0) {
-        ALOGE("cannot seek mFd: %s (%d) %lld", strerror(errno), errno, (long long)mFd);
-        release();
+    mIsFdSeekable = (off >= 0);
+    if (!mIsFdSeekable) {
+        ALOGW("cannot seek mFd: %s (%d) %lld", strerror(errno), errno, (long long)mFd);
     }
 
     if (fallocate64(mFd, FALLOC_FL_KEEP_SIZE, 0, 1) == 0) {
@@ -902,6 +1190,15 @@ status_t MPEG4Writer::start(MetaData *param) {
     }
     mStartMeta = param;
 
+    if (!mIsFdSeekable && !isFragmented()) {
+        ALOGE("cannot write a regular file to an fd that cannot seek");
+        return ERROR_IO;
+    }
+    if (isFragmented() && mHasFileLevelMeta) {
+        ALOGE("HEIF is not supported in fragmented mode");
+        return ERROR_UNSUPPORTED;
+    }
+
     /*
      * Check mMaxFileSizeLimitBytes at the beginning since mMaxFileSizeLimitBytes may be implicitly
      * changed later as per filesizebits of filesystem even if user does not set it explicitly.
@@ -910,20 +1207,30 @@ status_t MPEG4Writer::start(MetaData *param) {
         mIsFileSizeLimitExplicitlyRequested = true;
     }
 
-    /* mMaxFileSizeLimitBytes has to be set everytime fd is switched, hence the following code is
-     * appropriate in start() method.
-     */
-    int32_t fileSizeBits = fpathconf(mFd, _PC_FILESIZEBITS);
-    ALOGD("fpathconf _PC_FILESIZEBITS:%" PRId32, fileSizeBits);
-    fileSizeBits = std::min(fileSizeBits, 52 /* cap it below 4 peta bytes */);
-    int64_t maxFileSizeBytes = ((int64_t)1 << fileSizeBits) - 1;
-    if (mMaxFileSizeLimitBytes > maxFileSizeBytes) {
-        mMaxFileSizeLimitBytes = maxFileSizeBytes;
-        ALOGD("File size limit (%" PRId64 " bytes) too big. It is changed to %" PRId64 " bytes",
-              mMaxFileSizeLimitBytes, maxFileSizeBytes);
-    } else if (mMaxFileSizeLimitBytes == 0) {
-        mMaxFileSizeLimitBytes = maxFileSizeBytes;
-        ALOGD("File size limit set to %" PRId64 " bytes implicitly", maxFileSizeBytes);
+    if (isFragmented()) {
+        // A stream of fragments has no moov box to make room for, and no
+        // file to switch when it grows.
+        if (mMaxFileSizeLimitBytes != 0) {
+            ALOGW("File size limit is ignored in fragmented mode");
+            mMaxFileSizeLimitBytes = 0;
+        }
+        mPreAllocationEnabled = false;
+    } else {
+        /* mMaxFileSizeLimitBytes has to be set everytime fd is switched, hence the following
+         * code is appropriate in start() method.
+         */
+        int32_t fileSizeBits = fpathconf(mFd, _PC_FILESIZEBITS);
+        ALOGD("fpathconf _PC_FILESIZEBITS:%" PRId32, fileSizeBits);
+        fileSizeBits = std::min(fileSizeBits, 52 /* cap it below 4 peta bytes */);
+        int64_t maxFileSizeBytes = ((int64_t)1 << fileSizeBits) - 1;
+        if (mMaxFileSizeLimitBytes > maxFileSizeBytes) {
+            mMaxFileSizeLimitBytes = maxFileSizeBytes;
+            ALOGD("File size limit (%" PRId64 " bytes) too big. It is changed to %" PRId64
+                  " bytes", mMaxFileSizeLimitBytes, maxFileSizeBytes);
+        } else if (mMaxFileSizeLimitBytes == 0) {
+            mMaxFileSizeLimitBytes = maxFileSizeBytes;
+            ALOGD("File size limit set to %" PRId64 " bytes implicitly", maxFileSizeBytes);
+        }
     }
 
     int32_t use2ByteNalLength;
@@ -1029,49 +1336,56 @@ status_t MPEG4Writer::start(MetaData *param) {
         return err;
     }
 
-    writeFtypBox(param);
+    if (isFragmented()) {
+        // The ftyp and moov boxes go out with the first fragment, once the
+        // formats of all the tracks are known.
+        mOffset = 0;
+        mMdatOffset = 0;
+    } else {
+        writeFtypBox(param);
 
-    mFreeBoxOffset = mOffset;
+        mFreeBoxOffset = mOffset;
 
-    if (mInMemoryCacheSize == 0) {
-        int32_t bitRate = -1;
-        if (mHasFileLevelMeta) {
-            mFileLevelMetaDataSize = estimateFileLevelMetaSize(param);
-            mInMemoryCacheSize += mFileLevelMetaDataSize;
-        }
-        if (mHasMoovBox) {
-            if (param) {
-                param->findInt32(kKeyBitRate, &bitRate);
+        if (mInMemoryCacheSize == 0) {
+            int32_t bitRate = -1;
+            if (mHasFileLevelMeta) {
+                mFileLevelMetaDataSize = estimateFileLevelMetaSize(param);
+                mInMemoryCacheSize += mFileLevelMetaDataSize;
             }
-            mInMemoryCacheSize += estimateMoovBoxSize(bitRate);
-        }
-    }
-    if (mStreamableFile) {
-        // Reserve a 'free' box only for streamable file
-        seekOrPostError(mFd, mFreeBoxOffset, SEEK_SET);
-        writeInt32(mInMemoryCacheSize);
-        write("free", 4);
-        if (mInMemoryCacheSize >= 8) {
-            off64_t bufSize = mInMemoryCacheSize - 8;
-            char* zeroBuffer = new (std::nothrow) char[bufSize];
-            if (zeroBuffer) {
-                std::fill_n(zeroBuffer, bufSize, '0');
-                writeOrPostError(mFd, zeroBuffer, bufSize);
-                delete [] zeroBuffer;
+            if (mHasMoovBox) {
+                if (param) {
+                    param->findInt32(kKeyBitRate, &bitRate);
+                }
+                mInMemoryCacheSize += estimateMoovBoxSize(bitRate);
+            }
+        }
+        if (mStreamableFile) {
+            // Reserve a 'free' box only for streamable file
+            seekOrPostError(mFd, mFreeBoxOffset, SEEK_SET);
+            writeInt32(mInMemoryCacheSize);
+            write("free", 4);
+            if (mInMemoryCacheSize >= 8) {
+                off64_t bufSize = mInMemoryCacheSize - 8;
+                char* zeroBuffer = new (std::nothrow) char[bufSize];
+                if (zeroBuffer) {
+                    std::fill_n(zeroBuffer, bufSize, '0');
+                    writeOrPostError(mFd, zeroBuffer, bufSize);
+                    delete [] zeroBuffer;
+                } else {
+                    ALOGW("freebox in file isn't initialized to 0");
+                }
             } else {
-                ALOGW("freebox in file isn't initialized to 0");
+                ALOGW("freebox size is less than 8:%" PRId64, mInMemoryCacheSize);
             }
+            mMdatOffset = mFreeBoxOffset + mInMemoryCacheSize;
         } else {
-            ALOGW("freebox size is less than 8:%" PRId64, mInMemoryCacheSize);
+            mMdatOffset = mOffset;
         }
-        mMdatOffset = mFreeBoxOffset + mInMemoryCacheSize;
-    } else {
-        mMdatOffset = mOffset;
-    }
 
-    mOffset = mMdatOffset;
-    seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+        mOffset = mMdatOffset;
+        seekOrPostError(mFd, mMdatOffset, SEEK_SET);
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1370,6 +1684,17 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         return mResetStatus;
     }
 
+    if (isFragmented()) {
+        // There is no moov box to write, only the last fragments.
+        writePendingFragments();
+        status_t errRelease = release();
+        if (err == OK) {
+            err = errRelease;
+        }
+        mResetStatus = err;
+        return mResetStatus;
+    }
+
     // Fix up the size of the 'mdat' chunk.
     seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
     uint64_t size = mOffset - mMdatOffset;
@@ -1545,7 +1870,14 @@ void MPEG4Writer::writeFtypBox(MetaData *param) {
     if (!param || !param->findInt32(kKeyFileType, &fileType)) {
         fileType = OUTPUT_FORMAT_MPEG_4;
     }
-    if (fileType != OUTPUT_FORMAT_MPEG_4 && fileType != OUTPUT_FORMAT_HEIF) {
+    if (isFragmented()) {
+        // CMAF track files, ISO/IEC 23000-19 7.2.
+        writeFourcc("cmfc");
+        writeInt32(0);
+        writeFourcc("cmfc");
+        writeFourcc("iso6");
+        writeFourcc("isom");
+    } else if (fileType != OUTPUT_FORMAT_MPEG_4 && fileType != OUTPUT_FORMAT_HEIF) {
         writeFourcc("3gp4");
         writeInt32(0);
         writeFourcc("isom");
@@ -1674,12 +2006,13 @@ off64_t MPEG4Writer::addSample_l(
     } else {
         if (tiffHdrOffset > 0) {
             tiffHdrOffset = htonl(tiffHdrOffset);
-            writeOrPostError(mFd, &tiffHdrOffset, 4);  // exif_tiff_header_offset field
+            // exif_tiff_header_offset field
+            writeSampleOrPostError(&tiffHdrOffset, 4, true /* copy */);
             mOffset += 4;
         }
 
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(),
-                         buffer->range_length());
+        writeSampleOrPostError((const uint8_t*)buffer->data() + buffer->range_offset(),
+                               buffer->range_length(), false /* copy */);
 
         mOffset += buffer->range_length();
     }
@@ -1740,9 +2073,11 @@ void MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
         x[1] = (length >> 16) & 0xff;
         x[2] = (length >> 8) & 0xff;
         x[3] = length & 0xff;
-        writeOrPostError(mFd, &x, 4);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
-        mOffset += length + 4;
+        writeSampleOrPostError(&x, 4, true /* copy */);
+        mOffset += 4;
+        writeSampleOrPostError(
+                (const uint8_t*)buffer->data() + buffer->range_offset(), length, false);
+        mOffset += length;
     } else {
         ALOGV("mUse2ByteNalLength");
         CHECK_LT(length, 65536u);
@@ -1750,9 +2085,11 @@ void MPEG4Writer::addLengthPrefixedSample_l(MediaBuffer *buffer) {
         uint8_t x[2];
         x[0] = length >> 8;
         x[1] = length & 0xff;
-        writeOrPostError(mFd, &x, 2);
-        writeOrPostError(mFd, (const uint8_t*)buffer->data() + buffer->range_offset(), length);
-        mOffset += length + 2;
+        writeSampleOrPostError(&x, 2, true /* copy */);
+        mOffset += 2;
+        writeSampleOrPostError(
+                (const uint8_t*)buffer->data() + buffer->range_offset(), length, false);
+        mOffset += length;
     }
 }
 
@@ -1760,7 +2097,10 @@ size_t MPEG4Writer::write(
         const void *ptr, size_t size, size_t nmemb) {
 
     const size_t bytes = size * nmemb;
-    if (mWriteBoxToMemory) {
+    if (mWriteBoxToFragment) {
+        const uint8_t *data = (const uint8_t *)ptr;
+        mFragmentData.insert(mFragmentData.end(), data, data + bytes);
+    } else if (mWriteBoxToMemory) {
 
         off64_t boxSize = 8 + mInMemoryCacheOffset + bytes;
         if (boxSize > mInMemoryCacheSize) {
@@ -1821,6 +2161,119 @@ void MPEG4Writer::writeOrPostError(int fd, const void* buf, size_t count) {
     WARN_UNLESS(msg->post() == OK, "writeOrPostError:error posting ERROR_IO");
 }
 
+void MPEG4Writer::writeSampleOrPostError(const void *buf, size_t count, bool copy) {
+    if (mWriteBoxToFragment) {
+        write(buf, 1, count);
+        return;
+    }
+    if (mChunkWriter == nullptr) {
+        writeOrPostError(mFd, buf, count);
+        return;
+    }
+    if (mWriteSeekErr == true)
+        return;
+
+    if (mChunkWriter->hasError()) {
+        // The error was logged by the I/O thread.
+        mWriteSeekErr = true;
+        sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
+        msg->setInt32("err", ERROR_IO);
+        WARN_UNLESS(msg->post() == OK, "writeSampleOrPostError:error posting ERROR_IO");
+        return;
+    }
+
+    if (copy) {
+        mChunkWriter->writeCopy(mOffset, buf, count);
+    } else {
+        mChunkWriter->write(mOffset, buf, count);
+    }
+}
+
+void MPEG4Writer::releaseSample_l(MediaBuffer *buffer) {
+    if (mChunkWriter == nullptr) {
+        buffer->release();
+        return;
+    }
+    mChunkWriter->releaseSample(buffer);
+}
+
+bool MPEG4Writer::writeInitSegmentIfReady_l() {
+    if (mInitSegmentWritten) {
+        return true;
+    }
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if (!(*it)->isFragmentReady()) {
+            return false;
+        }
+    }
+
+    beginFragment_l();
+    writeFtypBox(mStartMeta.get());
+    beginBox("moov");
+    writeMvhdBox(0);
+    if (mAreGeoTagsAvailable) {
+        writeUdtaBox();
+    }
+    writeMoovLevelMetaBox();
+    // Tracks that ended without a sample are left out.
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if ((*it)->hasFragmentSamples()) {
+            (*it)->writeTrackHeader();
+        }
+    }
+    beginBox("mvex");
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if ((*it)->hasFragmentSamples()) {
+            (*it)->writeTrexBox();
+        }
+    }
+    endBox();  // mvex
+    endBox();  // moov
+    endFragment_l(true /* isInitSegment */);
+
+    mInitSegmentWritten = true;
+    return true;
+}
+
+void MPEG4Writer::beginFragment_l() {
+    CHECK(!mWriteBoxToFragment);
+    mFragmentData.clear();
+    mWriteBoxToFragment = true;
+}
+
+void MPEG4Writer::endFragment_l(bool isInitSegment) {
+    CHECK(mWriteBoxToFragment);
+    CHECK(mBoxes.empty());
+    mWriteBoxToFragment = false;
+
+    if (mFragmentSink != NULL) {
+        mFragmentSink->onFragment(mFragmentData.data(), mFragmentData.size(), isInitSegment);
+    } else {
+        writeOrPostError(mFd, mFragmentData.data(), mFragmentData.size());
+    }
+    mOffset += mFragmentData.size();
+}
+
+void MPEG4Writer::writeFragmentSample_l(MediaBuffer *buffer, bool usePrefix) {
+    CHECK(mWriteBoxToFragment);
+
+    // mOffset moves past the whole fragment once it is sent.
+    off64_t offset = mOffset;
+    if (usePrefix) {
+        addMultipleLengthPrefixedSamples_l(buffer);
+    } else {
+        write((const uint8_t *)buffer->data() + buffer->range_offset(), 1,
+              buffer->range_length());
+    }
+    mOffset = offset;
+}
+
+void MPEG4Writer::writePendingFragments() {
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        (*it)->writePendingFragment();
+    }
+}
+
 void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
     if (mWriteSeekErr == true)
         return;
@@ -1843,8 +2296,8 @@ void MPEG4Writer::seekOrPostError(int fd, off64_t offset, int whence) {
 void MPEG4Writer::beginBox(uint32_t id) {
     ALOGV("beginBox:%" PRIu32, id);
 
-    mBoxes.push_back(mWriteBoxToMemory?
-            mInMemoryCacheOffset: mOffset);
+    mBoxes.push_back(mWriteBoxToFragment? (off64_t)mFragmentData.size():
+            mWriteBoxToMemory? mInMemoryCacheOffset: mOffset);
 
     writeInt32(0);
     writeInt32(id);
@@ -1854,8 +2307,8 @@ void MPEG4Writer::beginBox(const char *fourcc) {
     ALOGV("beginBox:%s", fourcc);
     CHECK_EQ(strlen(fourcc), 4u);
 
-    mBoxes.push_back(mWriteBoxToMemory?
-            mInMemoryCacheOffset: mOffset);
+    mBoxes.push_back(mWriteBoxToFragment? (off64_t)mFragmentData.size():
+            mWriteBoxToMemory? mInMemoryCacheOffset: mOffset);
 
     writeInt32(0);
     writeFourcc(fourcc);
@@ -1867,7 +2320,10 @@ void MPEG4Writer::endBox() {
     off64_t offset = *--mBoxes.end();
     mBoxes.erase(--mBoxes.end());
 
-    if (mWriteBoxToMemory) {
+    if (mWriteBoxToFragment) {
+        int32_t x = htonl(mFragmentData.size() - offset);
+        memcpy(mFragmentData.data() + offset, &x, 4);
+    } else if (mWriteBoxToMemory) {
         int32_t x = htonl(mInMemoryCacheOffset - offset);
         memcpy(mInMemoryCache + offset, &x, 4);
     } else {
@@ -2225,6 +2681,9 @@ MPEG4Writer::Track::Track(
       mTrackId(aTrackId),
       mTrackDurationUs(0),
       mEstimatedTrackSizeBytes(0),
+      mFragmentEndTimeUs(-1),
+      mFragmentReady(false),
+      mHasFragmentSamples(false),
       mSamplesHaveSameSize(true),
       mStszTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
       mCo64TableEntries(new ListTableEntries<off64_t, 1>(1000)),
@@ -2314,6 +2773,9 @@ void MPEG4Writer::Track::resetInternal() {
     mIsMalformed = false;
     mTrackDurationUs = 0;
     mEstimatedTrackSizeBytes = 0;
+    mFragmentEndTimeUs = -1;
+    mFragmentReady = false;
+    mHasFragmentSamples = false;
     mSamplesHaveSameSize = false;
     if (mStszTableEntries != NULL) {
         delete mStszTableEntries;
@@ -2433,6 +2895,19 @@ void MPEG4Writer::stopAndReleaseLooper() {
     }
 }
 
+status_t MPEG4Writer::setFragmentedOutput(
+        int64_t fragmentDurationUs, const sp<FragmentSink> &sink) {
+    if (fragmentDurationUs <= 0) {
+        return BAD_VALUE;
+    }
+    if (mStarted) {
+        return INVALID_OPERATION;
+    }
+    mFragmentDurationUs = fragmentDurationUs;
+    mFragmentSink = sink;
+    return OK;
+}
+
 status_t MPEG4Writer::setNextFd(int fd) {
     Mutex::Autolock l(mLock);
     if (mNextFd != -1) {
@@ -2749,6 +3224,11 @@ MPEG4Writer::Track::~Track() {
     mCttsTableEntries = NULL;
     mElstTableEntries = NULL;
 
+    for (const FragmentSample &sample : mFragmentSamples) {
+        sample.mBuffer->release();
+    }
+    mFragmentSamples.clear();
+
     if (mCodecSpecificData != NULL) {
         free(mCodecSpecificData);
         mCodecSpecificData = NULL;
@@ -2823,7 +3303,7 @@ void MPEG4Writer::writeChunkToFile(Chunk* chunk) {
             isFirstSample = false;
         }
 
-        (*it)->release();
+        releaseSample_l(*it);
         (*it) = NULL;
         chunk->mSamples.erase(it);
     }
@@ -2927,6 +3407,27 @@ void MPEG4Writer::threadFunc() {
     ALOGV("threadFunc mOffset:%lld, mMaxOffsetAppend:%lld", (long long)mOffset,
           (long long)mMaxOffsetAppend);
     mOffset = std::max(mOffset, mMaxOffsetAppend);
+
+    if (mChunkWriter == nullptr) {
+        return;
+    }
+    bool chunkWriterOk = mChunkWriter->flush();
+    for (const std::chrono::microseconds &duration : mChunkWriter->longestWrites()) {
+        mWriteDurationPQ.emplace(duration);
+        if (mWriteDurationPQ.size() > kWriteDurationsCount) {
+            mWriteDurationPQ.pop();
+        }
+    }
+    mChunkWriter.reset();
+    if (!chunkWriterOk && mWriteSeekErr == false) {
+        mWriteSeekErr = true;
+        sp<AMessage> msg = new AMessage(kWhatIOError, mReflector);
+        msg->setInt32("err", ERROR_IO);
+        WARN_UNLESS(msg->post() == OK, "threadFunc:error posting ERROR_IO");
+    }
+    // The samples were written with pwritev(), leaving the file position
+    // behind. Catch up, so that the boxes written next land after them.
+    seekOrPostError(mFd, mOffset, SEEK_SET);
 }
 
 status_t MPEG4Writer::startWriterThread() {
@@ -2944,6 +3445,11 @@ status_t MPEG4Writer::startWriterThread() {
         mChunkInfos.push_back(info);
     }
 
+    if (!isFragmented()) {
+        // Fragments are written whole by the track threads.
+        mChunkWriter.reset(new AsyncChunkWriter(mFd));
+    }
+
     pthread_attr_t attr;
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
@@ -3993,6 +4499,25 @@ status_t MPEG4Writer::Track::threadEntry() {
                 trackProgressStatus(timestampUs);
             }
         }
+        if (mOwner->isFragmented()) {
+            FragmentSample sample;
+            sample.mBuffer = copy;
+            sample.mDecodingTimeUs = timestampUs;
+            sample.mCompositionOffsetUs =
+                    mIsVideo ? cttsOffsetTimeUs - kMaxCttsOffsetTimeUs : 0;
+            sample.mSize = sampleSize;
+            sample.mIsSync = !mIsVideo || isSync;
+            sample.mUsePrefix = usePrefix;
+            // Samples already in the file cannot be moved into fragments.
+            if (sampleFileOffset != -1 || addFragmentSample(sample) != OK) {
+                copy->release();
+                mSource->stop();
+                mIsMalformed = true;
+                break;
+            }
+            continue;
+        }
+
         if (!hasMultipleTracks) {
             size_t bytesWritten;
             off64_t offset = mOwner->addSample_l(
@@ -4005,7 +4530,7 @@ status_t MPEG4Writer::Track::threadEntry() {
                     addChunkOffset(offset);
                 }
             }
-            copy->release();
+            mOwner->releaseSample_l(copy);
             copy = NULL;
             continue;
         }
@@ -4096,6 +4621,16 @@ status_t MPEG4Writer::Track::threadEntry() {
             }
         }
     }
+
+    if (mOwner->isFragmented()) {
+        if (!mFragmentSamples.empty()) {
+            // The last sample lasts as long as it does in the stts table.
+            mFragmentEndTimeUs = mFragmentSamples.back().mDecodingTimeUs +
+                    (lastSampleDurationUs >= 0 ? lastSampleDurationUs : lastDurationUs);
+        }
+        setFragmentReady(false /* hasSamples */);
+        writePendingFragment();
+    }
     mReachedEOS = true;
 
     sendTrackSummary(hasMultipleTracks);
@@ -4112,6 +4647,120 @@ status_t MPEG4Writer::Track::threadEntry() {
     return err;
 }
 
+status_t MPEG4Writer::Track::addFragmentSample(const FragmentSample &sample) {
+    if (!mHasFragmentSamples) {
+        // The init segment needs the codec specific data of the track.
+        status_t err = checkCodecSpecificData();
+        if (err != OK) {
+            return err;
+        }
+        setFragmentReady(true /* hasSamples */);
+    } else if (!mFragmentSamples.empty() &&
+            sample.mDecodingTimeUs - mFragmentSamples.front().mDecodingTimeUs >=
+                    mOwner->mFragmentDurationUs) {
+        writeFragment(sample.mDecodingTimeUs);
+    }
+    mFragmentSamples.push_back(sample);
+    return OK;
+}
+
+void MPEG4Writer::Track::setFragmentReady(bool hasSamples) {
+    mOwner->lock();
+    mFragmentReady = true;
+    if (hasSamples) {
+        mHasFragmentSamples = true;
+    }
+    mOwner->unlock();
+}
+
+void MPEG4Writer::Track::writePendingFragment() {
+    if (!mFragmentSamples.empty()) {
+        writeFragment(mFragmentEndTimeUs);
+    }
+}
+
+void MPEG4Writer::Track::writeFragment(int64_t endTimeUs) {
+    // ISO/IEC 14496-12 8.8.3.1, sample_depends_on and sample_is_non_sync_sample.
+    static const uint32_t kSyncSampleFlags = 0x02000000;
+    static const uint32_t kNonSyncSampleFlags = 0x01010000;
+
+    mOwner->lock();
+    if (mFragmentSamples.empty() || !mOwner->writeInitSegmentIfReady_l()) {
+        // Held until the other tracks are ready, or the writer stops.
+        mOwner->unlock();
+        return;
+    }
+
+    // Decoding times start from the earliest track.
+    const int64_t startOffsetUs = mStartTimestampUs - mOwner->mStartTimestampUs;
+    auto toTicks = [this, startOffsetUs](int64_t timeUs) {
+        return ((startOffsetUs + timeUs) * mTimeScale + 500000LL) / 1000000LL;
+    };
+
+    mOwner->beginFragment_l();
+    mOwner->beginBox("moof");
+        mOwner->beginBox("mfhd");
+        mOwner->writeInt32(0);  // version=0, flags=0
+        mOwner->writeInt32(++mOwner->mFragmentSequenceNumber);
+        mOwner->endBox();  // mfhd
+        mOwner->beginBox("traf");
+            mOwner->beginBox("tfhd");
+            mOwner->writeInt32(0x020000);  // version=0, flags=default-base-is-moof
+            mOwner->writeInt32(mTrackId.getId());
+            mOwner->endBox();  // tfhd
+            mOwner->beginBox("tfdt");
+            mOwner->writeInt32(1 << 24);  // version=1, flags=0
+            mOwner->writeInt64(toTicks(mFragmentSamples.front().mDecodingTimeUs));
+            mOwner->endBox();  // tfdt
+            mOwner->beginBox("trun");
+            // Version 1 for signed composition time offsets. Flags for the
+            // data offset, and the duration, size, flags and composition time
+            // offset of each sample.
+            mOwner->writeInt32((1 << 24) | (mIsVideo ? 0xf01 : 0x701));
+            mOwner->writeInt32(mFragmentSamples.size());
+            const size_t dataOffsetPos = mOwner->mFragmentData.size();
+            mOwner->writeInt32(0);  // data offset, set below
+            size_t mdatSize = 0;
+            for (size_t i = 0; i < mFragmentSamples.size(); ++i) {
+                const FragmentSample &sample = mFragmentSamples[i];
+                int64_t nextTimeUs = (i + 1 < mFragmentSamples.size())
+                        ? mFragmentSamples[i + 1].mDecodingTimeUs : endTimeUs;
+                mOwner->writeInt32(toTicks(nextTimeUs) - toTicks(sample.mDecodingTimeUs));
+                mOwner->writeInt32(sample.mSize);
+                mOwner->writeInt32(sample.mIsSync ? kSyncSampleFlags : kNonSyncSampleFlags);
+                if (mIsVideo) {
+                    int64_t offsetUs = sample.mCompositionOffsetUs;
+                    mOwner->writeInt32((offsetUs * mTimeScale +
+                            (offsetUs < 0 ? -500000LL : 500000LL)) / 1000000LL);
+                }
+                mdatSize += sample.mSize;
+            }
+            mOwner->endBox();  // trun
+        mOwner->endBox();  // traf
+    mOwner->endBox();  // moof
+
+    // The sample data starts right after the mdat header.
+    int32_t dataOffset = htonl(mOwner->mFragmentData.size() + 8);
+    memcpy(mOwner->mFragmentData.data() + dataOffsetPos, &dataOffset, 4);
+    const size_t mdatOffset = mOwner->mFragmentData.size();
+    mOwner->beginBox("mdat");
+    for (const FragmentSample &sample : mFragmentSamples) {
+        mOwner->writeFragmentSample_l(sample.mBuffer, sample.mUsePrefix);
+    }
+    mOwner->endBox();  // mdat
+    if (mOwner->mFragmentData.size() - mdatOffset - 8 != mdatSize) {
+        ALOGE("%s fragment holds %zu bytes of samples instead of %zu", getTrackType(),
+              mOwner->mFragmentData.size() - mdatOffset - 8, mdatSize);
+    }
+    mOwner->endFragment_l(false /* isInitSegment */);
+    mOwner->unlock();
+
+    for (const FragmentSample &sample : mFragmentSamples) {
+        sample.mBuffer->release();
+    }
+    mFragmentSamples.clear();
+}
+
 bool MPEG4Writer::Track::isTrackMalFormed() {
     if (mIsMalformed) {
         return true;
@@ -4365,7 +5014,11 @@ void MPEG4Writer::Track::writeTrackHeader() {
     uint32_t now = getMpeg4Time();
     mOwner->beginBox("trak");
         writeTkhdBox(now);
-        writeEdtsBox();
+        // Fragments carry the start offset of the track in their decoding
+        // times instead.
+        if (!mOwner->isFragmented()) {
+            writeEdtsBox();
+        }
         mOwner->beginBox("mdia");
             writeMdhdBox(now);
             writeHdlrBox();
@@ -4384,6 +5037,17 @@ void MPEG4Writer::Track::writeTrackHeader() {
     mOwner->endBox();  // trak
 }
 
+void MPEG4Writer::Track::writeTrexBox() {
+    mOwner->beginBox("trex");
+    mOwner->writeInt32(0);                 // version=0, flags=0
+    mOwner->writeInt32(mTrackId.getId());  // track id
+    mOwner->writeInt32(1);                 // default sample description index
+    mOwner->writeInt32(0);                 // default sample duration
+    mOwner->writeInt32(0);                 // default sample size
+    mOwner->writeInt32(0);                 // default sample flags
+    mOwner->endBox();  // trex
+}
+
 int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
     // For video tracks with ctts table, this should return the minimum ctts
     // offset in the table. For non-video tracks or video tracks without ctts
@@ -4394,21 +5058,45 @@ int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
     return mMinCttsOffsetTimeUs;
 }
 
+void MPEG4Writer::Track::writeStsdBox() {
+    mOwner->beginBox("stsd");
+    mOwner->writeInt32(0);               // version=0, flags=0
+    mOwner->writeInt32(1);               // entry count
+    if (mIsAudio) {
+        writeAudioFourCCBox();
+    } else if (mIsVideo) {
+        writeVideoFourCCBox();
+    } else {
+        writeMetadataFourCCBox();
+    }
+    mOwner->endBox();  // stsd
+}
+
 void MPEG4Writer::Track::writeStblBox() {
     mOwner->beginBox("stbl");
-    // Add subboxes for only non-empty and well-formed tracks.
-    if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
-        mOwner->beginBox("stsd");
-        mOwner->writeInt32(0);               // version=0, flags=0
-        mOwner->writeInt32(1);               // entry count
-        if (mIsAudio) {
-            writeAudioFourCCBox();
-        } else if (mIsVideo) {
-            writeVideoFourCCBox();
-        } else {
-            writeMetadataFourCCBox();
-        }
-        mOwner->endBox();  // stsd
+    if (mOwner->isFragmented()) {
+        // The samples are all described by the track fragments.
+        writeStsdBox();
+        mOwner->beginBox("stts");
+        mOwner->writeInt32(0);  // version=0, flags=0
+        mOwner->writeInt32(0);  // entry count
+        mOwner->endBox();  // stts
+        mOwner->beginBox("stsc");
+        mOwner->writeInt32(0);  // version=0, flags=0
+        mOwner->writeInt32(0);  // entry count
+        mOwner->endBox();  // stsc
+        mOwner->beginBox("stsz");
+        mOwner->writeInt32(0);  // version=0, flags=0
+        mOwner->writeInt32(0);  // sample size
+        mOwner->writeInt32(0);  // sample count
+        mOwner->endBox();  // stsz
+        mOwner->beginBox("stco");
+        mOwner->writeInt32(0);  // version=0, flags=0
+        mOwner->writeInt32(0);  // entry count
+        mOwner->endBox();  // stco
+    } else if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
+        // Add subboxes for only non-empty and well-formed tracks.
+        writeStsdBox();
         writeSttsBox();
         if (mIsVideo) {
             writeCttsBox();
@@ -4783,7 +5471,7 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -4993,7 +5681,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
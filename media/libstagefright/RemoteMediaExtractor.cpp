@@ -51,6 +51,9 @@ static const char *kExtractorTracks = "android.media.mediaextractor.ntrk";
 // because they are not applicable or useful to that API.
 static const char *kExtractorEntryPoint = "android.media.mediaextractor.entry";
 static const char *kExtractorLogSessionId = "android.media.mediaextractor.logSessionId";
+static const char *kExtractorReadAheadHits = "android.media.mediaextractor.readahead.hits";
+static const char *kExtractorReadAheadMisses = "android.media.mediaextractor.readahead.misses";
+static const char *kExtractorReadAheadBytes = "android.media.mediaextractor.readahead.bytes";
 
 static const char *kEntryPointSdk = "sdk";
 static const char *kEntryPointWithJvm = "ndk-with-jvm";
@@ -149,6 +152,7 @@ static void asyncDataSourceClose(sp<DataSource> &ds) {
 }
 
 RemoteMediaExtractor::~RemoteMediaExtractor() {
+    updateReadAheadMetrics();
     delete mExtractor;
     // TODO(287851984) hook for changing behavior this dynamically, drop after testing
     int8_t new_scheme = property_get_bool("debug.mediaextractor.delayedclose", 1);
@@ -207,10 +211,33 @@ status_t RemoteMediaExtractor::getMetrics(Parcel *reply) {
         return UNKNOWN_ERROR;
     }
 
+    updateReadAheadMetrics();
     mMetricsItem->writeToParcel(reply);
     return OK;
 }
 
+void RemoteMediaExtractor::updateReadAheadMetrics() {
+    if (mMetricsItem == nullptr) {
+        return;
+    }
+    // The statistics change as the tracks are read. They come from private
+    // metadata keys that are not part of the format seen by apps.
+    MetaDataBase meta;
+    if (mExtractor->getMetaData(meta) != OK) {
+        return;
+    }
+    int64_t value;
+    if (meta.findInt64(kKeyReadAheadHits, &value)) {
+        mMetricsItem->setInt64(kExtractorReadAheadHits, value);
+    }
+    if (meta.findInt64(kKeyReadAheadMisses, &value)) {
+        mMetricsItem->setInt64(kExtractorReadAheadMisses, value);
+    }
+    if (meta.findInt64(kKeyReadAheadBytes, &value)) {
+        mMetricsItem->setInt64(kExtractorReadAheadBytes, value);
+    }
+}
+
 uint32_t RemoteMediaExtractor::flags() const {
     return mExtractor->flags();
 }
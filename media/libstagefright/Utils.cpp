@@ -1805,6 +1805,19 @@ status_t convertMessageToMetaData(const sp<AMessage> &msg, sp<MetaData> &meta) {
         meta->setInt32(isBackgroundMode, 1);
     }
 
+    // Extractor read-ahead statistics. These are private keys that are not converted
+    // back to the format seen by apps.
+    int64_t readAhead;
+    if (msg->findInt64("android._read-ahead-hits", &readAhead)) {
+        meta->setInt64(kKeyReadAheadHits, readAhead);
+    }
+    if (msg->findInt64("android._read-ahead-misses", &readAhead)) {
+        meta->setInt64(kKeyReadAheadMisses, readAhead);
+    }
+    if (msg->findInt64("android._read-ahead-bytes", &readAhead)) {
+        meta->setInt64(kKeyReadAheadBytes, readAhead);
+    }
+
     int32_t avgBitrate = 0;
     int32_t maxBitrate;
     if (msg->findInt32("bitrate", &avgBitrate) && avgBitrate > 0) {
@@ -1740,15 +1740,10 @@ status_t PlaylistFetcher::extractAndQueueAccessUnitsFromTs(const sp<ABuffer> &bu
         mSampleAesKeyItemChanged = false;
     }
 
-    size_t offset = 0;
-    while (offset + 188 <= buffer->size()) {
-        status_t err = mTSParser->feedTSPacket(buffer->data() + offset, 188);
-
-        if (err != OK) {
-            return err;
-        }
-
-        offset += 188;
+    size_t offset = (buffer->size() / 188) * 188;
+    status_t parseErr = mTSParser->feedTSPackets(buffer->data(), offset / 188);
+    if (parseErr != OK) {
+        return parseErr;
     }
     // setRange to indicate consumed bytes.
     buffer->setRange(buffer->offset() + offset, buffer->size() - offset);
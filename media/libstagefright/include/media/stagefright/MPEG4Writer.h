@@ -26,8 +26,10 @@
 #include <map>
 #include <media/stagefright/foundation/AHandlerReflector.h>
 #include <media/stagefright/foundation/ALooper.h>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace android {
 
@@ -78,11 +80,29 @@ public:
     virtual int32_t getStartTimeOffsetMs() const { return mStartTimeOffsetMs; }
     virtual status_t setNextFd(int fd);
 
+    // Receives the output of the fragmented mode. Called from the track
+    // threads with the writer locked, so it must not call into the writer.
+    struct FragmentSink : public RefBase {
+        // The first call carries the init segment (ftyp and moov), each of
+        // the following ones a complete moof and mdat pair.
+        virtual void onFragment(const void *data, size_t size, bool isInitSegment) = 0;
+    };
+
+    // Writes a fragmented MP4 (CMAF) stream instead of a regular file. Each
+    // track emits a fragment as soon as it holds fragmentDurationUs of media,
+    // independently of the other tracks. The output is never seeked back
+    // into, so the fd may be a pipe or a socket. It goes to "sink" instead of
+    // the fd if one is given. Must be called before start(). Not supported
+    // for HEIF.
+    status_t setFragmentedOutput(int64_t fragmentDurationUs,
+                                 const sp<FragmentSink> &sink = NULL);
+
 protected:
     virtual ~MPEG4Writer();
 
 private:
     class Track;
+    class AsyncChunkWriter;
     friend struct AHandlerReflector<MPEG4Writer>;
 
     enum {
@@ -128,6 +148,7 @@ private:
     bool mWriteSeekErr;
     bool mFallocateErr;
     bool mPreAllocationEnabled;
+    bool mIsFdSeekable;
     status_t mResetStatus;
     // Queue to hold top long write durations
     std::priority_queue<std::chrono::microseconds, std::vector<std::chrono::microseconds>,
@@ -192,6 +213,17 @@ private:
     pthread_t       mThread;                // Thread id for the writer
     List<ChunkInfo> mChunkInfos;            // Chunk infos
     Condition       mChunkReadyCondition;   // Signal that chunks are available
+    // Writes the sample data while the writer thread runs.
+    std::unique_ptr<AsyncChunkWriter> mChunkWriter;
+
+    // Fragmented output, see setFragmentedOutput(). Each fragment is built
+    // in mFragmentData and sent out in one piece.
+    int64_t mFragmentDurationUs;
+    sp<FragmentSink> mFragmentSink;
+    bool mInitSegmentWritten;
+    uint32_t mFragmentSequenceNumber;
+    bool mWriteBoxToFragment;
+    std::vector<uint8_t> mFragmentData;
 
     // HEIF writing
     typedef key_value_pair_t< const char *, Vector<uint16_t> > ItemRefs;
@@ -300,6 +332,17 @@ private:
             uint32_t tiffHdrOffset, size_t *bytesWritten);
     void addLengthPrefixedSample_l(MediaBuffer *buffer);
     void addMultipleLengthPrefixedSamples_l(MediaBuffer *buffer);
+    // Writes sample data at mOffset, through mChunkWriter if it is running.
+    // "copy" is set for data that does not outlive the call.
+    void writeSampleOrPostError(const void *buf, size_t count, bool copy);
+    // Releases a sample passed to addSample_l() once its data is written.
+    void releaseSample_l(MediaBuffer *buffer);
+    // Writes the ftyp and moov boxes of the fragmented output once all the
+    // tracks are ready. Returns whether they have been written.
+    bool writeInitSegmentIfReady_l();
+    void beginFragment_l();
+    void endFragment_l(bool isInitSegment);
+    void writeFragmentSample_l(MediaBuffer *buffer, bool usePrefix);
     uint16_t addProperty_l(const ItemProperty &);
     status_t reserveItemId_l(size_t numItems, uint16_t *itemIdBase);
     uint16_t addItem_l(const ItemInfo &);
@@ -309,6 +352,8 @@ private:
     bool exceedsFileDurationLimit();
     bool approachingFileSizeLimit();
     bool isFileStreamable() const;
+    bool isFragmented() const { return mFragmentDurationUs > 0; }
+    void writePendingFragments();
     void trackProgressStatus(uint32_t trackId, int64_t timeUs, status_t err = OK);
     status_t validateAllTracksId(bool akKey4BitTrackIds);
     void writeCompositionMatrix(int32_t degrees);
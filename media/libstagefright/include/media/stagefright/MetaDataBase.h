@@ -284,6 +284,11 @@ enum {
     kKeyLastSampleIndexInChunk = 'lsic',  //int64_t, index of last sample in a chunk.
     kKeySampleTimeBeforeAppend = 'lsba', // int64_t, timestamp of last sample of a track.
 
+    // Extractor read-ahead statistics, only reported through the extractor metrics.
+    kKeyReadAheadHits    = 'rahi', // int64_t, sample reads served from the read-ahead cache.
+    kKeyReadAheadMisses  = 'rami', // int64_t, sample reads that went to the data source.
+    kKeyReadAheadBytes   = 'raby', // int64_t, bytes read ahead from the data source.
+
     // DVB component tag
     kKeyDvbComponentTag = 'copt', // int32_t, component tag for DVB video/audio/subtitle
 
@@ -52,6 +52,9 @@ private:
 
     mediametrics::Item *mMetricsItem;
 
+    // copies the read-ahead statistics of the extractor to the metrics item.
+    void updateReadAheadMetrics();
+
     explicit RemoteMediaExtractor(
             MediaExtractor *extractor,
             const sp<DataSource> &source,
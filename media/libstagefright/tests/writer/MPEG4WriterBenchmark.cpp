@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of MPEG4Writer writing two seconds of 120 fps AVC
+// video, with video frames of state.range(0) bytes, alone (the single track
+// path) and together with AAC audio (the interleaved chunk path).
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/MPEG4Writer.h>
+#include <media/stagefright/MediaAdapter.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MetaData.h>
+#include <media/stagefright/Utils.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+namespace {
+
+const char *kOutputFile = "/data/local/tmp/writerBenchmark.mp4";
+
+const int32_t kVideoFrameCount = 240;
+const int64_t kVideoFrameDurationUs = 1000000 / 120;
+// Each video frame is split into this many slice NAL units.
+const size_t kSlicesPerFrame = 4;
+const int64_t kAudioFrameDurationUs = 1024 * 1000000LL / 48000;
+const size_t kAudioFrameSize = 768;
+
+const uint8_t kSps[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x33,
+                        0xac, 0x1b, 0x1a, 0x80, 0x78, 0x02, 0x27, 0xe5};
+const uint8_t kPps[] = {0x00, 0x00, 0x00, 0x01, 0x68, 0xee, 0x3c, 0xb0};
+// AAC LC, 48 kHz, stereo.
+const uint8_t kAudioSpecificConfig[] = {0x11, 0x90};
+
+sp<MetaData> makeTrackFormat(const sp<AMessage> &format) {
+    sp<MetaData> meta = new MetaData;
+    convertMessageToMetaData(format, meta);
+    return meta;
+}
+
+sp<MetaData> makeVideoFormat() {
+    sp<AMessage> format = new AMessage;
+    format->setString("mime", MEDIA_MIMETYPE_VIDEO_AVC);
+    format->setInt32("width", 3840);
+    format->setInt32("height", 2160);
+    format->setBuffer("csd-0", ABuffer::CreateAsCopy(kSps, sizeof(kSps)));
+    format->setBuffer("csd-1", ABuffer::CreateAsCopy(kPps, sizeof(kPps)));
+    return makeTrackFormat(format);
+}
+
+sp<MetaData> makeAudioFormat() {
+    sp<AMessage> format = new AMessage;
+    format->setString("mime", MEDIA_MIMETYPE_AUDIO_AAC);
+    format->setInt32("channel-count", 2);
+    format->setInt32("sample-rate", 48000);
+    format->setBuffer("csd-0",
+            ABuffer::CreateAsCopy(kAudioSpecificConfig, sizeof(kAudioSpecificConfig)));
+    return makeTrackFormat(format);
+}
+
+// A frame of start code prefixed slices, with payloads free of start codes.
+sp<ABuffer> makeVideoFrame(size_t size) {
+    sp<ABuffer> frame = new ABuffer(size);
+    memset(frame->data(), 0xab, size);
+    const size_t sliceSize = size / kSlicesPerFrame;
+    for (size_t i = 0; i < kSlicesPerFrame; ++i) {
+        uint8_t *slice = frame->data() + i * sliceSize;
+        slice[0] = slice[1] = slice[2] = 0x00;
+        slice[3] = 0x01;
+        slice[4] = 0x65;
+    }
+    return frame;
+}
+
+// Pushes "count" copies of "frame" to "track". pushBuffer() returns once the
+// writer has consumed each one.
+void pushFrames(const sp<MediaAdapter> &track, const sp<ABuffer> &frame, int32_t count,
+                int64_t frameDurationUs) {
+    for (int32_t i = 0; i < count; ++i) {
+        MediaBuffer *buffer = new MediaBuffer(frame);
+        buffer->add_ref();
+        MetaDataBase &meta = buffer->meta_data();
+        meta.setInt64(kKeyTime, i * frameDurationUs);
+        meta.setInt64(kKeyDecodingTime, i * frameDurationUs);
+        meta.setInt32(kKeyIsSyncFrame, (i % 30) == 0);
+        if (track->pushBuffer(buffer) != OK) {
+            buffer->release();
+            return;
+        }
+    }
+}
+
+void writeFile(benchmark::State &state, bool withAudio) {
+    const size_t videoFrameSize = state.range(0);
+    const sp<ABuffer> videoFrame = makeVideoFrame(videoFrameSize);
+    const sp<ABuffer> audioFrame = new ABuffer(kAudioFrameSize);
+    memset(audioFrame->data(), 0x5a, kAudioFrameSize);
+    const int32_t audioFrameCount =
+            withAudio ? kVideoFrameCount * kVideoFrameDurationUs / kAudioFrameDurationUs : 0;
+
+    for (auto _ : state) {
+        int fd = open(kOutputFile, O_CREAT | O_TRUNC | O_RDWR, 0644);
+        if (fd < 0) {
+            state.SkipWithError("Unable to open the output file");
+            return;
+        }
+
+        sp<MPEG4Writer> writer = new MPEG4Writer(fd);
+        sp<MediaAdapter> video = new MediaAdapter(makeVideoFormat());
+        sp<MediaAdapter> audio = new MediaAdapter(makeAudioFormat());
+        sp<MetaData> fileMeta = new MetaData;
+        fileMeta->setInt32(kKeyRealTimeRecording, false);
+        if (writer->addSource(video) != OK
+                || (withAudio && writer->addSource(audio) != OK)
+                || writer->start(fileMeta.get()) != OK) {
+            close(fd);
+            state.SkipWithError("Unable to start the writer");
+            return;
+        }
+
+        std::thread audioThread(pushFrames, audio, audioFrame, audioFrameCount,
+                                kAudioFrameDurationUs);
+        pushFrames(video, videoFrame, kVideoFrameCount, kVideoFrameDurationUs);
+        audioThread.join();
+
+        video->stop();
+        if (withAudio) {
+            audio->stop();
+        }
+        if (writer->stop() != OK) {
+            state.SkipWithError("Writer failed");
+        }
+        close(fd);
+    }
+
+    state.SetBytesProcessed(state.iterations() * (videoFrameSize * kVideoFrameCount +
+                                                  kAudioFrameSize * audioFrameCount));
+    unlink(kOutputFile);
+}
+
+}  // namespace
+
+static void BM_MPEG4WriterVideo(benchmark::State& state) {
+    writeFile(state, false /* withAudio */);
+}
+
+static void BM_MPEG4WriterVideoAudio(benchmark::State& state) {
+    writeFile(state, true /* withAudio */);
+}
+
+// From a 1080p frame to the I frames of a high bitrate 8K recording.
+BENCHMARK(BM_MPEG4WriterVideo)
+        ->RangeMultiplier(4)->Range(16 * 1024, 1024 * 1024)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_MPEG4WriterVideoAudio)
+        ->RangeMultiplier(4)->Range(16 * 1024, 1024 * 1024)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,489 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MPEG4WriterFragmentTest"
+#include <utils/Log.h>
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/stagefright/MPEG4Writer.h>
+#include <media/stagefright/MediaAdapter.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MetaData.h>
+#include <media/stagefright/Utils.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+using namespace android;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char *kOutputFile = "/data/local/tmp/writerFragmentTest.mp4";
+
+const int64_t kFragmentDurationUs = 400000;
+const int64_t kRecordingDurationUs = 3000000;
+const int64_t kVideoFrameDurationUs = 1000000 / 25;
+const size_t kVideoFrameSize = 4096;
+const int32_t kVideoSyncInterval = 25;
+const int64_t kAudioFrameDurationUs = 1024 * 1000000LL / 48000;
+const size_t kAudioFrameSize = 384;
+
+const uint8_t kSps[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0xc0, 0x1e,
+                        0xda, 0x02, 0x80, 0xbf, 0xe5, 0x84, 0x00, 0x00};
+const uint8_t kPps[] = {0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80};
+// AAC LC, 48 kHz, stereo.
+const uint8_t kAudioSpecificConfig[] = {0x11, 0x90};
+
+sp<MetaData> makeTrackFormat(const sp<AMessage> &format) {
+    sp<MetaData> meta = new MetaData;
+    convertMessageToMetaData(format, meta);
+    return meta;
+}
+
+sp<MetaData> makeVideoFormat() {
+    sp<AMessage> format = new AMessage;
+    format->setString("mime", MEDIA_MIMETYPE_VIDEO_AVC);
+    format->setInt32("width", 640);
+    format->setInt32("height", 480);
+    format->setBuffer("csd-0", ABuffer::CreateAsCopy(kSps, sizeof(kSps)));
+    format->setBuffer("csd-1", ABuffer::CreateAsCopy(kPps, sizeof(kPps)));
+    return makeTrackFormat(format);
+}
+
+sp<MetaData> makeAudioFormat() {
+    sp<AMessage> format = new AMessage;
+    format->setString("mime", MEDIA_MIMETYPE_AUDIO_AAC);
+    format->setInt32("channel-count", 2);
+    format->setInt32("sample-rate", 48000);
+    format->setBuffer("csd-0",
+            ABuffer::CreateAsCopy(kAudioSpecificConfig, sizeof(kAudioSpecificConfig)));
+    return makeTrackFormat(format);
+}
+
+// Pushes "count" frames to "track", each one frame duration after the
+// previous one when "paced", and returns the time each was pushed at.
+std::vector<Clock::time_point> pushFrames(const sp<MediaAdapter> &track, size_t frameSize,
+                                          int32_t count, int64_t frameDurationUs,
+                                          int32_t syncInterval, bool paced) {
+    std::vector<Clock::time_point> pushTimes;
+    const Clock::time_point start = Clock::now();
+    for (int32_t i = 0; i < count; ++i) {
+        const int64_t timeUs = i * frameDurationUs;
+        if (paced) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(timeUs));
+        }
+        sp<ABuffer> frame = new ABuffer(frameSize);
+        // Without zero bytes, which could form start codes.
+        memset(frame->data(), 0x80 | (i & 0x7f), frameSize);
+        if (syncInterval > 1) {
+            // A start code prefixed slice.
+            memcpy(frame->data(), "\x00\x00\x00\x01\x65", 5);
+        }
+        MediaBuffer *buffer = new MediaBuffer(frame);
+        buffer->add_ref();
+        MetaDataBase &meta = buffer->meta_data();
+        meta.setInt64(kKeyTime, timeUs);
+        meta.setInt64(kKeyDecodingTime, timeUs);
+        meta.setInt32(kKeyIsSyncFrame, (i % syncInterval) == 0);
+        pushTimes.push_back(Clock::now());
+        if (track->pushBuffer(buffer) != OK) {
+            buffer->release();
+            break;
+        }
+    }
+    return pushTimes;
+}
+
+struct Box {
+    std::string type;
+    const uint8_t *data;  // payload
+    size_t size;          // payload size
+};
+
+// Splits "size" bytes at "data" into boxes. Returns the number of bytes of
+// complete boxes.
+size_t parseBoxes(const uint8_t *data, size_t size, std::vector<Box> *boxes) {
+    size_t offset = 0;
+    while (size - offset >= 8) {
+        uint64_t boxSize = U32_AT(data + offset);
+        size_t headerSize = 8;
+        if (boxSize == 1) {
+            if (size - offset < 16) {
+                break;
+            }
+            boxSize = U64_AT(data + offset + 8);
+            headerSize = 16;
+        }
+        if (boxSize < headerSize) {
+            ADD_FAILURE() << "invalid box size " << boxSize;
+            return size;
+        }
+        if (boxSize > size - offset) {
+            break;
+        }
+        boxes->push_back({std::string((const char *)data + offset + 4, 4),
+                          data + offset + headerSize, (size_t)boxSize - headerSize});
+        offset += boxSize;
+    }
+    return offset;
+}
+
+const Box *findBox(const std::vector<Box> &boxes, const char *type) {
+    for (const Box &box : boxes) {
+        if (box.type == type) {
+            return &box;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<Box> childBoxes(const Box &box) {
+    std::vector<Box> children;
+    EXPECT_EQ(box.size, parseBoxes(box.data, box.size, &children)) << box.type;
+    return children;
+}
+
+struct TrackInfo {
+    uint32_t timeScale;
+    std::string handlerType;
+};
+
+// Reads the track ids, time scales and handler types from the moov box.
+std::map<uint32_t, TrackInfo> parseMoov(const Box &moov) {
+    std::map<uint32_t, TrackInfo> tracks;
+    std::vector<Box> moovChildren = childBoxes(moov);
+    EXPECT_NE(nullptr, findBox(moovChildren, "mvex"));
+    for (const Box &trak : moovChildren) {
+        if (trak.type != "trak") {
+            continue;
+        }
+        std::vector<Box> trakChildren = childBoxes(trak);
+        const Box *tkhd = findBox(trakChildren, "tkhd");
+        const Box *mdia = findBox(trakChildren, "mdia");
+        if (tkhd == nullptr || mdia == nullptr) {
+            ADD_FAILURE() << "incomplete trak box";
+            continue;
+        }
+        std::vector<Box> mdiaChildren = childBoxes(*mdia);
+        const Box *mdhd = findBox(mdiaChildren, "mdhd");
+        const Box *hdlr = findBox(mdiaChildren, "hdlr");
+        if (mdhd == nullptr || hdlr == nullptr) {
+            ADD_FAILURE() << "incomplete mdia box";
+            continue;
+        }
+        const bool tkhdV1 = tkhd->data[0] == 1;
+        const bool mdhdV1 = mdhd->data[0] == 1;
+        tracks[U32_AT(tkhd->data + (tkhdV1 ? 20 : 12))] = {
+                U32_AT(mdhd->data + (mdhdV1 ? 20 : 12)),
+                std::string((const char *)hdlr->data + 8, 4)};
+    }
+    return tracks;
+}
+
+struct Fragment {
+    uint32_t sequenceNumber;
+    uint32_t trackId;
+    uint64_t baseDecodeTime;
+    uint64_t duration;
+    uint32_t sampleCount;
+    uint64_t dataSize;
+};
+
+// Reads a moof box holding one track fragment.
+Fragment parseMoof(const Box &moof) {
+    Fragment fragment = {};
+    std::vector<Box> moofChildren = childBoxes(moof);
+    const Box *mfhd = findBox(moofChildren, "mfhd");
+    const Box *traf = findBox(moofChildren, "traf");
+    if (mfhd == nullptr || traf == nullptr) {
+        ADD_FAILURE() << "incomplete moof box";
+        return fragment;
+    }
+    fragment.sequenceNumber = U32_AT(mfhd->data + 4);
+
+    std::vector<Box> trafChildren = childBoxes(*traf);
+    const Box *tfhd = findBox(trafChildren, "tfhd");
+    const Box *tfdt = findBox(trafChildren, "tfdt");
+    const Box *trun = findBox(trafChildren, "trun");
+    if (tfhd == nullptr || tfdt == nullptr || trun == nullptr) {
+        ADD_FAILURE() << "incomplete traf box";
+        return fragment;
+    }
+    fragment.trackId = U32_AT(tfhd->data + 4);
+    fragment.baseDecodeTime = tfdt->data[0] == 1 ? U64_AT(tfdt->data + 4)
+                                                 : U32_AT(tfdt->data + 4);
+
+    const uint32_t flags = U32_AT(trun->data) & 0xffffff;
+    fragment.sampleCount = U32_AT(trun->data + 4);
+    // Every sample of this writer has a duration and a size.
+    EXPECT_EQ(0x300u, flags & 0x300u);
+    size_t offset = 8 + ((flags & 0x1) ? 4 : 0) + ((flags & 0x4) ? 4 : 0);
+    const size_t sampleFieldsSize = 4 * __builtin_popcount(flags & 0xf00);
+    if (trun->size < offset + fragment.sampleCount * sampleFieldsSize) {
+        ADD_FAILURE() << "trun box too small";
+        return fragment;
+    }
+    for (uint32_t i = 0; i < fragment.sampleCount; ++i) {
+        fragment.duration += U32_AT(trun->data + offset);
+        fragment.dataSize += U32_AT(trun->data + offset + 4);
+        offset += sampleFieldsSize;
+    }
+    return fragment;
+}
+
+// Checks the boxes of a fragmented stream and returns its fragments.
+void parseStream(const std::vector<Box> &boxes, std::map<uint32_t, TrackInfo> *tracks,
+                 std::vector<Fragment> *fragments) {
+    ASSERT_GE(boxes.size(), 2u);
+    ASSERT_EQ("ftyp", boxes[0].type);
+    ASSERT_GE(boxes[0].size, 4u);
+    EXPECT_EQ("cmfc", std::string((const char *)boxes[0].data, 4));
+    ASSERT_EQ("moov", boxes[1].type);
+    *tracks = parseMoov(boxes[1]);
+
+    // Then moof and mdat pairs.
+    ASSERT_EQ(0u, boxes.size() % 2);
+    for (size_t i = 2; i < boxes.size(); i += 2) {
+        ASSERT_EQ("moof", boxes[i].type);
+        ASSERT_EQ("mdat", boxes[i + 1].type);
+        Fragment fragment = parseMoof(boxes[i]);
+        EXPECT_EQ(fragment.dataSize, boxes[i + 1].size);
+        fragments->push_back(fragment);
+    }
+}
+
+// Checks that the fragments are numbered in order and that the fragments of
+// each track follow each other without gaps. Returns the number of samples
+// of each track.
+std::map<uint32_t, uint32_t> checkFragments(const std::vector<Fragment> &fragments) {
+    std::map<uint32_t, uint32_t> sampleCounts;
+    std::map<uint32_t, uint64_t> nextDecodeTimes;
+    uint32_t sequenceNumber = 0;
+    for (const Fragment &fragment : fragments) {
+        EXPECT_EQ(++sequenceNumber, fragment.sequenceNumber);
+        EXPECT_GT(fragment.sampleCount, 0u);
+        auto it = nextDecodeTimes.find(fragment.trackId);
+        if (it == nextDecodeTimes.end()) {
+            EXPECT_EQ(0u, fragment.baseDecodeTime) << "track " << fragment.trackId;
+        } else {
+            EXPECT_EQ(it->second, fragment.baseDecodeTime) << "track " << fragment.trackId;
+        }
+        nextDecodeTimes[fragment.trackId] = fragment.baseDecodeTime + fragment.duration;
+        sampleCounts[fragment.trackId] += fragment.sampleCount;
+    }
+    return sampleCounts;
+}
+
+class FragmentCollector : public MPEG4Writer::FragmentSink {
+  public:
+    void onFragment(const void *data, size_t size, bool isInitSegment) override {
+        const uint8_t *bytes = (const uint8_t *)data;
+        mFragments.emplace_back(std::vector<uint8_t>(bytes, bytes + size), isInitSegment);
+    }
+
+    std::vector<std::pair<std::vector<uint8_t>, bool>> mFragments;
+};
+
+}  // namespace
+
+// Records three seconds of audio and video in real time into a pipe, and
+// measures how long after its last sample is pushed each fragment comes out.
+TEST(MPEG4WriterFragmentTest, FragmentsStreamWhileRecording) {
+    int pipeFds[2];
+    ASSERT_EQ(0, pipe(pipeFds));
+    sp<MPEG4Writer> writer = new MPEG4Writer(pipeFds[1]);
+    close(pipeFds[1]);
+
+    sp<MediaAdapter> video = new MediaAdapter(makeVideoFormat());
+    sp<MediaAdapter> audio = new MediaAdapter(makeAudioFormat());
+    sp<MetaData> fileMeta = new MetaData;
+    fileMeta->setInt32(kKeyRealTimeRecording, false);
+    ASSERT_EQ(OK, writer->setFragmentedOutput(kFragmentDurationUs));
+    ASSERT_EQ(OK, writer->addSource(video));
+    ASSERT_EQ(OK, writer->addSource(audio));
+    ASSERT_EQ(OK, writer->start(fileMeta.get()));
+
+    // Reads the stream, noting when each box is complete.
+    std::vector<uint8_t> stream;
+    std::vector<Clock::time_point> boxTimes;
+    std::atomic<size_t> boxCount(0);
+    std::thread reader([&stream, &boxTimes, &boxCount, readFd = pipeFds[0]]() {
+        uint8_t buffer[16384];
+        size_t parsed = 0;
+        ssize_t n;
+        while ((n = read(readFd, buffer, sizeof(buffer))) > 0) {
+            stream.insert(stream.end(), buffer, buffer + n);
+            std::vector<Box> boxes;
+            size_t size = parseBoxes(stream.data() + parsed, stream.size() - parsed, &boxes);
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                boxTimes.push_back(Clock::now());
+            }
+            parsed += size;
+            boxCount = boxTimes.size();
+        }
+    });
+
+    const int32_t videoFrameCount = kRecordingDurationUs / kVideoFrameDurationUs;
+    const int32_t audioFrameCount = kRecordingDurationUs / kAudioFrameDurationUs;
+    std::vector<Clock::time_point> audioPushTimes;
+    std::thread audioThread([&audio, &audioPushTimes]() {
+        audioPushTimes = pushFrames(audio, kAudioFrameSize,
+                                    kRecordingDurationUs / kAudioFrameDurationUs,
+                                    kAudioFrameDurationUs, 1 /* syncInterval */, true);
+    });
+    std::vector<Clock::time_point> videoPushTimes = pushFrames(
+            video, kVideoFrameSize, videoFrameCount, kVideoFrameDurationUs,
+            kVideoSyncInterval, true /* paced */);
+    audioThread.join();
+    // The reader is still running, so its box count may lag behind.
+    const size_t boxesBeforeStop = boxCount;
+
+    video->stop();
+    audio->stop();
+    status_t err = writer->stop();
+    reader.join();
+    close(pipeFds[0]);
+    ASSERT_EQ(OK, err);
+
+    std::vector<Box> boxes;
+    ASSERT_EQ(stream.size(), parseBoxes(stream.data(), stream.size(), &boxes));
+    ASSERT_EQ(boxes.size(), boxTimes.size());
+    std::map<uint32_t, TrackInfo> tracks;
+    std::vector<Fragment> fragments;
+    ASSERT_NO_FATAL_FAILURE(parseStream(boxes, &tracks, &fragments));
+    ASSERT_EQ(2u, tracks.size());
+
+    std::map<uint32_t, uint32_t> sampleCounts = checkFragments(fragments);
+    std::map<uint32_t, const std::vector<Clock::time_point> *> pushTimes;
+    for (const auto &track : tracks) {
+        if (track.second.handlerType == "vide") {
+            EXPECT_EQ((uint32_t)videoFrameCount, sampleCounts[track.first]);
+            pushTimes[track.first] = &videoPushTimes;
+        } else {
+            EXPECT_EQ("soun", track.second.handlerType);
+            EXPECT_EQ((uint32_t)audioFrameCount, sampleCounts[track.first]);
+            pushTimes[track.first] = &audioPushTimes;
+        }
+    }
+
+    // All but the last fragment of each track are out before the recording
+    // stops, give or take the one the reader has not finished yet.
+    const size_t fragmentsPerTrack = kRecordingDurationUs / kFragmentDurationUs;
+    EXPECT_GE(boxesBeforeStop, 2 + 2 * 2 * (fragmentsPerTrack - 2));
+
+    // A fragment is cut when the first sample past it arrives, so it should
+    // come out about a frame after its last sample.
+    std::map<uint32_t, uint32_t> samplesSeen;
+    int64_t maxLatencyUs = 0;
+    int64_t totalLatencyUs = 0;
+    for (size_t i = 0; i < fragments.size(); ++i) {
+        const Fragment &fragment = fragments[i];
+        uint32_t &seen = samplesSeen[fragment.trackId];
+        seen += fragment.sampleCount;
+        if (pushTimes[fragment.trackId]->size() < seen) {
+            continue;
+        }
+        // The mdat box completes the fragment.
+        const Clock::time_point arrival = boxTimes[2 + 2 * i + 1];
+        const int64_t latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                arrival - (*pushTimes[fragment.trackId])[seen - 1]).count();
+        maxLatencyUs = std::max(maxLatencyUs, latencyUs);
+        totalLatencyUs += latencyUs;
+    }
+    ASSERT_FALSE(fragments.empty());
+    const int64_t averageLatencyUs = totalLatencyUs / (int64_t)fragments.size();
+    ALOGI("%zu fragments, latency average %" PRId64 " us, max %" PRId64 " us",
+          fragments.size(), averageLatencyUs, maxLatencyUs);
+    RecordProperty("averageFragmentLatencyUs", std::to_string(averageLatencyUs));
+    RecordProperty("maxFragmentLatencyUs", std::to_string(maxLatencyUs));
+    EXPECT_LT(maxLatencyUs, kFragmentDurationUs);
+}
+
+TEST(MPEG4WriterFragmentTest, FragmentSink) {
+    int fd = open(kOutputFile, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    ASSERT_GE(fd, 0);
+    sp<MPEG4Writer> writer = new MPEG4Writer(fd);
+    sp<FragmentCollector> collector = new FragmentCollector;
+    EXPECT_EQ(BAD_VALUE, writer->setFragmentedOutput(0, collector));
+    ASSERT_EQ(OK, writer->setFragmentedOutput(kFragmentDurationUs, collector));
+
+    sp<MediaAdapter> video = new MediaAdapter(makeVideoFormat());
+    sp<MetaData> fileMeta = new MetaData;
+    fileMeta->setInt32(kKeyRealTimeRecording, false);
+    ASSERT_EQ(OK, writer->addSource(video));
+    ASSERT_EQ(OK, writer->start(fileMeta.get()));
+    EXPECT_EQ(INVALID_OPERATION, writer->setFragmentedOutput(kFragmentDurationUs, collector));
+
+    const int32_t videoFrameCount = kRecordingDurationUs / kVideoFrameDurationUs;
+    pushFrames(video, kVideoFrameSize, videoFrameCount, kVideoFrameDurationUs,
+               kVideoSyncInterval, false /* paced */);
+    video->stop();
+    ASSERT_EQ(OK, writer->stop());
+
+    // Nothing goes to the file.
+    EXPECT_EQ(0, lseek(fd, 0, SEEK_END));
+    close(fd);
+    unlink(kOutputFile);
+
+    // The init segment first, then one fragment per call.
+    ASSERT_GE(collector->mFragments.size(), 2u);
+    std::vector<uint8_t> stream;
+    for (size_t i = 0; i < collector->mFragments.size(); ++i) {
+        const std::vector<uint8_t> &data = collector->mFragments[i].first;
+        EXPECT_EQ(i == 0, collector->mFragments[i].second);
+        std::vector<Box> boxes;
+        EXPECT_EQ(data.size(), parseBoxes(data.data(), data.size(), &boxes));
+        ASSERT_EQ(2u, boxes.size());
+        EXPECT_EQ(i == 0 ? "ftyp" : "moof", boxes[0].type);
+        stream.insert(stream.end(), data.begin(), data.end());
+    }
+
+    std::vector<Box> boxes;
+    ASSERT_EQ(stream.size(), parseBoxes(stream.data(), stream.size(), &boxes));
+    std::map<uint32_t, TrackInfo> tracks;
+    std::vector<Fragment> fragments;
+    ASSERT_NO_FATAL_FAILURE(parseStream(boxes, &tracks, &fragments));
+    ASSERT_EQ(1u, tracks.size());
+    const uint32_t trackId = tracks.begin()->first;
+    EXPECT_EQ((uint32_t)videoFrameCount, checkFragments(fragments)[trackId]);
+
+    // Each fragment but the last holds at least kFragmentDurationUs, and less
+    // than a frame more.
+    const uint64_t timeScale = tracks.begin()->second.timeScale;
+    const uint64_t fragmentDuration = kFragmentDurationUs * timeScale / 1000000;
+    const uint64_t frameDuration = kVideoFrameDurationUs * timeScale / 1000000;
+    for (size_t i = 0; i + 1 < fragments.size(); ++i) {
+        EXPECT_GE(fragments[i].duration, fragmentDuration);
+        EXPECT_LT(fragments[i].duration, fragmentDuration + frameDuration);
+    }
+}
@@ -80,11 +80,6 @@ private:
     unsigned mPATContinuityCounter;
     unsigned mPMTContinuityCounter;
 
-    uint32_t mCrcTable[256];
-
-    void initCrcTable();
-    uint32_t crc32(const uint8_t *start, size_t size) const;
-
     DISALLOW_EVIL_CONSTRUCTORS(TSPacketizer);
 };
 
@@ -17,6 +17,7 @@
 #define LOG_TAG "BufferPoolClient"
 //#define LOG_NDEBUG 0
 
+#include <atomic>
 #include <thread>
 #include <utils/Log.h>
 #include "BufferPoolClient.h"
@@ -34,6 +35,12 @@ static constexpr int kPostMaxRetry = 3;
 static constexpr int kCacheTtlUs = 1000000; // TODO: tune
 static constexpr size_t kMaxCachedBufferCount = 64;
 static constexpr size_t kCachedBufferCountTarget = kMaxCachedBufferCount - 16;
+// Buffers released by the client which allocated them are kept in a local
+// free list, and handed out again by allocate() without going through the
+// accessor. Unused ones are returned to the accessor in batches.
+static constexpr size_t kFreeListSize = 32; // must be a power of two
+static constexpr int64_t kFreeListTtlUs = 500000; // 500ms
+static constexpr int64_t kFreeListSyncUs = 100000; // 100ms
 
 class BufferPoolClient::Impl
         : public std::enable_shared_from_this<BufferPoolClient::Impl> {
@@ -89,6 +96,12 @@ private:
 
     void trySyncFromRemote();
 
+    bool fetchFreeBuffer(
+            const std::vector<uint8_t> &params, native_handle_t **handle,
+            std::shared_ptr<BufferPoolData> *buffer);
+
+    void syncFreeList(int64_t now, bool clearAll);
+
     bool syncReleased(uint32_t msgId = 0);
 
     void evictCaches(bool clearCache = false);
@@ -108,6 +121,10 @@ private:
     struct BlockPoolDataDtor;
     struct ClientBuffer;
 
+    // Puts a released buffer to the free list. Returns false if it has to be
+    // released to the accessor instead.
+    bool recycleBuffer(ClientBuffer *buffer);
+
     bool mLocal;
     bool mValid;
     sp<IAccessor> mAccessor;
@@ -157,6 +174,31 @@ private:
         ReleaseCache() : mInvalidateId(0), mInvalidateAck(true) {}
     } mReleasing;
 
+    // Bounded lock-free MPMC queue of buffers allocated by this client and
+    // released since, in release order. Buffers in the queue still count as
+    // active in mCache, and as used by this client in the accessor.
+    struct FreeList {
+        struct Cell {
+            std::atomic<size_t> mSeq;
+            ClientBuffer *mBuffer;
+            int64_t mReleasedUs;
+        };
+        Cell mCells[kFreeListSize];
+        std::atomic<size_t> mPushPos;
+        std::atomic<size_t> mPopPos;
+        std::atomic<int64_t> mNextSyncUs;
+
+        FreeList() : mPushPos(0), mPopPos(0), mNextSyncUs(getTimestampNow() + kFreeListSyncUs) {
+            for (size_t i = 0; i < kFreeListSize; ++i) {
+                mCells[i].mSeq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool push(ClientBuffer *buffer, int64_t releasedUs);
+
+        bool pop(ClientBuffer **buffer, int64_t *releasedUs);
+    } mFreeList;
+
     // This lock is held during synchronization from remote side.
     // In order to minimize remote calls and locking durtaion, this lock is held
     // by best effort approach using try_lock().
@@ -164,8 +206,9 @@ private:
 };
 
 struct BufferPoolClient::Impl::BlockPoolDataDtor {
-    BlockPoolDataDtor(const std::shared_ptr<BufferPoolClient::Impl> &impl)
-            : mImpl(impl) {}
+    BlockPoolDataDtor(const std::shared_ptr<BufferPoolClient::Impl> &impl,
+                      ClientBuffer *recyclable = nullptr)
+            : mImpl(impl), mRecyclable(recyclable) {}
 
     void operator()(BufferPoolData *buffer) {
         BufferId id = buffer->mId;
@@ -173,10 +216,15 @@ struct BufferPoolClient::Impl::BlockPoolDataDtor {
 
         auto impl = mImpl.lock();
         if (impl && impl->isValid()) {
-            impl->postBufferRelease(id);
+            if (!mRecyclable || !impl->recycleBuffer(mRecyclable)) {
+                impl->postBufferRelease(id);
+            }
         }
     }
     const std::weak_ptr<BufferPoolClient::Impl> mImpl;
+    // Set for buffers allocated by this client. It stays in mCache as long as
+    // the buffer is in use or in the free list.
+    ClientBuffer *const mRecyclable;
 };
 
 struct BufferPoolClient::Impl::ClientBuffer {
@@ -187,6 +235,9 @@ private:
     BufferId mId;
     native_handle_t *mHandle;
     std::weak_ptr<BufferPoolData> mCache;
+    // Allocation parameters, for buffers allocated by this client.
+    std::vector<uint8_t> mParams;
+    std::atomic<bool> mSent;
 
     void updateExpire() {
         mExpireUs = getTimestampNow() + kCacheTtlUs;
@@ -196,7 +247,7 @@ public:
     ClientBuffer(
             ConnectionId connectionId, BufferId id, native_handle_t *handle)
             : mHasCache(false), mConnectionId(connectionId),
-              mId(id), mHandle(handle) {
+              mId(id), mHandle(handle), mSent(false) {
         mExpireUs = getTimestampNow() + kCacheTtlUs;
     }
 
@@ -254,6 +305,69 @@ public:
         return nullptr;
     }
 
+    /**
+     * Creates the cache of a buffer allocated by this client, which is put to
+     * the free list instead of being released if it was never sent.
+     */
+    std::shared_ptr<BufferPoolData> createRecyclableCache(
+            const std::shared_ptr<BufferPoolClient::Impl> &impl,
+            const std::vector<uint8_t> &params,
+            native_handle_t **pHandle) {
+        if (!mHasCache) {
+            BufferPoolData *ptr = new BufferPoolData(mConnectionId, mId);
+            if (ptr) {
+                std::shared_ptr<BufferPoolData> cache(ptr, BlockPoolDataDtor(impl, this));
+                if (cache) {
+                    mCache = cache;
+                    mHasCache = true;
+                    mParams = params;
+                    mSent = false;
+                    *pHandle = mHandle;
+                    return cache;
+                }
+            }
+            if (ptr) {
+                delete ptr;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Hands out a buffer from the free list again. The cache stays active
+     * while the buffer is in the free list, and since it was never sent, no
+     * transaction can look the buffer up concurrently.
+     */
+    std::shared_ptr<BufferPoolData> recycleCache(
+            const std::shared_ptr<BufferPoolClient::Impl> &impl,
+            native_handle_t **pHandle) {
+        BufferPoolData *ptr = new BufferPoolData(mConnectionId, mId);
+        if (ptr) {
+            std::shared_ptr<BufferPoolData> cache(ptr, BlockPoolDataDtor(impl, this));
+            if (cache) {
+                mCache = cache;
+                *pHandle = mHandle;
+                return cache;
+            }
+            delete ptr;
+        }
+        return nullptr;
+    }
+
+    bool compatible(const std::vector<uint8_t> &params) const {
+        return mParams == params;
+    }
+
+    // Buffers sent to a receiver are not recycled, since the receiver may
+    // still use them after this client released them.
+    bool sent() const {
+        return mSent;
+    }
+
+    void onSend() {
+        mSent = true;
+    }
+
     bool onCacheRelease() {
         if (mHasCache) {
             // TODO: verify mCache is not valid;
@@ -321,6 +435,7 @@ BufferPoolClient::Impl::Impl(const sp<IAccessor> &accessor, const sp<IObserver>
 
 bool BufferPoolClient::Impl::isActive(int64_t *lastTransactionUs, bool clearCache) {
     bool active = false;
+    syncFreeList(getTimestampNow(), clearCache);
     {
         std::lock_guard<std::mutex> lock(mCache.mLock);
         syncReleased();
@@ -345,6 +460,7 @@ ResultStatus BufferPoolClient::Impl::flush() {
     if (!mLocal || !mLocalConnection || !mValid) {
         return ResultStatus::CRITICAL_ERROR;
     }
+    syncFreeList(getTimestampNow(), true);
     {
         std::unique_lock<std::mutex> lock(mCache.mLock);
         syncReleased();
@@ -363,6 +479,9 @@ ResultStatus BufferPoolClient::Impl::allocate(
     BufferId bufferId;
     native_handle_t *handle = nullptr;
     buffer->reset();
+    if (fetchFreeBuffer(params, pHandle, buffer)) {
+        return ResultStatus::OK;
+    }
     ResultStatus status = allocateBufferHandle(params, &bufferId, &handle);
     if (status == ResultStatus::OK) {
         if (handle) {
@@ -380,8 +499,8 @@ ResultStatus BufferPoolClient::Impl::allocate(
                 auto result = mCache.mBuffers.insert(std::make_pair(
                         bufferId, std::move(clientBuffer)));
                 if (result.second) {
-                    *buffer = result.first->second->createCache(
-                            shared_from_this(), pHandle);
+                    *buffer = result.first->second->createRecyclableCache(
+                            shared_from_this(), params, pHandle);
                     if (*buffer) {
                         mCache.incActive_l();
                     }
@@ -510,6 +629,10 @@ bool BufferPoolClient::Impl::postSend(
         // TODO: don't need to call syncReleased every time
         std::lock_guard<std::mutex> lock(mCache.mLock);
         syncReleased();
+        auto cacheIt = mCache.mBuffers.find(bufferId);
+        if (cacheIt != mCache.mBuffers.end()) {
+            cacheIt->second->onSend();
+        }
     }
     bool ret = false;
     bool needsSync = false;
@@ -597,6 +720,116 @@ void BufferPoolClient::Impl::trySyncFromRemote() {
     }
 }
 
+bool BufferPoolClient::Impl::FreeList::push(ClientBuffer *buffer, int64_t releasedUs) {
+    size_t pos = mPushPos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell = &mCells[pos & (kFreeListSize - 1)];
+        size_t seq = cell->mSeq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (mPushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // full
+        } else {
+            pos = mPushPos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->mBuffer = buffer;
+    cell->mReleasedUs = releasedUs;
+    cell->mSeq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool BufferPoolClient::Impl::FreeList::pop(ClientBuffer **buffer, int64_t *releasedUs) {
+    size_t pos = mPopPos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell = &mCells[pos & (kFreeListSize - 1)];
+        size_t seq = cell->mSeq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (mPopPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // empty
+        } else {
+            pos = mPopPos.load(std::memory_order_relaxed);
+        }
+    }
+    *buffer = cell->mBuffer;
+    *releasedUs = cell->mReleasedUs;
+    cell->mSeq.store(pos + kFreeListSize, std::memory_order_release);
+    return true;
+}
+
+bool BufferPoolClient::Impl::recycleBuffer(ClientBuffer *buffer) {
+    if (buffer->sent()) {
+        return false;
+    }
+    return mFreeList.push(buffer, getTimestampNow());
+}
+
+bool BufferPoolClient::Impl::fetchFreeBuffer(
+        const std::vector<uint8_t> &params, native_handle_t **pHandle,
+        std::shared_ptr<BufferPoolData> *buffer) {
+    int64_t now = getTimestampNow();
+    int64_t nextSyncUs = mFreeList.mNextSyncUs.load(std::memory_order_relaxed);
+    if (now >= nextSyncUs && mFreeList.mNextSyncUs.compare_exchange_strong(
+            nextSyncUs, now + kFreeListSyncUs, std::memory_order_relaxed)) {
+        syncFreeList(now, false);
+        // Best effort, as allocate() would otherwise do it every time.
+        std::unique_lock<std::mutex> lock(mCache.mLock, std::try_to_lock);
+        if (lock.owns_lock()) {
+            syncReleased();
+            evictCaches();
+        }
+    }
+    ClientBuffer *clientBuffer;
+    int64_t releasedUs;
+    while (mFreeList.pop(&clientBuffer, &releasedUs)) {
+        if (clientBuffer->compatible(params)) {
+            *buffer = clientBuffer->recycleCache(shared_from_this(), pHandle);
+            if (*buffer) {
+                ALOGV("client allocate from free list %lld : %u",
+                      (long long)mConnectionId, clientBuffer->id());
+                return true;
+            }
+        }
+        // Let the accessor decide whether the buffer can be used for params.
+        postBufferRelease(clientBuffer->id());
+    }
+    return false;
+}
+
+// Returns the buffers which stayed in the free list for kFreeListTtlUs, or all
+// of them if clearAll is set, to the accessor at once.
+void BufferPoolClient::Impl::syncFreeList(int64_t now, bool clearAll) {
+    std::list<BufferId> released;
+    ClientBuffer *buffer;
+    int64_t releasedUs;
+    for (size_t i = 0; i < kFreeListSize && mFreeList.pop(&buffer, &releasedUs); ++i) {
+        if (!clearAll && now < releasedUs + kFreeListTtlUs) {
+            // The remaining ones were released later.
+            if (mFreeList.push(buffer, releasedUs)) {
+                break;
+            }
+        }
+        released.push_back(buffer->id());
+    }
+    if (released.size() > 0) {
+        ALOGV("client %lld releases %zu buffers from free list",
+              (long long)mConnectionId, released.size());
+        std::lock_guard<std::mutex> lock(mReleasing.mLock);
+        mReleasing.mReleasingIds.splice(mReleasing.mReleasingIds.end(), released);
+        mReleasing.mStatusChannel->postBufferRelease(
+                mConnectionId, mReleasing.mReleasingIds, mReleasing.mReleasedIds);
+    }
+}
+
 // should have mCache.mLock
 bool BufferPoolClient::Impl::syncReleased(uint32_t messageId) {
     bool cleared = false;
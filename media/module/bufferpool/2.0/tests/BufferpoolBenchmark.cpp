@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures allocations per second from buffer pools, with one client per
+// benchmark thread as with concurrent codecs. Buffers released by a client are
+// recycled from its local free list, so allocate() only goes to the accessor
+// when a new buffer is needed.
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <bufferpool/ClientManager.h>
+#include "allocator.h"
+
+using android::hardware::media::bufferpool::BufferPoolData;
+using android::hardware::media::bufferpool::V2_0::ResultStatus;
+using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
+using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
+
+namespace {
+
+// Holds a connection to a new buffer pool for the calling benchmark thread.
+class PoolConnection {
+  public:
+    PoolConnection() : mManager(ClientManager::getInstance()), mValid(false) {
+        mAllocator = std::make_shared<TestBufferPoolAllocator>();
+        mValid = mManager && mManager->create(mAllocator, &mConnectionId) == ResultStatus::OK;
+        getTestAllocatorParams(&mParams);
+    }
+
+    ~PoolConnection() {
+        if (mValid) {
+            mManager->close(mConnectionId);
+        }
+    }
+
+    bool isValid() const { return mValid; }
+
+    bool allocate(std::shared_ptr<BufferPoolData>* buffer) {
+        native_handle_t* handle = nullptr;
+        if (mManager->allocate(mConnectionId, mParams, &handle, buffer) != ResultStatus::OK) {
+            return false;
+        }
+        if (handle) {
+            native_handle_close(handle);
+            native_handle_delete(handle);
+        }
+        return true;
+    }
+
+  private:
+    android::sp<ClientManager> mManager;
+    std::shared_ptr<BufferPoolAllocator> mAllocator;
+    std::vector<uint8_t> mParams;
+    ConnectionId mConnectionId;
+    bool mValid;
+};
+
+// Allocates a buffer and releases it right away.
+static void BM_AllocateRelease(benchmark::State& state) {
+    PoolConnection connection;
+    if (!connection.isValid()) {
+        state.SkipWithError("cannot create buffer pool");
+        return;
+    }
+    for (auto _ : state) {
+        std::shared_ptr<BufferPoolData> buffer;
+        if (!connection.allocate(&buffer)) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+        benchmark::DoNotOptimize(buffer);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Keeps |state.range(0)| buffers in flight, releasing the oldest one after
+// each allocation, as a codec cycling through its output buffers does.
+static void BM_AllocateInFlight(benchmark::State& state) {
+    const size_t inFlight = state.range(0);
+    PoolConnection connection;
+    if (!connection.isValid()) {
+        state.SkipWithError("cannot create buffer pool");
+        return;
+    }
+    std::deque<std::shared_ptr<BufferPoolData>> buffers;
+    for (auto _ : state) {
+        std::shared_ptr<BufferPoolData> buffer;
+        if (!connection.allocate(&buffer)) {
+            state.SkipWithError("allocation failed");
+            break;
+        }
+        buffers.push_back(std::move(buffer));
+        if (buffers.size() > inFlight) {
+            buffers.pop_front();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_AllocateRelease)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_AllocateInFlight)->Arg(8)->Arg(32)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
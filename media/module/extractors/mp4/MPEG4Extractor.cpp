@@ -26,10 +26,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <android-base/properties.h>
 #include <utils/Log.h>
 
 #include "AC4Parser.h"
 #include "MPEG4Extractor.h"
+#include "SampleReadAheadCache.h"
 #include "SampleTable.h"
 #include "ItemTable.h"
 
@@ -95,7 +97,8 @@ public:
                 off64_t firstMoofOffset,
                 const sp<ItemTable> &itemTable,
                 uint64_t elstShiftStartTicks,
-                uint64_t elstInitialEmptyEditTicks);
+                uint64_t elstInitialEmptyEditTicks,
+                const sp<SampleReadAheadCache> &readAheadCache);
     virtual status_t init();
 
     virtual media_status_t start();
@@ -174,7 +177,11 @@ private:
      */
     uint64_t mElstInitialEmptyEditTicks;
 
+    sp<SampleReadAheadCache> mReadAheadCache;
+    int32_t mReadAheadTrackId;
+
     size_t parseNALSize(const uint8_t *data) const;
+    ssize_t readSampleData(off64_t offset, void *data, size_t size);
     status_t parseChunk(off64_t *offset);
     status_t parseTrackFragmentHeader(off64_t offset, off64_t size);
     status_t parseTrackFragmentRun(off64_t offset, off64_t size);
@@ -479,6 +486,14 @@ media_status_t MPEG4Extractor::getMetaData(AMediaFormat *meta) {
         return AMEDIA_ERROR_UNKNOWN;
     }
     AMediaFormat_copy(meta, mFileMetaData);
+    if (mReadAheadCache != NULL) {
+        // private keys, only reported through the extractor metrics.
+        int64_t hits, misses, bytesRead;
+        mReadAheadCache->getStats(&hits, &misses, &bytesRead);
+        AMediaFormat_setInt64(meta, "android._read-ahead-hits", hits);
+        AMediaFormat_setInt64(meta, "android._read-ahead-misses", misses);
+        AMediaFormat_setInt64(meta, "android._read-ahead-bytes", bytesRead);
+    }
     return AMEDIA_OK;
 }
 
@@ -4579,10 +4594,27 @@ MediaTrackHelper *MPEG4Extractor::getTrack(size_t index) {
     ALOGV("elst_initial_empty_edit_ticks in MediaTimeScale :%" PRIu64,
           elst_initial_empty_edit_ticks);
 
+    // Samples located by the sample table can be read ahead across tracks,
+    // which pays off for sources that are slow to seek. For local files the
+    // extra copy is not known to pay off, so it is only enabled by property.
+    sp<SampleReadAheadCache> readAheadCache;
+    const uint32_t sourceFlags = mDataSource->flags();
+    if (mMoofOffset == 0 && itemTable == NULL && track->sampleTable != NULL
+            && ((sourceFlags & (DataSourceBase::kWantsPrefetching
+                    | DataSourceBase::kIsCachingDataSource))
+                || ((sourceFlags & DataSourceBase::kIsLocalFileSource)
+                    && android::base::GetBoolProperty("media.mp4.local_read_ahead", false)))) {
+        if (mReadAheadCache == NULL) {
+            mReadAheadCache = new SampleReadAheadCache(mDataSource);
+        }
+        readAheadCache = mReadAheadCache;
+    }
+
     MPEG4Source* source =
             new MPEG4Source(track->meta, mDataSource, track->timescale, track->sampleTable,
                             mSidxEntries, trex, mMoofOffset, itemTable,
-                            track->elst_shift_start_ticks, elst_initial_empty_edit_ticks);
+                            track->elst_shift_start_ticks, elst_initial_empty_edit_ticks,
+                            readAheadCache);
     if (source->init() != OK) {
         delete source;
         return NULL;
@@ -5086,7 +5118,8 @@ MPEG4Source::MPEG4Source(
         off64_t firstMoofOffset,
         const sp<ItemTable> &itemTable,
         uint64_t elstShiftStartTicks,
-        uint64_t elstInitialEmptyEditTicks)
+        uint64_t elstInitialEmptyEditTicks,
+        const sp<SampleReadAheadCache> &readAheadCache)
     : mFormat(format),
       mDataSource(dataSource),
       mTimescale(timeScale),
@@ -5118,7 +5151,9 @@ MPEG4Source::MPEG4Source(
       mSrcBuffer(NULL),
       mItemTable(itemTable),
       mElstShiftStartTicks(elstShiftStartTicks),
-      mElstInitialEmptyEditTicks(elstInitialEmptyEditTicks) {
+      mElstInitialEmptyEditTicks(elstInitialEmptyEditTicks),
+      mReadAheadCache(readAheadCache),
+      mReadAheadTrackId(-1) {
 
     memset(&mTrackFragmentHeaderInfo, 0, sizeof(mTrackFragmentHeaderInfo));
 
@@ -5285,6 +5320,10 @@ media_status_t MPEG4Source::start() {
     }
     mSrcBufferSize = max_size;
 
+    if (mReadAheadCache != NULL) {
+        mReadAheadTrackId = mReadAheadCache->addTrack(mSampleTable);
+    }
+
     mStarted = true;
 
     return AMEDIA_OK;
@@ -5304,6 +5343,11 @@ media_status_t MPEG4Source::stop() {
     delete[] mSrcBuffer;
     mSrcBuffer = NULL;
 
+    if (mReadAheadCache != NULL) {
+        mReadAheadCache->removeTrack(mReadAheadTrackId);
+        mReadAheadTrackId = -1;
+    }
+
     mStarted = false;
     mCurrentSampleIndex = 0;
 
@@ -6093,6 +6137,14 @@ size_t MPEG4Source::parseNALSize(const uint8_t *data) const {
     return 0;
 }
 
+ssize_t MPEG4Source::readSampleData(off64_t offset, void *data, size_t size) {
+    if (mReadAheadCache != NULL) {
+        return mReadAheadCache->readAt(
+                mReadAheadTrackId, mCurrentSampleIndex, offset, data, size);
+    }
+    return mDataSource->readAt(offset, data, size);
+}
+
 int32_t MPEG4Source::parseHEVCLayerId(const uint8_t *data, size_t size) {
     if (data == nullptr || size < mNALLengthSize + 2) {
         return -1;
@@ -6381,7 +6433,7 @@ media_status_t MPEG4Source::read(
                     return AMEDIA_ERROR_UNKNOWN;
                 }
                 uint8_t* buf = (uint8_t *)mBuffer->data();
-                ssize_t bytesRead = mDataSource->readAt(offset, buf, totalSize);
+                ssize_t bytesRead = readSampleData(offset, buf, totalSize);
                 if (bytesRead < (ssize_t)totalSize) {
                     mBuffer->release();
                     mBuffer = NULL;
@@ -6412,7 +6464,7 @@ media_status_t MPEG4Source::read(
                 mBuffer->set_range(0, totalSize);
             } else {
                 ssize_t num_bytes_read =
-                    mDataSource->readAt(offset, (uint8_t *)mBuffer->data(), size);
+                    readSampleData(offset, (uint8_t *)mBuffer->data(), size);
 
                 if (num_bytes_read < (ssize_t)size) {
                     mBuffer->release();
@@ -6482,7 +6534,7 @@ media_status_t MPEG4Source::read(
         dstData[dstOffset++] = (uint8_t)((size >> 8) & 0xFF);
         dstData[dstOffset++] = (uint8_t)((size >> 0) & 0xFF);
 
-        ssize_t numBytesRead = mDataSource->readAt(offset, dstData + dstOffset, size);
+        ssize_t numBytesRead = readSampleData(offset, dstData + dstOffset, size);
         if (numBytesRead != (ssize_t)size) {
             mBuffer->release();
             mBuffer = NULL;
@@ -6529,7 +6581,7 @@ media_status_t MPEG4Source::read(
         ssize_t num_bytes_read = 0;
         bool mSrcBufferFitsDataToRead = size <= mSrcBufferSize;
         if (mSrcBufferFitsDataToRead) {
-          num_bytes_read = mDataSource->readAt(offset, mSrcBuffer, size);
+          num_bytes_read = readSampleData(offset, mSrcBuffer, size);
         } else {
           // We are trying to read a sample larger than the expected max sample size.
           // Fall through and let the failure be handled by the following if.
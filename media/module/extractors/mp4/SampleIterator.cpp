@@ -48,6 +48,7 @@ void SampleIterator::reset() {
     mStopChunkSampleIndex = 0;
     mSamplesPerChunk = 0;
     mChunkDesc = 0;
+    mChunkLoaded = false;
 }
 
 status_t SampleIterator::seekTo(uint32_t sampleIndex) {
@@ -69,12 +70,90 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
         return OK;
     }
 
-    if (!mInitialized || sampleIndex < mFirstChunkSampleIndex) {
+    status_t err;
+    if ((err = seekToChunk(sampleIndex)) != OK) {
+        return err;
+    }
+
+    uint32_t chunkRelativeSampleIndex =
+        (sampleIndex - mFirstChunkSampleIndex) % mSamplesPerChunk;
+
+    mCurrentSampleOffset = mCurrentChunkOffset;
+    for (uint32_t i = 0; i < chunkRelativeSampleIndex; ++i) {
+        mCurrentSampleOffset += mCurrentChunkSampleSizes[i];
+    }
+
+    mCurrentSampleSize = mCurrentChunkSampleSizes[chunkRelativeSampleIndex];
+    if (sampleIndex < mTTSSampleIndex) {
+        mTimeToSampleIndex = 0;
+        mTTSSampleIndex = 0;
+        mTTSSampleTime = 0;
+        mTTSCount = 0;
+        mTTSDuration = 0;
+    }
+
+    if ((err = findSampleTimeAndDuration(
+            sampleIndex, &mCurrentSampleTime, &mCurrentSampleDuration)) != OK) {
+        ALOGE("findSampleTime return error");
+        return err;
+    }
+
+    mCurrentSampleIndex = sampleIndex;
+
+    mInitialized = true;
+
+    return OK;
+}
+
+status_t SampleIterator::getChunkRange(
+        uint32_t sampleIndex, off64_t *offset, size_t *size,
+        uint32_t *nextChunkSampleIndex) {
+    if (sampleIndex >= mTable->mNumSampleSizes) {
+        return ERROR_END_OF_STREAM;
+    }
+
+    if (mTable->mSampleToChunkOffset < 0
+            || mTable->mChunkOffsetOffset < 0
+            || mTable->mSampleSizeOffset < 0) {
+        return ERROR_MALFORMED;
+    }
+
+    status_t err;
+    if ((err = seekToChunk(sampleIndex)) != OK) {
+        return err;
+    }
+
+    uint32_t chunkRelativeSampleIndex =
+        (sampleIndex - mFirstChunkSampleIndex) % mSamplesPerChunk;
+
+    off64_t sampleOffset = mCurrentChunkOffset;
+    for (uint32_t i = 0; i < chunkRelativeSampleIndex; ++i) {
+        sampleOffset += mCurrentChunkSampleSizes[i];
+    }
+
+    uint64_t remaining = 0;
+    for (size_t i = chunkRelativeSampleIndex; i < mCurrentChunkSampleSizes.size(); ++i) {
+        remaining += mCurrentChunkSampleSizes[i];
+    }
+    if (remaining > SIZE_MAX) {
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    *offset = sampleOffset;
+    *size = remaining;
+    *nextChunkSampleIndex =
+        sampleIndex - chunkRelativeSampleIndex + mCurrentChunkSampleSizes.size();
+
+    return OK;
+}
+
+status_t SampleIterator::seekToChunk(uint32_t sampleIndex) {
+    if (!mChunkLoaded || sampleIndex < mFirstChunkSampleIndex) {
         reset();
     }
 
+    status_t err;
     if (sampleIndex >= mStopChunkSampleIndex) {
-        status_t err;
         if ((err = findChunkRange(sampleIndex)) != OK) {
             ALOGE("findChunkRange failed");
             return err;
@@ -92,8 +171,9 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
         (sampleIndex - mFirstChunkSampleIndex) / mSamplesPerChunk
         + mFirstChunk;
 
-    if (!mInitialized || chunk != mCurrentChunkIndex) {
-        status_t err;
+    if (!mChunkLoaded || chunk != mCurrentChunkIndex) {
+        mChunkLoaded = false;
+
         if ((err = getChunkOffset(chunk, &mCurrentChunkOffset)) != OK) {
             ALOGE("getChunkOffset return error");
             return err;
@@ -125,36 +205,9 @@ status_t SampleIterator::seekTo(uint32_t sampleIndex) {
         }
 
         mCurrentChunkIndex = chunk;
+        mChunkLoaded = true;
     }
 
-    uint32_t chunkRelativeSampleIndex =
-        (sampleIndex - mFirstChunkSampleIndex) % mSamplesPerChunk;
-
-    mCurrentSampleOffset = mCurrentChunkOffset;
-    for (uint32_t i = 0; i < chunkRelativeSampleIndex; ++i) {
-        mCurrentSampleOffset += mCurrentChunkSampleSizes[i];
-    }
-
-    mCurrentSampleSize = mCurrentChunkSampleSizes[chunkRelativeSampleIndex];
-    if (sampleIndex < mTTSSampleIndex) {
-        mTimeToSampleIndex = 0;
-        mTTSSampleIndex = 0;
-        mTTSSampleTime = 0;
-        mTTSCount = 0;
-        mTTSDuration = 0;
-    }
-
-    status_t err;
-    if ((err = findSampleTimeAndDuration(
-            sampleIndex, &mCurrentSampleTime, &mCurrentSampleDuration)) != OK) {
-        ALOGE("findSampleTime return error");
-        return err;
-    }
-
-    mCurrentSampleIndex = sampleIndex;
-
-    mInitialized = true;
-
     return OK;
 }
 
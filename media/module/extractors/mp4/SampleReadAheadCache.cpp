@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SampleReadAheadCache"
+#include <utils/Log.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <new>
+
+#include "SampleReadAheadCache.h"
+#include "SampleTable.h"
+
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/MediaErrors.h>
+
+namespace android {
+
+namespace {
+
+// Reads are aligned to pages of this size.
+const off64_t kPageSize = 4096;
+// Predicted ranges at most this far apart are fetched in the same read.
+const off64_t kMaxGap = 32 * 1024;
+// The largest single read.
+const off64_t kMaxReadSize = 1024 * 1024;
+// Samples larger than this are read directly, as there is little to gain.
+const size_t kMaxSampleSize = 256 * 1024;
+// How far ahead to predict for each track, in bytes and in chunks.
+const off64_t kTrackReadAheadSize = 512 * 1024;
+const int kMaxChunksPerTrack = 16;
+// The cached ranges are dropped, oldest first, beyond this size.
+const size_t kMaxCacheSize = 4 * 1024 * 1024;
+// Keeps the offset arithmetic below clear of overflows.
+const off64_t kMaxOffset = INT64_MAX / 2;
+
+}  // namespace
+
+SampleReadAheadCache::SampleReadAheadCache(DataSourceHelper *source)
+    : mSource(source),
+      mSourceSize(-1),
+      mNextTrackId(0),
+      mCachedBytes(0),
+      mHits(0),
+      mMisses(0),
+      mBytesRead(0) {
+    if (mSource->getSize(&mSourceSize) != OK) {
+        mSourceSize = -1;
+    }
+}
+
+SampleReadAheadCache::~SampleReadAheadCache() {
+    clear_l();
+}
+
+int32_t SampleReadAheadCache::addTrack(const sp<SampleTable> &sampleTable) {
+    Mutex::Autolock autoLock(mLock);
+
+    if (sampleTable == NULL) {
+        return -1;
+    }
+
+    Track track;
+    track.mId = mNextTrackId++;
+    track.mSampleTable = sampleTable;
+    track.mSampleIndex = 0;
+    track.mReadEnd = -1;
+    mTracks.push_back(track);
+
+    return track.mId;
+}
+
+void SampleReadAheadCache::removeTrack(int32_t trackId) {
+    Mutex::Autolock autoLock(mLock);
+
+    for (auto it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if (it->mId == trackId) {
+            mTracks.erase(it);
+            break;
+        }
+    }
+
+    if (mTracks.empty()) {
+        clear_l();
+    }
+}
+
+ssize_t SampleReadAheadCache::readAt(int32_t trackId, uint32_t sampleIndex,
+        off64_t offset, void *data, size_t size) {
+    Mutex::Autolock autoLock(mLock);
+
+    Track *track = findTrack_l(trackId);
+    if (track == NULL || offset < 0 || size > kMaxSampleSize
+            || offset > kMaxOffset) {
+        ++mMisses;
+        return mSource->readAt(offset, data, size);
+    }
+
+    track->mSampleIndex = sampleIndex;
+    track->mReadEnd = offset;
+
+    const Range *range = findRange_l(offset, size);
+    if (range != NULL) {
+        ++mHits;
+    } else {
+        ++mMisses;
+        if (fill_l(offset, size) == OK) {
+            range = findRange_l(offset, size);
+        }
+    }
+
+    ssize_t n;
+    if (range != NULL) {
+        memcpy(data, range->mData + (offset - range->mOffset), size);
+        n = size;
+    } else {
+        n = mSource->readAt(offset, data, size);
+    }
+
+    if (n > 0) {
+        track->mReadEnd = offset + n;
+    }
+
+    return n;
+}
+
+void SampleReadAheadCache::getStats(int64_t *hits, int64_t *misses, int64_t *bytesRead) {
+    Mutex::Autolock autoLock(mLock);
+
+    *hits = mHits;
+    *misses = mMisses;
+    *bytesRead = mBytesRead;
+}
+
+SampleReadAheadCache::Track *SampleReadAheadCache::findTrack_l(int32_t trackId) {
+    for (Track &track : mTracks) {
+        if (track.mId == trackId) {
+            return &track;
+        }
+    }
+    return NULL;
+}
+
+const SampleReadAheadCache::Range *SampleReadAheadCache::findRange_l(
+        off64_t offset, size_t size) const {
+    for (auto it = mRanges.rbegin(); it != mRanges.rend(); ++it) {
+        if (offset >= it->mOffset && size <= it->mSize
+                && offset - it->mOffset <= (off64_t)(it->mSize - size)) {
+            return &*it;
+        }
+    }
+    return NULL;
+}
+
+void SampleReadAheadCache::predictRanges_l(const Track &track,
+        std::vector<std::pair<off64_t, off64_t>> *ranges) {
+    uint32_t sampleIndex = track.mSampleIndex;
+    off64_t predicted = 0;
+
+    for (int i = 0; i < kMaxChunksPerTrack && predicted < kTrackReadAheadSize; ++i) {
+        off64_t offset;
+        size_t size;
+        uint32_t nextChunkSampleIndex;
+        if (track.mSampleTable->getChunkRange(
+                sampleIndex, &offset, &size, &nextChunkSampleIndex) != OK
+                || offset < 0 || offset > kMaxOffset) {
+            break;
+        }
+
+        off64_t end = offset + (off64_t)std::min(size, (size_t)kMaxOffset);
+        if (i == 0 && track.mReadEnd > offset && track.mReadEnd <= end) {
+            // Skip what the track has already read from this chunk.
+            offset = track.mReadEnd;
+        }
+        end = std::min(end, offset + kMaxReadSize);
+
+        if (end > offset) {
+            ranges->push_back(std::make_pair(offset, end));
+            predicted += end - offset;
+        }
+
+        if (nextChunkSampleIndex <= sampleIndex) {
+            break;
+        }
+        sampleIndex = nextChunkSampleIndex;
+    }
+}
+
+status_t SampleReadAheadCache::fill_l(off64_t offset, size_t size) {
+    std::vector<std::pair<off64_t, off64_t>> ranges;
+    ranges.push_back(std::make_pair(offset, offset + (off64_t)size));
+    for (const Track &track : mTracks) {
+        predictRanges_l(track, &ranges);
+    }
+
+    for (auto &range : ranges) {
+        range.first &= ~(kPageSize - 1);
+        range.second = (range.second + kPageSize - 1) & ~(kPageSize - 1);
+        if (mSourceSize > 0) {
+            range.second = std::min(range.second, std::max(range.first, mSourceSize));
+        }
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    // Merge the ranges in offset order into reads of at most kMaxReadSize,
+    // and keep the one holding the requested sample. The requested range is
+    // never split, as it is smaller than a read on its own.
+    const off64_t requestEnd = offset + size;
+    off64_t start = -1;
+    off64_t end = -1;
+    for (const auto &range : ranges) {
+        if (start >= 0 && range.first <= end + kMaxGap
+                && std::max(end, range.second) - start <= kMaxReadSize) {
+            end = std::max(end, range.second);
+            continue;
+        }
+        if (start >= 0 && start <= offset && requestEnd <= end) {
+            break;
+        }
+        start = range.first;
+        end = range.second;
+    }
+    if (start < 0 || start > offset || end < requestEnd) {
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    size_t readSize = end - start;
+    while (!mRanges.empty() && mCachedBytes + readSize > kMaxCacheSize) {
+        mCachedBytes -= mRanges.front().mSize;
+        delete[] mRanges.front().mData;
+        mRanges.erase(mRanges.begin());
+    }
+
+    uint8_t *data = new (std::nothrow) uint8_t[readSize];
+    if (data == NULL) {
+        return NO_MEMORY;
+    }
+
+    ssize_t n = mSource->readAt(start, data, readSize);
+    if (n <= 0) {
+        delete[] data;
+        return ERROR_IO;
+    }
+    mBytesRead += n;
+
+    ALOGV("read %zd bytes at %lld for a sample at %lld",
+            n, (long long)start, (long long)offset);
+
+    Range range;
+    range.mOffset = start;
+    range.mSize = n;
+    range.mData = data;
+    mRanges.push_back(range);
+    mCachedBytes += n;
+
+    return OK;
+}
+
+void SampleReadAheadCache::clear_l() {
+    for (const Range &range : mRanges) {
+        delete[] range.mData;
+    }
+    mRanges.clear();
+    mCachedBytes = 0;
+}
+
+}  // namespace android
@@ -18,7 +18,10 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include "SampleTable.h"
 #include "SampleIterator.h"
@@ -128,7 +131,12 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mHasTimeToSample(false),
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
-      mSampleTimeEntries(NULL),
+      mSampleTimeRuns(NULL),
+      mNumSampleTimeRuns(0),
+      mSortedSampleIndices(NULL),
+      mSortedTimeBases(NULL),
+      mSortedTimeOffsets(NULL),
+      mSortedTimeBlockShift(0),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -139,6 +147,7 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mSampleToChunkEntries(NULL),
       mTotalSize(0) {
     mSampleIterator = new SampleIterator(this);
+    mChunkRangeIterator = new SampleIterator(this);
 }
 
 SampleTable::~SampleTable() {
@@ -157,11 +166,23 @@ SampleTable::~SampleTable() {
     delete[] mCompositionTimeDeltaEntries;
     mCompositionTimeDeltaEntries = NULL;
 
-    delete[] mSampleTimeEntries;
-    mSampleTimeEntries = NULL;
+    delete[] mSampleTimeRuns;
+    mSampleTimeRuns = NULL;
+
+    delete[] mSortedSampleIndices;
+    mSortedSampleIndices = NULL;
+
+    delete[] mSortedTimeBases;
+    mSortedTimeBases = NULL;
+
+    delete[] mSortedTimeOffsets;
+    mSortedTimeOffsets = NULL;
 
     delete mSampleIterator;
     mSampleIterator = NULL;
+
+    delete mChunkRangeIterator;
+    mChunkRangeIterator = NULL;
 }
 
 bool SampleTable::isValid() const {
@@ -615,54 +636,240 @@ uint32_t abs_difference(uint64_t time1, uint64_t time2) {
     return time1 > time2 ? time1 - time2 : time2 - time1;
 }
 
-// static
-int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
-    const SampleTimeEntry *a = (const SampleTimeEntry *)_a;
-    const SampleTimeEntry *b = (const SampleTimeEntry *)_b;
+// log2 of the number of samples per base time in the sorted sample time table.
+static const uint32_t kSortedTimeBlockShift = 6;
+
+// Returns the ctts offset of sampleIndex, like CompositionDeltaLookup, for
+// sample indices that only increase between calls.
+static int32_t nextCompositionTimeOffset(
+        const int32_t *deltaEntries, size_t numDeltaEntries, uint32_t sampleIndex,
+        size_t *deltaEntry, uint64_t *deltaEntrySampleIndex) {
+    while (*deltaEntry < numDeltaEntries) {
+        uint32_t sampleCount = deltaEntries[2 * *deltaEntry];
+        if (sampleIndex < *deltaEntrySampleIndex + sampleCount) {
+            return deltaEntries[2 * *deltaEntry + 1];
+        }
+        *deltaEntrySampleIndex += sampleCount;
+        ++*deltaEntry;
+    }
+    return 0;
+}
 
-    if (a->mCompositionTime < b->mCompositionTime) {
-        return -1;
-    } else if (a->mCompositionTime > b->mCompositionTime) {
-        return 1;
+namespace {
+
+struct SampleTimeEntry {
+    uint64_t mCompositionTime;
+    uint32_t mSampleIndex;
+};
+
+// Samples that are further out of composition time order than this are
+// sorted with std::sort.
+const size_t kMaxInsertionDistance = 64;
+
+// Sorts by composition time, then sample index. Reordered samples are usually
+// only a few places away from their position in composition time order, so an
+// insertion sort does it in about one pass over the samples.
+void sortSampleTimeEntries(SampleTimeEntry *entries, size_t numEntries) {
+    for (size_t i = 1; i < numEntries; ++i) {
+        SampleTimeEntry entry = entries[i];
+        size_t j = i;
+        while (j > 0 && entries[j - 1].mCompositionTime > entry.mCompositionTime) {
+            if (i - j == kMaxInsertionDistance) {
+                entries[j] = entry;
+                std::sort(entries, entries + numEntries,
+                        [](const SampleTimeEntry &a, const SampleTimeEntry &b) {
+                            return a.mCompositionTime != b.mCompositionTime
+                                    ? a.mCompositionTime < b.mCompositionTime
+                                    : a.mSampleIndex < b.mSampleIndex;
+                        });
+                return;
+            }
+            entries[j] = entries[j - 1];
+            --j;
+        }
+        entries[j] = entry;
     }
+}
 
-    return 0;
+}  // namespace
+
+uint32_t SampleTable::getSortedSampleIndex(uint32_t order) const {
+    if (mSampleTimeRuns != NULL) {
+        return order;
+    }
+    return mSortedSampleIndices[order];
+}
+
+uint64_t SampleTable::getSortedCompositionTime(uint32_t order) const {
+    if (mSampleTimeRuns != NULL) {
+        // The last run that starts at or before order.
+        const SampleTimeRun *run = std::upper_bound(
+                mSampleTimeRuns, mSampleTimeRuns + mNumSampleTimeRuns, order,
+                [](uint32_t sampleIndex, const SampleTimeRun &run) {
+                    return sampleIndex < run.mFirstSampleIndex;
+                }) - 1;
+        return run->mFirstCompositionTime
+                + (uint64_t)(order - run->mFirstSampleIndex) * run->mDelta;
+    }
+
+    uint64_t time = mSortedTimeBases[order >> mSortedTimeBlockShift];
+    if (mSortedTimeOffsets != NULL) {
+        time += mSortedTimeOffsets[order];
+    }
+    return time;
 }
 
 void SampleTable::buildSampleEntriesTable() {
     Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
+    if (hasSampleTimeIndex() || mNumSampleSizes == 0) {
         if (mNumSampleSizes == 0) {
             ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         }
         return;
     }
 
-    mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
+    if (!buildSampleTimeRuns()) {
+        buildSortedSampleTimes();
+    }
+}
+
+// Describes the composition time order with runs of samples, without looking
+// at every sample. Works when the samples are already in composition time
+// order, the time-to-sample table covers all of them and no time overflows.
+// Returns false otherwise.
+bool SampleTable::buildSampleTimeRuns() {
+    std::vector<SampleTimeRun> runs;
+
+    uint32_t sampleIndex = 0;
+    uint64_t sampleTime = 0;
+    uint64_t lastCompositionTime = 0;
+
+    size_t deltaEntry = 0;
+    uint64_t deltaEntrySampleIndex = 0;
+
+    for (uint32_t i = 0; i < mTimeToSampleCount && sampleIndex < mNumSampleSizes; ++i) {
+        uint32_t remaining = std::min(mTimeToSample[2 * i], mNumSampleSizes - sampleIndex);
+        uint32_t delta = mTimeToSample[2 * i + 1];
+
+        while (remaining > 0) {
+            // The samples up to the end of the current ctts entry have the
+            // same composition time offset.
+            int32_t compTimeDelta = nextCompositionTimeOffset(
+                    mCompositionTimeDeltaEntries, mNumCompositionTimeDeltaEntries,
+                    sampleIndex, &deltaEntry, &deltaEntrySampleIndex);
+            uint32_t count = remaining;
+            if (deltaEntry < mNumCompositionTimeDeltaEntries) {
+                uint64_t deltaEntryEnd = deltaEntrySampleIndex
+                        + (uint32_t)mCompositionTimeDeltaEntries[2 * deltaEntry];
+                count = std::min((uint64_t)count, deltaEntryEnd - sampleIndex);
+            }
+
+            uint64_t endTime;
+            if (__builtin_add_overflow(sampleTime, (uint64_t)count * delta, &endTime)) {
+                return false;
+            }
+            uint64_t lastSampleTime = endTime - delta;
+
+            uint64_t firstCompositionTime;
+            if (compTimeDelta < 0) {
+                if (compTimeDelta == INT32_MIN || sampleTime < uint32_t(-compTimeDelta)) {
+                    return false;
+                }
+                firstCompositionTime = sampleTime - uint32_t(-compTimeDelta);
+            } else {
+                if (lastSampleTime > UINT64_MAX - compTimeDelta) {
+                    return false;
+                }
+                firstCompositionTime = sampleTime + compTimeDelta;
+            }
+
+            if (!runs.empty() && firstCompositionTime < lastCompositionTime) {
+                ALOGV("sample %u is out of composition time order", sampleIndex);
+                return false;
+            }
+
+            if (runs.empty() || runs.back().mDelta != delta
+                    || firstCompositionTime != lastCompositionTime + delta) {
+                runs.push_back({sampleIndex, delta, firstCompositionTime});
+            }
+            lastCompositionTime = firstCompositionTime + (uint64_t)(count - 1) * delta;
+
+            sampleIndex += count;
+            sampleTime = endTime;
+            remaining -= count;
+        }
+    }
+
+    if (sampleIndex < mNumSampleSizes) {
+        return false;
+    }
+
+    uint64_t allocSize = (uint64_t)runs.size() * sizeof(SampleTimeRun);
+    mTotalSize += allocSize;
+    if (mTotalSize > kMaxTotalSize) {
+        ALOGE("Sample time run table size would make sample table too large.\n"
+              "    Requested sample time run table size = %llu\n"
+              "    Eventual sample table size >= %llu\n"
+              "    Allowed sample table size = %llu\n",
+              (unsigned long long)allocSize,
+              (unsigned long long)mTotalSize,
+              (unsigned long long)kMaxTotalSize);
+        return true;
+    }
+
+    mSampleTimeRuns = new (std::nothrow) SampleTimeRun[runs.size()];
+    if (!mSampleTimeRuns) {
+        ALOGE("Cannot allocate sample time run table with %zu entries.", runs.size());
+        return true;
+    }
+    std::copy(runs.begin(), runs.end(), mSampleTimeRuns);
+    mNumSampleTimeRuns = runs.size();
+
+    ALOGV("%u samples in composition time order in %u runs",
+            mNumSampleSizes, mNumSampleTimeRuns);
+    return true;
+}
+
+// Sorts the samples by composition time. The times are stored as 32-bit
+// offsets from the time of the first sample in each block of
+// 1 << kSortedTimeBlockShift samples.
+void SampleTable::buildSortedSampleTimes() {
+    const size_t numBlocks =
+            ((size_t)mNumSampleSizes + (1 << kSortedTimeBlockShift) - 1) >> kSortedTimeBlockShift;
+    uint64_t allocSize = (uint64_t)mNumSampleSizes * 2 * sizeof(uint32_t)
+            + (uint64_t)numBlocks * sizeof(uint64_t);
+    mTotalSize += allocSize;
     if (mTotalSize > kMaxTotalSize) {
         ALOGE("Sample entry table size would make sample table too large.\n"
               "    Requested sample entry table size = %llu\n"
               "    Eventual sample table size >= %llu\n"
               "    Allowed sample table size = %llu\n",
-              (unsigned long long)mNumSampleSizes * sizeof(SampleTimeEntry),
+              (unsigned long long)allocSize,
               (unsigned long long)mTotalSize,
               (unsigned long long)kMaxTotalSize);
         return;
     }
 
-    mSampleTimeEntries = new (std::nothrow) SampleTimeEntry[mNumSampleSizes];
-
-    if (!mSampleTimeEntries) {
+    // Samples past the end of the time-to-sample table stay at index 0 and
+    // time 0.
+    std::unique_ptr<SampleTimeEntry[]> entries(
+            new (std::nothrow) SampleTimeEntry[mNumSampleSizes]());
+    std::unique_ptr<uint32_t[]> indices(new (std::nothrow) uint32_t[mNumSampleSizes]);
+    std::unique_ptr<uint64_t[]> bases(new (std::nothrow) uint64_t[numBlocks]);
+    std::unique_ptr<uint32_t[]> offsets(new (std::nothrow) uint32_t[mNumSampleSizes]);
+    if (!entries || !indices || !bases || !offsets) {
         ALOGE("Cannot allocate sample entry table with %llu entries.",
                 (unsigned long long)mNumSampleSizes);
         return;
     }
-    memset(mSampleTimeEntries, 0, sizeof(SampleTimeEntry) * mNumSampleSizes);
 
     uint32_t sampleIndex = 0;
     uint64_t sampleTime = 0;
 
+    size_t deltaEntry = 0;
+    uint64_t deltaEntrySampleIndex = 0;
+
     for (uint32_t i = 0; i < mTimeToSampleCount; ++i) {
         uint32_t n = mTimeToSample[2 * i];
         uint32_t delta = mTimeToSample[2 * i + 1];
@@ -673,11 +880,11 @@ void SampleTable::buildSampleEntriesTable() {
                 // is well-formed, but you know... there's (gasp) malformed
                 // content out there.
 
-                mSampleTimeEntries[sampleIndex].mSampleIndex = sampleIndex;
+                entries[sampleIndex].mSampleIndex = sampleIndex;
 
-                int32_t compTimeDelta =
-                    mCompositionDeltaLookup->getCompositionTimeOffset(
-                            sampleIndex);
+                int32_t compTimeDelta = nextCompositionTimeOffset(
+                        mCompositionTimeDeltaEntries, mNumCompositionTimeDeltaEntries,
+                        sampleIndex, &deltaEntry, &deltaEntrySampleIndex);
 
                 if ((compTimeDelta < 0 && sampleTime <
                         (compTimeDelta == INT32_MIN ?
@@ -694,7 +901,7 @@ void SampleTable::buildSampleEntriesTable() {
                     compTimeDelta = 0;
                 }
 
-                mSampleTimeEntries[sampleIndex].mCompositionTime =
+                entries[sampleIndex].mCompositionTime =
                         compTimeDelta > 0 ? sampleTime + compTimeDelta:
                                 sampleTime - (-compTimeDelta);
             }
@@ -710,8 +917,41 @@ void SampleTable::buildSampleEntriesTable() {
         }
     }
 
-    qsort(mSampleTimeEntries, mNumSampleSizes, sizeof(SampleTimeEntry),
-          CompareIncreasingTime);
+    sortSampleTimeEntries(entries.get(), mNumSampleSizes);
+
+    bool fitsOffsets = true;
+    for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+        indices[i] = entries[i].mSampleIndex;
+        if ((i & ((1 << kSortedTimeBlockShift) - 1)) == 0) {
+            bases[i >> kSortedTimeBlockShift] = entries[i].mCompositionTime;
+        }
+        uint64_t offset = entries[i].mCompositionTime - bases[i >> kSortedTimeBlockShift];
+        if (offset > UINT32_MAX) {
+            fitsOffsets = false;
+        }
+        offsets[i] = offset;
+    }
+
+    if (!fitsOffsets) {
+        // Only for clamped times or times that jump by more than 32 bits
+        // within a block: keep the time of every sample.
+        bases.reset(new (std::nothrow) uint64_t[mNumSampleSizes]);
+        if (!bases) {
+            ALOGE("Cannot allocate sample entry table with %llu entries.",
+                    (unsigned long long)mNumSampleSizes);
+            return;
+        }
+        for (uint32_t i = 0; i < mNumSampleSizes; ++i) {
+            bases[i] = entries[i].mCompositionTime;
+        }
+        offsets.reset();
+        mTotalSize += (uint64_t)mNumSampleSizes * sizeof(uint32_t);
+    }
+
+    mSortedSampleIndices = indices.release();
+    mSortedTimeBases = bases.release();
+    mSortedTimeOffsets = offsets.release();
+    mSortedTimeBlockShift = fitsOffsets ? kSortedTimeBlockShift : 0;
 }
 
 status_t SampleTable::findSampleAtTime(
@@ -719,7 +959,7 @@ status_t SampleTable::findSampleAtTime(
         uint32_t *sample_index, uint32_t flags) {
     buildSampleEntriesTable();
 
-    if (mSampleTimeEntries == NULL) {
+    if (!hasSampleTimeIndex()) {
         return ERROR_OUT_OF_RANGE;
     }
 
@@ -727,7 +967,7 @@ status_t SampleTable::findSampleAtTime(
         if (req_time >= mNumSampleSizes) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        *sample_index = getSortedSampleIndex(req_time);
         return OK;
     }
 
@@ -743,7 +983,7 @@ status_t SampleTable::findSampleAtTime(
         } else if (req_time > centerTime) {
             left = center + 1;
         } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+            *sample_index = getSortedSampleIndex(center);
             return OK;
         }
     }
@@ -792,7 +1032,7 @@ status_t SampleTable::findSampleAtTime(
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
+    *sample_index = getSortedSampleIndex(closestIndex);
     return OK;
 }
 
@@ -950,6 +1190,14 @@ uint32_t SampleTable::getLastSampleIndexInChunk() {
     return mSampleIterator->getLastSampleIndexInChunk();
 }
 
+status_t SampleTable::getChunkRange(
+        uint32_t sampleIndex, off64_t *offset, size_t *size,
+        uint32_t *nextChunkSampleIndex) {
+    Mutex::Autolock autoLock(mLock);
+    return mChunkRangeIterator->getChunkRange(
+            sampleIndex, offset, size, nextChunkSampleIndex);
+}
+
 status_t SampleTable::getMetaDataForSample(
         uint32_t sampleIndex,
         off64_t *offset,
@@ -33,6 +33,7 @@ namespace android {
 struct AMessage;
 struct CDataSource;
 class DataSourceHelper;
+class SampleReadAheadCache;
 class SampleTable;
 class String8;
 namespace heif {
@@ -174,6 +175,10 @@ private:
 
     sp<ItemTable> mItemTable;
 
+    // Shared by the tracks read from the sample tables, created with the
+    // first of them if the source is worth prefetching from.
+    sp<SampleReadAheadCache> mReadAheadCache;
+
     status_t parseTrackHeader(off64_t data_offset, off64_t data_size);
 
     status_t parseSegmentIndex(off64_t data_offset, size_t data_size);
@@ -44,6 +44,13 @@ struct SampleIterator {
     status_t getSampleSizeDirect(
             uint32_t sampleIndex, size_t *size);
 
+    // Returns the byte range from the start of sample "sampleIndex" to the
+    // end of its chunk, and the index of the first sample in the next chunk.
+    // Unlike seekTo(), this does not look up sample times.
+    status_t getChunkRange(
+            uint32_t sampleIndex, off64_t *offset, size_t *size,
+            uint32_t *nextChunkSampleIndex);
+
 private:
     SampleTable *mTable;
 
@@ -57,6 +64,7 @@ private:
     uint32_t mSamplesPerChunk;
     uint32_t mChunkDesc;
 
+    bool mChunkLoaded;
     uint32_t mCurrentChunkIndex;
     off64_t mCurrentChunkOffset;
     Vector<size_t> mCurrentChunkSampleSizes;
@@ -74,6 +82,7 @@ private:
     uint64_t mCurrentSampleDuration;
 
     void reset();
+    status_t seekToChunk(uint32_t sampleIndex);
     status_t findChunkRange(uint32_t sampleIndex);
     status_t getChunkOffset(uint32_t chunk, off64_t *offset);
     status_t findSampleTimeAndDuration(uint32_t sampleIndex, uint64_t *time, uint64_t *duration);
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SAMPLE_READ_AHEAD_CACHE_H_
+
+#define SAMPLE_READ_AHEAD_CACHE_H_
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+#include <utils/threads.h>
+
+namespace android {
+
+class DataSourceHelper;
+class SampleTable;
+
+/*
+ * Serves sample reads of all the tracks of one file from a shared set of
+ * cached ranges. On a miss, the sample tables of the active tracks predict
+ * the chunks each track reads next, and the ones close to the requested
+ * sample are fetched together in one large page aligned read. For
+ * interleaved files this turns a read per sample, per track, into a read
+ * per interleave period.
+ */
+class SampleReadAheadCache : public RefBase {
+public:
+    // Caller retains ownership of "source".
+    explicit SampleReadAheadCache(DataSourceHelper *source);
+
+    // Returns an id for readAt(), or -1 if the track could not be added.
+    int32_t addTrack(const sp<SampleTable> &sampleTable);
+    void removeTrack(int32_t trackId);
+
+    // Reads "size" bytes at "offset", which hold sample "sampleIndex" (and
+    // possibly the samples following it) of track "trackId".
+    ssize_t readAt(int32_t trackId, uint32_t sampleIndex,
+            off64_t offset, void *data, size_t size);
+
+    void getStats(int64_t *hits, int64_t *misses, int64_t *bytesRead);
+
+protected:
+    ~SampleReadAheadCache();
+
+private:
+    struct Track {
+        int32_t mId;
+        sp<SampleTable> mSampleTable;
+        // The last sample read, and the end of the data read for it.
+        uint32_t mSampleIndex;
+        off64_t mReadEnd;
+    };
+
+    struct Range {
+        off64_t mOffset;
+        size_t mSize;
+        uint8_t *mData;
+    };
+
+    Mutex mLock;
+    DataSourceHelper *mSource;
+    off64_t mSourceSize;
+
+    std::vector<Track> mTracks;
+    int32_t mNextTrackId;
+
+    // Oldest first.
+    std::vector<Range> mRanges;
+    size_t mCachedBytes;
+
+    int64_t mHits;
+    int64_t mMisses;
+    int64_t mBytesRead;
+
+    Track *findTrack_l(int32_t trackId);
+    const Range *findRange_l(off64_t offset, size_t size) const;
+    void predictRanges_l(const Track &track,
+            std::vector<std::pair<off64_t, off64_t>> *ranges);
+    status_t fill_l(off64_t offset, size_t size);
+    void clear_l();
+
+    SampleReadAheadCache(const SampleReadAheadCache &);
+    SampleReadAheadCache &operator=(const SampleReadAheadCache &);
+};
+
+}  // namespace android
+
+#endif  // SAMPLE_READ_AHEAD_CACHE_H_
@@ -73,6 +73,13 @@ public:
     // call only after getMetaDataForSample has been called successfully.
     uint32_t getLastSampleIndexInChunk();
 
+    // Returns the byte range from the start of sample "sampleIndex" to the
+    // end of its chunk, and the index of the first sample in the next chunk.
+    // Uses its own iterator, so it does not disturb getMetaDataForSample().
+    status_t getChunkRange(
+            uint32_t sampleIndex, off64_t *offset, size_t *size,
+            uint32_t *nextChunkSampleIndex);
+
     enum {
         kFlagBefore,
         kFlagAfter,
@@ -126,11 +133,25 @@ private:
     uint32_t mTimeToSampleCount;
     uint32_t* mTimeToSample;
 
-    struct SampleTimeEntry {
-        uint32_t mSampleIndex;
-        uint64_t mCompositionTime;
+    // The samples in composition time order, built on the first seek by
+    // buildSampleEntriesTable(). Samples that are stored in composition time
+    // order are described by runs with a constant time delta, in
+    // mSampleTimeRuns. Otherwise they are sorted into mSortedSampleIndices,
+    // and the time of the sample at position i is
+    // mSortedTimeBases[i >> mSortedTimeBlockShift] + mSortedTimeOffsets[i].
+    struct SampleTimeRun {
+        uint32_t mFirstSampleIndex;
+        uint32_t mDelta;
+        uint64_t mFirstCompositionTime;
     };
-    SampleTimeEntry *mSampleTimeEntries;
+    SampleTimeRun *mSampleTimeRuns;
+    uint32_t mNumSampleTimeRuns;
+
+    uint32_t *mSortedSampleIndices;
+    uint64_t *mSortedTimeBases;
+    // NULL if the bases hold the time of every sample.
+    uint32_t *mSortedTimeOffsets;
+    uint32_t mSortedTimeBlockShift;
 
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
@@ -142,6 +163,7 @@ private:
     size_t mLastSyncSampleIndex;
 
     SampleIterator *mSampleIterator;
+    SampleIterator *mChunkRangeIterator;
 
     struct SampleToChunkEntry {
         uint32_t startChunk;
@@ -155,20 +177,29 @@ private:
 
     friend struct SampleIterator;
 
+    bool hasSampleTimeIndex() const {
+        return mSampleTimeRuns != NULL || mSortedSampleIndices != NULL;
+    }
+
+    // The sample and the composition time at position |order| in composition
+    // time order.
+    uint32_t getSortedSampleIndex(uint32_t order) const;
+    uint64_t getSortedCompositionTime(uint32_t order) const;
+
     // normally we don't round
     inline uint64_t getSampleTime(
             size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
+        return (sample_index < (size_t)mNumSampleSizes && hasSampleTimeIndex()
                 && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
+                ? (getSortedCompositionTime(sample_index) * scale_num) / scale_den : 0;
     }
 
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
-    static int CompareIncreasingTime(const void *, const void *);
-
     void buildSampleEntriesTable();
+    bool buildSampleTimeRuns();
+    void buildSortedSampleTimes();
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
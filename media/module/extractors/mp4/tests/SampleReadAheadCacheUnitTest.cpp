@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include <SampleReadAheadCache.h>
+#include <SampleTable.h>
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginApi.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+namespace {
+
+using android::CDataSource;
+using android::DataSourceHelper;
+using android::SampleReadAheadCache;
+using android::SampleTable;
+using android::sp;
+
+struct TrackLayout {
+    uint32_t samplesPerChunk;
+    uint32_t sampleSize;
+};
+
+// A file with the chunks of its tracks interleaved, followed by their sample
+// tables. Counts the reads of sample data.
+class InterleavedFile {
+  public:
+    InterleavedFile(std::initializer_list<TrackLayout> tracks, uint32_t numChunks)
+        : mTracks(tracks), mNumChunks(numChunks), mSampleReads(0) {
+        mSource.readAt = readAt;
+        mSource.getSize = getSize;
+        mSource.flags = flags;
+        mSource.getUri = getUri;
+        mSource.handle = this;
+
+        std::vector<std::vector<uint32_t>> chunkOffsets(mTracks.size());
+        for (uint32_t chunk = 0; chunk < mNumChunks; ++chunk) {
+            for (size_t track = 0; track < mTracks.size(); ++track) {
+                chunkOffsets[track].push_back(mData.size());
+                const TrackLayout &layout = mTracks[track];
+                for (uint32_t i = 0; i < layout.samplesPerChunk * layout.sampleSize; ++i) {
+                    mData.push_back(byteAt(mData.size()));
+                }
+            }
+        }
+        mSampleDataSize = mData.size();
+
+        mHelper.reset(new DataSourceHelper(&mSource));
+        for (size_t track = 0; track < mTracks.size(); ++track) {
+            const TrackLayout &layout = mTracks[track];
+            off64_t stco = mData.size();
+            append32({0, mNumChunks});
+            for (uint32_t offset : chunkOffsets[track]) {
+                append32({offset});
+            }
+            off64_t stsc = mData.size();
+            append32({0, 1, 1, layout.samplesPerChunk, 1});
+            off64_t stsz = mData.size();
+            append32({0, layout.sampleSize, numSamples(track)});
+            off64_t stts = mData.size();
+            append32({0, 1, numSamples(track), 1000});
+            off64_t end = mData.size();
+
+            sp<SampleTable> table = new SampleTable(mHelper.get());
+            EXPECT_EQ(android::OK, table->setChunkOffsetParams(
+                    android::FOURCC("stco"), stco, stsc - stco));
+            EXPECT_EQ(android::OK, table->setSampleToChunkParams(stsc, stsz - stsc));
+            EXPECT_EQ(android::OK, table->setSampleSizeParams(
+                    android::FOURCC("stsz"), stsz, stts - stsz));
+            EXPECT_EQ(android::OK, table->setTimeToSampleParams(stts, end - stts));
+            mSampleTables.push_back(table);
+        }
+    }
+
+    static uint8_t byteAt(size_t offset) { return (offset * 7 + offset / 251) & 0xff; }
+
+    uint32_t numSamples(size_t track) const {
+        return mTracks[track].samplesPerChunk * mNumChunks;
+    }
+
+    DataSourceHelper *source() const { return mHelper.get(); }
+    const sp<SampleTable> &sampleTable(size_t track) const { return mSampleTables[track]; }
+    size_t sampleReads() const { return mSampleReads; }
+    size_t sampleDataSize() const { return mSampleDataSize; }
+
+  private:
+    void append32(std::initializer_list<uint32_t> values) {
+        for (uint32_t value : values) {
+            mData.push_back(value >> 24);
+            mData.push_back(value >> 16);
+            mData.push_back(value >> 8);
+            mData.push_back(value);
+        }
+    }
+
+    static ssize_t readAt(void *handle, off64_t offset, void *data, size_t size) {
+        InterleavedFile *file = static_cast<InterleavedFile *>(handle);
+        const std::vector<uint8_t> &bytes = file->mData;
+        if (offset < 0 || (size_t)offset >= bytes.size()) {
+            return 0;
+        }
+        if ((size_t)offset < file->mSampleDataSize) {
+            ++file->mSampleReads;
+        }
+        size = std::min(size, bytes.size() - offset);
+        memcpy(data, bytes.data() + offset, size);
+        return size;
+    }
+
+    static android::status_t getSize(void *handle, off64_t *size) {
+        *size = static_cast<InterleavedFile *>(handle)->mData.size();
+        return android::OK;
+    }
+
+    static uint32_t flags(void *) { return 0; }
+
+    static bool getUri(void *, char *, size_t) { return false; }
+
+    const std::vector<TrackLayout> mTracks;
+    const uint32_t mNumChunks;
+    std::vector<uint8_t> mData;
+    size_t mSampleDataSize;
+    size_t mSampleReads;
+    CDataSource mSource;
+    std::unique_ptr<DataSourceHelper> mHelper;
+    std::vector<sp<SampleTable>> mSampleTables;
+};
+
+// Reads sample "sampleIndex" of a track through the cache and checks its data.
+void readAndVerify(const InterleavedFile &file, const sp<SampleReadAheadCache> &cache,
+                   int32_t trackId, size_t track, uint32_t sampleIndex) {
+    off64_t offset;
+    size_t size;
+    ASSERT_EQ(android::OK, file.sampleTable(track)->getMetaDataForSample(
+            sampleIndex, &offset, &size, nullptr));
+    std::vector<uint8_t> data(size);
+    ASSERT_EQ((ssize_t)size, cache->readAt(trackId, sampleIndex, offset, data.data(), size));
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(InterleavedFile::byteAt(offset + i), data[i])
+                << "track " << track << " sample " << sampleIndex << " byte " << i;
+    }
+}
+
+TEST(SampleReadAheadCacheTest, InterleavedTracksShareReads) {
+    // About one second of video and audio per chunk.
+    InterleavedFile file({{30, 8000}, {43, 400}}, 40);
+    sp<SampleReadAheadCache> cache = new SampleReadAheadCache(file.source());
+    int32_t video = cache->addTrack(file.sampleTable(0));
+    int32_t audio = cache->addTrack(file.sampleTable(1));
+
+    // Read the tracks the way a player does, a little of each at a time.
+    uint32_t videoSample = 0;
+    uint32_t audioSample = 0;
+    size_t reads = 0;
+    while (videoSample < file.numSamples(0) || audioSample < file.numSamples(1)) {
+        for (int i = 0; i < 3 && videoSample < file.numSamples(0); ++i, ++reads) {
+            ASSERT_NO_FATAL_FAILURE(readAndVerify(file, cache, video, 0, videoSample++));
+        }
+        for (int i = 0; i < 4 && audioSample < file.numSamples(1); ++i, ++reads) {
+            ASSERT_NO_FATAL_FAILURE(readAndVerify(file, cache, audio, 1, audioSample++));
+        }
+    }
+
+    int64_t hits, misses, bytesRead;
+    cache->getStats(&hits, &misses, &bytesRead);
+    EXPECT_EQ((int64_t)reads, hits + misses);
+    EXPECT_EQ((int64_t)file.sampleReads(), misses);
+    EXPECT_LT(file.sampleReads() * 20, reads);
+    EXPECT_GE(bytesRead, (int64_t)file.sampleDataSize());
+    EXPECT_LT(bytesRead, (int64_t)file.sampleDataSize() * 2);
+
+    cache->removeTrack(video);
+    cache->removeTrack(audio);
+}
+
+TEST(SampleReadAheadCacheTest, SeeksAndLargeSamples) {
+    InterleavedFile file({{2, 300 * 1024}, {10, 1000}}, 8);
+    sp<SampleReadAheadCache> cache = new SampleReadAheadCache(file.source());
+    int32_t video = cache->addTrack(file.sampleTable(0));
+    int32_t audio = cache->addTrack(file.sampleTable(1));
+
+    for (uint32_t sampleIndex : {70u, 71u, 5u, 6u, 7u, 79u, 0u}) {
+        ASSERT_NO_FATAL_FAILURE(readAndVerify(file, cache, audio, 1, sampleIndex));
+    }
+
+    // Samples too large to be worth caching are read directly.
+    size_t sampleReads = file.sampleReads();
+    ASSERT_NO_FATAL_FAILURE(readAndVerify(file, cache, video, 0, 3));
+    ASSERT_NO_FATAL_FAILURE(readAndVerify(file, cache, video, 0, 3));
+    EXPECT_EQ(sampleReads + 2, file.sampleReads());
+
+    cache->removeTrack(video);
+    ASSERT_NO_FATAL_FAILURE(readAndVerify(file, cache, audio, 1, 12));
+    cache->removeTrack(audio);
+}
+
+}  // namespace
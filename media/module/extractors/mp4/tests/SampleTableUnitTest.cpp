@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <SampleTable.h>
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginApi.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+namespace {
+
+using android::CDataSource;
+using android::DataSourceHelper;
+using android::SampleTable;
+using android::sp;
+
+// A sample table whose boxes are kept in memory.
+class SampleTableBuilder {
+  public:
+    explicit SampleTableBuilder(uint32_t numSamples) : mNumSamples(numSamples) {
+        mSource.readAt = readAt;
+        mSource.getSize = getSize;
+        mSource.flags = flags;
+        mSource.getUri = getUri;
+        mSource.handle = this;
+    }
+
+    void addTimeToSample(uint32_t count, uint32_t delta) {
+        mTimeToSample.push_back({count, delta});
+    }
+
+    void addCompositionOffset(uint32_t count, int32_t offset) {
+        mCompositionOffsets.push_back({count, offset});
+    }
+
+    // The composition time of every sample, computed the simple way.
+    std::vector<uint64_t> compositionTimes() const {
+        std::vector<uint64_t> times;
+        uint64_t time = 0;
+        for (const auto &[count, delta] : mTimeToSample) {
+            for (uint32_t i = 0; i < count; ++i) {
+                times.push_back(time);
+                time += delta;
+            }
+        }
+        times.resize(mNumSamples, 0);
+        size_t sampleIndex = 0;
+        for (const auto &[count, offset] : mCompositionOffsets) {
+            for (uint32_t i = 0; i < count && sampleIndex < times.size(); ++i) {
+                times[sampleIndex++] += offset;
+            }
+        }
+        return times;
+    }
+
+    sp<SampleTable> build() {
+        mData.clear();
+
+        // One chunk at offset 0 with all the samples, each 1 byte.
+        off64_t stco = mData.size();
+        append32({0, 1, 0});
+        off64_t stsc = mData.size();
+        append32({0, 1, 1, mNumSamples, 1});
+        off64_t stsz = mData.size();
+        append32({0, 1, mNumSamples});
+        off64_t stts = mData.size();
+        append32({0, (uint32_t)mTimeToSample.size()});
+        for (const auto &[count, delta] : mTimeToSample) {
+            append32({count, delta});
+        }
+        off64_t ctts = mData.size();
+        append32({0, (uint32_t)mCompositionOffsets.size()});
+        for (const auto &[count, offset] : mCompositionOffsets) {
+            append32({count, (uint32_t)offset});
+        }
+
+        mHelper.reset(new DataSourceHelper(&mSource));
+        sp<SampleTable> table = new SampleTable(mHelper.get());
+        EXPECT_EQ(android::OK, table->setChunkOffsetParams(
+                android::FOURCC("stco"), stco, stsc - stco));
+        EXPECT_EQ(android::OK, table->setSampleToChunkParams(stsc, stsz - stsc));
+        EXPECT_EQ(android::OK, table->setSampleSizeParams(
+                android::FOURCC("stsz"), stsz, stts - stsz));
+        EXPECT_EQ(android::OK, table->setTimeToSampleParams(stts, ctts - stts));
+        if (!mCompositionOffsets.empty()) {
+            EXPECT_EQ(android::OK, table->setCompositionTimeToSampleParams(
+                    ctts, mData.size() - ctts));
+        }
+        return table;
+    }
+
+  private:
+    void append32(std::initializer_list<uint32_t> values) {
+        for (uint32_t value : values) {
+            mData.push_back(value >> 24);
+            mData.push_back(value >> 16);
+            mData.push_back(value >> 8);
+            mData.push_back(value);
+        }
+    }
+
+    static ssize_t readAt(void *handle, off64_t offset, void *data, size_t size) {
+        const std::vector<uint8_t> &bytes = static_cast<SampleTableBuilder *>(handle)->mData;
+        if (offset < 0 || (size_t)offset >= bytes.size()) {
+            return 0;
+        }
+        size = std::min(size, bytes.size() - offset);
+        memcpy(data, bytes.data() + offset, size);
+        return size;
+    }
+
+    static android::status_t getSize(void *handle, off64_t *size) {
+        *size = static_cast<SampleTableBuilder *>(handle)->mData.size();
+        return android::OK;
+    }
+
+    static uint32_t flags(void *) { return 0; }
+
+    static bool getUri(void *, char *, size_t) { return false; }
+
+    const uint32_t mNumSamples;
+    std::vector<std::pair<uint32_t, uint32_t>> mTimeToSample;
+    std::vector<std::pair<uint32_t, int32_t>> mCompositionOffsets;
+    std::vector<uint8_t> mData;
+    CDataSource mSource;
+    std::unique_ptr<DataSourceHelper> mHelper;
+};
+
+// Checks every seek mode of findSampleAtTime() against the composition times
+// sorted the simple way, for times at, between and around the samples.
+void verifySeeks(SampleTableBuilder &builder, uint64_t scaleNum = 1, uint64_t scaleDen = 1) {
+    sp<SampleTable> table = builder.build();
+    const std::vector<uint64_t> times = builder.compositionTimes();
+    std::vector<uint64_t> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    const size_t numSamples = sorted.size();
+
+    auto scaled = [&](uint64_t time) { return time * scaleNum / scaleDen; };
+
+    for (uint32_t order = 0; order < numSamples; ++order) {
+        uint32_t sampleIndex;
+        ASSERT_EQ(android::OK, table->findSampleAtTime(
+                order, scaleNum, scaleDen, &sampleIndex, SampleTable::kFlagFrameIndex));
+        ASSERT_LT(sampleIndex, numSamples);
+        ASSERT_EQ(sorted[order], times[sampleIndex]) << "frame index " << order;
+
+        uint64_t compositionTime;
+        ASSERT_EQ(android::OK, table->getMetaDataForSample(
+                sampleIndex, nullptr, nullptr, &compositionTime));
+        ASSERT_EQ(times[sampleIndex], compositionTime) << "sample " << sampleIndex;
+    }
+
+    std::vector<uint64_t> requests;
+    for (uint64_t time : sorted) {
+        requests.push_back(scaled(time));
+        requests.push_back(scaled(time) + 1);
+        if (scaled(time) > 0) {
+            requests.push_back(scaled(time) - 1);
+        }
+    }
+
+    for (uint64_t request : requests) {
+        // The first position with a later time, as the binary search in
+        // findSampleAtTime() ends up with when there is no exact match.
+        size_t after = std::upper_bound(sorted.begin(), sorted.end(), request,
+                [&](uint64_t time, uint64_t sampleTime) {
+                    return time < scaled(sampleTime);
+                }) - sorted.begin();
+        bool exact = after > 0 && scaled(sorted[after - 1]) == request;
+
+        for (uint32_t flags : {SampleTable::kFlagBefore, SampleTable::kFlagAfter,
+                               SampleTable::kFlagClosest}) {
+            uint32_t sampleIndex;
+            android::status_t err =
+                    table->findSampleAtTime(request, scaleNum, scaleDen, &sampleIndex, flags);
+            if (!exact && after == numSamples && flags == SampleTable::kFlagAfter) {
+                EXPECT_EQ(android::ERROR_OUT_OF_RANGE, err) << "request " << request;
+                continue;
+            }
+            ASSERT_EQ(android::OK, err) << "request " << request << " flags " << flags;
+            ASSERT_LT(sampleIndex, numSamples);
+
+            uint64_t expected;
+            if (exact) {
+                expected = request;
+            } else if (after == 0) {
+                expected = scaled(sorted[0]);
+            } else if (after == numSamples) {
+                expected = scaled(sorted[numSamples - 1]);
+            } else if (flags == SampleTable::kFlagBefore) {
+                expected = scaled(sorted[after - 1]);
+            } else if (flags == SampleTable::kFlagAfter) {
+                expected = scaled(sorted[after]);
+            } else {
+                uint64_t before = scaled(sorted[after - 1]);
+                uint64_t later = scaled(sorted[after]);
+                expected = later - request > request - before ? before : later;
+            }
+            ASSERT_EQ(expected, scaled(times[sampleIndex]))
+                    << "request " << request << " flags " << flags;
+        }
+    }
+}
+
+TEST(SampleTableTest, ConstantFrameRate) {
+    SampleTableBuilder builder(1000);
+    builder.addTimeToSample(1000, 375);
+    verifySeeks(builder, 1000000, 90000);
+}
+
+TEST(SampleTableTest, VariableFrameRate) {
+    SampleTableBuilder builder(600);
+    builder.addTimeToSample(100, 3000);
+    builder.addTimeToSample(1, 2999);
+    builder.addTimeToSample(299, 1501);
+    builder.addTimeToSample(200, 3000);
+    verifySeeks(builder);
+}
+
+TEST(SampleTableTest, ConstantCompositionOffset) {
+    // Samples stay in composition time order.
+    SampleTableBuilder builder(500);
+    builder.addTimeToSample(500, 512);
+    builder.addCompositionOffset(200, 1024);
+    builder.addCompositionOffset(300, 1024);
+    verifySeeks(builder);
+}
+
+TEST(SampleTableTest, ReorderedFrames) {
+    // I P B B P B B ..., in decode order.
+    const uint32_t kNumSamples = 1000;
+    SampleTableBuilder builder(kNumSamples);
+    builder.addTimeToSample(kNumSamples, 1001);
+    builder.addCompositionOffset(1, 1001);
+    for (uint32_t i = 1; i + 3 <= kNumSamples; i += 3) {
+        builder.addCompositionOffset(1, 3003);
+        builder.addCompositionOffset(2, 0);
+    }
+    verifySeeks(builder, 1000000, 30000);
+}
+
+TEST(SampleTableTest, ReversedFrames) {
+    // Samples far away from their place in composition time order.
+    const int32_t kNumSamples = 300;
+    SampleTableBuilder builder(kNumSamples);
+    builder.addTimeToSample(kNumSamples, 100);
+    for (int32_t i = 0; i < kNumSamples; ++i) {
+        builder.addCompositionOffset(1, (kNumSamples - 1 - 2 * i) * 100 + 50000);
+    }
+    verifySeeks(builder);
+}
+
+TEST(SampleTableTest, ReorderedFramesWithLargeGap) {
+    // Times more than 32 bits apart in the same block of sorted times.
+    SampleTableBuilder builder(200);
+    builder.addTimeToSample(100, 1000);
+    builder.addTimeToSample(2, 0xffffffff);
+    builder.addTimeToSample(98, 1000);
+    for (uint32_t i = 0; i < 100; ++i) {
+        builder.addCompositionOffset(1, 2000);
+        builder.addCompositionOffset(1, -1000);
+    }
+    verifySeeks(builder);
+}
+
+TEST(SampleTableTest, ShortTimeToSampleTable) {
+    // The samples not in the stts box are at time 0.
+    SampleTableBuilder builder(100);
+    builder.addTimeToSample(90, 100);
+    verifySeeks(builder);
+}
+
+}  // namespace
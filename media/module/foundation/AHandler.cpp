@@ -30,16 +30,56 @@ void AHandler::deliverMessage(const sp<AMessage> &msg) {
     setDeliveryStatus(false, 0, 0);
 
     if (mVerboseStats) {
-        uint32_t what = msg->what();
-        ssize_t idx = mMessages.indexOfKey(what);
-        if (idx < 0) {
-            mMessages.add(what, 1);
-        } else {
-            mMessages.editValueAt(idx)++;
+        countMessage(msg->what());
+    }
+}
+
+void AHandler::deliverMessages(const std::vector<sp<AMessage>> &msgs) {
+    setDeliveryStatus(true, msgs.front()->what(), ALooper::GetNowUs());
+    onMessagesReceived(msgs);
+    mMessageCounter += msgs.size();
+    setDeliveryStatus(false, 0, 0);
+
+    if (mVerboseStats) {
+        for (const sp<AMessage> &msg : msgs) {
+            countMessage(msg->what());
         }
     }
 }
 
+void AHandler::countMessage(uint32_t what) {
+    ssize_t idx = mMessages.indexOfKey(what);
+    if (idx < 0) {
+        mMessages.add(what, 1);
+    } else {
+        mMessages.editValueAt(idx)++;
+    }
+}
+
+void AHandler::onMessagesReceived(const std::vector<sp<AMessage>> &msgs) {
+    for (const sp<AMessage> &msg : msgs) {
+        onMessageReceived(msg);
+    }
+}
+
+status_t AHandler::setBatchedDelivery(bool enabled) {
+    sp<ALooper> looper = mLooper.promote();
+    if (looper == NULL) {
+        return -ENOENT;
+    }
+    looper->setBatchedDelivery(mID, enabled);
+    return OK;
+}
+
+status_t AHandler::setCoalescible(uint32_t what, bool coalescible) {
+    sp<ALooper> looper = mLooper.promote();
+    if (looper == NULL) {
+        return -ENOENT;
+    }
+    looper->setCoalescible(mID, what, coalescible);
+    return OK;
+}
+
 void AHandler::setDeliveryStatus(bool delivering, uint32_t what, int64_t startUs) {
 //    AutoMutex autoLock(mLock);
     mDeliveringMessage = delivering;
@@ -64,6 +64,10 @@ private:
     DISALLOW_EVIL_CONSTRUCTORS(LooperThread);
 };
 
+// Token under which the messages of a coalescible what are posted uniquely.
+struct CoalescingToken : public RefBase {
+};
+
 // static
 int64_t ALooper::GetNowUs() {
     return systemTime(SYSTEM_TIME_MONOTONIC) / 1000LL;
@@ -95,6 +99,43 @@ ALooper::handler_id ALooper::registerHandler(const sp<AHandler> &handler) {
 
 void ALooper::unregisterHandler(handler_id handlerID) {
     gLooperRoster.unregisterHandler(handlerID);
+
+    Mutex::Autolock autoLock(mLock);
+    mBatchedHandlers.erase(handlerID);
+    for (auto it = mCoalescingTokens.begin(); it != mCoalescingTokens.end();) {
+        if ((handler_id)(it->first >> 32) == handlerID) {
+            it = mCoalescingTokens.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+ALooper::Stats ALooper::getStats() const {
+    Stats stats;
+    stats.mDelivered = mDeliveredCount.load(std::memory_order_relaxed);
+    stats.mBatched = mBatchedCount.load(std::memory_order_relaxed);
+    stats.mCoalesced = mCoalescedCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ALooper::setBatchedDelivery(handler_id handlerID, bool enabled) {
+    Mutex::Autolock autoLock(mLock);
+    if (enabled) {
+        mBatchedHandlers.insert(handlerID);
+    } else {
+        mBatchedHandlers.erase(handlerID);
+    }
+}
+
+void ALooper::setCoalescible(handler_id handlerID, uint32_t what, bool coalescible) {
+    Mutex::Autolock autoLock(mLock);
+    const uint64_t key = CoalescingKey(handlerID, what);
+    if (!coalescible) {
+        mCoalescingTokens.erase(key);
+    } else if (mCoalescingTokens.find(key) == mCoalescingTokens.end()) {
+        mCoalescingTokens.emplace(key, new CoalescingToken);
+    }
 }
 
 status_t ALooper::start(
@@ -181,21 +222,32 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         whenUs = getNowUs();
     }
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
+    // Only an event that becomes the new head of the queue changes the loop's wake-up time.
+    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.top().mWhenUs;
+
+    // A coalescible message replaces the pending one with the same handler and what.
+    // A message whose sender awaits a response is never dropped, so it is posted
+    // without the coalescing token: it neither replaces nor can be replaced.
+    sp<RefBase> token;
+    if (!mCoalescingTokens.empty()) {
+        auto it = mCoalescingTokens.find(CoalescingKey(msg->mTarget, msg->mWhat));
+        if (it != mCoalescingTokens.end() && !msg->contains("replyID")) {
+            token = it->second;
+            if (mEventQueue.eraseToken(token)) {
+                mCoalescedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
     }
 
     Event event;
     event.mWhenUs = whenUs;
     event.mMessage = msg;
-    event.mToken = nullptr;
+    event.mToken = token;
+    mEventQueue.push(event);
 
-    if (it == mEventQueue.begin()) {
+    if (shouldAwakeLoop) {
         mQueueChangedCondition.signal();
     }
-
-    mEventQueue.insert(it, event);
 }
 
 status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token, int64_t delayUs) {
@@ -215,28 +267,16 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
     // We only need to wake the loop up if we're rescheduling to the earliest event in the queue.
     // This needs to be checked now, before we reschedule the message, in case this message is
     // already at the beginning of the queue.
-    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.begin()->mWhenUs;
+    bool shouldAwakeLoop = mEventQueue.empty() || whenUs < mEventQueue.top().mWhenUs;
 
     // Erase any previously-posted event with this token.
-    for (auto i = mEventQueue.begin(); i != mEventQueue.end();) {
-        if (i->mToken == token) {
-            i = mEventQueue.erase(i);
-        } else {
-            ++i;
-        }
-    }
-
-    // Find the insertion point for the rescheduled message.
-    List<Event>::iterator i = mEventQueue.begin();
-    while (i != mEventQueue.end() && i->mWhenUs <= whenUs) {
-        ++i;
-    }
+    mEventQueue.eraseToken(token);
 
     Event event;
     event.mWhenUs = whenUs;
     event.mMessage = msg;
     event.mToken = token;
-    mEventQueue.insert(i, event);
+    mEventQueue.push(event);
 
     // If we rescheduled the event to be earlier than the first event, then we need to wake up the
     // looper earlier than it was previously scheduled to be woken up. Otherwise, it can sleep until
@@ -250,6 +290,7 @@ status_t ALooper::postUnique(const sp<AMessage> &msg, const sp<RefBase> &token,
 bool ALooper::loop() {
 
     Event event;
+    std::vector<sp<AMessage>> batch;
 
     {
         Mutex::Autolock autoLock(mLock);
@@ -260,7 +301,7 @@ bool ALooper::loop() {
             mQueueChangedCondition.wait(mLock);
             return true;
         }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+        int64_t whenUs = mEventQueue.top().mWhenUs;
         int64_t nowUs = getNowUs();
 
         if (whenUs > nowUs) {
@@ -273,11 +314,38 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        mEventQueue.pop(&event);
+
+        // Take the messages that are due for the same batching handler along.
+        const handler_id target = event.mMessage->mTarget;
+        if (!mBatchedHandlers.empty() && mBatchedHandlers.count(target) != 0) {
+            while (!mEventQueue.empty()
+                    && mEventQueue.top().mWhenUs <= nowUs
+                    && mEventQueue.top().mMessage->mTarget == target
+                    && batch.size() < kMaxBatchSize) {
+                if (batch.empty()) {
+                    batch.push_back(std::move(event.mMessage));
+                }
+                Event next;
+                mEventQueue.pop(&next);
+                batch.push_back(std::move(next.mMessage));
+            }
+            mBatchedCount.fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+        mDeliveredCount.fetch_add(batch.empty() ? 1 : batch.size(), std::memory_order_relaxed);
     }
 
-    event.mMessage->deliver();
+    if (batch.empty()) {
+        event.mMessage->deliver();
+    } else {
+        sp<AHandler> handler = batch.front()->mHandler.promote();
+        if (handler == NULL) {
+            ALOGW("failed to deliver %zu messages as target handler %d is gone.",
+                    batch.size(), batch.front()->mTarget);
+        } else {
+            handler->deliverMessages(batch);
+        }
+    }
 
     // NOTE: It's important to note that at this point our "ALooper" object
     // may no longer exist (its final reference may have gone away while
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ALooperEventQueue"
+
+#include <media/stagefright/foundation/ADebug.h>
+
+#include "ALooperEventQueue.h"
+
+#include "AMessage.h"
+
+namespace android {
+
+ALooperEventQueue::ALooperEventQueue()
+    : mNextSeq(0) {
+}
+
+ALooperEventQueue::~ALooperEventQueue() {
+}
+
+const ALooperEventQueue::Event &ALooperEventQueue::top() const {
+    CHECK(!mHeap.empty());
+    return mHeap[0].mEvent;
+}
+
+void ALooperEventQueue::pop(Event *event) {
+    CHECK(!mHeap.empty());
+    removeAt(0, event);
+}
+
+void ALooperEventQueue::push(const Event &event) {
+    Entry entry;
+    entry.mEvent = event;
+    entry.mSeq = mNextSeq++;
+
+    if (event.mToken != nullptr) {
+        CHECK(mTokenIndex.find(event.mToken.get()) == mTokenIndex.end());
+    }
+
+    mHeap.emplace_back();
+    place(mHeap.size() - 1, std::move(entry));
+    siftUp(mHeap.size() - 1);
+}
+
+bool ALooperEventQueue::eraseToken(const sp<RefBase> &token) {
+    if (token == nullptr) {
+        return false;
+    }
+    auto it = mTokenIndex.find(token.get());
+    if (it == mTokenIndex.end()) {
+        return false;
+    }
+    removeAt(it->second, nullptr);
+    return true;
+}
+
+void ALooperEventQueue::clear() {
+    mHeap.clear();
+    mTokenIndex.clear();
+}
+
+void ALooperEventQueue::place(size_t index, Entry &&entry) {
+    mHeap[index] = std::move(entry);
+    RefBase *token = mHeap[index].mEvent.mToken.get();
+    if (token != nullptr) {
+        mTokenIndex[token] = index;
+    }
+}
+
+void ALooperEventQueue::siftUp(size_t index) {
+    if (index == 0) {
+        return;
+    }
+    Entry entry = std::move(mHeap[index]);
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!Before(entry, mHeap[parent])) {
+            break;
+        }
+        place(index, std::move(mHeap[parent]));
+        index = parent;
+    }
+    place(index, std::move(entry));
+}
+
+void ALooperEventQueue::siftDown(size_t index) {
+    const size_t n = mHeap.size();
+    Entry entry = std::move(mHeap[index]);
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && Before(mHeap[child + 1], mHeap[child])) {
+            ++child;
+        }
+        if (!Before(mHeap[child], entry)) {
+            break;
+        }
+        place(index, std::move(mHeap[child]));
+        index = child;
+    }
+    place(index, std::move(entry));
+}
+
+void ALooperEventQueue::removeAt(size_t index, Event *event) {
+    CHECK_LT(index, mHeap.size());
+
+    Entry removed = std::move(mHeap[index]);
+    if (removed.mEvent.mToken != nullptr) {
+        mTokenIndex.erase(removed.mEvent.mToken.get());
+    }
+
+    const size_t last = mHeap.size() - 1;
+    if (index != last) {
+        // Fill the hole with the last leaf and restore the heap property in whichever
+        // direction it was violated.
+        place(index, std::move(mHeap[last]));
+        mHeap.pop_back();
+        if (index > 0 && Before(mHeap[index], mHeap[(index - 1) / 2])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    } else {
+        mHeap.pop_back();
+    }
+
+    if (event != nullptr) {
+        *event = std::move(removed.mEvent);
+    }
+}
+
+}  // namespace android
@@ -141,6 +141,9 @@ void ALooperRoster::dump(int fd, const Vector<String16>& args) {
         sp<ALooper> looper = info.mLooper.promote();
         if (looper != NULL) {
             s.append(looper->getName());
+            const ALooper::Stats stats = looper->getStats();
+            s.appendFormat(" (%" PRIu64 " delivered, %" PRIu64 " batched, %" PRIu64
+                           " coalesced)", stats.mDelivered, stats.mBatched, stats.mCoalesced);
             sp<AHandler> handler = info.mHandler.promote();
             if (handler != NULL) {
                 bool deliveringMessages;
@@ -20,6 +20,8 @@
 
 #include <ctype.h>
 
+#include <algorithm>
+
 #include "AMessage.h"
 
 #include <log/log.h>
@@ -54,11 +56,13 @@ status_t AReplyToken::setReply(const sp<AMessage> &reply) {
 
 AMessage::AMessage(void)
     : mWhat(0),
-      mTarget(0) {
+      mTarget(0),
+      mInternedKeys(false) {
 }
 
 AMessage::AMessage(uint32_t what, const sp<const AHandler> &handler)
-    : mWhat(what) {
+    : mWhat(what),
+      mInternedKeys(false) {
     setTarget(handler);
 }
 
@@ -89,13 +93,29 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
 }
 
+void AMessage::useInternedKeys(size_t numItems) {
+    mInternedKeys = true;
+    mItems.reserve(std::min(numItems, (size_t)kMaxNumItems));
+    for (Item &item : mItems) {
+        if (!item.mNameInterned) {
+            const char *atom = AAtomizer::Atomize(item.mName);
+            item.freeName();
+            item.mName = atom;
+            item.mNameInterned = true;
+        }
+    }
+}
+
+bool AMessage::usesInternedKeys() const {
+    return mInternedKeys;
+}
+
 void AMessage::freeItemValue(Item *item) {
     switch (item->mType) {
         case kTypeString:
@@ -156,6 +176,10 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 #endif
     size_t i = 0;
     for (; i < mItems.size(); i++) {
+        // atoms are unique, so with interned keys an atomized |name| matches by address
+        if (mInternedKeys && mItems[i].mName == name) {
+            break;
+        }
         if (len != mItems[i].mNameLength) {
             continue;
         }
@@ -180,16 +204,29 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
 }
 
 // assumes item's name was uninitialized or NULL
-void AMessage::Item::setName(const char *name, size_t len) {
+void AMessage::Item::setName(const char *name, size_t len, bool interned) {
     mNameLength = len;
-    mName = new char[len + 1];
-    memcpy((void*)mName, name, len + 1);
+    mNameInterned = interned;
+    if (interned) {
+        mName = AAtomizer::Atomize(name);
+    } else {
+        mName = new char[len + 1];
+        memcpy((void*)mName, name, len + 1);
+    }
 }
 
-AMessage::Item::Item(const char *name, size_t len)
+void AMessage::Item::freeName() {
+    if (!mNameInterned) {
+        delete[] mName;
+    }
+    mName = nullptr;
+    mNameInterned = false;
+}
+
+AMessage::Item::Item(const char *name, size_t len, bool interned)
     : mType(kTypeInt32) {
-    // mName and mNameLength are initialized by setName
-    setName(name, len);
+    // mName, mNameLength and mNameInterned are initialized by setName
+    setName(name, len, interned);
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
@@ -204,7 +241,7 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         CHECK(mItems.size() < kMaxNumItems);
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
-        mItems.emplace_back(name, len);
+        mItems.emplace_back(name, len, mInternedKeys);
         item = &mItems[i];
     }
 
@@ -490,6 +527,7 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
+    msg->mInternedKeys = mInternedKeys;
     msg->mItems = mItems;
 
 #ifdef DUMP_STATS
@@ -505,7 +543,10 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        if (!from->mNameInterned) {
+            // interned names are shared atoms and were copied with the item
+            to->setName(from->mName, from->mNameLength, false /* interned */);
+        }
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -771,7 +812,7 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
             }
         }
 
-        item->setName(name, strlen(name));
+        item->setName(name, strlen(name), msg->mInternedKeys);
     }
 
     return msg;
@@ -1026,9 +1067,8 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (findItemIndex(name, len) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
-    mItems[index].setName(name, len);
+    mItems[index].freeName();
+    mItems[index].setName(name, len, mInternedKeys);
     return OK;
 }
 
@@ -1091,8 +1131,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
@@ -1100,6 +1139,7 @@ status_t AMessage::removeEntryAt(size_t index) {
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
         mItems[lastIndex].mName = nullptr;
+        mItems[lastIndex].mNameInterned = false;
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
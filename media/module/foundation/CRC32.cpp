@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CRC32.h"
+
+#include <array>
+
+#include <string.h>
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace android {
+
+namespace {
+
+constexpr uint64_t kPolynomial = 0x104c11db7;
+
+// Below this size the setup of the instruction based versions does not pay off.
+constexpr size_t kMinAcceleratedSize = 32;
+
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+// tables[0] is the usual byte at a time table, and tables[k] gives the CRC of a byte
+// followed by k zero bytes, so that 8 bytes are processed with independent lookups.
+constexpr Tables MakeTables() {
+    Tables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc << 1) ^ ((crc & 0x80000000) ? (uint32_t)kPolynomial : 0);
+        }
+        tables[0][i] = crc;
+    }
+    for (size_t k = 1; k < tables.size(); ++k) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            const uint32_t crc = tables[k - 1][i];
+            tables[k][i] = (crc << 8) ^ tables[0][crc >> 24];
+        }
+    }
+    return tables;
+}
+
+constexpr Tables kTables = MakeTables();
+
+uint32_t CRC32Slicing8(const uint8_t *p, size_t size, uint32_t crc) {
+    for (; size >= 8; p += 8, size -= 8) {
+        crc ^= (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        crc = kTables[7][crc >> 24] ^ kTables[6][(crc >> 16) & 0xff]
+                ^ kTables[5][(crc >> 8) & 0xff] ^ kTables[4][crc & 0xff]
+                ^ kTables[3][p[4]] ^ kTables[2][p[5]] ^ kTables[1][p[6]] ^ kTables[0][p[7]];
+    }
+    for (; size > 0; ++p, --size) {
+        crc = (crc << 8) ^ kTables[0][(crc >> 24) ^ *p];
+    }
+    return crc;
+}
+
+#if defined(__aarch64__)
+
+// The CRC32 instructions use the same polynomial, but take the bits least significant
+// first. Feed them every byte bit reversed in place, and reverse the CRC on the way in
+// and out.
+__attribute__((target("crc")))
+uint32_t CRC32Arm(const uint8_t *p, size_t size, uint32_t crc) {
+    crc = __rbit(crc);
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = __crc32d(crc, __builtin_bswap64(__rbitll(word)));
+    }
+    for (; size > 0; ++p, --size) {
+        crc = __crc32b(crc, __rbit(*p) >> 24);
+    }
+    return __rbit(crc);
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+// Returns x^n mod P.
+constexpr uint32_t XPowerModP(unsigned n) {
+    uint64_t r = 1;
+    for (unsigned i = 0; i < n; ++i) {
+        r <<= 1;
+        if (r & (1ull << 32)) {
+            r ^= kPolynomial;
+        }
+    }
+    return r;
+}
+
+// Folds the data 16 bytes at a time into a 128 bit remainder with carry-less
+// multiplications: for a block A followed by a block B, A * x^128 + B is congruent
+// to A_hi * (x^192 mod P) + A_lo * (x^128 mod P) + B. The CRC of the remainder is
+// the CRC of the data it was folded from, so the table finishes the computation.
+__attribute__((target("pclmul,ssse3")))
+uint32_t CRC32Pclmul(const uint8_t *p, size_t size, uint32_t crc) {
+    // Block bytes come first in the most significant bits.
+    const __m128i kByteReverse =
+            _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i kFold = _mm_set_epi64x(XPowerModP(192), XPowerModP(128));
+
+    __m128i remainder = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), kByteReverse);
+    remainder = _mm_xor_si128(remainder, _mm_set_epi32(crc, 0, 0, 0));
+    p += 16;
+    size -= 16;
+    for (; size >= 16; p += 16, size -= 16) {
+        const __m128i block = _mm_shuffle_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), kByteReverse);
+        remainder = _mm_xor_si128(
+                _mm_xor_si128(_mm_clmulepi64_si128(remainder, kFold, 0x11),
+                        _mm_clmulepi64_si128(remainder, kFold, 0x00)),
+                block);
+    }
+
+    uint8_t folded[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(folded),
+            _mm_shuffle_epi8(remainder, kByteReverse));
+    crc = CRC32Slicing8(folded, sizeof(folded), 0);
+    return CRC32Slicing8(p, size, crc);
+}
+
+#endif
+
+using CRC32Function = uint32_t (*)(const uint8_t *p, size_t size, uint32_t crc);
+
+CRC32Function SelectAccelerated() {
+#if defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        return CRC32Arm;
+    }
+#elif defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+        return CRC32Pclmul;
+    }
+#endif
+    return CRC32Slicing8;
+}
+
+}  // namespace
+
+uint32_t CRC32MPEG2(const void *data, size_t size, uint32_t crc) {
+    static const CRC32Function accelerated = SelectAccelerated();
+
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    if (size < kMinAcceleratedSize) {
+        return CRC32Slicing8(p, size, crc);
+    }
+    return accelerated(p, size, crc);
+}
+
+}  // namespace android
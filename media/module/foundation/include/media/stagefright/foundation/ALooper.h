@@ -18,7 +18,12 @@
 
 #define A_LOOPER_H_
 
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/ALooperEventQueue.h>
 #include <media/stagefright/foundation/AString.h>
 #include <utils/Errors.h>
 #include <utils/KeyedVector.h>
@@ -58,6 +63,14 @@ struct ALooper : public RefBase {
         return mName.c_str();
     }
 
+    // Message counters of this looper, which may be read from any thread.
+    struct Stats {
+        uint64_t mDelivered;    // messages delivered to handlers
+        uint64_t mBatched;      // of these, messages delivered in a batch of more than one
+        uint64_t mCoalesced;    // messages dropped for a later one with the same handler and what
+    };
+    Stats getStats() const;
+
 protected:
     // overridable by test harness
     virtual int64_t getNowUs();
@@ -66,19 +79,32 @@ protected:
 
 private:
     friend struct AMessage;       // post()
+    friend struct AHandler;       // setBatchedDelivery(), setCoalescible()
 
-    struct Event {
-        int64_t mWhenUs;
-        sp<AMessage> mMessage;
-        sp<RefBase> mToken;
-    };
+    // maximum number of messages delivered in one AHandler::onMessagesReceived() call
+    static constexpr size_t kMaxBatchSize = 32;
+
+    typedef ALooperEventQueue::Event Event;
 
     Mutex mLock;
     Condition mQueueChangedCondition;
 
     AString mName;
 
-    List<Event> mEventQueue;
+    ALooperEventQueue mEventQueue;
+
+    // handlers that receive due messages in batches
+    std::unordered_set<handler_id> mBatchedHandlers;
+    // tokens used to post coalescible messages uniquely, keyed by CoalescingKey(handler, what)
+    std::unordered_map<uint64_t, sp<RefBase>> mCoalescingTokens;
+
+    std::atomic<uint64_t> mDeliveredCount{0};
+    std::atomic<uint64_t> mBatchedCount{0};
+    std::atomic<uint64_t> mCoalescedCount{0};
+
+    static uint64_t CoalescingKey(handler_id handlerID, uint32_t what) {
+        return (uint64_t)(uint32_t)handlerID << 32 | what;
+    }
 
     struct LooperThread;
     sp<LooperThread> mThread;
@@ -110,6 +136,13 @@ private:
 
     // END --- methods used only by AMessage
 
+    // START --- methods used only by AHandler
+
+    void setBatchedDelivery(handler_id handlerID, bool enabled);
+    void setCoalescible(handler_id handlerID, uint32_t what, bool coalescible);
+
+    // END --- methods used only by AHandler
+
     bool loop();
 
     DISALLOW_EVIL_CONSTRUCTORS(ALooper);
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_LOOPER_EVENT_QUEUE_H_
+
+#define A_LOOPER_EVENT_QUEUE_H_
+
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include <media/stagefright/foundation/ABase.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+struct AMessage;
+
+// Time ordered event store used by ALooper.
+//
+// Events are kept in a binary min-heap ordered by (whenUs, insertion sequence), so events that
+// are due at the same time are still delivered in the order they were posted. Events posted with
+// a token are additionally indexed by that token so that postUnique() can replace the pending
+// event without scanning the queue.
+//
+// push(), pop() and eraseToken() are O(log n); top() is O(1).
+// This class is not thread safe; ALooper serializes access through its own lock.
+struct ALooperEventQueue {
+    struct Event {
+        int64_t mWhenUs;
+        sp<AMessage> mMessage;
+        sp<RefBase> mToken;
+    };
+
+    ALooperEventQueue();
+    ~ALooperEventQueue();
+
+    bool empty() const {
+        return mHeap.empty();
+    }
+
+    size_t size() const {
+        return mHeap.size();
+    }
+
+    // Returns the earliest event. The queue must not be empty.
+    const Event &top() const;
+
+    // Removes the earliest event and returns it in |event|. The queue must not be empty.
+    void pop(Event *event);
+
+    // Inserts |event| after all queued events with the same or earlier time.
+    // At most one event per non-null token may be queued; callers must eraseToken() first.
+    void push(const Event &event);
+
+    // Removes the queued event posted with |token|, if any. Returns true if an event was removed.
+    bool eraseToken(const sp<RefBase> &token);
+
+    void clear();
+
+private:
+    struct Entry {
+        Event mEvent;
+        uint64_t mSeq;
+    };
+
+    std::vector<Entry> mHeap;
+    std::unordered_map<RefBase *, size_t> mTokenIndex;
+    uint64_t mNextSeq;
+
+    static bool Before(const Entry &a, const Entry &b) {
+        return a.mEvent.mWhenUs < b.mEvent.mWhenUs
+                || (a.mEvent.mWhenUs == b.mEvent.mWhenUs && a.mSeq < b.mSeq);
+    }
+
+    void place(size_t index, Entry &&entry);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void removeAt(size_t index, Event *event);
+
+    DISALLOW_EVIL_CONSTRUCTORS(ALooperEventQueue);
+};
+
+}  // namespace android
+
+#endif  // A_LOOPER_EVENT_QUEUE_H_
@@ -100,6 +100,16 @@ struct AMessage : public RefBase {
     // removes all items
     void clear();
 
+    // Switches this message to interned keys. Item names are then stored as AAtomizer atoms
+    // shared across all messages instead of a heap copy per item, and lookups using an atomized
+    // name (see AAtomizer::Atomize()) resolve with a pointer compare. Items already present are
+    // converted, and storage for |numItems| items is reserved up front. Messages created by dup()
+    // inherit the mode.
+    // Only use this for messages with a bounded key set (e.g. codec formats): atoms are never
+    // released.
+    void useInternedKeys(size_t numItems = 0);
+    bool usesInternedKeys() const;
+
     void setInt32(const char *name, int32_t value);
     void setInt64(const char *name, int64_t value);
     void setSize(const char *name, size_t value);
@@ -309,16 +319,19 @@ private:
         } u;
         const char *mName;
         size_t      mNameLength;
+        bool        mNameInterned; // mName is an AAtomizer atom and is not owned
         Type mType;
-        void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
-        Item(const char *name, size_t length);
+        void setName(const char *name, size_t len, bool interned);
+        void freeName();
+        Item() : mName(nullptr), mNameLength(0), mNameInterned(false), mType(kTypeInt32) { }
+        Item(const char *name, size_t length, bool interned);
     };
 
     enum {
         kMaxNumItems = 256
     };
     std::vector<Item> mItems;
+    bool mInternedKeys;
 
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
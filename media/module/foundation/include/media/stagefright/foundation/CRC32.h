@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+// Computes the CRC-32/MPEG-2 of |size| bytes at |data|, the checksum of MPEG-2
+// PSI sections (ISO/IEC 13818-1 Annex A): polynomial 0x04c11db7, bits taken
+// most significant first, no final inversion. Pass a previous result as |crc|
+// to continue a checksum over more data.
+//
+// Uses the ARMv8 CRC32 or the x86 PCLMULQDQ instructions when the CPU has them.
+uint32_t CRC32MPEG2(const void *data, size_t size, uint32_t crc = 0xffffffff);
+
+}  // namespace android
+
+#endif  // CRC32_H_
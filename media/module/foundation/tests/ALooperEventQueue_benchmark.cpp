@@ -0,0 +1,133 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the ALooper heap based event store against the sorted List<Event>
+// it replaced, with a queue already holding state.range(0) delayed messages.
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/ALooperEventQueue.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <utils/List.h>
+
+using namespace android;
+
+typedef ALooperEventQueue::Event Event;
+
+namespace {
+
+// The pre-heap ALooper event store.
+struct ListEventQueue {
+    List<Event> mList;
+
+    void push(const Event &event) {
+        List<Event>::iterator it = mList.begin();
+        while (it != mList.end() && (*it).mWhenUs <= event.mWhenUs) {
+            ++it;
+        }
+        mList.insert(it, event);
+    }
+
+    void eraseToken(const sp<RefBase> &token) {
+        for (auto i = mList.begin(); i != mList.end();) {
+            if (i->mToken == token) {
+                i = mList.erase(i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    void pop(Event *event) {
+        *event = *mList.begin();
+        mList.erase(mList.begin());
+    }
+};
+
+struct HeapEventQueue {
+    ALooperEventQueue mQueue;
+
+    void push(const Event &event) { mQueue.push(event); }
+    void eraseToken(const sp<RefBase> &token) { mQueue.eraseToken(token); }
+    void pop(Event *event) { mQueue.pop(event); }
+};
+
+std::vector<int64_t> makeTimes(size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> dist(0, 10000000);
+    std::vector<int64_t> times(count);
+    for (int64_t &t : times) {
+        t = dist(rng);
+    }
+    return times;
+}
+
+template <typename Queue>
+void fill(Queue *queue, const sp<AMessage> &msg, const std::vector<int64_t> &times) {
+    for (int64_t t : times) {
+        queue->push(Event{t, msg, nullptr});
+    }
+}
+
+}  // namespace
+
+// One post() followed by one dequeue from the head, at a steady queue depth.
+template <typename Queue>
+static void BM_PostAndDequeue(benchmark::State& state) {
+    const size_t depth = state.range(0);
+    const std::vector<int64_t> times = makeTimes(depth + 1024);
+    sp<AMessage> msg = new AMessage();
+    Queue queue;
+    fill(&queue, msg, std::vector<int64_t>(times.begin(), times.begin() + depth));
+
+    size_t i = depth;
+    Event event;
+    while (state.KeepRunning()) {
+        queue.push(Event{times[i], msg, nullptr});
+        queue.pop(&event);
+        benchmark::DoNotOptimize(event.mWhenUs);
+        i = (i + 1 < times.size()) ? i + 1 : depth;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Repeated postUnique() rescheduling of the same token within a populated queue.
+template <typename Queue>
+static void BM_PostUnique(benchmark::State& state) {
+    const size_t depth = state.range(0);
+    const std::vector<int64_t> times = makeTimes(depth + 1024);
+    sp<AMessage> msg = new AMessage();
+    sp<RefBase> token = new RefBase();
+    Queue queue;
+    fill(&queue, msg, std::vector<int64_t>(times.begin(), times.begin() + depth));
+
+    size_t i = depth;
+    while (state.KeepRunning()) {
+        queue.eraseToken(token);
+        queue.push(Event{times[i], msg, token});
+        i = (i + 1 < times.size()) ? i + 1 : depth;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_PostAndDequeue, ListEventQueue)->RangeMultiplier(4)->Range(4, 4096);
+BENCHMARK_TEMPLATE(BM_PostAndDequeue, HeapEventQueue)->RangeMultiplier(4)->Range(4, 4096);
+BENCHMARK_TEMPLATE(BM_PostUnique, ListEventQueue)->RangeMultiplier(4)->Range(4, 4096);
+BENCHMARK_TEMPLATE(BM_PostUnique, HeapEventQueue)->RangeMultiplier(4)->Range(4, 4096);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ALooperEventQueue_test"
+
+#include <gtest/gtest.h>
+#include <utils/RefBase.h>
+
+#include <list>
+#include <random>
+
+#include <media/stagefright/foundation/ALooperEventQueue.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+typedef ALooperEventQueue::Event Event;
+
+static Event makeEvent(int64_t whenUs, int32_t what, const sp<RefBase> &token = nullptr) {
+    Event event;
+    event.mWhenUs = whenUs;
+    event.mMessage = new AMessage(what, nullptr);
+    event.mToken = token;
+    return event;
+}
+
+// Reference implementation matching the sorted list ALooper used previously.
+struct ReferenceQueue {
+    std::list<Event> mList;
+
+    void push(const Event &event) {
+        auto it = mList.begin();
+        while (it != mList.end() && it->mWhenUs <= event.mWhenUs) {
+            ++it;
+        }
+        mList.insert(it, event);
+    }
+
+    void eraseToken(const sp<RefBase> &token) {
+        for (auto it = mList.begin(); it != mList.end();) {
+            if (it->mToken == token) {
+                it = mList.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+TEST(ALooperEventQueue_tests, popsInTimeOrder) {
+    ALooperEventQueue queue;
+    queue.push(makeEvent(30, 3));
+    queue.push(makeEvent(10, 1));
+    queue.push(makeEvent(20, 2));
+    EXPECT_EQ(3u, queue.size());
+
+    Event event;
+    for (int32_t what = 1; what <= 3; ++what) {
+        ASSERT_FALSE(queue.empty());
+        queue.pop(&event);
+        EXPECT_EQ(what, event.mMessage->what());
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(ALooperEventQueue_tests, keepsPostOrderForEqualTimes) {
+    ALooperEventQueue queue;
+    for (int32_t what = 0; what < 100; ++what) {
+        queue.push(makeEvent(42, what));
+    }
+    Event event;
+    for (int32_t what = 0; what < 100; ++what) {
+        queue.pop(&event);
+        EXPECT_EQ(what, event.mMessage->what());
+    }
+}
+
+TEST(ALooperEventQueue_tests, eraseTokenRemovesOnlyThatEvent) {
+    ALooperEventQueue queue;
+    sp<RefBase> token = new RefBase();
+    queue.push(makeEvent(10, 1));
+    queue.push(makeEvent(20, 2, token));
+    queue.push(makeEvent(30, 3));
+
+    EXPECT_TRUE(queue.eraseToken(token));
+    EXPECT_FALSE(queue.eraseToken(token));
+    EXPECT_FALSE(queue.eraseToken(nullptr));
+    ASSERT_EQ(2u, queue.size());
+
+    Event event;
+    queue.pop(&event);
+    EXPECT_EQ(1, event.mMessage->what());
+    queue.pop(&event);
+    EXPECT_EQ(3, event.mMessage->what());
+}
+
+TEST(ALooperEventQueue_tests, matchesSortedListOrder) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int64_t> whenDist(0, 50);
+    std::uniform_int_distribution<int> opDist(0, 9);
+
+    std::vector<sp<RefBase>> tokens;
+    for (int i = 0; i < 8; ++i) {
+        tokens.push_back(new RefBase());
+    }
+
+    ALooperEventQueue queue;
+    ReferenceQueue reference;
+    int32_t what = 0;
+    for (int i = 0; i < 5000; ++i) {
+        int op = opDist(rng);
+        if (op < 5) {
+            Event event = makeEvent(whenDist(rng), what++);
+            queue.push(event);
+            reference.push(event);
+        } else if (op < 8) {
+            const sp<RefBase> &token = tokens[rng() % tokens.size()];
+            queue.eraseToken(token);
+            reference.eraseToken(token);
+            Event event = makeEvent(whenDist(rng), what++, token);
+            queue.push(event);
+            reference.push(event);
+        } else if (!reference.mList.empty()) {
+            Event event;
+            queue.pop(&event);
+            EXPECT_EQ(reference.mList.front().mMessage, event.mMessage);
+            reference.mList.pop_front();
+        }
+        ASSERT_EQ(reference.mList.size(), queue.size());
+    }
+
+    while (!reference.mList.empty()) {
+        Event event;
+        queue.pop(&event);
+        EXPECT_EQ(reference.mList.front().mMessage, event.mMessage);
+        reference.mList.pop_front();
+    }
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures AMessage set/find/dup throughput for a codec-format sized message
+// (state.range(0) keys) with the default key copies and with interned keys.
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/AAtomizer.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+namespace {
+
+enum KeyMode {
+    kCopiedKeys,
+    kInternedKeys,
+};
+
+std::vector<std::string> makeKeyNames(size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) {
+        // similar lengths to real format keys, to defeat the length check
+        names.push_back("vendor.key-" + std::to_string(1000 + i));
+    }
+    return names;
+}
+
+// Keys as a caller would hold them: atoms in interned mode, plain strings otherwise.
+std::vector<const char *> makeKeys(const std::vector<std::string> &names, KeyMode mode) {
+    std::vector<const char *> keys;
+    for (const std::string &name : names) {
+        keys.push_back(mode == kInternedKeys ? AAtomizer::Atomize(name.c_str()) : name.c_str());
+    }
+    return keys;
+}
+
+sp<AMessage> makeMessage(const std::vector<const char *> &keys, KeyMode mode) {
+    sp<AMessage> msg = new AMessage;
+    if (mode == kInternedKeys) {
+        msg->useInternedKeys(keys.size());
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        msg->setInt32(keys[i], i);
+    }
+    return msg;
+}
+
+}  // namespace
+
+template <KeyMode MODE>
+static void BM_AMessageSet(benchmark::State& state) {
+    const std::vector<std::string> names = makeKeyNames(state.range(0));
+    const std::vector<const char *> keys = makeKeys(names, MODE);
+    while (state.KeepRunning()) {
+        sp<AMessage> msg = makeMessage(keys, MODE);
+        benchmark::DoNotOptimize(msg.get());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <KeyMode MODE>
+static void BM_AMessageFind(benchmark::State& state) {
+    const std::vector<std::string> names = makeKeyNames(state.range(0));
+    const std::vector<const char *> keys = makeKeys(names, MODE);
+    sp<AMessage> msg = makeMessage(keys, MODE);
+    int32_t value;
+    while (state.KeepRunning()) {
+        for (const char *key : keys) {
+            benchmark::DoNotOptimize(msg->findInt32(key, &value));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <KeyMode MODE>
+static void BM_AMessageDup(benchmark::State& state) {
+    const std::vector<std::string> names = makeKeyNames(state.range(0));
+    const std::vector<const char *> keys = makeKeys(names, MODE);
+    sp<AMessage> msg = makeMessage(keys, MODE);
+    while (state.KeepRunning()) {
+        sp<AMessage> copy = msg->dup();
+        benchmark::DoNotOptimize(copy.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_AMessageSet, kCopiedKeys)->Arg(8)->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_AMessageSet, kInternedKeys)->Arg(8)->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_AMessageFind, kCopiedKeys)->Arg(8)->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_AMessageFind, kInternedKeys)->Arg(8)->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_AMessageDup, kCopiedKeys)->Arg(8)->Arg(64)->Arg(256);
+BENCHMARK_TEMPLATE(BM_AMessageDup, kInternedKeys)->Arg(8)->Arg(64)->Arg(256);
+
+BENCHMARK_MAIN();
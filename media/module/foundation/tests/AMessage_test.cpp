@@ -17,10 +17,14 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AData_test"
 
+#include <future>
+#include <thread>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <utils/RefBase.h>
 
+#include <media/stagefright/foundation/AAtomizer.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
@@ -335,3 +339,194 @@ TEST(AMessage_tests, postUnique_withNullToken_returnsInvalidArgument) {
   sp<AMessage> msg = new AMessage(0, mockHandler);
   EXPECT_EQ(msg->postUnique(nullptr, 0), -EINVAL);
 }
+
+TEST(AMessage_tests, internedKeys) {
+  sp<AMessage> m1 = new AMessage();
+  m1->setInt32("before", 1);
+  m1->setString("name", "value");
+
+  m1->useInternedKeys(8);
+  EXPECT_TRUE(m1->usesInternedKeys());
+
+  // existing items are still found, with plain and atomized names
+  int32_t i32;
+  EXPECT_TRUE(m1->findInt32("before", &i32));
+  EXPECT_EQ(1, i32);
+  const char *atom = AAtomizer::Atomize("before");
+  EXPECT_TRUE(m1->findInt32(atom, &i32));
+  AMessage::Type type;
+  EXPECT_EQ(atom, m1->getEntryNameAt(0, &type));
+
+  m1->setInt64(AAtomizer::Atomize("after"), 2);
+  int64_t i64;
+  EXPECT_TRUE(m1->findInt64("after", &i64));
+  EXPECT_EQ(2, i64);
+  EXPECT_FALSE(m1->contains("missing"));
+
+  // overwriting through an equal but non-atomized name reuses the entry
+  char name[] = "after";
+  m1->setInt64(name, 3);
+  EXPECT_EQ(3u, m1->countEntries());
+  EXPECT_TRUE(m1->findInt64("after", &i64));
+  EXPECT_EQ(3, i64);
+
+  sp<AMessage> m2 = m1->dup();
+  EXPECT_TRUE(m2->usesInternedKeys());
+  AString s;
+  EXPECT_TRUE(m2->findString("name", &s));
+  EXPECT_EQ(AString("value"), s);
+
+  EXPECT_EQ(OK, m2->setEntryNameAt(m2->findEntryByName("name"), "renamed"));
+  EXPECT_TRUE(m2->contains("renamed"));
+  EXPECT_EQ(OK, m2->removeEntryByName("before"));
+  EXPECT_EQ(2u, m2->countEntries());
+  EXPECT_TRUE(m1->contains("name"));
+  EXPECT_TRUE(m1->contains("before"));
+}
+
+class BatchingHandler : public AHandler {
+public:
+    status_t enableBatching() { return setBatchedDelivery(true); }
+    status_t coalesce(uint32_t what) { return setCoalescible(what); }
+
+    std::vector<std::vector<sp<AMessage>>> mBatches;
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        mBatches.push_back({msg});
+    }
+
+    void onMessagesReceived(const std::vector<sp<AMessage>> &msgs) override {
+        mBatches.push_back(msgs);
+    }
+};
+
+TEST(AMessage_tests, requiresRegistrationForBatchingAndCoalescing) {
+  sp<BatchingHandler> handler = new BatchingHandler;
+  EXPECT_EQ(-ENOENT, handler->enableBatching());
+  EXPECT_EQ(-ENOENT, handler->coalesce('what'));
+}
+
+TEST(AMessage_tests, deliversDueMessagesInOneBatch) {
+  sp<BatchingHandler> handler = new BatchingHandler;
+  sp<BatchingHandler> otherHandler = new BatchingHandler;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->registerHandler(handler);
+  looper->registerHandler(otherHandler);
+  ASSERT_EQ(OK, handler->enableBatching());
+
+  std::vector<sp<AMessage>> msgs;
+  for (int32_t i = 0; i < 3; ++i) {
+    msgs.push_back(new AMessage(i, handler));
+    msgs.back()->post();
+  }
+  sp<AMessage> otherMsg = new AMessage(0, otherHandler);
+  otherMsg->post();
+  sp<AMessage> lastMsg = new AMessage(3, handler);
+  lastMsg->post();
+  sp<AMessage> delayedMsg = new AMessage(4, handler);
+  delayedMsg->post(100);
+
+  looper->start();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+  looper->stop();
+
+  // a message for another handler ends the batch, and the delayed message is not due
+  ASSERT_EQ(2u, handler->mBatches.size());
+  EXPECT_EQ(msgs, handler->mBatches[0]);
+  EXPECT_EQ(std::vector<sp<AMessage>>{lastMsg}, handler->mBatches[1]);
+  ASSERT_EQ(1u, otherHandler->mBatches.size());
+  EXPECT_EQ(otherMsg, otherHandler->mBatches[0][0]);
+
+  const ALooper::Stats stats = looper->getStats();
+  EXPECT_EQ(5u, stats.mDelivered);
+  EXPECT_EQ(3u, stats.mBatched);
+  EXPECT_EQ(0u, stats.mCoalesced);
+}
+
+// Blocks the looper on a 'blok' message until released, and replies to the messages
+// whose sender awaits a response.
+class BlockingHandler : public BatchingHandler {
+public:
+    std::promise<void> mBlocked;
+    std::promise<void> mRelease;
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        if (msg->what() == 'blok') {
+            mBlocked.set_value();
+            mRelease.get_future().wait();
+        }
+        sp<AReplyToken> replyID;
+        if (msg->senderAwaitsResponse(&replyID)) {
+            (new AMessage)->postReply(replyID);
+        }
+        BatchingHandler::onMessageReceived(msg);
+    }
+};
+
+TEST(AMessage_tests, doesNotCoalesceMessageAwaitingResponse) {
+  sp<BlockingHandler> handler = new BlockingHandler;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->registerHandler(handler);
+  ASSERT_EQ(OK, handler->coalesce('cols'));
+  looper->start();
+
+  // keep the looper thread busy so that the following messages stay queued
+  (new AMessage('blok', handler))->post();
+  handler->mBlocked.get_future().wait();
+
+  sp<AMessage> awaiting = new AMessage('cols', handler);
+  status_t err = UNKNOWN_ERROR;
+  std::thread sender([&awaiting, &err] {
+    sp<AMessage> response;
+    err = awaiting->postAndAwaitResponse(&response);
+  });
+  nanosleep(&millis100, nullptr); // just enough time for the sender to post
+  sp<AMessage> latest = new AMessage('cols', handler);
+  latest->post();
+
+  handler->mRelease.set_value();
+  sender.join();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+  looper->stop();
+
+  // the message awaiting a response is neither dropped nor replaced
+  EXPECT_EQ(OK, err);
+  ASSERT_EQ(3u, handler->mBatches.size());
+  EXPECT_EQ(awaiting, handler->mBatches[1][0]);
+  EXPECT_EQ(latest, handler->mBatches[2][0]);
+  EXPECT_EQ(0u, looper->getStats().mCoalesced);
+}
+
+TEST(AMessage_tests, deliversOnlyLatestCoalescibleMessage) {
+  sp<BatchingHandler> handler = new BatchingHandler;
+  sp<LooperWithSettableClock> looper = new LooperWithSettableClock();
+  looper->registerHandler(handler);
+  ASSERT_EQ(OK, handler->coalesce('cols'));
+
+  sp<AMessage> other = new AMessage('othr', handler);
+  sp<AMessage> latest;
+  for (int32_t i = 0; i < 4; ++i) {
+    latest = new AMessage('cols', handler);
+    latest->setInt32("index", i);
+    latest->post();
+    if (i == 1) {
+      other->post();
+    }
+  }
+
+  looper->start();
+  nanosleep(&millis100, nullptr); // just enough time for the looper thread to run
+  looper->stop();
+
+  // the surviving message takes the place of the last one posted
+  ASSERT_EQ(2u, handler->mBatches.size());
+  EXPECT_EQ(other, handler->mBatches[0][0]);
+  EXPECT_EQ(latest, handler->mBatches[1][0]);
+
+  const ALooper::Stats stats = looper->getStats();
+  EXPECT_EQ(2u, stats.mDelivered);
+  EXPECT_EQ(0u, stats.mBatched);
+  EXPECT_EQ(3u, stats.mCoalesced);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares CRC32MPEG2() against the byte at a time table loop that ATSParser and
+// MPEG2TSWriter used, over PSI section sized buffers of state.range(0) bytes.
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/CRC32.h>
+
+using namespace android;
+
+namespace {
+
+struct ByteTable {
+    uint32_t mTable[256];
+
+    ByteTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04c11db7 : 0);
+            }
+            mTable[i] = crc;
+        }
+    }
+
+    uint32_t crc32(const uint8_t *data, size_t size) const {
+        uint32_t crc = 0xffffffff;
+        for (size_t i = 0; i < size; ++i) {
+            crc = (crc << 8) ^ mTable[((crc >> 24) ^ data[i]) & 0xff];
+        }
+        return crc;
+    }
+};
+
+std::vector<uint8_t> makeData(size_t size) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> data(size);
+    for (uint8_t &byte : data) {
+        byte = dist(rng);
+    }
+    return data;
+}
+
+}  // namespace
+
+static void BM_CRC32ByteTable(benchmark::State& state) {
+    const std::vector<uint8_t> data = makeData(state.range(0));
+    const ByteTable table;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.crc32(data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void BM_CRC32MPEG2(benchmark::State& state) {
+    const std::vector<uint8_t> data = makeData(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CRC32MPEG2(data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// A PAT is 16 bytes, PMTs are typically up to a few hundred, and sections at most 4 KiB.
+BENCHMARK(BM_CRC32ByteTable)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK(BM_CRC32MPEG2)->RangeMultiplier(4)->Range(16, 4096);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "CRC32_test"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/stagefright/foundation/CRC32.h>
+
+namespace android {
+
+namespace {
+
+// The bit at a time definition.
+uint32_t ReferenceCRC32MPEG2(const uint8_t *data, size_t size, uint32_t crc = 0xffffffff) {
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+}  // namespace
+
+TEST(CRC32Test, CheckValue) {
+    // The check value of the CRC-32/MPEG-2 model.
+    EXPECT_EQ(0x0376e6e7u, CRC32MPEG2("123456789", 9));
+    EXPECT_EQ(0xffffffffu, CRC32MPEG2(nullptr, 0));
+}
+
+TEST(CRC32Test, ProgramAssociationSection) {
+    // A PAT with its CRC: the CRC over the whole section is 0.
+    const uint8_t kSection[] = {
+        0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        0x00, 0x01, 0xf0, 0x00, 0x2a, 0xb1, 0x04, 0xb2,
+    };
+    EXPECT_EQ(0x2ab104b2u, CRC32MPEG2(kSection, sizeof(kSection) - 4));
+    EXPECT_EQ(0u, CRC32MPEG2(kSection, sizeof(kSection)));
+}
+
+// Covers every size around the cutover to the accelerated versions and
+// unaligned starts, and continuing a CRC over several calls.
+TEST(CRC32Test, MatchesReference) {
+    std::minstd_rand gen(42);
+    std::uniform_int_distribution<int> dis(0, 255);
+    std::vector<uint8_t> data(4096 + 16);
+    for (uint8_t &byte : data) {
+        byte = dis(gen);
+    }
+
+    for (size_t offset = 0; offset < 16; ++offset) {
+        for (size_t size = 0; size <= 300; ++size) {
+            ASSERT_EQ(ReferenceCRC32MPEG2(&data[offset], size),
+                    CRC32MPEG2(&data[offset], size))
+                    << "offset " << offset << " size " << size;
+        }
+    }
+    for (size_t size : { 1021, 1024, 4093, 4096 }) {
+        EXPECT_EQ(ReferenceCRC32MPEG2(data.data(), size), CRC32MPEG2(data.data(), size))
+                << "size " << size;
+    }
+
+    const uint32_t expected = ReferenceCRC32MPEG2(data.data(), 1000);
+    for (size_t split : { 1, 17, 31, 32, 500, 999 }) {
+        EXPECT_EQ(expected,
+                CRC32MPEG2(&data[split], 1000 - split, CRC32MPEG2(data.data(), split)))
+                << "split " << split;
+    }
+}
+
+}  // namespace android
@@ -33,6 +33,8 @@
 #include <media/cas/DescramblerAPI.h>
 #include <media/hardware/CryptoAPI.h>
 
+#include <algorithm>
+
 #include <inttypes.h>
 #include <netinet/in.h>
 
@@ -42,6 +44,61 @@
 
 namespace android {
 
+// An access unit that refers to bytes already consumed from an ElementaryStreamQueue's
+// buffer. It keeps that buffer alive, which stops appendData() from reusing the bytes.
+struct SharedAccessUnit : public ABuffer {
+    SharedAccessUnit(const sp<ABuffer> &buffer, size_t size)
+        : ABuffer(buffer->data(), size),
+          mBuffer(buffer) {
+    }
+
+private:
+    const sp<ABuffer> mBuffer;
+
+    DISALLOW_EVIL_CONSTRUCTORS(SharedAccessUnit);
+};
+
+// Appends to the range of *buffer, which holds the data not yet consumed. The space
+// in front of the range is reclaimed by moving the data back to the start of the
+// buffer if this frees at least half of it. If a SharedAccessUnit still refers to the
+// buffer then only the data not yet consumed is copied into a new buffer, sized for
+// that data rather than for the old capacity, so that buffers kept alive by access
+// units do not grow with every generation.
+static void AppendToBuffer(sp<ABuffer> *buffer, const void *data, size_t size) {
+    static constexpr size_t kChunkSize = 65536;
+
+    size_t pendingSize = (*buffer == NULL ? 0 : (*buffer)->size());
+    if (*buffer == NULL
+            || (*buffer)->offset() + pendingSize + size > (*buffer)->capacity()) {
+        size_t neededSize = pendingSize + size;
+        const bool shared = *buffer != NULL && (*buffer)->getStrongCount() > 1;
+        if (*buffer != NULL && !shared && neededSize <= (*buffer)->capacity() / 2) {
+            memmove((*buffer)->base(), (*buffer)->data(), pendingSize);
+            (*buffer)->setRange(0, pendingSize);
+        } else {
+            if (shared) {
+                // Leave one chunk of room for the data appended before the next dequeue.
+                neededSize = ((neededSize + kChunkSize - 1) & ~(kChunkSize - 1)) + kChunkSize;
+            } else {
+                neededSize = (2 * neededSize + kChunkSize - 1) & ~(kChunkSize - 1);
+            }
+
+            ALOGV("resizing buffer to size %zu", neededSize);
+
+            sp<ABuffer> newBuffer = new ABuffer(neededSize);
+            if (*buffer != NULL) {
+                memcpy(newBuffer->data(), (*buffer)->data(), pendingSize);
+            }
+            newBuffer->setRange(0, pendingSize);
+
+            *buffer = newBuffer;
+        }
+    }
+
+    memcpy((*buffer)->data() + (*buffer)->size(), data, size);
+    (*buffer)->setRange((*buffer)->offset(), (*buffer)->size() + size);
+}
+
 ElementaryStreamQueue::ElementaryStreamQueue(Mode mode, uint32_t flags)
     : mMode(mode),
       mFlags(flags),
@@ -69,7 +126,7 @@ sp<MetaData> ElementaryStreamQueue::getFormat() {
 
 void ElementaryStreamQueue::clear(bool clearFormat) {
     if (mBuffer != NULL) {
-        mBuffer->setRange(0, 0);
+        consumeData(mBuffer->size());
     }
 
     mRangeInfos.clear();
@@ -1161,25 +1218,7 @@ status_t ElementaryStreamQueue::appendData(
         }
     }
 
-    size_t neededSize = (mBuffer == NULL ? 0 : mBuffer->size()) + size;
-    if (mBuffer == NULL || neededSize > mBuffer->capacity()) {
-        neededSize = (neededSize + 65535) & ~65535;
-
-        ALOGV("resizing buffer to size %zu", neededSize);
-
-        sp<ABuffer> buffer = new ABuffer(neededSize);
-        if (mBuffer != NULL) {
-            memcpy(buffer->data(), mBuffer->data(), mBuffer->size());
-            buffer->setRange(0, mBuffer->size());
-        } else {
-            buffer->setRange(0, 0);
-        }
-
-        mBuffer = buffer;
-    }
-
-    memcpy(mBuffer->data() + mBuffer->size(), data, size);
-    mBuffer->setRange(0, mBuffer->size() + size);
+    AppendToBuffer(&mBuffer, data, size);
 
     RangeInfo info;
     info.mLength = size;
@@ -1207,24 +1246,7 @@ void ElementaryStreamQueue::appendScrambledData(
         return;
     }
 
-    size_t neededSize = (mScrambledBuffer == NULL ? 0 : mScrambledBuffer->size()) + size;
-    if (mScrambledBuffer == NULL || neededSize > mScrambledBuffer->capacity()) {
-        neededSize = (neededSize + 65535) & ~65535;
-
-        ALOGI("resizing scrambled buffer to size %zu", neededSize);
-
-        sp<ABuffer> buffer = new ABuffer(neededSize);
-        if (mScrambledBuffer != NULL) {
-            memcpy(buffer->data(), mScrambledBuffer->data(), mScrambledBuffer->size());
-            buffer->setRange(0, mScrambledBuffer->size());
-        } else {
-            buffer->setRange(0, 0);
-        }
-
-        mScrambledBuffer = buffer;
-    }
-    memcpy(mScrambledBuffer->data() + mScrambledBuffer->size(), data, size);
-    mScrambledBuffer->setRange(0, mScrambledBuffer->size() + size);
+    AppendToBuffer(&mScrambledBuffer, data, size);
 
     ScrambledRangeInfo scrambledInfo;
     scrambledInfo.mLength = size;
@@ -1281,9 +1303,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     // range on mBuffer. Note that the leading clear bytes includes the
     // PES header portion, while mBuffer doesn't.
     if ((int32_t)leadingClearBytes > pesOffset) {
-        mBuffer->setRange(0, leadingClearBytes - pesOffset);
+        mBuffer->setRange(mBuffer->offset(),
+                std::min(leadingClearBytes - pesOffset, mBuffer->size()));
     } else {
-        mBuffer->setRange(0, 0);
+        mBuffer->setRange(mBuffer->offset(), 0);
     }
 
     // Try to parse formats, and if unavailable set up a dummy format.
@@ -1339,7 +1362,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
                 0, mCasSessionId.data(), mCasSessionId.size());
     }
 
-    mBuffer->setRange(0, 0);
+    consumeData(mBuffer->size());
 
     // copy into scrambled access unit
     sp<ABuffer> scrambledAccessUnit = ABuffer::CreateAsCopy(
@@ -1359,12 +1382,9 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     scrambledAccessUnit->meta()->setBuffer("encBytes", encSizes);
     scrambledAccessUnit->meta()->setInt32("pesOffset", pesOffset);
 
-    memmove(mScrambledBuffer->data(),
-            mScrambledBuffer->data() + scrambledLength,
+    mScrambledBuffer->setRange(mScrambledBuffer->offset() + scrambledLength,
             mScrambledBuffer->size() - scrambledLength);
 
-    mScrambledBuffer->setRange(0, mScrambledBuffer->size() - scrambledLength);
-
     ALOGV("[stream %d] dequeued scrambled AU: timeUs=%lld, size=%zu",
             mMode, (long long)timeUs, scrambledAccessUnit->size());
 
@@ -1384,16 +1404,9 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnit() {
         RangeInfo info = *mRangeInfos.begin();
         mRangeInfos.erase(mRangeInfos.begin());
 
-        sp<ABuffer> accessUnit = new ABuffer(info.mLength);
-        memcpy(accessUnit->data(), mBuffer->data(), info.mLength);
+        sp<ABuffer> accessUnit = consumeAccessUnit(info.mLength);
         accessUnit->meta()->setInt64("timeUs", info.mTimestampUs);
 
-        memmove(mBuffer->data(),
-                mBuffer->data() + info.mLength,
-                mBuffer->size() - info.mLength);
-
-        mBuffer->setRange(0, mBuffer->size() - info.mLength);
-
         if (mFormat == NULL) {
             mFormat = new MetaData;
             if (!MakeAVCCodecSpecificData(*mFormat, accessUnit->data(), accessUnit->size())) {
@@ -1473,19 +1486,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSOrDTSHD() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = consumeAccessUnit(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1527,19 +1532,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSUHD()
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = consumeAccessUnit(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1599,19 +1596,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitEAC3() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = consumeAccessUnit(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1663,18 +1652,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAC4() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = consumeAccessUnit(syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
-
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
     return accessUnit;
 }
 
@@ -1736,12 +1717,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         ptr[i] = ntohs(ptr[i]);
     }
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + 4 + payloadSize,
-            mBuffer->size() - 4 - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - 4 - payloadSize);
+    consumeData(4 + payloadSize);
 
     return accessUnit;
 }
@@ -1882,12 +1858,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
 
     int64_t timeUs = fetchTimestamp(offset);
 
-    sp<ABuffer> accessUnit = new ABuffer(offset);
-    memcpy(accessUnit->data(), mBuffer->data(), offset);
-
-    memmove(mBuffer->data(), mBuffer->data() + offset,
-            mBuffer->size() - offset);
-    mBuffer->setRange(0, mBuffer->size() - offset);
+    sp<ABuffer> accessUnit = consumeAccessUnit(offset);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
@@ -1937,6 +1908,16 @@ int64_t ElementaryStreamQueue::fetchTimestamp(
     return timeUs;
 }
 
+void ElementaryStreamQueue::consumeData(size_t size) {
+    mBuffer->setRange(mBuffer->offset() + size, mBuffer->size() - size);
+}
+
+sp<ABuffer> ElementaryStreamQueue::consumeAccessUnit(size_t size) {
+    sp<ABuffer> accessUnit = new SharedAccessUnit(mBuffer, size);
+    consumeData(size);
+    return accessUnit;
+}
+
 sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
     const uint8_t *data = mBuffer->data();
 
@@ -2072,11 +2053,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             const NALPosition &pos = nals.itemAt(nals.size() - 1);
             size_t nextScan = pos.nalOffset + pos.nalSize;
 
-            memmove(mBuffer->data(),
-                    mBuffer->data() + nextScan,
-                    mBuffer->size() - nextScan);
-
-            mBuffer->setRange(0, mBuffer->size() - nextScan);
+            consumeData(nextScan);
 
             int64_t timeUs = fetchTimestamp(nextScan);
             if (timeUs < 0LL) {
@@ -2145,7 +2122,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
                 header, &frameSize, &samplingRate, &numChannels,
                 &bitrate, &numSamples)) {
         ALOGE("Failed to get audio frame size");
-        mBuffer->setRange(0, 0);
+        consumeData(size);
         return NULL;
     }
 
@@ -2155,14 +2132,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
 
     unsigned layer = 4 - ((header >> 17) & 3);
 
-    sp<ABuffer> accessUnit = new ABuffer(frameSize);
-    memcpy(accessUnit->data(), data, frameSize);
-
-    memmove(mBuffer->data(),
-            mBuffer->data() + frameSize,
-            mBuffer->size() - frameSize);
-
-    mBuffer->setRange(0, mBuffer->size() - frameSize);
+    sp<ABuffer> accessUnit = consumeAccessUnit(frameSize);
 
     int64_t timeUs = fetchTimestamp(frameSize);
     if (timeUs < 0LL) {
@@ -2285,11 +2255,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
         currentStartCode = data[offset + 3];
 
         if (currentStartCode == 0xb3 && mFormat == NULL) {
-            memmove(mBuffer->data(), mBuffer->data() + offset, size - offset);
+            consumeData(offset);
+            data = mBuffer->data();
             size -= offset;
             (void)fetchTimestamp(offset);
             offset = 0;
-            mBuffer->setRange(0, size);
         }
 
         if ((prevStartCode == 0xb3 && currentStartCode != 0xb5)
@@ -2315,14 +2285,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
 
                 ALOGI("found MPEG2 video codec config (%d x %d)", width, height);
 
-                sp<ABuffer> csd = new ABuffer(offset);
-                memcpy(csd->data(), data, offset);
-
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                sp<ABuffer> csd = consumeAccessUnit(offset);
                 size -= offset;
                 (void)fetchTimestamp(offset);
                 offset = 0;
@@ -2358,14 +2321,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
             if (!sawPictureStart) {
                 sawPictureStart = true;
             } else {
-                sp<ABuffer> accessUnit = new ABuffer(offset);
-                memcpy(accessUnit->data(), data, offset);
-
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                sp<ABuffer> accessUnit = consumeAccessUnit(offset);
 
                 int64_t timeUs = fetchTimestamp(offset);
                 if (timeUs < 0LL) {
@@ -2557,12 +2513,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
                     offset += chunkSize;
 
-                    sp<ABuffer> accessUnit = new ABuffer(offset);
-                    memcpy(accessUnit->data(), data, offset);
-
-                    memmove(data, &data[offset], size - offset);
-                    size -= offset;
-                    mBuffer->setRange(0, size);
+                    sp<ABuffer> accessUnit = consumeAccessUnit(offset);
 
                     int64_t timeUs = fetchTimestamp(offset);
                     if (timeUs < 0LL) {
@@ -2598,10 +2549,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
         if (discard) {
             (void)fetchTimestamp(offset);
-            memmove(data, &data[offset], size - offset);
+            consumeData(offset);
+            data = mBuffer->data();
             size -= offset;
             offset = 0;
-            mBuffer->setRange(0, size);
         } else {
             offset += chunkSize;
         }
@@ -2628,13 +2579,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMetadata() {
         return NULL;
     }
 
-    sp<ABuffer> accessUnit = new ABuffer(size);
     int64_t timeUs = fetchTimestamp(size);
+    sp<ABuffer> accessUnit = consumeAccessUnit(size);
     accessUnit->meta()->setInt64("timeUs", timeUs);
 
-    memcpy(accessUnit->data(), mBuffer->data(), size);
-    mBuffer->setRange(0, 0);
-
     if (mFormat == NULL) {
         mFormat = new MetaData;
         mFormat->setCString(kKeyMIMEType, MEDIA_MIMETYPE_DATA_TIMED_ID3);
@@ -122,6 +122,20 @@ struct ATSParser : public RefBase {
     status_t feedTSPacket(
             const void *data, size_t size, SyncEvent *event = NULL);
 
+    // Feed count consecutive TS packets into the parser. The result is the
+    // same as feeding them one by one to feedTSPacket(), but the packet
+    // headers are decoded directly and the stream of the previous packet is
+    // reused for runs of packets with the same PID.
+    //
+    // If event is not NULL, it goes in uninitialized with the start offset of
+    // the first packet, and parsing stops after the packet that initializes
+    // it. Parsing also stops after the first packet that fails. numParsed,
+    // if not NULL, is set to the number of packets fed, including that last
+    // one.
+    status_t feedTSPackets(
+            const void *data, size_t count, SyncEvent *event = NULL,
+            size_t *numParsed = NULL);
+
     void signalDiscontinuity(
             DiscontinuityType type, const sp<AMessage> &extra);
 
@@ -192,6 +206,7 @@ private:
     struct Stream;
     struct PSISection;
     struct CasManager;
+    struct StreamCache;
     struct CADescriptor {
         CADescriptor() : mPID(0), mSystemID(-1) {}
         unsigned mPID;
@@ -251,6 +266,14 @@ private:
     // see feedTSPacket().
     status_t parseTS(ABitReader *br, SyncEvent *event);
 
+    // see feedTSPackets().
+    status_t parseTSPacket(
+            const uint8_t *packet, SyncEvent *event, StreamCache *cache);
+
+    // Returns the stream that parsePID() would pass packets of this PID to,
+    // or NULL if they go elsewhere.
+    sp<Stream> findStream(unsigned PID);
+
     void updatePCR(unsigned PID, uint64_t PCR, uint64_t byteOffsetFromStart);
 
     uint64_t mPCR[2];
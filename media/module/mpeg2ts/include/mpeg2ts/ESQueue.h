@@ -102,6 +102,9 @@ private:
     uint32_t mFlags;
     bool mEOSReached;
 
+    // The range of mBuffer holds the data not yet dequeued. The bytes before its offset
+    // may still be referenced by dequeued access units, so they are only reclaimed by
+    // appendData(), and only once no access unit refers to mBuffer any more.
     sp<ABuffer> mBuffer;
     List<RangeInfo> mRangeInfos;
 
@@ -137,6 +140,13 @@ private:
             int32_t *pesOffset = NULL,
             int32_t *pesScramblingControl = NULL);
 
+    // drops the first "size" bytes of mBuffer without moving the remaining data.
+    void consumeData(size_t size);
+
+    // returns the first "size" bytes of mBuffer as an access unit that shares
+    // mBuffer's storage instead of copying it, and consumes them.
+    sp<ABuffer> consumeAccessUnit(size_t size);
+
     sp<ABuffer> dequeueScrambledAccessUnit();
 
     DISALLOW_EVIL_CONSTRUCTORS(ElementaryStreamQueue);
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/CRC32.h>
+#include <mpeg2ts/AnotherPacketSource.h>
+#include <mpeg2ts/ATSParser.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kTSPacketSize = 188;
+constexpr unsigned kPMTPID = 0x100;
+constexpr unsigned kVideoPID = 0x101;
+constexpr unsigned kAudioPID = 0x102;
+constexpr size_t kFrameCount = 120;        // 2 seconds at 60 fps
+constexpr size_t kIDRInterval = 30;
+constexpr int64_t kVideoFrameTicks = 1500; // 60 fps in 90 kHz ticks
+constexpr int64_t kAudioFrameTicks = 1920; // 1024 samples at 48 kHz in 90 kHz ticks
+constexpr size_t kAudioFrameSize = 384;
+constexpr size_t kPacketsPerDrain = 64;
+
+// Writes the RBSP of an H.264 parameter set.
+class BitWriter {
+public:
+    void putBits(uint32_t value, size_t count) {
+        while (count-- > 0) {
+            if (mBitCount % 8 == 0) {
+                mData.push_back(0);
+            }
+            mData.back() |= ((value >> count) & 1) << (7 - mBitCount % 8);
+            ++mBitCount;
+        }
+    }
+
+    void putUE(uint32_t value) {
+        size_t length = 0;
+        while ((value + 1) >> length) {
+            ++length;
+        }
+        putBits(0, length - 1);
+        putBits(value + 1, length);
+    }
+
+    // Appends the rbsp trailing bits and the emulation prevention bytes.
+    std::vector<uint8_t> finish() {
+        putBits(1, 1);
+        std::vector<uint8_t> escaped;
+        size_t zeros = 0;
+        for (uint8_t byte : mData) {
+            if (zeros >= 2 && byte <= 3) {
+                escaped.push_back(3);
+                zeros = 0;
+            }
+            escaped.push_back(byte);
+            zeros = byte == 0 ? zeros + 1 : 0;
+        }
+        return escaped;
+    }
+
+private:
+    std::vector<uint8_t> mData;
+    size_t mBitCount = 0;
+};
+
+// Packetizes PSI sections and PES packets into a transport stream.
+class TSWriter {
+public:
+    void writeSection(unsigned pid, std::vector<uint8_t> section) {
+        uint32_t crc = CRC32MPEG2(section.data(), section.size());
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            section.push_back(crc >> shift);
+        }
+        section.insert(section.begin(), 0);  // pointer_field
+        writePackets(pid, section);
+    }
+
+    void writePES(unsigned pid, uint8_t streamId, int64_t pts, const std::vector<uint8_t> &payload,
+            bool bounded) {
+        const size_t pesLength = bounded ? payload.size() + 8 : 0;
+        std::vector<uint8_t> pes = {
+            0x00, 0x00, 0x01, streamId,
+            (uint8_t)(pesLength >> 8), (uint8_t)pesLength,
+            0x80, 0x80, 0x05,  // PTS only
+            (uint8_t)(0x21 | ((pts >> 29) & 0x0e)),
+            (uint8_t)(pts >> 22),
+            (uint8_t)(((pts >> 14) & 0xfe) | 1),
+            (uint8_t)(pts >> 7),
+            (uint8_t)(((pts << 1) & 0xfe) | 1),
+        };
+        pes.insert(pes.end(), payload.begin(), payload.end());
+        writePackets(pid, pes);
+    }
+
+    const std::vector<uint8_t> &data() const { return mData; }
+
+private:
+    // Splits data into packets, padding the last one with adaptation field stuffing.
+    void writePackets(unsigned pid, const std::vector<uint8_t> &data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            const size_t chunk = std::min(data.size() - offset, kTSPacketSize - 4);
+            mData.push_back(0x47);
+            mData.push_back((offset == 0 ? 0x40 : 0x00) | (pid >> 8));
+            mData.push_back(pid & 0xff);
+            uint8_t &continuityCounter = mContinuityCounters[pid];
+            if (chunk < kTSPacketSize - 4) {
+                const size_t adaptationLength = kTSPacketSize - 5 - chunk;
+                mData.push_back(0x30 | continuityCounter);
+                mData.push_back(adaptationLength);
+                if (adaptationLength > 0) {
+                    mData.push_back(0x00);  // no adaptation field flags
+                    mData.insert(mData.end(), adaptationLength - 1, 0xff);
+                }
+            } else {
+                mData.push_back(0x10 | continuityCounter);
+            }
+            continuityCounter = (continuityCounter + 1) & 0x0f;
+            mData.insert(mData.end(), data.begin() + offset, data.begin() + offset + chunk);
+            offset += chunk;
+        }
+    }
+
+    std::vector<uint8_t> mData;
+    std::map<unsigned, uint8_t> mContinuityCounters;
+};
+
+void appendNAL(std::vector<uint8_t> *data, uint8_t header, const std::vector<uint8_t> &rbsp) {
+    static const uint8_t kStartCode[] = { 0x00, 0x00, 0x00, 0x01 };
+    data->insert(data->end(), kStartCode, kStartCode + sizeof(kStartCode));
+    data->push_back(header);
+    data->insert(data->end(), rbsp.begin(), rbsp.end());
+}
+
+// 3840x2160 baseline profile parameter sets.
+std::vector<uint8_t> makeSPS() {
+    BitWriter bits;
+    bits.putBits(66, 8);  // profile_idc
+    bits.putBits(0xc0, 8);  // constraint_set0_flag, constraint_set1_flag
+    bits.putBits(51, 8);  // level_idc
+    bits.putUE(0);  // seq_parameter_set_id
+    bits.putUE(0);  // log2_max_frame_num_minus4
+    bits.putUE(2);  // pic_order_cnt_type
+    bits.putUE(1);  // max_num_ref_frames
+    bits.putBits(0, 1);  // gaps_in_frame_num_value_allowed_flag
+    bits.putUE(3840 / 16 - 1);  // pic_width_in_mbs_minus1
+    bits.putUE(2160 / 16 - 1);  // pic_height_in_map_units_minus1
+    bits.putBits(1, 1);  // frame_mbs_only_flag
+    bits.putBits(1, 1);  // direct_8x8_inference_flag
+    bits.putBits(0, 1);  // frame_cropping_flag
+    bits.putBits(0, 1);  // vui_parameters_present_flag
+    return bits.finish();
+}
+
+std::vector<uint8_t> makePPS() {
+    BitWriter bits;
+    bits.putUE(0);  // pic_parameter_set_id
+    bits.putUE(0);  // seq_parameter_set_id
+    bits.putBits(0, 2);  // entropy_coding_mode_flag, bottom_field_pic_order_in_frame_present_flag
+    bits.putUE(0);  // num_slice_groups_minus1
+    bits.putUE(0);  // num_ref_idx_l0_default_active_minus1
+    bits.putUE(0);  // num_ref_idx_l1_default_active_minus1
+    bits.putBits(0, 3);  // weighted_pred_flag, weighted_bipred_idc
+    bits.putUE(0);  // pic_init_qp_minus26
+    bits.putUE(0);  // pic_init_qs_minus26
+    bits.putUE(0);  // chroma_qp_index_offset
+    bits.putBits(4, 3);  // deblocking_filter_control_present_flag, constrained_intra_pred_flag,
+                         // redundant_pic_cnt_present_flag
+    return bits.finish();
+}
+
+// Slice data bytes are never zero, so that they contain no start code.
+std::vector<uint8_t> makeSliceData(size_t size, std::minstd_rand *gen) {
+    std::uniform_int_distribution<int> dis(1, 255);
+    std::vector<uint8_t> data(size);
+    data[0] = 0x88;  // first_mb_in_slice is 0
+    for (size_t i = 1; i < size; ++i) {
+        data[i] = dis(*gen);
+    }
+    return data;
+}
+
+std::vector<uint8_t> makeADTSFrame(std::minstd_rand *gen) {
+    std::uniform_int_distribution<int> dis(0, 255);
+    std::vector<uint8_t> frame = {
+        0xff, 0xf1,  // MPEG-4, no CRC
+        0x4c,  // AAC LC, 48 kHz
+        (uint8_t)(0x80 | (kAudioFrameSize >> 11)),  // stereo
+        (uint8_t)(kAudioFrameSize >> 3),
+        (uint8_t)(((kAudioFrameSize & 7) << 5) | 0x1f),
+        0xfc,
+    };
+    while (frame.size() < kAudioFrameSize) {
+        frame.push_back(dis(*gen));
+    }
+    return frame;
+}
+
+// Returns a program of H.264 video with videoFrameSize bytes per frame and AAC audio.
+std::vector<uint8_t> makeStream(size_t videoFrameSize) {
+    TSWriter writer;
+    writer.writeSection(0, {
+        0x00,  // table_id
+        0xb0, 0x0d,  // section_length
+        0x00, 0x01,  // transport_stream_id
+        0xc1, 0x00, 0x00,  // version_number, current_next_indicator, section numbers
+        0x00, 0x01, 0xe0 | (kPMTPID >> 8), kPMTPID & 0xff,
+    });
+    writer.writeSection(kPMTPID, {
+        0x02,  // table_id
+        0xb0, 0x17,  // section_length
+        0x00, 0x01,  // program_number
+        0xc1, 0x00, 0x00,  // version_number, current_next_indicator, section numbers
+        0xe0 | (kVideoPID >> 8), kVideoPID & 0xff,  // PCR_PID
+        0xf0, 0x00,  // program_info_length
+        0x1b, 0xe0 | (kVideoPID >> 8), kVideoPID & 0xff, 0xf0, 0x00,
+        0x0f, 0xe0 | (kAudioPID >> 8), kAudioPID & 0xff, 0xf0, 0x00,
+    });
+
+    const std::vector<uint8_t> sps = makeSPS();
+    const std::vector<uint8_t> pps = makePPS();
+    std::minstd_rand gen(42);
+    int64_t audioPts = 0;
+    for (size_t i = 0; i < kFrameCount; ++i) {
+        const int64_t videoPts = i * kVideoFrameTicks;
+        std::vector<uint8_t> frame;
+        appendNAL(&frame, 0x09, { 0xf0 });  // access unit delimiter
+        const bool idr = i % kIDRInterval == 0;
+        if (idr) {
+            appendNAL(&frame, 0x67, sps);
+            appendNAL(&frame, 0x68, pps);
+        }
+        appendNAL(&frame, idr ? 0x65 : 0x41, makeSliceData(videoFrameSize, &gen));
+        writer.writePES(kVideoPID, 0xe0, videoPts, frame, false /* bounded */);
+
+        for (; audioPts <= videoPts; audioPts += kAudioFrameTicks) {
+            writer.writePES(kAudioPID, 0xc0, audioPts, makeADTSFrame(&gen), true /* bounded */);
+        }
+    }
+    return writer.data();
+}
+
+// Dequeues the access units a player would read, returning how many there were.
+size_t drain(ATSParser *parser) {
+    size_t count = 0;
+    for (ATSParser::SourceType type : { ATSParser::VIDEO, ATSParser::AUDIO }) {
+        sp<AnotherPacketSource> source = parser->getSource(type);
+        if (source == nullptr) {
+            continue;
+        }
+        status_t finalResult;
+        sp<ABuffer> accessUnit;
+        while (source->hasBufferAvailable(&finalResult)
+                && source->dequeueAccessUnit(&accessUnit) == OK) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+// Args: bytes per video frame. 128 KiB frames at 60 fps are a 60 Mbps stream.
+static void BM_DemuxTS(benchmark::State& state) {
+    const std::vector<uint8_t> stream = makeStream(state.range(0));
+
+    size_t accessUnits = 0;
+    for (auto _ : state) {
+        ATSParser parser;
+        accessUnits = 0;
+        for (size_t offset = 0; offset < stream.size(); offset += kTSPacketSize) {
+            if (parser.feedTSPacket(&stream[offset], kTSPacketSize) != OK) {
+                state.SkipWithError("feedTSPacket failed");
+                return;
+            }
+            if ((offset / kTSPacketSize) % kPacketsPerDrain == 0) {
+                accessUnits += drain(&parser);
+            }
+        }
+        parser.signalEOS(ERROR_END_OF_STREAM);
+        accessUnits += drain(&parser);
+    }
+    if (accessUnits == 0) {
+        state.SkipWithError("no access units demuxed");
+        return;
+    }
+    state.counters["accessUnits"] = accessUnits;
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+// Same as BM_DemuxTS, feeding kPacketsPerDrain packets per call.
+static void BM_DemuxTSBatched(benchmark::State& state) {
+    const std::vector<uint8_t> stream = makeStream(state.range(0));
+    const size_t numPackets = stream.size() / kTSPacketSize;
+
+    size_t accessUnits = 0;
+    for (auto _ : state) {
+        ATSParser parser;
+        accessUnits = 0;
+        for (size_t packet = 0; packet < numPackets; packet += kPacketsPerDrain) {
+            const size_t count = std::min(kPacketsPerDrain, numPackets - packet);
+            if (parser.feedTSPackets(&stream[packet * kTSPacketSize], count) != OK) {
+                state.SkipWithError("feedTSPackets failed");
+                return;
+            }
+            accessUnits += drain(&parser);
+        }
+        parser.signalEOS(ERROR_END_OF_STREAM);
+        accessUnits += drain(&parser);
+    }
+    if (accessUnits == 0) {
+        state.SkipWithError("no access units demuxed");
+        return;
+    }
+    state.counters["accessUnits"] = accessUnits;
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+BENCHMARK(BM_DemuxTS)->Arg(4 << 10)->Arg(32 << 10)->Arg(128 << 10)->Arg(512 << 10);
+BENCHMARK(BM_DemuxTSBatched)->Arg(4 << 10)->Arg(32 << 10)->Arg(128 << 10)->Arg(512 << 10);
+
+BENCHMARK_MAIN();
@@ -22,8 +22,11 @@
 #include <stdint.h>
 #include <sys/stat.h>
 
+#include <vector>
+
 #include <datasource/FileSource.h>
 #include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/MetaDataBase.h>
 #include <media/stagefright/foundation/AUtils.h>
 #include <mpeg2ts/AnotherPacketSource.h>
@@ -216,6 +219,98 @@ TEST_P(Mpeg2tsUnitTest, MediaInfoTest) {
     }
 }
 
+struct DemuxedUnit {
+    ATSParser::SourceType type;
+    int64_t timeUs;
+    vector<uint8_t> data;
+};
+
+struct DemuxedSyncEvent {
+    off64_t offset;
+    int64_t timeUs;
+    ATSParser::SourceType type;
+};
+
+static void drainAccessUnits(ATSParser *parser, vector<DemuxedUnit> *units) {
+    static const ATSParser::SourceType kTypes[] = {ATSParser::VIDEO, ATSParser::AUDIO,
+                                                   ATSParser::META};
+    for (ATSParser::SourceType type : kTypes) {
+        if (!parser->hasSource(type)) continue;
+        sp<AnotherPacketSource> source = parser->getSource(type);
+        status_t finalResult;
+        sp<ABuffer> accessUnit;
+        while (source->hasBufferAvailable(&finalResult) &&
+               source->dequeueAccessUnit(&accessUnit) == OK) {
+            int64_t timeUs = -1;
+            accessUnit->meta()->findInt64("timeUs", &timeUs);
+            units->push_back({type, timeUs,
+                              vector<uint8_t>(accessUnit->data(),
+                                              accessUnit->data() + accessUnit->size())});
+        }
+    }
+}
+
+// feedTSPackets() must demux exactly like feeding the same packets one by one.
+TEST_P(Mpeg2tsUnitTest, BatchedFeedTest) {
+    vector<uint8_t> stream(mTotalPackets * kTSPacketSize);
+    ASSERT_EQ(mSource->readAt(0, stream.data(), stream.size()), (ssize_t)stream.size())
+            << "Failed to read the input file";
+
+    vector<DemuxedUnit> expectedUnits;
+    vector<DemuxedSyncEvent> expectedEvents;
+    {
+        ATSParser parser;
+        for (size_t i = 0; i < mTotalPackets; ++i) {
+            ATSParser::SyncEvent event(i * kTSPacketSize);
+            ASSERT_EQ(parser.feedTSPacket(&stream[i * kTSPacketSize], kTSPacketSize, &event),
+                      (status_t)OK);
+            if (event.hasReturnedData()) {
+                expectedEvents.push_back({event.getOffset(), event.getTimeUs(), event.getType()});
+            }
+        }
+        parser.signalEOS(ERROR_END_OF_STREAM);
+        drainAccessUnits(&parser, &expectedUnits);
+    }
+
+    vector<DemuxedUnit> units;
+    vector<DemuxedSyncEvent> events;
+    {
+        ATSParser parser;
+        size_t i = 0;
+        while (i < mTotalPackets) {
+            ATSParser::SyncEvent event(i * kTSPacketSize);
+            size_t numParsed = 0;
+            ASSERT_EQ(parser.feedTSPackets(&stream[i * kTSPacketSize], mTotalPackets - i, &event,
+                                           &numParsed),
+                      (status_t)OK);
+            ASSERT_GT(numParsed, 0u);
+            i += numParsed;
+            if (event.hasReturnedData()) {
+                events.push_back({event.getOffset(), event.getTimeUs(), event.getType()});
+            } else {
+                ASSERT_EQ(i, mTotalPackets) << "Stopped without a sync event";
+            }
+        }
+        parser.signalEOS(ERROR_END_OF_STREAM);
+        drainAccessUnits(&parser, &units);
+    }
+
+    ASSERT_EQ(events.size(), expectedEvents.size()) << "Sync event count mismatch";
+    for (size_t i = 0; i < events.size(); ++i) {
+        ASSERT_EQ(events[i].offset, expectedEvents[i].offset) << "Sync event " << i;
+        ASSERT_EQ(events[i].timeUs, expectedEvents[i].timeUs) << "Sync event " << i;
+        ASSERT_EQ(events[i].type, expectedEvents[i].type) << "Sync event " << i;
+    }
+
+    ASSERT_GT(expectedUnits.size(), 0u) << "No access units demuxed";
+    ASSERT_EQ(units.size(), expectedUnits.size()) << "Access unit count mismatch";
+    for (size_t i = 0; i < units.size(); ++i) {
+        ASSERT_EQ(units[i].type, expectedUnits[i].type) << "Access unit " << i;
+        ASSERT_EQ(units[i].timeUs, expectedUnits[i].timeUs) << "Access unit " << i;
+        ASSERT_EQ(units[i].data, expectedUnits[i].data) << "Access unit " << i;
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(
         infoTest, Mpeg2tsUnitTest,
         ::testing::Values(make_tuple("crowd_1920x1080_25fps_6700kbps_h264.ts", 0x01, 1),
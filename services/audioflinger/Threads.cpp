@@ -241,6 +241,19 @@ static const int kFastTrackMultiplierMax = 2;
 // The actual value to use, which can be specified per-device via property af.fast_track_multiplier.
 static int sFastTrackMultiplier = kFastTrackMultiplier;
 
+// Most worker threads that the normal mixer may use in addition to the mixer thread, see
+// AudioMixerBase::setParallelThreadCount(). The count is set per-device via property
+// af.mixer.parallel_threads, and parallel mixing is off by default.
+static const int kMixerParallelThreadsMax = 3;
+
+static size_t getMixerParallelThreadCount()
+{
+    static const size_t sCount = std::clamp(
+            property_get_int32("af.mixer.parallel_threads", 0 /* default_value */),
+            0, kMixerParallelThreadsMax);
+    return sCount;
+}
+
 // See Thread::readOnlyHeap().
 // Initially this heap is used to allocate client buffers for "fast" AudioRecord.
 // Eventually it will be the single buffer that FastCapture writes into via HAL read(),
@@ -625,6 +638,23 @@ const char* ThreadBase::threadTypeToString(ThreadBase::type_t type)
     }
 }
 
+// static
+const char* ThreadBase::threadLoopPhaseToString(ThreadLoopPhase phase)
+{
+    switch (phase) {
+    case PHASE_PREPARE_TRACKS:
+        return "prepareTracks";
+    case PHASE_MIX:
+        return "mix";
+    case PHASE_EFFECTS:
+        return "effects";
+    case PHASE_WRITE:
+        return "write";
+    default:
+        return "unknown";
+    }
+}
+
 ThreadBase::ThreadBase(const sp<IAfThreadCallback>& afThreadCallback, audio_io_handle_t id,
         type_t type, bool systemReady, bool isOut)
     :   Thread(false /*canCallJava*/),
@@ -1133,6 +1163,15 @@ void ThreadBase::dumpBase_l(int fd, const Vector<String16>& /* args */)
                 mLatencyMs.toString().c_str());
     }
 
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        const auto& histogram = mPhaseLatency[i];
+        if (histogram.getCount() > 0) {
+            dprintf(fd, "  Threadloop %s time histogram: %s\n",
+                    threadLoopPhaseToString(static_cast<ThreadLoopPhase>(i)),
+                    histogram.toString().c_str());
+        }
+    }
+
     if (mMonopipePipeDepthStats.getN() > 0) {
         dprintf(fd, "  Monopipe %s pipe depth stats: %s\n",
             isOutput() ? "write" : "read",
@@ -2087,6 +2126,16 @@ NO_THREAD_SAFETY_ANALYSIS
         item->setDouble(MM_PREFIX "monopipePipeDepthStats.std",
                         mMonopipePipeDepthStats.getStdDev());
     }
+    for (int i = 0; i < PHASE_COUNT; ++i) {
+        const auto& histogram = mPhaseLatency[i];
+        if (histogram.getCount() > 0) {
+            const std::string prefix = std::string(MM_PREFIX)
+                    + threadLoopPhaseToString(static_cast<ThreadLoopPhase>(i)) + "TimeUs.";
+            item->setInt64((prefix + "p50").c_str(), histogram.getPercentileUs(50));
+            item->setInt64((prefix + "p99").c_str(), histogram.getPercentileUs(99));
+            item->setInt64((prefix + "max").c_str(), histogram.getMaxNs() / 1000);
+        }
+    }
 
     item->selfrecord();
 }
@@ -4222,7 +4271,9 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 }
             }
             // mMixerStatusIgnoringFastTracks is also updated internally
+            const nsecs_t prepareBeginNs = systemTime();
             mMixerStatus = prepareTracks_l(&tracksToRemove);
+            mPhaseLatency[PHASE_PREPARE_TRACKS].add(systemTime() - prepareBeginNs);
 
             mActiveTracks.updatePowerState_l(this);
 
@@ -4285,7 +4336,9 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
             mCurrentWriteLength = 0;
             if (mMixerStatus == MIXER_TRACKS_READY) {
                 // threadLoop_mix() sets mCurrentWriteLength
+                const nsecs_t mixBeginNs = systemTime();
                 threadLoop_mix();
+                mPhaseLatency[PHASE_MIX].add(systemTime() - mixBeginNs);
             } else if ((mMixerStatus != MIXER_DRAIN_TRACK)
                         && (mMixerStatus != MIXER_DRAIN_ALL)) {
                 // threadLoop_sleepTime sets mSleepTimeUs to 0 if data
@@ -4372,7 +4425,8 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
             }
 
             // only process effects if we're going to write
-            if (mSleepTimeUs == 0 && mType != OFFLOAD) {
+            if (mSleepTimeUs == 0 && mType != OFFLOAD && !effectChains.isEmpty()) {
+                const nsecs_t effectsBeginNs = systemTime();
                 for (size_t i = 0; i < effectChains.size(); i ++) {
                     effectChains[i]->process_l();
                     // TODO: Write haptic data directly to sink buffer when mixing.
@@ -4397,6 +4451,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                                 AUDIO_FORMAT_PCM_FLOAT, mNormalFrameCount * mHapticChannelCount);
                     }
                 }
+                mPhaseLatency[PHASE_EFFECTS].add(systemTime() - effectsBeginNs);
             }
         }
         // Process effect chains for offloaded thread even if no audio
@@ -4488,6 +4543,7 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                     const int64_t lastIoBeginNs = systemTime();
                     ret = threadLoop_write();
                     const int64_t lastIoEndNs = systemTime();
+                    mPhaseLatency[PHASE_WRITE].add(lastIoEndNs - lastIoBeginNs);
                     if (ret < 0) {
                         mBytesRemaining = 0;
                     } else if (ret > 0) {
@@ -5108,6 +5164,8 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
             "mFrameCount=%zu, mNormalFrameCount=%zu",
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
+    // Design the common resampler filters here rather than on the fast mixer thread.
+    AudioResampler::preloadFilters(mSampleRate);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
 
     if (type == DUPLICATING) {
@@ -6463,6 +6521,7 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
         }
         if (status == NO_ERROR && reconfig) {
             readOutputParameters_l();
+            AudioResampler::preloadFilters(mSampleRate);
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
             for (const auto &track : mTracks) {
@@ -6491,6 +6550,8 @@ void MixerThread::dumpInternals_l(int fd, const Vector<String16>& args)
     PlaybackThread::dumpInternals_l(fd, args);
     dprintf(fd, "  Thread throttle time (msecs): %u\n", (uint32_t)mThreadThrottleTimeMs);
     dprintf(fd, "  AudioMixer tracks: %s\n", mAudioMixer->trackNames().c_str());
+    dprintf(fd, "  AudioMixer copies avoided per cycle: %zu\n",
+            mAudioMixer->getCopiesAvoidedPerCycle());
     dprintf(fd, "  Master mono: %s\n", mMasterMono ? "on" : "off");
     dprintf(fd, "  Master balance: %f (%s)\n", mMasterBalance.load(),
             (hasFastMixer() ? std::to_string(mFastMixer->getMasterBalance())
@@ -6547,6 +6608,10 @@ void MixerThread::cacheParameters_l()
 {
     PlaybackThread::cacheParameters_l();
 
+    // Called on this thread at start and after mAudioMixer is recreated, so that the
+    // mixer workers are created here and inherit its priority.
+    mAudioMixer->setParallelThreadCount(getMixerParallelThreadCount());
+
     // FIXME: Relaxed timing because of a certain device that can't meet latency
     // Should be reduced to 2x after the vendor fixes the driver issue
     // increase threshold again due to low power audio mode. The way this warning
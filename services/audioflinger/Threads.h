@@ -33,6 +33,7 @@
 #include <fastpath/FastMixer.h>
 #include <mediautils/Synchronization.h>
 #include <mediautils/ThreadSnapshot.h>
+#include <timing/LatencyHistogram.h>
 #include <timing/MonotonicFrameCounter.h>
 #include <utils/Log.h>
 
@@ -755,6 +756,18 @@ protected:
     audio_utils::Statistics<double> mIoJitterMs GUARDED_BY(mutex()) {0.995 /* alpha */};
     audio_utils::Statistics<double> mProcessTimeMs GUARDED_BY(mutex()) {0.995 /* alpha */};
 
+                // Per-phase threadLoop durations, to attribute underruns to a phase.
+                // Written only by the threadLoop, read lock-free by dump() and mediametrics.
+                enum ThreadLoopPhase {
+                    PHASE_PREPARE_TRACKS,
+                    PHASE_MIX,
+                    PHASE_EFFECTS,
+                    PHASE_WRITE,
+                    PHASE_COUNT,
+                };
+                static const char* threadLoopPhaseToString(ThreadLoopPhase phase);
+                std::array<audioflinger::LatencyHistogram, PHASE_COUNT> mPhaseLatency;
+
     // NO_THREAD_SAFETY_ANALYSIS  GUARDED_BY(mutex())
                 audio_utils::Statistics<double> mLatencyMs{0.995 /* alpha */};
                 audio_utils::Statistics<double> mMonopipePipeDepthStats{0.999 /* alpha */};
@@ -292,6 +292,7 @@ void FastMixer::onStateChange()
     const unsigned currentTrackMask = current->mTrackMask;
     dumpState->mTrackMask = currentTrackMask;
     dumpState->mNumTracks = popcount(currentTrackMask);
+    dumpState->mPushesCoalesced = mSQ.getPushesCoalesced();
     if (current->mFastTracksGen != mFastTracksGen) {
 
         // process removed tracks first to avoid running out of track names
@@ -73,6 +73,7 @@ struct FastMixerDumpState : FastThreadDumpState {
     uint32_t mSampleRate = 0;
     size_t   mFrameCount = 0;
     uint32_t mTrackMask = 0;      // mask of active tracks
+    uint32_t mPushesCoalesced = 0; // state queue pushes that overwrote a state not yet polled
     FastTrackDump   mTracks[FastMixerState::kMaxFastTracks];
 
     // For timestamp statistics.
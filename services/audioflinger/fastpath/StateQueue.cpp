@@ -33,8 +33,8 @@ void StateQueueObserverDump::dump(int fd)
 
 void StateQueueMutatorDump::dump(int fd)
 {
-    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u blockedSequence=%u\n",
-            mPushDirty, mPushAck, mBlockedSequence);
+    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u pushCoalesced=%u "
+            "blockedSequence=%u\n", mPushDirty, mPushAck, mPushCoalesced, mBlockedSequence);
 }
 #endif
 
@@ -42,15 +42,22 @@ void StateQueueMutatorDump::dump(int fd)
 
 template<typename T> const T* StateQueue<T>::poll()
 {
-    const T *next = (const T *) atomic_load_explicit(&mNext, memory_order_acquire);
+    // relaxed is sufficient here, as the exchange below is what acquires the state
+    if (!(atomic_load_explicit(&mNext, memory_order_relaxed) & kPending)) {
+        return mCurrent;
+    }
 
-    if (next != mCurrent) {
-        mAck = next;    // no additional barrier needed
-        mCurrent = next;
+    // take the pending state, which may be even newer than the one seen above,
+    // and hand our previous state back to the mutator
+    const T *next = (const T *) (atomic_exchange_explicit(&mNext, (uintptr_t) mPrevious,
+            memory_order_acq_rel) & ~kPending);
+    // there is no previous state on the first change, so release the slot that was
+    // reserved for current instead
+    mPrevious = mCurrent != nullptr ? mCurrent : &mStates[kN - 1];
+    mCurrent = next;
 #ifdef STATE_QUEUE_DUMP
-        mObserverDump->mStateChanges++;
+    mObserverDump->mStateChanges++;
 #endif
-    }
     return next;
 }
 
@@ -94,75 +101,46 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
         mMutatorDump->mPushDirty++;
 #endif
 
-        // wait for prior push to be acknowledged
-        if (mExpecting != nullptr) {
+        // publish, and take back either the state released by the observer,
+        // or our own prior push if the observer has not polled it yet
+        const uintptr_t prior = atomic_exchange_explicit(&mNext,
+                (uintptr_t) mMutating | kPending, memory_order_acq_rel);
+        if (prior & kPending) {
+            atomic_store_explicit(&mPushesCoalesced,
+                    atomic_load_explicit(&mPushesCoalesced, memory_order_relaxed) + 1,
+                    memory_order_relaxed);
 #ifdef STATE_QUEUE_DUMP
-            unsigned count = 0;
-#endif
-            for (;;) {
-                const T *ack = (const T *) mAck;    // no additional barrier needed
-                if (ack == mExpecting) {
-                    // unnecessary as we're about to rewrite
-                    //mExpecting = nullptr;
-                    break;
-                }
-                if (block == BLOCK_NEVER) {
-                    return false;
-                }
-#ifdef STATE_QUEUE_DUMP
-                if (count == 1) {
-                    mMutatorDump->mBlockedSequence++;
-                }
-                ++count;
-#endif
-                nanosleep(&req, nullptr);
-            }
-#ifdef STATE_QUEUE_DUMP
-            if (count > 1) {
-                mMutatorDump->mBlockedSequence++;
-            }
+            mMutatorDump->mPushCoalesced++;
 #endif
         }
 
-        // publish
-        atomic_store_explicit(&mNext, (uintptr_t)mMutating, memory_order_release);
-        mExpecting = mMutating;
-
-        // copy with circular wraparound
-        if (++mMutating >= &mStates[kN]) {
-            mMutating = &mStates[0];
-        }
-        *mMutating = *mExpecting;
+        // the observer can no longer see the state we took back, so continue mutating there
+        T *reclaimed = (T *) (prior & ~kPending);
+        *reclaimed = *mMutating;
+        mMutating = reclaimed;
         mIsDirty = false;
 
     }
 
     // optionally wait for this push or a prior push to be acknowledged
     if (block == BLOCK_UNTIL_ACKED) {
-        if (mExpecting != nullptr) {
-#ifdef STATE_QUEUE_DUMP
-            unsigned count = 0;
-#endif
-            for (;;) {
-                const T *ack = (const T *) mAck;    // no additional barrier needed
-                if (ack == mExpecting) {
-                    mExpecting = nullptr;
-                    break;
-                }
 #ifdef STATE_QUEUE_DUMP
-                if (count == 1) {
-                    mMutatorDump->mBlockedSequence++;
-                }
-                ++count;
+        unsigned count = 0;
 #endif
-                nanosleep(&req, nullptr);
-            }
+        while (atomic_load_explicit(&mNext, memory_order_acquire) & kPending) {
 #ifdef STATE_QUEUE_DUMP
-            if (count > 1) {
+            if (count == 1) {
                 mMutatorDump->mBlockedSequence++;
             }
+            ++count;
 #endif
+            nanosleep(&req, nullptr);
+        }
+#ifdef STATE_QUEUE_DUMP
+        if (count > 1) {
+            mMutatorDump->mBlockedSequence++;
         }
+#endif
     }
 
     return true;
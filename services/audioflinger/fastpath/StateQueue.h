@@ -58,12 +58,10 @@
 //    as is the case with fast mixer/normal mixer.
 // It is not a requirement to work well if the roles were reversed,
 // and the mutator were to run more frequently than the observer.
-// In this case, the mutator could get blocked waiting for a slot to fill up for
-// it to work with. This could be solved somewhat by increasing the depth of the queue, but it would
-// still limit the mutator to a finite number of changes before it would block.  A future
-// possibility, not implemented here, would be to allow the mutator to safely overwrite an already
-// pushed state. This could be done by the mutator overwriting mNext, but then being prepared to
-// read an mAck which is actually for the earlier mNext (since there is a race).
+// Even so, the mutator must never be blocked by a slow observer: during bursts of track creation
+// the normal mixer can push several states within one fast mixer period.  Rather than waiting for
+// a slot to free up, the mutator overwrites the state that it pushed earlier if the observer
+// has not picked it up yet.  Such a push is said to "coalesce" with the earlier one.
 
 // Solution:
 //  Let's call the fast mixer thread the "observer" and normal mixer thread the "mutator".
@@ -83,12 +81,19 @@
 //  starts execution after the mutator, there is a next state but no previous or current states.
 //  To solve this, we'll have the observer idle until there is a next state,
 //  and it will have to deal with the case where there is no previous state.
-//  The states are stored in a shared FIFO queue represented using a circular array.
-//  The observer polls for mutations, and receives a new state pointer after a
-//  a mutation is pushed onto the queue.  To the observer, the state pointers are
-//  effectively in random order, that is the observer should not do address
-//  arithmetic on the state pointers.  However to the mutator, the state pointers
-//  are in a definite circular order.
+//  The four states are stored in an array, and change roles as states are pushed and polled.
+//  The next state is handed over through a single atomic word, mNext, which holds a pointer to
+//  a state and a flag telling whether that state is pending, i.e. pushed and not yet polled.
+//  On push, the mutator atomically exchanges its mutating state into mNext as pending,
+//  and takes back whatever state mNext held:
+//      if that state was pending, the observer never saw it and the push coalesced;
+//      otherwise it is the state the observer released on its most recent poll.
+//  Either way it is no longer visible to the observer, so it becomes the new mutating state.
+//  On poll of a pending state, the observer exchanges its previous state into mNext as not pending.
+//  The new state becomes current, and the former current becomes previous.
+//  Neither side ever waits for the other, so push and poll are both wait-free.
+//  To the observer, the state pointers are effectively in random order, that is the observer
+//  should not do address arithmetic on the state pointers.
 
 #include "Configuration.h"
 
@@ -111,10 +116,12 @@ struct StateQueueObserverDump {
 };
 
 struct StateQueueMutatorDump {
-    StateQueueMutatorDump() : mPushDirty(0), mPushAck(0), mBlockedSequence(0) { }
+    StateQueueMutatorDump() : mPushDirty(0), mPushAck(0), mPushCoalesced(0), mBlockedSequence(0)
+            { }
     /*virtual*/ ~StateQueueMutatorDump() { }
     unsigned    mPushDirty;       // incremented each time push() is called with a dirty state
     unsigned    mPushAck;         // incremented each time push(BLOCK_UNTIL_ACKED) is called
+    unsigned    mPushCoalesced;   // incremented each time push() overwrites a pending state
     unsigned    mBlockedSequence; // incremented before and after each time that push()
                                   // blocks for more than one PUSH_BLOCK_ACK_NS;
                                   // if odd, then mutator is currently blocked inside push()
@@ -122,7 +129,7 @@ struct StateQueueMutatorDump {
 };
 #endif
 
-// manages a FIFO queue of states
+// manages a queue of states
 // marking as final to avoid derived classes as there are no virtuals.
 template<typename T> class StateQueue final {
 
@@ -153,23 +160,27 @@ public:
     void    end(bool didModify = true);
 
     // Push a new state, if any, out to the observer via the state queue.
-    // For BLOCK_NEVER, returns:
-    //      true if not dirty, or dirty and pushed successfully
-    //      false if dirty and not pushed because that would block; remains dirty
-    // For BLOCK_UNTIL_PUSHED and BLOCK_UNTIL_ACKED, always returns true.
+    // The push never waits for a slot: if the observer has not yet polled the previously pushed
+    // state, then that state is overwritten by this one, and the observer will skip it.
+    // Always returns true.
     // No-op if there are no pending modifications (not dirty), except
     //      for BLOCK_UNTIL_ACKED it will wait until a prior push has been acknowledged.
     // Must not be called in the middle of a mutation.
     enum block_t {
         BLOCK_NEVER,        // do not block
-        BLOCK_UNTIL_PUSHED, // block until there's a slot available for the push
-        BLOCK_UNTIL_ACKED,  // also block until the push is acknowledged by the observer
+        BLOCK_UNTIL_PUSHED, // same as BLOCK_NEVER, as a push no longer needs to wait for a slot
+        BLOCK_UNTIL_ACKED,  // block until the push is acknowledged by the observer
     };
     bool    push(block_t block = BLOCK_NEVER);
 
     // Return whether the current state is dirty (modified and not pushed).
     bool    isDirty() const { return mIsDirty; }
 
+    // Return the number of pushes that overwrote a state before the observer polled it.
+    // May be called from any thread.
+    uint32_t getPushesCoalesced() const
+            { return atomic_load_explicit(&mPushesCoalesced, memory_order_relaxed); }
+
 #ifdef STATE_QUEUE_DUMP
     // Register location of observer dump area
     void    setObserverDump(StateQueueObserverDump *dump)
@@ -181,20 +192,23 @@ public:
 #endif
 
 private:
-    static const unsigned kN = 4;       // values < 4 are not supported by this code
+    static const unsigned kN = 4;       // previous, current, next, and mutating
     T                 mStates[kN];      // written by mutator, read by observer
 
-    // "volatile" is meaningless with SMP, but here it indicates that we're using atomic ops
-    atomic_uintptr_t  mNext{}; // written by mutator to advance next, read by observer
-    volatile const T* mAck = nullptr;  // written by observer to acknowledge advance of next,
-                                       // read by mutator
+    // set in mNext when the state it points to has been pushed but not yet polled
+    static const uintptr_t kPending = 1;
+    static_assert(alignof(T) > kPending, "state pointers must leave room for kPending");
+
+    // exchanged by both mutator and observer, initially a state that neither of them holds
+    atomic_uintptr_t  mNext{(uintptr_t) &mStates[1]};
+    atomic_uint_least32_t mPushesCoalesced{}; // written by mutator, read by anyone
 
     // only used by observer
     const T*    mCurrent = nullptr;     // most recent value returned by poll()
+    const T*    mPrevious{&mStates[2]}; // released to the mutator on the next state change
 
     // only used by mutator
     T*          mMutating{&mStates[0]}; // where updates by mutator are done in place
-    const T*    mExpecting = nullptr;   // what the mutator expects mAck to be set to
     bool        mInMutation = false;    // whether we're currently in the middle of a mutation
     bool        mIsDirty = false;       // whether mutating state has been modified since last push
     bool        mIsInitialized = false; // whether mutating state has been initialized yet
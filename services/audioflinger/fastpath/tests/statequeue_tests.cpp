@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "statequeue_tests"
+
+#include "../FastMixer.h"
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace android;
+
+namespace {
+
+// Stamps a generation into fields at both ends of the state, so that a torn state is detected.
+void stamp(FastMixerState *state, int generation) {
+    state->mFastTracksGen = generation;
+    for (FastTrack &fastTrack : state->mFastTracks) {
+        fastTrack.mGeneration = generation;
+    }
+}
+
+// Returns the generation of the state, or -1 if the state is torn.
+int generationOf(const FastMixerState *state) {
+    for (const FastTrack &fastTrack : state->mFastTracks) {
+        if (fastTrack.mGeneration != state->mFastTracksGen) {
+            return -1;
+        }
+    }
+    return state->mFastTracksGen;
+}
+
+TEST(StateQueueTest, PollBeforePush) {
+    FastMixerStateQueue sq;
+    EXPECT_EQ(nullptr, sq.poll());
+    stamp(sq.begin(), 1);
+    sq.end();
+    EXPECT_EQ(nullptr, sq.poll());  // not pushed yet
+    ASSERT_TRUE(sq.push());
+    const FastMixerState *state = sq.poll();
+    ASSERT_NE(nullptr, state);
+    EXPECT_EQ(1, generationOf(state));
+    EXPECT_EQ(state, sq.poll());  // unchanged until the next push
+}
+
+TEST(StateQueueTest, PushOverwritesPendingState) {
+    FastMixerStateQueue sq;
+    for (int generation = 1; generation <= 10; ++generation) {
+        stamp(sq.begin(), generation);
+        sq.end();
+        ASSERT_TRUE(sq.push(FastMixerStateQueue::BLOCK_NEVER));
+    }
+    EXPECT_FALSE(sq.isDirty());
+    EXPECT_EQ(9u, sq.getPushesCoalesced());
+
+    const FastMixerState *state = sq.poll();
+    ASSERT_NE(nullptr, state);
+    EXPECT_EQ(10, generationOf(state));
+
+    // the mutator continues from the latest pushed state
+    FastMixerState *mutating = sq.begin();
+    EXPECT_EQ(10, generationOf(mutating));
+    sq.end(false /*didModify*/);
+}
+
+TEST(StateQueueTest, PreviousStateStaysValid) {
+    FastMixerStateQueue sq;
+    stamp(sq.begin(), 1);
+    sq.end();
+    sq.push();
+    const FastMixerState *previous = sq.poll();
+    for (int generation = 2; generation <= 20; ++generation) {
+        // several pushes per poll, so that states are overwritten and slots reused
+        for (int i = 0; i < 3; ++i) {
+            stamp(sq.begin(), generation);
+            sq.end();
+            sq.push();
+        }
+        const FastMixerState *current = sq.poll();
+        ASSERT_NE(previous, current);
+        EXPECT_EQ(generation, generationOf(current));
+        EXPECT_EQ(generation - 1, generationOf(previous));
+        previous = current;
+    }
+}
+
+// The mutator pushes as fast as it can while the observer polls as fast as it can.
+// The observer must never see a torn state, a state going backwards, or its previous
+// state being modified, and the mutator must never block.
+TEST(StateQueueTest, Stress) {
+    constexpr int kGenerations = 200000;
+    FastMixerStateQueue sq;
+    std::atomic<bool> failed{false};
+
+    std::thread observer([&] {
+        const FastMixerState *current = nullptr;
+        const FastMixerState *previous = nullptr;
+        int currentGeneration = 0;
+        int previousGeneration = 0;
+        while (currentGeneration < kGenerations && !failed) {
+            const FastMixerState *next = sq.poll();
+            if (next == nullptr || next == current) {
+                continue;
+            }
+            previous = current;
+            previousGeneration = currentGeneration;
+            current = next;
+            currentGeneration = generationOf(current);
+            if (currentGeneration <= previousGeneration
+                    || (previous != nullptr && generationOf(previous) != previousGeneration)) {
+                ADD_FAILURE() << "generation " << currentGeneration
+                        << " after " << previousGeneration;
+                failed = true;
+            }
+        }
+    });
+
+    for (int generation = 1; generation <= kGenerations && !failed; ++generation) {
+        stamp(sq.begin(), generation);
+        sq.end();
+        EXPECT_TRUE(sq.push(FastMixerStateQueue::BLOCK_NEVER));
+    }
+    observer.join();
+    EXPECT_FALSE(failed);
+    EXPECT_LT(sq.getPushesCoalesced(), static_cast<uint32_t>(kGenerations));
+}
+
+TEST(StateQueueTest, BlockUntilAcked) {
+    FastMixerStateQueue sq;
+    std::atomic<bool> done{false};
+    std::thread observer([&] {
+        while (!done) {
+            sq.poll();
+        }
+    });
+    for (int generation = 1; generation <= 100; ++generation) {
+        stamp(sq.begin(), generation);
+        sq.end();
+        EXPECT_TRUE(sq.push(FastMixerStateQueue::BLOCK_UNTIL_ACKED));
+    }
+    done = true;
+    observer.join();
+    EXPECT_EQ(0u, sq.getPushesCoalesced());
+}
+
+}  // namespace
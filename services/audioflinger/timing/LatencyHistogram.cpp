@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "LatencyHistogram"
+
+#include "LatencyHistogram.h"
+
+#include <android-base/stringprintf.h>
+
+namespace android::audioflinger {
+
+int64_t LatencyHistogram::getPercentileUs(double percentile) const {
+    std::array<uint64_t, kBuckets> counts{};
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] = getBucketCount(i);
+        total += counts[i];
+    }
+    if (total == 0) return 0;
+
+    // the rank of the sample at the percentile, counting from 1
+    const auto rank = std::max<uint64_t>(1,
+            static_cast<uint64_t>(std::clamp(percentile, 0., 100.) * 1e-2 * total + 0.5));
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < kBuckets - 1; ++i) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            return int64_t{1} << i;
+        }
+    }
+    return getMaxNs() / 1000;
+}
+
+std::string LatencyHistogram::toString() const {
+    std::string result = base::StringPrintf("n=%llu p50<%lld p99<%lld max=%lld us |",
+            (unsigned long long)getCount(), (long long)getPercentileUs(50),
+            (long long)getPercentileUs(99), (long long)(getMaxNs() / 1000));
+    for (size_t i = 0; i < kBuckets; ++i) {
+        const uint64_t count = getBucketCount(i);
+        if (count == 0) continue;
+        if (i < kBuckets - 1) {
+            result.append(base::StringPrintf(" <%lld:%llu",
+                    (long long)(int64_t{1} << i), (unsigned long long)count));
+        } else {
+            result.append(base::StringPrintf(" >=%lld:%llu",
+                    (long long)(int64_t{1} << (i - 1)), (unsigned long long)count));
+        }
+    }
+    return result;
+}
+
+}  // namespace android::audioflinger
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace android::audioflinger {
+
+/**
+ * LatencyHistogram
+ *
+ * A fixed-bucket histogram of durations, cheap enough to be always on in a threadLoop.
+ *
+ * Bucket 0 counts durations below 1 us, bucket i > 0 counts durations in [2^(i-1), 2^i) us,
+ * and the last bucket counts everything from 2^(kBuckets - 2) us (about 262 ms) on.
+ *
+ * This class is lock-free: add() must only be called by a single writer thread,
+ * and the getters may be called from any thread concurrently with add().
+ * A reader may see a count that is one sample ahead or behind another count.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 20;
+
+    /**
+     * Adds a duration to the histogram. Only to be called by the writer thread.
+     *
+     * \param durationNs the duration in nanoseconds; negative durations count as 0.
+     */
+    void add(int64_t durationNs) {
+        const uint64_t us = durationNs > 0 ? static_cast<uint64_t>(durationNs) / 1000 : 0;
+        const size_t bucket = us == 0
+                ? 0 : std::min<size_t>(64 - __builtin_clzll(us), kBuckets - 1);
+        // Single writer, so a plain load and store avoids the cost of a read-modify-write.
+        increment(mBuckets[bucket]);
+        increment(mCount);
+        if (durationNs > mMaxNs.load(std::memory_order_relaxed)) {
+            mMaxNs.store(durationNs, std::memory_order_relaxed);
+        }
+    }
+
+    /** Returns the total number of durations added. */
+    [[nodiscard]] uint64_t getCount() const { return mCount.load(std::memory_order_relaxed); }
+
+    /** Returns the number of durations added to bucket i. */
+    [[nodiscard]] uint64_t getBucketCount(size_t i) const {
+        return i < kBuckets ? mBuckets[i].load(std::memory_order_relaxed) : 0;
+    }
+
+    /** Returns the longest duration added, in nanoseconds, or 0 if none. */
+    [[nodiscard]] int64_t getMaxNs() const { return mMaxNs.load(std::memory_order_relaxed); }
+
+    /**
+     * Returns an upper bound in microseconds for the given percentile,
+     * the exclusive upper bound of the bucket that contains it.
+     * For the last bucket, the longest duration added is returned instead.
+     *
+     * \param percentile in the range [0, 100].
+     * \return the upper bound, or 0 if the histogram is empty.
+     */
+    [[nodiscard]] int64_t getPercentileUs(double percentile) const;
+
+    /** Returns a single line summary with the nonzero buckets, for dumpsys. */
+    [[nodiscard]] std::string toString() const;
+
+private:
+    static void increment(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, kBuckets> mBuckets{};
+    std::atomic<uint64_t> mCount{};
+    std::atomic<int64_t> mMaxNs{};
+};
+
+}  // namespace android::audioflinger
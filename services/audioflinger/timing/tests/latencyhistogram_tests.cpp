@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "latencyhistogram_tests"
+
+#include "../LatencyHistogram.h"
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace android::audioflinger;
+
+namespace {
+
+TEST(LatencyHistogramTest, Empty) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.getCount());
+    EXPECT_EQ(0, histogram.getMaxNs());
+    EXPECT_EQ(0, histogram.getPercentileUs(50));
+    EXPECT_EQ("n=0 p50<0 p99<0 max=0 us |", histogram.toString());
+}
+
+TEST(LatencyHistogramTest, Buckets) {
+    LatencyHistogram histogram;
+    histogram.add(-5);          // bucket 0
+    histogram.add(999);         // bucket 0, below 1 us
+    histogram.add(1'000);       // bucket 1, [1, 2) us
+    histogram.add(3'999);       // bucket 2, [2, 4) us
+    histogram.add(4'000);       // bucket 3, [4, 8) us
+    histogram.add(1'000'000);   // bucket 10, [512, 1024) us
+    histogram.add(10'000'000'000); // last bucket
+
+    EXPECT_EQ(7u, histogram.getCount());
+    EXPECT_EQ(2u, histogram.getBucketCount(0));
+    EXPECT_EQ(1u, histogram.getBucketCount(1));
+    EXPECT_EQ(1u, histogram.getBucketCount(2));
+    EXPECT_EQ(1u, histogram.getBucketCount(3));
+    EXPECT_EQ(1u, histogram.getBucketCount(10));
+    EXPECT_EQ(1u, histogram.getBucketCount(LatencyHistogram::kBuckets - 1));
+    EXPECT_EQ(0u, histogram.getBucketCount(LatencyHistogram::kBuckets));
+    EXPECT_EQ(10'000'000'000, histogram.getMaxNs());
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 98; ++i) {
+        histogram.add(5'000);   // [4, 8) us
+    }
+    histogram.add(600'000);     // [512, 1024) us
+    histogram.add(500'000'000); // last bucket
+
+    EXPECT_EQ(8, histogram.getPercentileUs(0));
+    EXPECT_EQ(8, histogram.getPercentileUs(50));
+    EXPECT_EQ(1024, histogram.getPercentileUs(99));
+    EXPECT_EQ(500'000, histogram.getPercentileUs(100));
+    EXPECT_EQ("n=100 p50<8 p99<1024 max=500000 us | <8:98 <1024:1 >=262144:1",
+            histogram.toString());
+}
+
+// One thread adds while another reads, as with a threadLoop and dumpsys.
+TEST(LatencyHistogramTest, ConcurrentReader) {
+    constexpr uint64_t kSamples = 100'000;
+    LatencyHistogram histogram;
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        uint64_t previous = 0;
+        while (!done) {
+            const uint64_t count = histogram.getCount();
+            EXPECT_GE(count, previous);
+            previous = count;
+            (void)histogram.toString();
+        }
+    });
+    for (uint64_t i = 0; i < kSamples; ++i) {
+        histogram.add(i * 10);
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(kSamples, histogram.getCount());
+    uint64_t total = 0;
+    for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+        total += histogram.getBucketCount(i);
+    }
+    EXPECT_EQ(kSamples, total);
+}
+
+}  // namespace
@@ -645,19 +645,23 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         if (mInFlightMap.size() == 0) {
             lines += "      None\n";
         } else {
-            for (size_t i = 0; i < mInFlightMap.size(); i++) {
-                InFlightRequest r = mInFlightMap.valueAt(i);
+            for (size_t i : mInFlightMap.sortedIndices()) {
+                const InFlightRequest& r = mInFlightMap.valueAt(i);
                 lines += fmt::sprintf("      Frame %d |  Timestamp: %" PRId64 ", metadata"
                         " arrived: %s, buffers left: %d\n", mInFlightMap.keyAt(i),
                         r.shutterTimestamp, r.haveResultMetadata ? "true" : "false",
                         r.numBuffersLeft);
             }
         }
+        write(fd, lines.c_str(), lines.size());
+        mSubmitToShutterLatency.dump(fd, "    Submit to shutter latency histogram:");
+        mShutterToResultLatency.dump(fd, "    Shutter to result latency histogram:");
+        mResultToBuffersLatency.dump(fd, "    Result to buffers latency histogram:");
         mInFlightLock.unlock();
     } else {
         lines += "      Failed to acquire In-flight lock!\n";
+        write(fd, lines.c_str(), lines.size());
     }
-    write(fd, lines.c_str(), lines.size());
 
     if (mRequestThread != NULL) {
         mRequestThread->dumpCaptureRequestLatency(fd,
@@ -2914,10 +2918,12 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
     std::lock_guard<std::mutex> l(mInFlightLock);
 
     ssize_t res;
-    res = mInFlightMap.add(frameNumber, InFlightRequest(numBuffers, resultExtras, hasInput,
+    InFlightRequest request(numBuffers, resultExtras, hasInput,
             hasAppCallback, minExpectedDuration, maxExpectedDuration, isFixedFps, physicalCameraIds,
             isStillCapture, isZslCapture, rotateAndCropAuto, autoframingAuto, cameraIdsWithZoom,
-            requestTimeNs, outputSurfaces));
+            requestTimeNs, outputSurfaces);
+    request.submitTimeNs = systemTime();
+    res = mInFlightMap.add(frameNumber, std::move(request));
     if (res < 0) return res;
 
     if (mInFlightMap.size() == 1) {
@@ -2947,6 +2953,25 @@ void Camera3Device::onInflightEntryRemovedLocked(nsecs_t duration) {
     mExpectedInflightDuration -= duration;
 }
 
+void Camera3Device::onInflightRequestCompletedLocked(const InFlightRequest& request) {
+    // Only successful requests go through every stage; failed ones would skew
+    // the histograms with whatever stage the error cut short.
+    if (request.requestStatus != OK || request.skipResultMetadata ||
+            request.submitTimeNs == 0 || request.shutterNotifiedTimeNs == 0 ||
+            request.resultNotifiedTimeNs == 0) {
+        return;
+    }
+
+    // Results and buffers may arrive before the shutter, in which case they
+    // are held back until it does; count such stages as taking no time.
+    nsecs_t shutterNs = request.shutterNotifiedTimeNs;
+    nsecs_t resultNs = std::max(shutterNs, request.resultNotifiedTimeNs);
+    nsecs_t buffersNs = std::max(resultNs, systemTime());
+    mSubmitToShutterLatency.add(request.submitTimeNs, shutterNs);
+    mShutterToResultLatency.add(shutterNs, resultNs);
+    mResultToBuffersLatency.add(resultNs, buffersNs);
+}
+
 void Camera3Device::checkInflightMapLengthLocked() {
     // Validation check - if we have too many in-flight frames with long total inflight duration,
     // something has likely gone wrong. This might still be legit only if application send in
@@ -2971,7 +2996,7 @@ void Camera3Device::onInflightMapFlushedLocked() {
 void Camera3Device::removeInFlightMapEntryLocked(int idx) {
     ATRACE_HFR_CALL();
     nsecs_t duration = mInFlightMap.valueAt(idx).maxExpectedDuration;
-    mInFlightMap.removeItemsAt(idx, 1);
+    mInFlightMap.removeItemAt(idx);
 
     onInflightEntryRemovedLocked(duration);
 }
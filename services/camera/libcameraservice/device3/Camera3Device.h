@@ -848,6 +848,7 @@ class Camera3Device :
     // Implements InflightRequestUpdateInterface
 
     void onInflightEntryRemovedLocked(nsecs_t duration) override;
+    void onInflightRequestCompletedLocked(const camera3::InFlightRequest& request) override;
     void checkInflightMapLengthLocked() override;
     void onInflightMapFlushedLocked() override;
 
@@ -1239,6 +1240,12 @@ class Camera3Device :
     int64_t                       mLastCompletedRegularFrameNumber = -1;
     int64_t                       mLastCompletedReprocessFrameNumber = -1;
     int64_t                       mLastCompletedZslFrameNumber = -1;
+    // Latency of the stages of successful requests: from submission to the
+    // shutter notification, to the final result metadata, to the last buffer.
+    static const int32_t          kStageLatencyBinSize = 10; // in ms
+    CameraLatencyHistogram        mSubmitToShutterLatency{kStageLatencyBinSize};
+    CameraLatencyHistogram        mShutterToResultLatency{kStageLatencyBinSize};
+    CameraLatencyHistogram        mResultToBuffersLatency{kStageLatencyBinSize};
     // End of mInFlightLock protection scope
 
     int mInFlightStatusId; // const after initialize
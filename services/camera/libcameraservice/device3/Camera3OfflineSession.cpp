@@ -249,6 +249,11 @@ void Camera3OfflineSession::onInflightEntryRemovedLocked(nsecs_t /*duration*/) {
     }
 }
 
+void Camera3OfflineSession::onInflightRequestCompletedLocked(
+        const camera3::InFlightRequest& /*request*/) {
+    // Intentional empty impl.
+}
+
 void Camera3OfflineSession::checkInflightMapLengthLocked() {
     // Intentional empty impl.
 }
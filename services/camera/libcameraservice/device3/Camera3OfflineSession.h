@@ -259,6 +259,7 @@ class Camera3OfflineSession :
 
     // InflightRequestUpdateInterface
     void onInflightEntryRemovedLocked(nsecs_t duration) override;
+    void onInflightRequestCompletedLocked(const camera3::InFlightRequest& request) override;
     void checkInflightMapLengthLocked() override;
     void onInflightMapFlushedLocked() override;
 
@@ -29,6 +29,8 @@ namespace android {
 
 namespace camera3 {
 
+    struct InFlightRequest;
+
     /**
      * Interfaces used by result/notification path shared between Camera3Device and
      * Camera3OfflineSession
@@ -76,6 +78,11 @@ namespace camera3 {
         // duration: the maxExpectedDuration of the removed entry
         virtual void onInflightEntryRemovedLocked(nsecs_t duration) = 0;
 
+        // Caller must hold the lock proctecting InflightRequestMap
+        // request: the entry about to be removed after all of its results,
+        // notifications and buffers arrived
+        virtual void onInflightRequestCompletedLocked(const InFlightRequest& request) = 0;
+
         virtual void checkInflightMapLengthLocked() = 0;
 
         virtual void onInflightMapFlushedLocked() = 0;
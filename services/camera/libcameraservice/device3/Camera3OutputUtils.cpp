@@ -494,7 +494,7 @@ void removeInFlightMapEntryLocked(CaptureOutputStates& states, int idx) {
     ATRACE_CALL();
     InFlightRequestMap& inflightMap = states.inflightMap;
     nsecs_t duration = inflightMap.valueAt(idx).maxExpectedDuration;
-    inflightMap.removeItemsAt(idx, 1);
+    inflightMap.removeItemAt(idx);
 
     states.inflightIntf.onInflightEntryRemovedLocked(duration);
 }
@@ -560,6 +560,7 @@ void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, int idx,
 
         sessionStatsBuilder.incResultCounter(request.skipResultMetadata);
 
+        states.inflightIntf.onInflightRequestCompletedLocked(request);
         removeInFlightMapEntryLocked(states, idx);
         ALOGVV("%s: removed frame %d from InFlightMap", __FUNCTION__, frameNumber);
     }
@@ -692,7 +693,8 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                                 // but we could still try and configure it for any future requests
                                 // that are still in flight. The assumption is that the physical
                                 // device id remains the same for the duration of the pending queue.
-                                for (size_t i = 0; i < states.inflightMap.size(); i++) {
+                                for (ssize_t i = states.inflightMap.firstIndex(); i >= 0;
+                                        i = states.inflightMap.nextIndex(i)) {
                                     auto &r = states.inflightMap.editValueAt(i);
                                     if (r.requestTimeNs >= request.requestTimeNs) {
                                         r.transform = transform;
@@ -769,6 +771,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                     request.collectedPartialResult);
             }
             request.haveResultMetadata = true;
+            request.resultNotifiedTimeNs = systemTime();
             request.errorBufStrategy = ERROR_BUF_RETURN_NOTIFY;
         }
 
@@ -1058,6 +1061,7 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
             }
 
             r.shutterTimestamp = msg.timestamp;
+            r.shutterNotifiedTimeNs = systemTime();
             if (msg.readout_timestamp_valid) {
                 r.resultExtras.hasReadoutTimestamp = true;
                 r.resultExtras.readoutTimestamp = msg.readout_timestamp;
@@ -1271,7 +1275,7 @@ void flushInflightRequests(FlushInflightReqStates& states) {
     std::vector<BufferToReturn> returnableBuffers{};
     { // First return buffers cached in inFlightMap
         std::lock_guard<std::mutex> l(states.inflightLock);
-        for (size_t idx = 0; idx < states.inflightMap.size(); idx++) {
+        for (size_t idx : states.inflightMap.sortedIndices()) {
             const InFlightRequest &request = states.inflightMap.valueAt(idx);
             collectReturnableOutputBuffers(
                 states.useHalBufManager, states.halBufManagedStreamIds,
@@ -121,6 +121,35 @@ static bool doesSettingsHaveMaxResolution(const CameraMetadata *settings) {
     return false;
 }
 
+// Maps the corners of all metering regions with non-zero weight in one call, stopping at the
+// first failure like mapping them one region at a time would
+template<typename MapFn>
+static status_t mapMeteringRegions(camera_metadata_entry_t e, MapFn map) {
+    std::vector<int32_t> coords;
+    coords.reserve(e.count / 5 * 4);
+    for (size_t j = 0; j < e.count; j += 5) {
+        int32_t weight = e.data.i32[j + 4];
+        if (weight == 0) {
+            continue;
+        }
+        coords.insert(coords.end(), e.data.i32 + j, e.data.i32 + j + 4);
+    }
+    if (coords.empty()) return OK;
+
+    status_t res = map(coords.data(), coords.size() / 2);
+
+    auto mapped = coords.begin();
+    for (size_t j = 0; j < e.count; j += 5) {
+        int32_t weight = e.data.i32[j + 4];
+        if (weight == 0) {
+            continue;
+        }
+        std::copy(mapped, mapped + 4, e.data.i32 + j);
+        mapped += 4;
+    }
+    return res;
+}
+
 bool DistortionMapper::calibrationValid() const {
     std::lock_guard<std::mutex> lock(mMutex);
     bool isValid =  mDistortionMapperInfo.mValidMapping;
@@ -145,14 +174,10 @@ status_t DistortionMapper::correctCaptureRequest(CameraMetadata *request) {
     if (e.count != 0 && e.data.u8[0] != ANDROID_DISTORTION_CORRECTION_MODE_OFF) {
         for (auto region : kMeteringRegionsToCorrect) {
             e = request->find(region);
-            for (size_t j = 0; j < e.count; j += 5) {
-                int32_t weight = e.data.i32[j + 4];
-                if (weight == 0) {
-                    continue;
-                }
-                res = mapCorrectedToRaw(e.data.i32 + j, 2, mapperInfo, /*clamp*/true);
-                if (res != OK) return res;
-            }
+            res = mapMeteringRegions(e, [&](int32_t *coordPairs, int coordCount) {
+                return mapCorrectedToRaw(coordPairs, coordCount, mapperInfo, /*clamp*/true);
+            });
+            if (res != OK) return res;
         }
         for (auto rect : kRectsToCorrect) {
             e = request->find(rect);
@@ -184,14 +209,10 @@ status_t DistortionMapper::correctCaptureResult(CameraMetadata *result) {
     if (e.count != 0 && e.data.u8[0] != ANDROID_DISTORTION_CORRECTION_MODE_OFF) {
         for (auto region : kMeteringRegionsToCorrect) {
             e = result->find(region);
-            for (size_t j = 0; j < e.count; j += 5) {
-                int32_t weight = e.data.i32[j + 4];
-                if (weight == 0) {
-                    continue;
-                }
-                res = mapRawToCorrected(e.data.i32 + j, 2, mapperInfo, /*clamp*/true);
-                if (res != OK) return res;
-            }
+            res = mapMeteringRegions(e, [&](int32_t *coordPairs, int coordCount) {
+                return mapRawToCorrected(coordPairs, coordCount, mapperInfo, /*clamp*/true);
+            });
+            if (res != OK) return res;
         }
         for (auto rect : kRectsToCorrect) {
             e = result->find(rect);
@@ -280,7 +301,7 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
     }
 
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mapperInfo->mDistortedGrid);
+        const GridQuad *quad = findEnclosingQuad(coordPairs + i, *mapperInfo);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -490,43 +511,143 @@ status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
         }
     }
 
+    buildGridIndex(mapperInfo);
+
     mapperInfo->mValidGrids = true;
     return OK;
 }
 
+// Bucket of a coordinate along one axis of the index; monotonic in v
+static size_t indexBucket(float v, float min, float scale, size_t size) {
+    return std::min(static_cast<size_t>(std::max(0.f, (v - min) * scale)), size - 1);
+}
+
+void DistortionMapper::buildGridIndex(DistortionMapperInfo *mapperInfo) {
+    const std::vector<GridQuad> &grid = mapperInfo->mDistortedGrid;
+    mapperInfo->mValidIndex = false;
+    if (grid.empty() || grid.size() > UINT16_MAX) return;
+
+    // Expanded bounding boxes of the quads, as minX, minY, maxX, maxY
+    std::vector<std::array<float, 4>> bounds(grid.size());
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (size_t i = 0; i < grid.size(); i++) {
+        const std::array<float, 8> &c = grid[i].coords;
+        for (float v : c) {
+            // The edge tests of a quad with non-finite corners don't reject any point; leave
+            // such grids to the linear scan
+            if (!std::isfinite(v)) return;
+        }
+        bounds[i] = {
+            std::min({c[0], c[2], c[4], c[6]}) - kIndexMargin,
+            std::min({c[1], c[3], c[5], c[7]}) - kIndexMargin,
+            std::max({c[0], c[2], c[4], c[6]}) + kIndexMargin,
+            std::max({c[1], c[3], c[5], c[7]}) + kIndexMargin
+        };
+        minX = std::min(minX, bounds[i][0]);
+        minY = std::min(minY, bounds[i][1]);
+        maxX = std::max(maxX, bounds[i][2]);
+        maxY = std::max(maxY, bounds[i][3]);
+    }
+
+    mapperInfo->mIndexMinX = minX;
+    mapperInfo->mIndexMinY = minY;
+    mapperInfo->mIndexMaxX = maxX;
+    mapperInfo->mIndexMaxY = maxY;
+    mapperInfo->mIndexScaleX = kIndexSize / (maxX - minX);
+    mapperInfo->mIndexScaleY = kIndexSize / (maxY - minY);
+
+    // Count the quads per bucket, then fill the buckets in grid order
+    std::vector<uint32_t> &offsets = mapperInfo->mIndexOffsets;
+    offsets.assign(kIndexSize * kIndexSize + 1, 0);
+    std::vector<std::array<size_t, 4>> ranges(grid.size());
+    for (size_t i = 0; i < grid.size(); i++) {
+        ranges[i] = {
+            indexBucket(bounds[i][0], minX, mapperInfo->mIndexScaleX, kIndexSize),
+            indexBucket(bounds[i][1], minY, mapperInfo->mIndexScaleY, kIndexSize),
+            indexBucket(bounds[i][2], minX, mapperInfo->mIndexScaleX, kIndexSize),
+            indexBucket(bounds[i][3], minY, mapperInfo->mIndexScaleY, kIndexSize)
+        };
+        for (size_t by = ranges[i][1]; by <= ranges[i][3]; by++) {
+            for (size_t bx = ranges[i][0]; bx <= ranges[i][2]; bx++) {
+                offsets[by * kIndexSize + bx + 1]++;
+            }
+        }
+    }
+    for (size_t b = 0; b < kIndexSize * kIndexSize; b++) {
+        offsets[b + 1] += offsets[b];
+    }
+    mapperInfo->mIndexQuads.resize(offsets.back());
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < grid.size(); i++) {
+        for (size_t by = ranges[i][1]; by <= ranges[i][3]; by++) {
+            for (size_t bx = ranges[i][0]; bx <= ranges[i][2]; bx++) {
+                mapperInfo->mIndexQuads[next[by * kIndexSize + bx]++] = static_cast<uint16_t>(i);
+            }
+        }
+    }
+
+    mapperInfo->mValidIndex = true;
+}
+
+static bool quadContains(float x, float y, const DistortionMapper::GridQuad& quad) {
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    // Point-in-quad test:
+
+    // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+    // edges (or on top of one of the edges or corners), traversed in a consistent direction.
+    // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+    // have the same sign (or be zero) for all edges.
+    // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+    // En is to the left of Ep, or overlapping.
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+
+    return true;
+}
+
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
         const int32_t pt[2], const std::vector<GridQuad>& grid) {
     const float x = pt[0];
     const float y = pt[1];
 
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (quadContains(x, y, quad)) return &quad;
+    }
+    return nullptr;
+}
+
+const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
+        const int32_t pt[2], const DistortionMapperInfo& mapperInfo) {
+    if (!mapperInfo.mValidIndex) return findEnclosingQuad(pt, mapperInfo.mDistortedGrid);
+
+    const float x = pt[0];
+    const float y = pt[1];
+    // Any quad enclosing the point lies within the index bounds, and overlaps its bucket
+    if (!(x >= mapperInfo.mIndexMinX && x <= mapperInfo.mIndexMaxX &&
+            y >= mapperInfo.mIndexMinY && y <= mapperInfo.mIndexMaxY)) {
+        return nullptr;
+    }
+    size_t bx = indexBucket(x, mapperInfo.mIndexMinX, mapperInfo.mIndexScaleX, kIndexSize);
+    size_t by = indexBucket(y, mapperInfo.mIndexMinY, mapperInfo.mIndexScaleY, kIndexSize);
+    size_t bucket = by * kIndexSize + bx;
+    for (uint32_t i = mapperInfo.mIndexOffsets[bucket]; i < mapperInfo.mIndexOffsets[bucket + 1];
+            i++) {
+        const GridQuad& quad = mapperInfo.mDistortedGrid[mapperInfo.mIndexQuads[i]];
+        if (quadContains(x, y, quad)) return &quad;
     }
     return nullptr;
 }
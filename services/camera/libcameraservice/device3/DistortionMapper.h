@@ -155,12 +155,26 @@ class DistortionMapper : public CoordinateMapper {
 
         std::vector<GridQuad> mCorrectedGrid;
         std::vector<GridQuad> mDistortedGrid;
+
+        // Uniform grid of kIndexSize x kIndexSize buckets covering the bounding box of
+        // mDistortedGrid. Bucket b lists the quads whose bounding box overlaps it, in grid
+        // order, at mIndexQuads[mIndexOffsets[b]] to mIndexQuads[mIndexOffsets[b + 1]].
+        bool mValidIndex = false;
+        float mIndexMinX, mIndexMinY, mIndexMaxX, mIndexMaxY;
+        float mIndexScaleX, mIndexScaleY;
+        std::vector<uint32_t> mIndexOffsets;
+        std::vector<uint16_t> mIndexQuads;
     };
 
     // Find which grid quad encloses the point; returns null if none do
     static const GridQuad* findEnclosingQuad(
             const int32_t pt[2], const std::vector<GridQuad>& grid);
 
+    // Find which quad of the distorted grid encloses the point, using the bucket index if
+    // valid. Returns the same quad as a scan of the whole grid.
+    static const GridQuad* findEnclosingQuad(
+            const int32_t pt[2], const DistortionMapperInfo& mapperInfo);
+
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
     // Given quad with points P1-P4, and edges E12-E41, and considering the edge segments as
@@ -184,6 +198,11 @@ class DistortionMapper : public CoordinateMapper {
 
     // Number of quads in each dimension of the mapping grids
     constexpr static size_t kGridSize = 15;
+    // Number of buckets in each dimension of the distorted grid index
+    constexpr static size_t kIndexSize = 2 * kGridSize;
+    // Margin to expand the quad bounds by in the index, in pixels, so that points accepted by
+    // the edge tests despite rounding are still found
+    constexpr static float kIndexMargin = 1.f;
     // Margin to expand the grid by to ensure it doesn't clip the domain
     constexpr static float kGridMargin = 0.05f;
     // Fuzziness for float inequality tests
@@ -209,6 +228,9 @@ class DistortionMapper : public CoordinateMapper {
     // Utility to create reverse mapping grids
     status_t buildGrids(DistortionMapperInfo *mapperInfo);
 
+    // Utility to create the bucket index of the distorted grid
+    static void buildGridIndex(DistortionMapperInfo *mapperInfo);
+
     DistortionMapperInfo mDistortionMapperInfo;
     DistortionMapperInfo mDistortionMapperInfoMaximumResolution;
 
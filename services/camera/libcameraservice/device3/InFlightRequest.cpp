@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera3-InFlightMap"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "device3/InFlightRequest.h"
+
+namespace android {
+
+namespace camera3 {
+
+InFlightRequestMap::InFlightRequestMap(size_t capacity) : mSize(0) {
+    size_t slots = 1;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    mSlots.resize(slots);
+}
+
+ssize_t InFlightRequestMap::add(uint32_t frameNumber, InFlightRequest request) {
+    if ((mSize + 1) * 4 > mSlots.size() * 3) {
+        grow();
+    }
+
+    const size_t mask = mSlots.size() - 1;
+    size_t index = homeOf(frameNumber);
+    while (mSlots[index].used) {
+        if (mSlots[index].frameNumber == frameNumber) {
+            ALOGE("%s: Frame %u is already in flight", __FUNCTION__, frameNumber);
+            return ALREADY_EXISTS;
+        }
+        index = (index + 1) & mask;
+    }
+
+    Slot& slot = mSlots[index];
+    slot.used = true;
+    slot.frameNumber = frameNumber;
+    slot.request = std::move(request);
+    mSize++;
+    return index;
+}
+
+ssize_t InFlightRequestMap::indexOfKey(uint32_t frameNumber) const {
+    const size_t mask = mSlots.size() - 1;
+    size_t index = homeOf(frameNumber);
+    while (mSlots[index].used) {
+        if (mSlots[index].frameNumber == frameNumber) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return NAME_NOT_FOUND;
+}
+
+const InFlightRequest& InFlightRequestMap::valueFor(uint32_t frameNumber) const {
+    ssize_t index = indexOfKey(frameNumber);
+    LOG_ALWAYS_FATAL_IF(index < 0, "%s: Frame %u is not in flight", __FUNCTION__, frameNumber);
+    return mSlots[index].request;
+}
+
+void InFlightRequestMap::removeItemAt(size_t index) {
+    const size_t mask = mSlots.size() - 1;
+    // Close the gap by pulling back any later entry of the same probe run
+    // whose home slot is not between the hole and itself, so that lookups
+    // never stop early at the freed slot.
+    size_t hole = index;
+    for (size_t next = (hole + 1) & mask; mSlots[next].used; next = (next + 1) & mask) {
+        size_t home = homeOf(mSlots[next].frameNumber);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            mSlots[hole] = std::move(mSlots[next]);
+            hole = next;
+        }
+    }
+
+    // Release the buffers and metadata held by the request right away
+    // instead of when the slot is reused.
+    mSlots[hole].used = false;
+    mSlots[hole].request = InFlightRequest();
+    mSize--;
+}
+
+void InFlightRequestMap::clear() {
+    for (Slot& slot : mSlots) {
+        if (slot.used) {
+            slot.used = false;
+            slot.request = InFlightRequest();
+        }
+    }
+    mSize = 0;
+}
+
+std::vector<size_t> InFlightRequestMap::sortedIndices() const {
+    std::vector<size_t> indices;
+    indices.reserve(mSize);
+    for (ssize_t i = firstIndex(); i >= 0; i = nextIndex(i)) {
+        indices.push_back(i);
+    }
+    std::sort(indices.begin(), indices.end(), [this](size_t a, size_t b) {
+        return mSlots[a].frameNumber < mSlots[b].frameNumber;
+    });
+    return indices;
+}
+
+ssize_t InFlightRequestMap::nextUsed(size_t index) const {
+    for (; index < mSlots.size(); index++) {
+        if (mSlots[index].used) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+void InFlightRequestMap::grow() {
+    std::vector<Slot> slots(mSlots.size() * 2);
+    std::swap(slots, mSlots);
+    ALOGV("%s: Growing to %zu slots with %zu requests in flight", __FUNCTION__,
+            mSlots.size(), mSize);
+
+    const size_t mask = mSlots.size() - 1;
+    for (Slot& slot : slots) {
+        if (!slot.used) continue;
+        size_t index = homeOf(slot.frameNumber);
+        while (mSlots[index].used) {
+            index = (index + 1) & mask;
+        }
+        mSlots[index] = std::move(slot);
+    }
+}
+
+} // namespace camera3
+
+} // namespace android
@@ -18,9 +18,11 @@
 #define ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 
 #include <set>
+#include <vector>
 
 #include <camera/CaptureResult.h>
 #include <camera/CameraMetadata.h>
+#include <utils/Errors.h>
 #include <utils/Timers.h>
 
 #include "common/CameraDeviceBase.h"
@@ -198,10 +200,18 @@ struct InFlightRequest {
     // Current output transformation
     int32_t transform;
 
+    // Time (from systemTime) in Ns of the stages of this request, used for the
+    // per-stage latency statistics: registration in the in-flight map before
+    // submission to the HAL, arrival of the shutter notification, and arrival
+    // of the final result metadata. 0 if the stage hasn't been reached.
+    nsecs_t submitTimeNs;
+    nsecs_t shutterNotifiedTimeNs;
+    nsecs_t resultNotifiedTimeNs;
+
     static const nsecs_t kDefaultMinExpectedDuration = 33333333; // 33 ms
     static const nsecs_t kDefaultMaxExpectedDuration = 100000000; // 100 ms
 
-    // Default constructor needed by KeyedVector
+    // Default constructor needed by InFlightRequestMap
     InFlightRequest() :
             shutterTimestamp(0),
             sensorTimestamp(0),
@@ -220,7 +230,10 @@ struct InFlightRequest {
             rotateAndCropAuto(false),
             autoframingAuto(false),
             requestTimeNs(0),
-            transform(-1) {
+            transform(-1),
+            submitTimeNs(0),
+            shutterNotifiedTimeNs(0),
+            resultNotifiedTimeNs(0) {
     }
 
     InFlightRequest(int numBuffers, CaptureResultExtras extras, bool hasInput,
@@ -250,12 +263,77 @@ struct InFlightRequest {
             cameraIdsWithZoom(idsWithZoom),
             requestTimeNs(requestNs),
             outputSurfaces(outSurfaces),
-            transform(-1) {
+            transform(-1),
+            submitTimeNs(0),
+            shutterNotifiedTimeNs(0),
+            resultNotifiedTimeNs(0) {
     }
 };
 
-// Map from frame number to the in-flight request state
-typedef KeyedVector<uint32_t, InFlightRequest> InFlightRequestMap;
+/**
+ * Map from frame number to the in-flight request state.
+ *
+ * Frame numbers are handed out sequentially and requests mostly complete in
+ * order, so the map is a ring of preallocated slots indexed by frame number
+ * modulo its (power of two) capacity. As long as the pipeline holds fewer
+ * frames than the capacity, every frame has its own slot and add, lookup and
+ * removal touch a single entry without shifting any others. Linear probing
+ * handles the frames that stay in flight across a full lap of the ring, and
+ * the ring doubles in size if it gets more than 3/4 full.
+ *
+ * Indices refer to slots and stay valid until the next add, removeItemAt or
+ * clear call. Not thread-safe; callers hold the lock protecting the map.
+ */
+class InFlightRequestMap {
+public:
+    explicit InFlightRequestMap(size_t capacity = kDefaultCapacity);
+
+    // Returns the index of the new entry, or ALREADY_EXISTS if there is
+    // already an entry for frameNumber.
+    ssize_t add(uint32_t frameNumber, InFlightRequest request);
+
+    // Returns the index of the entry for frameNumber, or NAME_NOT_FOUND.
+    ssize_t indexOfKey(uint32_t frameNumber) const;
+
+    uint32_t keyAt(size_t index) const { return mSlots[index].frameNumber; }
+    const InFlightRequest& valueAt(size_t index) const { return mSlots[index].request; }
+    InFlightRequest& editValueAt(size_t index) { return mSlots[index].request; }
+    // The entry for frameNumber must exist.
+    const InFlightRequest& valueFor(uint32_t frameNumber) const;
+
+    void removeItemAt(size_t index);
+    void clear();
+
+    size_t size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+    size_t capacity() const { return mSlots.size(); }
+
+    // Visits the entries in no particular order:
+    //   for (ssize_t i = map.firstIndex(); i >= 0; i = map.nextIndex(i)) { ... }
+    ssize_t firstIndex() const { return nextUsed(0); }
+    ssize_t nextIndex(size_t index) const { return nextUsed(index + 1); }
+
+    // Indices of all entries in ascending frame number order.
+    std::vector<size_t> sortedIndices() const;
+
+    // Covers the usual pipeline depths; high speed sessions grow the ring
+    // once to fit their request batches.
+    static const size_t kDefaultCapacity = 64;
+
+private:
+    struct Slot {
+        bool used = false;
+        uint32_t frameNumber = 0;
+        InFlightRequest request;
+    };
+
+    size_t homeOf(uint32_t frameNumber) const { return frameNumber & (mSlots.size() - 1); }
+    ssize_t nextUsed(size_t index) const;
+    void grow();
+
+    std::vector<Slot> mSlots;
+    size_t mSize;
+};
 
 } // namespace camera3
 
@@ -379,3 +379,99 @@ TEST(DistortionMapperTest, CompareToOpenCV) {
                 << expCoords[i] << ", " << expCoords[i + 1] << ")";
     }
 }
+
+// Check that the bucket index of the distorted grid finds the same quad as a scan of the
+// whole grid, including points on shared quad edges and outside of the grid.
+TEST(DistortionMapperTest, IndexedQuadLookup) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    int32_t coords[2] = {0, 0};
+    ASSERT_EQ(m.mapRawToCorrected(coords, 1, mapperInfo, /*clamp*/false, /*simple*/false), OK);
+    ASSERT_TRUE(mapperInfo->mValidIndex);
+
+    std::vector<std::array<int32_t, 2>> points;
+    for (int32_t y = -200; y < testPreCorrActiveArray[3] + 200; y += 3) {
+        for (int32_t x = -200; x < testPreCorrActiveArray[2] + 200; x += 3) {
+            points.push_back({x, y});
+        }
+    }
+    for (const DistortionMapper::GridQuad &quad : mapperInfo->mDistortedGrid) {
+        for (size_t i = 0; i < quad.coords.size(); i += 2) {
+            points.push_back({static_cast<int32_t>(std::round(quad.coords[i])),
+                    static_cast<int32_t>(std::round(quad.coords[i + 1]))});
+        }
+    }
+
+    size_t found = 0;
+    for (const auto &pt : points) {
+        const DistortionMapper::GridQuad *expected =
+                DistortionMapper::findEnclosingQuad(pt.data(), mapperInfo->mDistortedGrid);
+        const DistortionMapper::GridQuad *quad =
+                DistortionMapper::findEnclosingQuad(pt.data(), *mapperInfo);
+        ASSERT_EQ(quad, expected) << "(" << pt[0] << ", " << pt[1] << ")";
+        if (quad != nullptr) found++;
+    }
+    EXPECT_GT(found, points.size() / 2);
+}
+
+// Measure the throughput of quad lookups and of raw to corrected mapping for coordinates
+// covering the pre-correction active array.
+TEST(DistortionMapperTest, MappingThroughput) {
+    constexpr size_t kCoordCount = 100000;
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+
+    std::default_random_engine gen(0xFACE);
+    std::uniform_int_distribution<int> x_dist(0, testPreCorrActiveArray[2] - 1);
+    std::uniform_int_distribution<int> y_dist(0, testPreCorrActiveArray[3] - 1);
+    std::vector<int32_t> coords(kCoordCount * 2);
+    for (size_t i = 0; i < coords.size(); i += 2) {
+        coords[i] = x_dist(gen);
+        coords[i + 1] = y_dist(gen);
+    }
+
+    // Builds the grids and their index
+    auto mapped = coords;
+    base::Timer mapTimer;
+    ASSERT_EQ(m.mapRawToCorrected(mapped.data(), kCoordCount, mapperInfo, /*clamp*/false,
+            /*simple*/false), OK);
+    auto mapDuration = mapTimer.duration();
+
+    size_t scanFound = 0;
+    base::Timer scanTimer;
+    for (size_t i = 0; i < coords.size(); i += 2) {
+        if (DistortionMapper::findEnclosingQuad(coords.data() + i,
+                mapperInfo->mDistortedGrid) != nullptr) {
+            scanFound++;
+        }
+    }
+    auto scanDuration = scanTimer.duration();
+
+    size_t indexFound = 0;
+    base::Timer indexTimer;
+    for (size_t i = 0; i < coords.size(); i += 2) {
+        if (DistortionMapper::findEnclosingQuad(coords.data() + i, *mapperInfo) != nullptr) {
+            indexFound++;
+        }
+    }
+    auto indexDuration = indexTimer.duration();
+    EXPECT_EQ(indexFound, scanFound);
+
+    auto perSecond = [](std::chrono::milliseconds duration) {
+        return kCoordCount / std::max(std::chrono::duration<double>(duration).count(), 1e-3);
+    };
+    RecordProperty("RawToCorrectedCoordsPerSec", fmt::sprintf("%f", perSecond(mapDuration)));
+    RecordProperty("ScanLookupsPerSec", fmt::sprintf("%f", perSecond(scanDuration)));
+    RecordProperty("IndexedLookupsPerSec", fmt::sprintf("%f", perSecond(indexDuration)));
+}
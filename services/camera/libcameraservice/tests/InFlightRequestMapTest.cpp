@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "InFlightRequestMapTest"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "../device3/InFlightRequest.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+InFlightRequest makeRequest(uint32_t frameNumber) {
+    InFlightRequest request;
+    request.numBuffersLeft = static_cast<int>(frameNumber);
+    return request;
+}
+
+} // anonymous namespace
+
+TEST(InFlightRequestMapTest, AddFindRemove) {
+    InFlightRequestMap map(4);
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(NAME_NOT_FOUND, map.indexOfKey(0));
+
+    for (uint32_t frameNumber = 10; frameNumber < 13; frameNumber++) {
+        ssize_t idx = map.add(frameNumber, makeRequest(frameNumber));
+        ASSERT_GE(idx, 0);
+        EXPECT_EQ(frameNumber, map.keyAt(idx));
+    }
+    EXPECT_EQ(3u, map.size());
+    EXPECT_EQ(ALREADY_EXISTS, map.add(11, makeRequest(11)));
+
+    ssize_t idx = map.indexOfKey(11);
+    ASSERT_GE(idx, 0);
+    map.editValueAt(idx).numBuffersLeft = 0;
+    EXPECT_EQ(0, map.valueFor(11).numBuffersLeft);
+
+    map.removeItemAt(idx);
+    EXPECT_EQ(2u, map.size());
+    EXPECT_EQ(NAME_NOT_FOUND, map.indexOfKey(11));
+    EXPECT_EQ(10, map.valueFor(10).numBuffersLeft);
+    EXPECT_EQ(12, map.valueFor(12).numBuffersLeft);
+
+    map.clear();
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_LT(map.firstIndex(), 0);
+}
+
+TEST(InFlightRequestMapTest, MatchesOrderedMap) {
+    // Keep frames in flight across several laps of the ring, complete them
+    // mostly but not always in order, and let the frame number wrap around.
+    InFlightRequestMap map(8);
+    std::map<uint32_t, int> expected;
+    std::mt19937 rng(0);
+    uint32_t nextFrameNumber = UINT32_MAX - 1000;
+
+    for (int i = 0; i < 100000; i++) {
+        if (rng() % 2 == 0 && expected.size() < 300) {
+            ASSERT_GE(map.add(nextFrameNumber, makeRequest(nextFrameNumber)), 0);
+            expected[nextFrameNumber] = static_cast<int>(nextFrameNumber);
+            nextFrameNumber += (rng() % 8 == 0) ? 2 : 1;
+        } else if (!expected.empty()) {
+            auto it = expected.begin();
+            std::advance(it, rng() % std::min<size_t>(expected.size(), 3));
+            ssize_t idx = map.indexOfKey(it->first);
+            ASSERT_GE(idx, 0);
+            ASSERT_EQ(it->second, map.valueAt(idx).numBuffersLeft);
+            map.removeItemAt(idx);
+            expected.erase(it);
+        }
+        ASSERT_EQ(expected.size(), map.size());
+    }
+
+    size_t count = 0;
+    for (ssize_t i = map.firstIndex(); i >= 0; i = map.nextIndex(i)) {
+        EXPECT_EQ(1u, expected.count(map.keyAt(i)));
+        count++;
+    }
+    EXPECT_EQ(expected.size(), count);
+
+    std::vector<size_t> sorted = map.sortedIndices();
+    ASSERT_EQ(expected.size(), sorted.size());
+    auto it = expected.begin();
+    for (size_t idx : sorted) {
+        EXPECT_EQ(it->first, map.keyAt(idx));
+        EXPECT_EQ(it->second, map.valueAt(idx).numBuffersLeft);
+        it++;
+    }
+}
+
+TEST(InFlightRequestMapTest, GrowsWhenPipelineIsDeep) {
+    InFlightRequestMap map(8);
+    EXPECT_EQ(8u, map.capacity());
+    for (uint32_t frameNumber = 0; frameNumber < 100; frameNumber++) {
+        ASSERT_GE(map.add(frameNumber, makeRequest(frameNumber)), 0);
+    }
+    EXPECT_GE(map.capacity() * 3, map.size() * 4);
+    for (uint32_t frameNumber = 0; frameNumber < 100; frameNumber++) {
+        EXPECT_EQ(static_cast<int>(frameNumber), map.valueFor(frameNumber).numBuffersLeft);
+    }
+}
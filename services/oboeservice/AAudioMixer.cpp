@@ -23,6 +23,12 @@
 #include <cstring>
 #include <utils/Trace.h>
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "AAudioMixer.h"
 
 #ifndef AAUDIO_MIXER_ATRACE_ENABLED
@@ -33,6 +39,67 @@ using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
 
+namespace {
+
+// destination[i] += source[i]
+void mixAdd(float * __restrict destination, const float * __restrict source,
+            int32_t numSamples) {
+    int32_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= numSamples; i += 8) {
+        vst1q_f32(destination + i, vaddq_f32(vld1q_f32(destination + i),
+                                             vld1q_f32(source + i)));
+        vst1q_f32(destination + i + 4, vaddq_f32(vld1q_f32(destination + i + 4),
+                                                 vld1q_f32(source + i + 4)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i),
+                                                  _mm_loadu_ps(source + i)));
+        _mm_storeu_ps(destination + i + 4, _mm_add_ps(_mm_loadu_ps(destination + i + 4),
+                                                      _mm_loadu_ps(source + i + 4)));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        destination[i] += source[i];
+    }
+}
+
+// Adds each mono source sample to every channel of the destination frame.
+void mixMono(float * __restrict destination, const float * __restrict source,
+             int32_t numFrames, int32_t samplesPerFrame) {
+    int32_t frame = 0;
+    if (samplesPerFrame == 2) {
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; frame + 4 <= numFrames; frame += 4) {
+            float32x4x2_t pairs = vzipq_f32(vld1q_f32(source + frame),
+                                            vld1q_f32(source + frame));
+            float *out = destination + 2 * frame;
+            vst1q_f32(out, vaddq_f32(vld1q_f32(out), pairs.val[0]));
+            vst1q_f32(out + 4, vaddq_f32(vld1q_f32(out + 4), pairs.val[1]));
+        }
+#elif defined(__SSE2__)
+        for (; frame + 4 <= numFrames; frame += 4) {
+            const __m128 samples = _mm_loadu_ps(source + frame);
+            float *out = destination + 2 * frame;
+            _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out),
+                                          _mm_unpacklo_ps(samples, samples)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4),
+                                              _mm_unpackhi_ps(samples, samples)));
+        }
+#endif
+    }
+    for (; frame < numFrames; frame++) {
+        const float sample = source[frame];
+        float *out = destination + frame * samplesPerFrame;
+        for (int32_t channel = 0; channel < samplesPerFrame; channel++) {
+            out[channel] += sample;
+        }
+    }
+}
+
+} // namespace
+
 void AAudioMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst) {
     mSamplesPerFrame = samplesPerFrame;
     mFramesPerBurst = framesPerBurst;
@@ -45,8 +112,8 @@ void AAudioMixer::clear() {
     memset(mOutputBuffer.get(), 0, mBufferSizeInBytes);
 }
 
-int32_t AAudioMixer::mix(
-        int streamIndex, const std::shared_ptr<FifoBuffer>& fifo, bool allowUnderflow) {
+int32_t AAudioMixer::mix(int streamIndex, const std::shared_ptr<FifoBuffer>& fifo,
+                         bool allowUnderflow) {
     WrappingBuffer wrappingBuffer;
     float *destination = mOutputBuffer.get();
 
@@ -78,6 +145,17 @@ int32_t AAudioMixer::mix(
         framesDesired = fullFrames; // just use what is available then stop
     }
 
+    const int32_t sourceSamplesPerFrame = fifo->getBytesPerFrame() / sizeof(float);
+    if (sourceSamplesPerFrame != mSamplesPerFrame && sourceSamplesPerFrame != 1) {
+        ALOGE("%s() cannot mix %d channels into %d", __func__,
+              sourceSamplesPerFrame, mSamplesPerFrame);
+        fifo->advanceReadIndex(framesDesired);
+#if AAUDIO_MIXER_ATRACE_ENABLED
+        ATRACE_END();
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+        return framesDesired;
+    }
+
     // Mix data in one or two parts.
     int partIndex = 0;
     int32_t framesLeft = framesDesired;
@@ -88,8 +166,8 @@ int32_t AAudioMixer::mix(
             if (framesToMixFromPart > framesAvailableFromPart) {
                 framesToMixFromPart = framesAvailableFromPart;
             }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
-                    framesToMixFromPart);
+            mixPart(destination, (const float *)wrappingBuffer.data[partIndex],
+                    framesToMixFromPart, sourceSamplesPerFrame);
 
             destination += framesToMixFromPart * mSamplesPerFrame;
             framesLeft -= framesToMixFromPart;
@@ -105,11 +183,12 @@ int32_t AAudioMixer::mix(
     return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
+void AAudioMixer::mixPart(float *destination, const float *source, int32_t numFrames,
+                          int32_t sourceSamplesPerFrame) {
+    if (sourceSamplesPerFrame != mSamplesPerFrame) {
+        mixMono(destination, source, numFrames, mSamplesPerFrame);
+    } else {
+        mixAdd(destination, source, numFrames * mSamplesPerFrame);
     }
 }
 
@@ -31,7 +31,11 @@ public:
     void clear();
 
     /**
-     * Mix from this FIFO
+     * Mix from this FIFO.
+     *
+     * The FIFO holds float frames with either the channel count of the mixer or a single
+     * channel, which is then added to every output channel.
+     *
      * @param streamIndex for marking stream variables in systrace
      * @param fifo to read from
      * @param allowUnderflow if true then allow mixer to advance read index past the write index
@@ -46,7 +50,8 @@ public:
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    void mixPart(float *destination, const float *source, int32_t numFrames,
+                 int32_t sourceSamplesPerFrame);
 
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <iterator>
 #include <map>
 #include <mutex>
 #include <sstream>
@@ -103,6 +104,7 @@ std::vector<android::sp<AAudioServiceStreamBase>>
     {
         const std::lock_guard<std::mutex> lock(mLockStreams);
         mRegisteredStreams.swap(streamsDisconnected);
+        mRegisteredStreamsGeneration++;
     }
     mConnected.store(false);
     // We need to stop all the streams before we disconnect them.
@@ -134,19 +136,67 @@ void AAudioServiceEndpoint::releaseRegisteredStreams() {
 }
 
 aaudio_result_t AAudioServiceEndpoint::registerStream(const sp<AAudioServiceStreamBase>& stream) {
-    const std::lock_guard<std::mutex> lock(mLockStreams);
-    mRegisteredStreams.push_back(stream);
+    {
+        const std::lock_guard<std::mutex> lock(mLockStreams);
+        mRegisteredStreams.push_back(stream);
+        mRegisteredStreamsGeneration++;
+        // So that the data thread can retire every stream without allocating.
+        mRetiredStreams.reserve(mRegisteredStreams.size() + mRetiredStreams.size());
+    }
+    releaseRetiredStreams();
     return AAUDIO_OK;
 }
 
 aaudio_result_t AAudioServiceEndpoint::unregisterStream(const sp<AAudioServiceStreamBase>& stream) {
-    const std::lock_guard<std::mutex> lock(mLockStreams);
-    mRegisteredStreams.erase(std::remove(
-            mRegisteredStreams.begin(), mRegisteredStreams.end(), stream),
-                             mRegisteredStreams.end());
+    {
+        const std::lock_guard<std::mutex> lock(mLockStreams);
+        mRegisteredStreams.erase(std::remove(
+                mRegisteredStreams.begin(), mRegisteredStreams.end(), stream),
+                                 mRegisteredStreams.end());
+        mRegisteredStreamsGeneration++;
+    }
+    releaseRetiredStreams();
     return AAUDIO_OK;
 }
 
+void AAudioServiceEndpoint::updateRegisteredStreamsSnapshot(
+        std::vector<android::sp<AAudioServiceStreamBase>>* streams, int32_t* generation) {
+    if (mRegisteredStreamsGeneration.load() == *generation) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(mLockStreams);
+    // A stream dropped from the copy may be holding its last reference here.
+    for (auto& stream : *streams) {
+        if (std::find(mRegisteredStreams.begin(), mRegisteredStreams.end(), stream)
+                == mRegisteredStreams.end()) {
+            mRetiredStreams.push_back(std::move(stream));
+        }
+    }
+    // Assign in place to reuse the capacity of the previous copy.
+    streams->assign(mRegisteredStreams.begin(), mRegisteredStreams.end());
+    *generation = mRegisteredStreamsGeneration.load();
+}
+
+void AAudioServiceEndpoint::retireRegisteredStreamsSnapshot(
+        std::vector<android::sp<AAudioServiceStreamBase>>* streams) {
+    const std::lock_guard<std::mutex> lock(mLockStreams);
+    for (auto& stream : *streams) {
+        mRetiredStreams.push_back(std::move(stream));
+    }
+    streams->clear();
+}
+
+void AAudioServiceEndpoint::releaseRetiredStreams() {
+    std::vector<android::sp<AAudioServiceStreamBase>> streamsToRelease;
+    {
+        const std::lock_guard<std::mutex> lock(mLockStreams);
+        streamsToRelease.assign(std::make_move_iterator(mRetiredStreams.begin()),
+                                std::make_move_iterator(mRetiredStreams.end()));
+        mRetiredStreams.clear(); // keep the capacity
+    }
+    // The streams may be deleted here, outside the lock.
+}
+
 bool AAudioServiceEndpoint::matches(const AAudioStreamConfiguration& configuration) {
     if (!mConnected.load()) {
         return false; // Only use an endpoint if it is connected to a device.
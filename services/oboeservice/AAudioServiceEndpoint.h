@@ -31,6 +31,7 @@
 #include "binding/AAudioStreamConfiguration.h"
 
 #include "AAudioServiceStreamBase.h"
+#include "SharedBroadcastRingBuffer.h"
 
 namespace aaudio {
 
@@ -111,7 +112,15 @@ public:
 
     int32_t getRequestedDeviceId() const { return mRequestedDeviceId; }
 
-    bool matches(const AAudioStreamConfiguration& configuration);
+    virtual bool matches(const AAudioStreamConfiguration& configuration);
+
+    /**
+     * @return ring read directly by every client of the endpoint, or nullptr
+     *         if each client gets its own copy of the data
+     */
+    virtual std::shared_ptr<SharedBroadcastRingBuffer> getBroadcastRingBuffer() {
+        return nullptr;
+    }
 
     // This should only be called from the AAudioEndpointManager under a mutex.
     int32_t getOpenCount() const {
@@ -156,9 +165,41 @@ protected:
     std::vector<android::sp<AAudioServiceStreamBase>> disconnectRegisteredStreams()
             EXCLUDES(mLockStreams);
 
+    /**
+     * Copy the registered streams if they changed since the last copy, so that a data
+     * thread can walk them without holding mLockStreams. The lock is only taken when
+     * a stream was registered or unregistered in between.
+     *
+     * @param streams receives the registered streams
+     * @param generation the generation of streams, set to -1 for the first call
+     */
+    void updateRegisteredStreamsSnapshot(
+            std::vector<android::sp<AAudioServiceStreamBase>>* streams,
+            int32_t* generation) EXCLUDES(mLockStreams);
+
+    /**
+     * Hand over a copy made by updateRegisteredStreamsSnapshot() when the data thread
+     * stops using it.
+     *
+     * Streams dropped from a copy are not released by the data thread, as that could
+     * delete them there. They are kept until releaseRetiredStreams() is called from
+     * a thread that is not real-time.
+     *
+     * @param streams the copy, cleared on return
+     */
+    void retireRegisteredStreamsSnapshot(
+            std::vector<android::sp<AAudioServiceStreamBase>>* streams) EXCLUDES(mLockStreams);
+
+    void releaseRetiredStreams() EXCLUDES(mLockStreams);
+
     mutable std::mutex       mLockStreams;
     std::vector<android::sp<AAudioServiceStreamBase>> mRegisteredStreams
             GUARDED_BY(mLockStreams);
+    // Incremented under mLockStreams whenever mRegisteredStreams changes.
+    std::atomic<int32_t>     mRegisteredStreamsGeneration{0};
+    // Streams dropped from the copies of mRegisteredStreams, waiting to be released.
+    std::vector<android::sp<AAudioServiceStreamBase>> mRetiredStreams
+            GUARDED_BY(mLockStreams);
 
     SimpleDoubleBuffer<Timestamp>  mAtomicEndpointTimestamp;
 
@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <assert.h>
 #include <map>
 #include <mutex>
@@ -27,6 +28,7 @@
 #include "AAudioServiceEndpoint.h"
 
 #include "core/AudioStreamBuilder.h"
+#include "utility/AAudioUtilities.h"
 #include "AAudioServiceEndpoint.h"
 #include "AAudioServiceStreamShared.h"
 #include "AAudioServiceEndpointCapture.h"
@@ -35,6 +37,11 @@
 using namespace android;  // TODO just import names needed
 using namespace aaudio;   // TODO just import names needed
 
+// Size of the ring shared by the clients in broadcast mode.
+#define BROADCAST_BURSTS_PER_BUFFER       16
+// Client buffers must be smaller than this.
+#define BROADCAST_MAX_FRAMES_PER_BUFFER   (32 * 1024)
+
 AAudioServiceEndpointCapture::AAudioServiceEndpointCapture(AAudioService& audioService)
         : AAudioServiceEndpointShared(
                 new AudioStreamInternalCapture(audioService.asAAudioServiceInterface(), true)) {
@@ -42,12 +49,42 @@ AAudioServiceEndpointCapture::AAudioServiceEndpointCapture(AAudioService& audioS
 
 aaudio_result_t AAudioServiceEndpointCapture::open(const aaudio::AAudioStreamRequest &request) {
     aaudio_result_t result = AAudioServiceEndpointShared::open(request);
-    if (result == AAUDIO_OK) {
-        int distributionBufferSizeBytes = getStreamInternal()->getFramesPerBurst()
-                                          * getStreamInternal()->getBytesPerFrame();
-        mDistributionBuffer = std::make_unique<uint8_t[]>(distributionBufferSizeBytes);
+    if (result != AAUDIO_OK) {
+        return result;
+    }
+
+    const int32_t framesPerBurst = getStreamInternal()->getFramesPerBurst();
+    if (AAudioProperty_isCaptureBroadcastEnabled()) {
+        // The clients cannot choose their capacity so use the largest that is
+        // a multiple of the burst and still fits in a client buffer.
+        int32_t numBursts = std::min(BROADCAST_BURSTS_PER_BUFFER,
+                                     (BROADCAST_MAX_FRAMES_PER_BUFFER - 1) / framesPerBurst);
+        if (numBursts >= 2) {
+            mBroadcastRingBuffer = std::make_shared<SharedBroadcastRingBuffer>();
+            result = mBroadcastRingBuffer->allocate(getStreamInternal()->getBytesPerFrame(),
+                                                    numBursts * framesPerBurst);
+            if (result == AAUDIO_OK) {
+                ALOGD("%s() broadcasting %d bursts to the clients", __func__, numBursts);
+                return AAUDIO_OK;
+            }
+            ALOGW("%s() could not allocate broadcast ring, copying to each client", __func__);
+            mBroadcastRingBuffer.reset();
+        }
     }
-    return result;
+
+    int distributionBufferSizeBytes = framesPerBurst * getStreamInternal()->getBytesPerFrame();
+    mDistributionBuffer = std::make_unique<uint8_t[]>(distributionBufferSizeBytes);
+    return AAUDIO_OK;
+}
+
+aaudio_result_t AAudioServiceEndpointCapture::startStream(
+        sp<AAudioServiceStreamBase> stream,
+        audio_port_handle_t *clientHandle) {
+    if (mBroadcastRingBuffer != nullptr) {
+        // Do not count the data written while the client was stopped as lost.
+        static_cast<AAudioServiceStreamShared *>(stream.get())->markBroadcastReaderStart();
+    }
+    return AAudioServiceEndpointShared::startStream(stream, clientHandle);
 }
 
 // Read data from the shared MMAP stream and then distribute it to the client streams.
@@ -60,10 +97,12 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
     while (mCallbackEnabled.load() && getStreamInternal()->isActive() && (result >= 0)) {
 
         int64_t mmapFramesRead = getStreamInternal()->getFramesRead();
+        uint8_t *buffer = (mBroadcastRingBuffer != nullptr)
+                ? mBroadcastRingBuffer->getWriteAddress()
+                : mDistributionBuffer.get();
 
         // Read audio data from stream using a blocking read.
-        result = getStreamInternal()->read(mDistributionBuffer.get(),
-                getFramesPerBurst(), timeoutNanos);
+        result = getStreamInternal()->read(buffer, getFramesPerBurst(), timeoutNanos);
         if (result == AAUDIO_ERROR_DISCONNECTED) {
             ALOGD("%s() read() returned AAUDIO_ERROR_DISCONNECTED", __func__);
             AAudioServiceEndpointShared::handleDisconnectRegisteredStreamsAsync();
@@ -74,6 +113,11 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
             break;
         }
 
+        if (mBroadcastRingBuffer != nullptr) {
+            // The data is already in place, all the clients see it at once.
+            mBroadcastRingBuffer->advanceWriteCounter(getFramesPerBurst());
+        }
+
         // Distribute data to each active stream.
         { // brackets are for lock_guard
             std::lock_guard <std::mutex> lock(mLockStreams);
@@ -81,9 +125,14 @@ void *AAudioServiceEndpointCapture::callbackLoop() {
                 if (clientStream->isRunning() && !clientStream->isSuspended()) {
                     sp<AAudioServiceStreamShared> streamShared =
                             static_cast<AAudioServiceStreamShared *>(clientStream.get());
-                    streamShared->writeDataIfRoom(mmapFramesRead,
-                                                  mDistributionBuffer.get(),
-                                                  getFramesPerBurst());
+                    if (mBroadcastRingBuffer != nullptr) {
+                        streamShared->onBroadcastDataWritten(mmapFramesRead,
+                                                             getFramesPerBurst());
+                    } else {
+                        streamShared->writeDataIfRoom(mmapFramesRead,
+                                                      mDistributionBuffer.get(),
+                                                      getFramesPerBurst());
+                    }
                 }
             }
         }
@@ -34,10 +34,19 @@ public:
 
     aaudio_result_t open(const aaudio::AAudioStreamRequest &request) override;
 
+    aaudio_result_t startStream(android::sp<AAudioServiceStreamBase> stream,
+                                audio_port_handle_t *clientHandle) override;
+
+    std::shared_ptr<SharedBroadcastRingBuffer> getBroadcastRingBuffer() override {
+        return mBroadcastRingBuffer;
+    }
+
     void *callbackLoop() override;
 
 private:
     std::unique_ptr<uint8_t[]>  mDistributionBuffer;
+    // In broadcast mode the MMAP data is read straight into this ring instead.
+    std::shared_ptr<SharedBroadcastRingBuffer>  mBroadcastRingBuffer;
 };
 
 } /* namespace aaudio */
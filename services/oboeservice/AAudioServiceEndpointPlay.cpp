@@ -63,6 +63,16 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     return result;
 }
 
+bool AAudioServiceEndpointPlay::matches(const AAudioStreamConfiguration& configuration) {
+    // The mixer adds mono streams to every channel so they can share any endpoint.
+    if (configuration.getSamplesPerFrame() == 1 && getSamplesPerFrame() > 1) {
+        AAudioStreamConfiguration adapted = configuration;
+        adapted.setChannelMask(getChannelMask());
+        return AAudioServiceEndpointShared::matches(adapted);
+    }
+    return AAudioServiceEndpointShared::matches(configuration);
+}
+
 // Mix data from each application stream and write result to the shared MMAP stream.
 void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
@@ -74,12 +84,14 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
         // Mix data from each active stream.
         mMixer.clear();
 
-        { // brackets are for lock_guard
+        {
             int index = 0;
             int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
-            std::lock_guard <std::mutex> lock(mLockStreams);
-            for (const auto& clientStream : mRegisteredStreams) {
+            // Walk a copy of the registered streams so that registering or
+            // unregistering a stream does not wait for a whole mix.
+            updateRegisteredStreamsSnapshot(&mMixerStreams, &mMixerStreamsGeneration);
+            for (const auto& clientStream : mMixerStreams) {
                 int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
@@ -156,6 +168,10 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
         }
     }
 
+    // Do not keep the streams alive after the mixer stops.
+    retireRegisteredStreamsSnapshot(&mMixerStreams);
+    mMixerStreamsGeneration = -1;
+
     ALOGD("%s() exiting, enabled = %d, state = %d, result = %d <<<<<<<<<<<<< MIXER",
           __func__, mCallbackEnabled.load(), getStreamInternal()->getState(), result);
     return nullptr; // TODO review
@@ -41,11 +41,17 @@ public:
 
     aaudio_result_t open(const aaudio::AAudioStreamRequest &request) override;
 
+    bool matches(const AAudioStreamConfiguration& configuration) override;
+
     void *callbackLoop() override;
 
 private:
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
+
+    // Copy of mRegisteredStreams used by the mixer thread.
+    std::vector<android::sp<AAudioServiceStreamBase>> mMixerStreams;
+    int32_t                  mMixerStreamsGeneration = -1;
 };
 
 } /* namespace aaudio */
@@ -139,7 +139,10 @@ aaudio_result_t aaudio::AAudioServiceEndpointShared::startSharingThread_l() {
 
 aaudio_result_t aaudio::AAudioServiceEndpointShared::stopSharingThread() {
     mCallbackEnabled.store(false);
-    return getStreamInternal()->joinThread(nullptr);
+    aaudio_result_t result = getStreamInternal()->joinThread(nullptr);
+    // Release the streams that the sharing thread stopped using.
+    releaseRetiredStreams();
+    return result;
 }
 
 aaudio_result_t AAudioServiceEndpointShared::startStream(
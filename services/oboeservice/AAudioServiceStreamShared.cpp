@@ -48,7 +48,7 @@ AAudioServiceStreamShared::AAudioServiceStreamShared(AAudioService &audioService
 std::string AAudioServiceStreamShared::dumpHeader() {
     std::stringstream result;
     result << AAudioServiceStreamBase::dumpHeader();
-    result << "    Write#     Read#   Avail   XRuns";
+    result << "    Write#     Read#   Avail   XRuns      Lost";
     return result.str();
 }
 
@@ -65,8 +65,13 @@ std::string AAudioServiceStreamShared::dump() const NO_THREAD_SAFETY_ANALYSIS {
 
     result << AAudioServiceStreamBase::dump();
 
-    result << mAudioDataQueue->dump();
+    if (mBroadcastReader != nullptr) {
+        result << mBroadcastRingBuffer->dump(*mBroadcastReader);
+    } else if (mAudioDataQueue != nullptr) {
+        result << mAudioDataQueue->dump();
+    }
     result << std::setw(8) << getXRunCount();
+    result << std::setw(10) << getFramesLost();
 
     if (isLocked) {
         audioDataQueueLock.unlock();
@@ -167,6 +172,8 @@ aaudio_result_t AAudioServiceStreamShared::open(const aaudio::AAudioStreamReques
     setChannelMask(configurationInput.getChannelMask());
     if (getChannelMask() == AAUDIO_UNSPECIFIED) {
         setChannelMask(endpoint->getChannelMask());
+    } else if (getSamplesPerFrame() == 1 && getDirection() == AAUDIO_DIRECTION_OUTPUT) {
+        // The mixer adds mono streams to every channel of the endpoint.
     } else if (getSamplesPerFrame() != endpoint->getSamplesPerFrame()) {
         ALOGD("%s() mSamplesPerFrame = %#x, need %#x",
               __func__, getSamplesPerFrame(), endpoint->getSamplesPerFrame());
@@ -174,15 +181,31 @@ aaudio_result_t AAudioServiceStreamShared::open(const aaudio::AAudioStreamReques
         goto error;
     }
 
-    setBufferCapacity(calculateBufferCapacity(configurationInput.getBufferCapacity(),
-                                     mFramesPerBurst));
-    if (getBufferCapacity() < 0) {
-        result = getBufferCapacity(); // negative error code
-        setBufferCapacity(0);
-        goto error;
+    {
+        std::lock_guard<std::mutex> lock(audioDataQueueLock);
+        mBroadcastRingBuffer = endpoint->getBroadcastRingBuffer();
+        if (mBroadcastRingBuffer != nullptr) {
+            // Read directly from the ring of the endpoint. Only the read counter is ours.
+            setBufferCapacity(mBroadcastRingBuffer->getCapacityInFrames());
+            mBroadcastReader = std::make_unique<SharedBroadcastRingBuffer::Reader>();
+            result = mBroadcastReader->allocate();
+            if (result != AAUDIO_OK) {
+                ALOGE("%s() could not allocate read counter", __func__);
+                result = AAUDIO_ERROR_NO_MEMORY;
+                goto error;
+            }
+        }
     }
 
-    {
+    if (mBroadcastRingBuffer == nullptr) {
+        setBufferCapacity(calculateBufferCapacity(configurationInput.getBufferCapacity(),
+                                                  mFramesPerBurst));
+        if (getBufferCapacity() < 0) {
+            result = getBufferCapacity(); // negative error code
+            setBufferCapacity(0);
+            goto error;
+        }
+
         std::lock_guard<std::mutex> lock(audioDataQueueLock);
         // Create audio data shared memory buffer for client.
         mAudioDataQueue = std::make_shared<SharedRingBuffer>();
@@ -215,13 +238,18 @@ aaudio_result_t AAudioServiceStreamShared::getAudioDataDescription_l(
         AudioEndpointParcelable* parcelable)
 {
     std::lock_guard<std::mutex> lock(audioDataQueueLock);
-    if (mAudioDataQueue == nullptr) {
+    if (mBroadcastReader != nullptr) {
+        mBroadcastRingBuffer->fillParcelable(parcelable,
+                                             parcelable->mDownDataQueueParcelable,
+                                             *mBroadcastReader);
+    } else if (mAudioDataQueue != nullptr) {
+        // Gather information on the data queue.
+        mAudioDataQueue->fillParcelable(parcelable,
+                                        parcelable->mDownDataQueueParcelable);
+    } else {
         ALOGW("%s(): mUpMessageQueue null! - stream not open", __func__);
         return AAUDIO_ERROR_NULL;
     }
-    // Gather information on the data queue.
-    mAudioDataQueue->fillParcelable(parcelable,
-                                    parcelable->mDownDataQueueParcelable);
     parcelable->mDownDataQueueParcelable.setFramesPerBurst(getFramesPerBurst());
     return AAUDIO_OK;
 }
@@ -286,6 +314,7 @@ void AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
         // Is the buffer too full to write a burst?
         if (fifo->getEmptyFramesAvailable() < getFramesPerBurst()) {
             incrementXRunCount();
+            mFramesLost += numFrames;
         } else {
             fifo->write(buffer, numFrames);
         }
@@ -300,3 +329,46 @@ void AAudioServiceStreamShared::writeDataIfRoom(int64_t mmapFramesRead,
         markTransferTime(timestamp);
     }
 }
+
+void AAudioServiceStreamShared::onBroadcastDataWritten(int64_t mmapFramesRead,
+                                                       int32_t numFrames) {
+    // Lock the reader to protect against close.
+    std::lock_guard <std::mutex> lock(audioDataQueueLock);
+
+    if (mBroadcastReader == nullptr) {
+        return;
+    }
+
+    // All the clients share the write counter of the ring.
+    const int64_t framesWritten = mBroadcastRingBuffer->getWriteCounter();
+    setTimestampPositionOffset(mmapFramesRead - (framesWritten - numFrames));
+
+    // The next burst will overwrite the oldest frames of the ring. If the client
+    // has not read them yet, skip past them so that it does not read a mix of
+    // old and new data. If the client moves its counter at the same time then
+    // this is checked again after the next burst.
+    // The client can write anything to its read counter. Ignore it until the client
+    // has caught up after being started, or if it is past the data written.
+    const int64_t oldestFrameKept = framesWritten + numFrames
+            - mBroadcastRingBuffer->getCapacityInFrames();
+    const int64_t readCounter = mBroadcastReader->getReadCounter();
+    if (readCounter >= mBroadcastStartCounter
+            && readCounter < oldestFrameKept
+            && mBroadcastReader->compareAndSetReadCounter(readCounter, oldestFrameKept)) {
+        incrementXRunCount();
+        mFramesLost += oldestFrameKept - readCounter;
+    }
+
+    // This timestamp represents the completion of data being written into the
+    // client buffer. It is sent to the client and used in the timing model
+    // to decide when data will be available to read.
+    Timestamp timestamp(framesWritten, AudioClock::getNanoseconds());
+    markTransferTime(timestamp);
+}
+
+void AAudioServiceStreamShared::markBroadcastReaderStart() {
+    std::lock_guard <std::mutex> lock(audioDataQueueLock);
+    if (mBroadcastReader != nullptr) {
+        mBroadcastStartCounter = mBroadcastRingBuffer->getWriteCounter();
+    }
+}
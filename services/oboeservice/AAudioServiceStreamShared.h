@@ -24,6 +24,7 @@
 
 #include "AAudioService.h"
 #include "AAudioServiceStreamBase.h"
+#include "SharedBroadcastRingBuffer.h"
 
 namespace aaudio {
 
@@ -55,6 +56,20 @@ public:
 
     void writeDataIfRoom(int64_t mmapFramesRead, const void *buffer, int32_t numFrames);
 
+    /**
+     * Called after the endpoint wrote numFrames into its broadcast ring.
+     * If this client is so far behind that the next burst would overwrite
+     * frames it has not read yet then those frames are skipped and counted as lost.
+     */
+    void onBroadcastDataWritten(int64_t mmapFramesRead, int32_t numFrames);
+
+    /**
+     * Remember where the broadcast ring was when this client was started.
+     * The client moves its own read counter to the newest data when it starts
+     * and adjusts its frame position to match, so nothing is lost until then.
+     */
+    void markBroadcastReaderStart();
+
     /**
      * This must only be called under getAudioDataQueueLock().
      * @return
@@ -81,6 +96,11 @@ public:
         return mXRunCount.load();
     }
 
+    // Frames captured for this client that it never got to read.
+    int64_t getFramesLost() const {
+        return mFramesLost.load();
+    }
+
     const char *getTypeText() const override { return "Shared"; }
 
     // This is public so that the thread safety annotation, GUARDED_BY(),
@@ -109,9 +129,16 @@ protected:
 private:
 
     std::shared_ptr<SharedRingBuffer> mAudioDataQueue PT_GUARDED_BY(audioDataQueueLock);
+    // Used instead of mAudioDataQueue when the endpoint broadcasts its data.
+    std::shared_ptr<SharedBroadcastRingBuffer> mBroadcastRingBuffer
+            PT_GUARDED_BY(audioDataQueueLock);
+    std::unique_ptr<SharedBroadcastRingBuffer::Reader> mBroadcastReader
+            PT_GUARDED_BY(audioDataQueueLock);
+    int64_t                  mBroadcastStartCounter GUARDED_BY(audioDataQueueLock) = 0;
 
     std::atomic<int64_t>     mTimestampPositionOffset;
     std::atomic<int32_t>     mXRunCount;
+    std::atomic<int64_t>     mFramesLost{0};
 
 };
 
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "SharedBroadcastRingBuffer"
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#include <cutils/ashmem.h>
+#include <iomanip>
+#include <sstream>
+#include <sys/mman.h>
+
+#include "SharedBroadcastRingBuffer.h"
+
+using namespace android;
+using namespace aaudio;
+
+// Create a shared memory region and map it into the service.
+static uint8_t *allocateSharedMemory(const char *name, int32_t sizeInBytes,
+                                     base::unique_fd *fileDescriptor) {
+    fileDescriptor->reset(ashmem_create_region(name, sizeInBytes));
+    if (fileDescriptor->get() == -1) {
+        ALOGE("%s() ashmem_create_region() failed %d", __func__, errno);
+        return nullptr;
+    }
+
+    if (ashmem_set_prot_region(fileDescriptor->get(), PROT_READ|PROT_WRITE) < 0) {
+        ALOGE("%s() ashmem_set_prot_region() failed %d", __func__, errno);
+        fileDescriptor->reset();
+        return nullptr;
+    }
+
+    auto address = (uint8_t *) mmap(nullptr, sizeInBytes, PROT_READ|PROT_WRITE, MAP_SHARED,
+                                    fileDescriptor->get(), 0);
+    if (address == MAP_FAILED) {
+        ALOGE("%s() mmap() failed %d", __func__, errno);
+        fileDescriptor->reset();
+        return nullptr;
+    }
+    return address;
+}
+
+SharedBroadcastRingBuffer::Reader::~Reader() {
+    if (mReadCounter != nullptr) {
+        munmap(mReadCounter, sizeof(fifo_counter_t));
+        mReadCounter = nullptr;
+    }
+}
+
+aaudio_result_t SharedBroadcastRingBuffer::Reader::allocate() {
+    uint8_t *sharedMemory = allocateSharedMemory("AAudioSharedReadCounter",
+                                                 sizeof(fifo_counter_t), &mFileDescriptor);
+    if (sharedMemory == nullptr) {
+        return AAUDIO_ERROR_INTERNAL;
+    }
+    mReadCounter = (std::atomic<fifo_counter_t> *) sharedMemory;
+    setReadCounter(0);
+    return AAUDIO_OK;
+}
+
+SharedBroadcastRingBuffer::~SharedBroadcastRingBuffer() {
+    if (mSharedMemory != nullptr) {
+        munmap(mSharedMemory, mSharedMemorySizeInBytes);
+        mSharedMemory = nullptr;
+    }
+}
+
+aaudio_result_t SharedBroadcastRingBuffer::allocate(fifo_frames_t bytesPerFrame,
+                                                    fifo_frames_t capacityInFrames) {
+    mBytesPerFrame = bytesPerFrame;
+    mCapacityInFrames = capacityInFrames;
+
+    // Create shared memory large enough to hold the data and the write counter.
+    mDataMemorySizeInBytes = bytesPerFrame * capacityInFrames;
+    mSharedMemorySizeInBytes = mDataMemorySizeInBytes + sizeof(fifo_counter_t);
+    mSharedMemory = allocateSharedMemory("AAudioSharedBroadcastRingBuffer",
+                                         mSharedMemorySizeInBytes, &mFileDescriptor);
+    if (mSharedMemory == nullptr) {
+        return AAUDIO_ERROR_INTERNAL;
+    }
+
+    // Our mapping stays writable but clients will only be able to map the ring read-only.
+    if (ashmem_set_prot_region(mFileDescriptor.get(), PROT_READ) < 0) {
+        ALOGE("%s() ashmem_set_prot_region(PROT_READ) failed %d", __func__, errno);
+        munmap(mSharedMemory, mSharedMemorySizeInBytes);
+        mSharedMemory = nullptr;
+        mFileDescriptor.reset();
+        return AAUDIO_ERROR_INTERNAL;
+    }
+
+    mSharedWriteCounter = (std::atomic<fifo_counter_t> *)
+            &mSharedMemory[SHARED_BROADCAST_WRITE_OFFSET];
+    mData = &mSharedMemory[SHARED_BROADCAST_DATA_OFFSET];
+    mWriteCounter.store(0, std::memory_order_release);
+    mSharedWriteCounter->store(0, std::memory_order_release);
+    return AAUDIO_OK;
+}
+
+void SharedBroadcastRingBuffer::fillParcelable(AudioEndpointParcelable* endpointParcelable,
+                                               RingBufferParcelable &ringBufferParcelable,
+                                               const Reader &reader) {
+    int ringIndex = endpointParcelable->addFileDescriptor(mFileDescriptor,
+                                                          mSharedMemorySizeInBytes);
+    int readerIndex = endpointParcelable->addFileDescriptor(reader.mFileDescriptor,
+                                                            sizeof(fifo_counter_t));
+    ringBufferParcelable.setupMemory(
+            {ringIndex, SHARED_BROADCAST_DATA_OFFSET, mDataMemorySizeInBytes},
+            {readerIndex, 0, sizeof(fifo_counter_t)},
+            {ringIndex, SHARED_BROADCAST_WRITE_OFFSET, sizeof(fifo_counter_t)});
+    ringBufferParcelable.setBytesPerFrame(mBytesPerFrame);
+    ringBufferParcelable.setFramesPerBurst(1);
+    ringBufferParcelable.setCapacityInFrames(mCapacityInFrames);
+    ringBufferParcelable.setFlags(RingbufferFlags::SHARED_READ_ONLY);
+}
+
+std::string SharedBroadcastRingBuffer::dump(const Reader &reader) const {
+    std::stringstream result;
+    fifo_counter_t readCounter = reader.getReadCounter();
+    fifo_counter_t writeCounter = getWriteCounter();
+    result << std::setw(10) << writeCounter;
+    result << std::setw(10) << readCounter;
+    result << std::setw(8) << (writeCounter - readCounter);
+    return result.str();
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAUDIO_SHARED_BROADCAST_RINGBUFFER_H
+#define AAUDIO_SHARED_BROADCAST_RINGBUFFER_H
+
+#include <android-base/unique_fd.h>
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+#include "fifo/FifoControllerBase.h"
+#include "binding/RingBufferParcelable.h"
+#include "binding/AudioEndpointParcelable.h"
+
+namespace aaudio {
+
+// Determine the placement of the write counter and data in the shared ring.
+#define SHARED_BROADCAST_WRITE_OFFSET   0
+#define SHARED_BROADCAST_DATA_OFFSET    (SHARED_BROADCAST_WRITE_OFFSET + sizeof(fifo_counter_t))
+
+/**
+ * Capture FIFO in shared memory that is read by all the clients of an endpoint.
+ *
+ * The service writes each burst straight into the data region and then only
+ * publishes a copy of its write counter. Clients can only map the data and the
+ * published counter read-only. Every client has its own read counter in a
+ * separate region so that the clients never copy from or wait on each other.
+ * A client that falls more than a buffer behind loses the oldest frames.
+ *
+ * Anything a client can write is only used after it has been range checked.
+ */
+class SharedBroadcastRingBuffer {
+public:
+    /**
+     * Read counter of one client of the ring.
+     * The client can write any value here so callers must validate it.
+     */
+    class Reader {
+    public:
+        Reader() = default;
+
+        ~Reader();
+
+        aaudio_result_t allocate();
+
+        android::fifo_counter_t getReadCounter() const {
+            return mReadCounter->load(std::memory_order_acquire);
+        }
+
+        void setReadCounter(android::fifo_counter_t count) {
+            mReadCounter->store(count, std::memory_order_release);
+        }
+
+        /**
+         * Move the read counter unless the client moved it first.
+         * @return true if the counter was changed
+         */
+        bool compareAndSetReadCounter(android::fifo_counter_t expected,
+                                      android::fifo_counter_t count) {
+            return mReadCounter->compare_exchange_strong(expected, count);
+        }
+
+    private:
+        friend class SharedBroadcastRingBuffer;
+
+        android::base::unique_fd               mFileDescriptor;
+        std::atomic<android::fifo_counter_t>  *mReadCounter = nullptr; // mmap
+    };
+
+    SharedBroadcastRingBuffer() = default;
+
+    ~SharedBroadcastRingBuffer();
+
+    aaudio_result_t allocate(android::fifo_frames_t bytesPerFrame,
+                             android::fifo_frames_t capacityInFrames);
+
+    /**
+     * Describe the ring to one client. The data and the write counter are shared
+     * by all the clients, the read counter is the one owned by the reader.
+     */
+    void fillParcelable(AudioEndpointParcelable* endpointParcelable,
+                        RingBufferParcelable &ringBufferParcelable,
+                        const Reader &reader);
+
+    /**
+     * The capacity is a multiple of the burst size so a burst never wraps.
+     * @return address where the next burst should be written
+     */
+    uint8_t *getWriteAddress() const {
+        return mData + (getWriteCounter() % mCapacityInFrames) * mBytesPerFrame;
+    }
+
+    /**
+     * Publish frames that were written at getWriteAddress().
+     * Only called by the thread that writes the data.
+     */
+    void advanceWriteCounter(android::fifo_frames_t numFrames) {
+        const android::fifo_counter_t writeCounter = getWriteCounter() + numFrames;
+        mWriteCounter.store(writeCounter, std::memory_order_release);
+        mSharedWriteCounter->store(writeCounter, std::memory_order_release);
+    }
+
+    // This is the private counter, never the copy in shared memory.
+    android::fifo_counter_t getWriteCounter() const {
+        return mWriteCounter.load(std::memory_order_acquire);
+    }
+
+    android::fifo_frames_t getCapacityInFrames() const {
+        return mCapacityInFrames;
+    }
+
+    // dump: write# read# available
+    std::string dump(const Reader &reader) const;
+
+private:
+    android::base::unique_fd               mFileDescriptor;
+    uint8_t                               *mSharedMemory = nullptr; // mmap
+    int32_t                                mSharedMemorySizeInBytes = 0;
+    int32_t                                mDataMemorySizeInBytes = 0;
+    std::atomic<android::fifo_counter_t>   mWriteCounter{0};
+    std::atomic<android::fifo_counter_t>  *mSharedWriteCounter = nullptr; // published copy
+    uint8_t                               *mData = nullptr;
+    android::fifo_frames_t                 mBytesPerFrame = 0;
+    android::fifo_frames_t                 mCapacityInFrames = 0;
+};
+
+} /* namespace aaudio */
+
+#endif //AAUDIO_SHARED_BROADCAST_RINGBUFFER_H
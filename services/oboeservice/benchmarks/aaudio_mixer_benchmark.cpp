@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fifo/FifoBuffer.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+
+namespace {
+
+constexpr int32_t kSamplesPerFrame = 2;
+constexpr int32_t kFramesPerBurst = 192; // 4 ms at 48 kHz
+constexpr int32_t kBurstsPerFifo = 4;
+
+// Streams with a FIFO full of noise, kept full by pretending that the client
+// writes a burst for each burst that is mixed.
+std::vector<std::shared_ptr<FifoBuffer>> makeStreams(int numStreams, int32_t samplesPerFrame) {
+    std::minstd_rand random(42);
+    std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+    std::vector<float> noise(kBurstsPerFifo * kFramesPerBurst * samplesPerFrame);
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    for (int i = 0; i < numStreams; i++) {
+        for (float &sample : noise) {
+            sample = distribution(random);
+        }
+        auto fifo = std::make_shared<FifoBufferAllocated>(samplesPerFrame * sizeof(float),
+                                                          kBurstsPerFifo * kFramesPerBurst);
+        fifo->write(noise.data(), kBurstsPerFifo * kFramesPerBurst);
+        fifos.push_back(std::move(fifo));
+    }
+    return fifos;
+}
+
+void runMixer(benchmark::State& state, int32_t sourceSamplesPerFrame) {
+    const int numStreams = state.range(0);
+    std::vector<std::shared_ptr<FifoBuffer>> fifos =
+            makeStreams(numStreams, sourceSamplesPerFrame);
+    AAudioMixer mixer;
+    mixer.allocate(kSamplesPerFrame, kFramesPerBurst);
+
+    for (auto _ : state) {
+        mixer.clear();
+        for (int i = 0; i < numStreams; i++) {
+            mixer.mix(i, fifos[i], true /* allowUnderflow */);
+            fifos[i]->advanceWriteIndex(kFramesPerBurst);
+        }
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * numStreams * kFramesPerBurst);
+}
+
+// Streams with the channel count of the mixer, the common case.
+void BM_MixStereo(benchmark::State& state) {
+    runMixer(state, kSamplesPerFrame);
+}
+
+// Mono streams added to both channels.
+void BM_MixMono(benchmark::State& state) {
+    runMixer(state, 1);
+}
+
+} // namespace
+
+BENCHMARK(BM_MixStereo)->RangeMultiplier(2)->Range(1, 32);
+BENCHMARK(BM_MixMono)->RangeMultiplier(2)->Range(1, 32);
+
+BENCHMARK_MAIN();